@@ -0,0 +1,200 @@
+#include "bench_harness.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <new>
+#include <utility>
+
+namespace {
+
+std::atomic<std::uint64_t> g_allocation_count{0};
+std::atomic<std::size_t> g_keep_alive{0};
+
+void* CountedAllocate(std::size_t size) {
+  g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) {
+    size = 1;
+  }
+  void* memory = std::malloc(size);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size) {
+  return CountedAllocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return CountedAllocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return CountedAllocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+namespace dbgx::bench {
+
+bool ParseBenchOptions(int argc, char** argv, BenchOptions* options, std::string* error_message) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    const bool has_value = i + 1 < argc;
+
+    if (arg == "--min-time-ms" && has_value) {
+      options->min_time_ms = std::strtoull(argv[++i], nullptr, 10);
+      continue;
+    }
+    if (arg == "--filter" && has_value) {
+      options->filter = argv[++i];
+      continue;
+    }
+    if (arg == "--corpus" && has_value) {
+      options->corpus_dir = argv[++i];
+      continue;
+    }
+    if (arg == "--trace" && has_value) {
+      options->trace_path = argv[++i];
+      continue;
+    }
+
+    if (error_message != nullptr) {
+      *error_message = "Unknown or incomplete argument: " + std::string(arg);
+    }
+    return false;
+  }
+
+  if (options->min_time_ms == 0) {
+    options->min_time_ms = 1;
+  }
+  return true;
+}
+
+bool ReadFileText(const std::string& path, std::string* out_text) {
+  std::ifstream stream(path, std::ios::binary);
+  if (!stream) {
+    return false;
+  }
+  out_text->assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  return true;
+}
+
+std::uint64_t AllocationCount() {
+  return g_allocation_count.load(std::memory_order_relaxed);
+}
+
+void KeepAlive(std::size_t value) {
+  g_keep_alive.fetch_add(value, std::memory_order_relaxed);
+}
+
+BenchRunner::BenchRunner(BenchOptions options) : options_(std::move(options)) {}
+
+void BenchRunner::Run(
+    std::string_view name,
+    std::string_view case_name,
+    std::size_t bytes_per_op,
+    const std::function<void()>& operation) {
+  std::string full_name = std::string(name) + "/" + std::string(case_name);
+  if (!options_.filter.empty() && full_name.find(options_.filter) == std::string::npos) {
+    return;
+  }
+
+  operation();
+
+  const auto min_time = std::chrono::milliseconds(options_.min_time_ms);
+  std::uint64_t iterations = 1;
+  std::chrono::nanoseconds elapsed{0};
+  std::uint64_t allocations = 0;
+
+  while (true) {
+    const std::uint64_t allocations_before = AllocationCount();
+    const auto started_at = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < iterations; ++i) {
+      operation();
+    }
+    elapsed = std::chrono::steady_clock::now() - started_at;
+    allocations = AllocationCount() - allocations_before;
+
+    if (elapsed >= min_time || iterations >= (1ULL << 40)) {
+      break;
+    }
+    iterations *= 2;
+  }
+
+  BenchResult result;
+  result.name = std::string(name);
+  result.case_name = std::string(case_name);
+  result.bytes_per_op = bytes_per_op;
+  result.iterations = iterations;
+  result.ns_per_op = static_cast<double>(elapsed.count()) / static_cast<double>(iterations);
+  result.allocs_per_op = static_cast<double>(allocations) / static_cast<double>(iterations);
+  if (result.ns_per_op > 0.0) {
+    result.mb_per_second =
+        (static_cast<double>(bytes_per_op) / (1024.0 * 1024.0)) / (result.ns_per_op / 1e9);
+  }
+
+  std::printf(
+      "%-28s %-26s %12zu %10llu %14.1f %10.1f %10.2f\n",
+      result.name.c_str(),
+      result.case_name.c_str(),
+      result.bytes_per_op,
+      static_cast<unsigned long long>(result.iterations),
+      result.ns_per_op,
+      result.mb_per_second,
+      result.allocs_per_op);
+  std::fflush(stdout);
+
+  results_.push_back(std::move(result));
+}
+
+void BenchRunner::PrintHeader() const {
+  std::printf(
+      "%-28s %-26s %12s %10s %14s %10s %10s\n",
+      "benchmark",
+      "case",
+      "bytes",
+      "iters",
+      "ns/op",
+      "MB/s",
+      "allocs/op");
+}
+
+const std::vector<BenchResult>& BenchRunner::Results() const {
+  return results_;
+}
+
+}  // namespace dbgx::bench
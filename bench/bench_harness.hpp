@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dbgx::bench {
+
+struct BenchOptions {
+  std::uint64_t min_time_ms = 250;
+  std::string filter;
+  std::string corpus_dir;
+  std::string trace_path;
+};
+
+struct BenchResult {
+  std::string name;
+  std::string case_name;
+  std::size_t bytes_per_op = 0;
+  std::uint64_t iterations = 0;
+  double ns_per_op = 0.0;
+  double mb_per_second = 0.0;
+  double allocs_per_op = 0.0;
+};
+
+bool ParseBenchOptions(int argc, char** argv, BenchOptions* options, std::string* error_message);
+
+bool ReadFileText(const std::string& path, std::string* out_text);
+
+std::uint64_t AllocationCount();
+
+void KeepAlive(std::size_t value);
+
+class BenchRunner {
+ public:
+  explicit BenchRunner(BenchOptions options);
+
+  void Run(
+      std::string_view name,
+      std::string_view case_name,
+      std::size_t bytes_per_op,
+      const std::function<void()>& operation);
+
+  void PrintHeader() const;
+  const std::vector<BenchResult>& Results() const;
+
+ private:
+  BenchOptions options_;
+  std::vector<BenchResult> results_;
+};
+
+}  // namespace dbgx::bench
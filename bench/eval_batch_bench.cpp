@@ -0,0 +1,135 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench_harness.hpp"
+#include "dbgx/mcp/json_rpc.hpp"
+#include "dbgx/windbg/command_executor.hpp"
+
+namespace {
+
+// Stand-ins for the DbgEng costs: creating a client and swapping output callbacks happens once per
+// Execute call unless a session is open, while the command itself costs the same either way.
+constexpr auto kSimulatedClientSetup = std::chrono::microseconds(20);
+constexpr auto kSimulatedCommand = std::chrono::microseconds(5);
+
+void SpinFor(std::chrono::nanoseconds duration) {
+  const auto deadline = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < deadline) {
+  }
+}
+
+class SimulatedExecutor final : public dbgx::windbg::IWinDbgCommandExecutor {
+ public:
+  explicit SimulatedExecutor(bool supports_session) : supports_session_(supports_session) {}
+
+  dbgx::windbg::CommandExecutionResult Execute(const std::string& command) override {
+    SetUpClient();
+    return RunCommand(command);
+  }
+
+  bool OpenSession(std::string* /*error_message*/) override {
+    if (supports_session_) {
+      SpinFor(kSimulatedClientSetup);
+      session_open_ = true;
+    }
+    return supports_session_;
+  }
+
+  void CloseSession() override {
+    session_open_ = false;
+  }
+
+ private:
+  void SetUpClient() const {
+    if (!session_open_) {
+      SpinFor(kSimulatedClientSetup);
+    }
+  }
+
+  static dbgx::windbg::CommandExecutionResult RunCommand(const std::string& command) {
+    SpinFor(kSimulatedCommand);
+    return {
+        .success = true,
+        .output = command + " => 00000000`0014f9a0 00007ff6`12345678\n",
+        .error_message = "",
+    };
+  }
+
+  bool supports_session_;
+  bool session_open_ = false;
+};
+
+std::vector<std::string> BuildTriageCommands(std::size_t count) {
+  static constexpr const char* kTemplates[] = {"dq rsp L2", "dt ntdll!_PEB @$peb", "? @rip+0x10", "ln @rip"};
+  std::vector<std::string> commands;
+  commands.reserve(count);
+  for (std::size_t index = 0; index < count; ++index) {
+    commands.emplace_back(kTemplates[index % (sizeof(kTemplates) / sizeof(kTemplates[0]))]);
+  }
+  return commands;
+}
+
+std::string BuildEvalRequest(const std::string& command, std::size_t id) {
+  return "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) +
+         ",\"method\":\"tools/call\",\"params\":{\"name\":\"windbg.eval\",\"arguments\":{\"command\":\"" + command +
+         "\"}}}";
+}
+
+std::string BuildEvalBatchRequest(const std::vector<std::string>& commands) {
+  std::string array = "[";
+  for (const std::string& command : commands) {
+    array += (array.size() == 1 ? "\"" : ",\"") + command + "\"";
+  }
+  array += "]";
+  return "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/call\",\"params\":{\"name\":\"windbg.eval_batch\","
+         "\"arguments\":{\"commands\":" +
+         array + "}}}";
+}
+
+void RunRoundTripBenchmarks(dbgx::bench::BenchRunner* runner, bool with_session) {
+  SimulatedExecutor executor(with_session);
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  for (const std::size_t count : {1U, 8U, 32U}) {
+    const std::vector<std::string> commands = BuildTriageCommands(count);
+    std::vector<std::string> eval_requests;
+    std::size_t eval_bytes = 0;
+    for (std::size_t index = 0; index < commands.size(); ++index) {
+      eval_requests.push_back(BuildEvalRequest(commands[index], index + 1));
+      eval_bytes += eval_requests.back().size();
+    }
+    const std::string batch_request = BuildEvalBatchRequest(commands);
+    const std::string case_name = "commands_" + std::to_string(count) + (with_session ? "/session" : "");
+
+    runner->Run("windbg.eval x N", case_name, eval_bytes, [&router, &eval_requests]() {
+      for (const std::string& request : eval_requests) {
+        dbgx::bench::KeepAlive(router.HandleJsonRpcPost(request).body.size());
+      }
+    });
+
+    runner->Run("windbg.eval_batch", case_name, batch_request.size(), [&router, &batch_request]() {
+      dbgx::bench::KeepAlive(router.HandleJsonRpcPost(batch_request).body.size());
+    });
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  dbgx::bench::BenchOptions options;
+
+  std::string error_message;
+  if (!dbgx::bench::ParseBenchOptions(argc, argv, &options, &error_message)) {
+    std::fprintf(stderr, "%s\n", error_message.c_str());
+    std::fprintf(stderr, "usage: dbgx_eval_batch_bench [--filter TEXT] [--min-time-ms N]\n");
+    return 2;
+  }
+
+  dbgx::bench::BenchRunner runner(options);
+  runner.PrintHeader();
+  RunRoundTripBenchmarks(&runner, false);
+  RunRoundTripBenchmarks(&runner, true);
+  return 0;
+}
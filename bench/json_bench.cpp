@@ -0,0 +1,253 @@
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bench_harness.hpp"
+#include "dbgx/mcp/async_log.hpp"
+#include "dbgx/mcp/http_server.hpp"
+#include "dbgx/mcp/io_echo.hpp"
+#include "dbgx/mcp/json.hpp"
+#include "dbgx/mcp/metrics.hpp"
+#include "dbgx/mcp/span_tracer.hpp"
+
+#ifndef DBGX_BENCH_CORPUS_DIR
+#define DBGX_BENCH_CORPUS_DIR "bench/corpus"
+#endif
+
+namespace {
+
+struct CorpusMessage {
+  std::string name;
+  std::string body;
+};
+
+struct Corpus {
+  std::vector<CorpusMessage> requests;
+  std::vector<CorpusMessage> responses;
+  std::vector<CorpusMessage> outputs;
+};
+
+bool LoadMessage(const std::string& dir, const std::string& file, CorpusMessage* out) {
+  out->name = file.substr(0, file.find('.'));
+  if (!dbgx::bench::ReadFileText(dir + "/" + file, &out->body)) {
+    std::fprintf(stderr, "failed to read corpus file %s/%s\n", dir.c_str(), file.c_str());
+    return false;
+  }
+  while (!out->body.empty() && (out->body.back() == '\n' || out->body.back() == '\r')) {
+    out->body.pop_back();
+  }
+  return true;
+}
+
+std::string RepeatToSize(std::string_view sample, std::size_t target_size) {
+  std::string output;
+  output.reserve(target_size);
+  while (output.size() < target_size) {
+    output.append(sample.substr(0, target_size - output.size()));
+  }
+  return output;
+}
+
+std::string BuildToolsCallResponse(std::string_view id_raw, std::string_view output) {
+  return "{\"jsonrpc\":\"2.0\",\"id\":" + std::string(id_raw) +
+         ",\"result\":{\"content\":[{\"type\":\"text\",\"text\":\"" + dbgx::json::Escape(output) +
+         "\"}],\"isError\":false}}";
+}
+
+bool LoadCorpus(const std::string& dir, Corpus* corpus) {
+  for (const char* file : {"initialize_request.json", "tools_list_request.json", "tools_call_request.json"}) {
+    CorpusMessage message;
+    if (!LoadMessage(dir, file, &message)) {
+      return false;
+    }
+    corpus->requests.push_back(std::move(message));
+  }
+
+  for (const char* file :
+       {"initialize_response.json", "tools_list_response.json", "tools_call_error_response.json"}) {
+    CorpusMessage message;
+    if (!LoadMessage(dir, file, &message)) {
+      return false;
+    }
+    corpus->responses.push_back(std::move(message));
+  }
+
+  std::string sample;
+  if (!dbgx::bench::ReadFileText(dir + "/eval_output_sample.txt", &sample) || sample.empty()) {
+    std::fprintf(stderr, "failed to read corpus file %s/eval_output_sample.txt\n", dir.c_str());
+    return false;
+  }
+
+  const std::pair<const char*, std::size_t> sizes[] = {
+      {"output_1kb", 1024},
+      {"output_100kb", 100 * 1024},
+      {"output_10mb", 10 * 1024 * 1024},
+  };
+  for (const auto& [name, size] : sizes) {
+    CorpusMessage output{name, RepeatToSize(sample, size)};
+    corpus->responses.push_back({"tools_call_" + output.name, BuildToolsCallResponse("42", output.body)});
+    corpus->outputs.push_back(std::move(output));
+  }
+  return true;
+}
+
+dbgx::mcp::HttpRequest MakeHttpRequest(const std::string& body) {
+  dbgx::mcp::HttpRequest request;
+  request.method = "POST";
+  request.path = "/mcp";
+  request.headers.insert_or_assign("content-type", "application/json");
+  request.headers.insert_or_assign("accept", "application/json, text/event-stream");
+  request.headers.insert_or_assign("mcp-protocol-version", "2025-11-25");
+  request.headers.insert_or_assign("authorization", "Bearer bench-token");
+  request.body = body;
+  return request;
+}
+
+void RunParseBenchmarks(dbgx::bench::BenchRunner* runner, const Corpus& corpus) {
+  for (const auto* group : {&corpus.requests, &corpus.responses}) {
+    for (const CorpusMessage& message : *group) {
+      runner->Run("ParseObjectFields", message.name, message.body.size(), [&message]() {
+        dbgx::json::FieldMap fields;
+        std::string error;
+        dbgx::json::ParseObjectFields(message.body, &fields, &error);
+        dbgx::bench::KeepAlive(fields.size());
+      });
+    }
+  }
+}
+
+void RunTryGetObjectFieldBenchmarks(dbgx::bench::BenchRunner* runner, const Corpus& corpus) {
+  for (const CorpusMessage& message : corpus.requests) {
+    dbgx::json::FieldMap root_fields;
+    std::string error;
+    if (!dbgx::json::ParseObjectFields(message.body, &root_fields, &error)) {
+      continue;
+    }
+    runner->Run("TryGetObjectField(params)", message.name, message.body.size(), [root_fields]() {
+      dbgx::json::FieldMap params_fields;
+      std::string field_error;
+      dbgx::json::TryGetObjectField(root_fields, "params", &params_fields, &field_error);
+      dbgx::bench::KeepAlive(params_fields.size());
+    });
+  }
+
+  for (const CorpusMessage& message : corpus.responses) {
+    dbgx::json::FieldMap root_fields;
+    std::string error;
+    if (!dbgx::json::ParseObjectFields(message.body, &root_fields, &error) ||
+        root_fields.find("result") == root_fields.end()) {
+      continue;
+    }
+    runner->Run("TryGetObjectField(result)", message.name, message.body.size(), [root_fields]() {
+      dbgx::json::FieldMap result_fields;
+      std::string field_error;
+      dbgx::json::TryGetObjectField(root_fields, "result", &result_fields, &field_error);
+      dbgx::bench::KeepAlive(result_fields.size());
+    });
+  }
+}
+
+void RunEscapeBenchmarks(dbgx::bench::BenchRunner* runner, const Corpus& corpus) {
+  for (const CorpusMessage& output : corpus.outputs) {
+    runner->Run("Escape", output.name, output.body.size(), [&output]() {
+      dbgx::bench::KeepAlive(dbgx::json::Escape(output.body).size());
+    });
+  }
+}
+
+void RunIoSummaryBenchmarks(dbgx::bench::BenchRunner* runner, const Corpus& corpus) {
+  dbgx::mcp::IoTraceContext trace_context;
+  trace_context.trace_id = "rpc:42";
+  trace_context.stage = "response_sent";
+  trace_context.rpc_method = "tools/call";
+  trace_context.rpc_id = "42";
+  trace_context.tool_name = "windbg.eval";
+  trace_context.duration_ms = 3;
+
+  for (const CorpusMessage& message : corpus.requests) {
+    const dbgx::mcp::HttpRequest request = MakeHttpRequest(message.body);
+    runner->Run("BuildRequestIoSummary", message.name, message.body.size(), [&request, &trace_context]() {
+      dbgx::bench::KeepAlive(dbgx::mcp::BuildRequestIoSummary(request, trace_context).size());
+    });
+  }
+
+  for (const CorpusMessage& message : corpus.responses) {
+    dbgx::mcp::HttpResponse response;
+    response.body = message.body;
+    runner->Run("BuildResponseIoSummary", message.name, message.body.size(), [response, &trace_context]() {
+      dbgx::bench::KeepAlive(dbgx::mcp::BuildResponseIoSummary(response, trace_context).size());
+    });
+  }
+}
+
+// What a request thread pays to echo a summary: a slot claim and a copy. The sink discards records, so
+// this measures the producer side; drops under the tight loop are counted but still timed.
+void RunAsyncLogBenchmarks(dbgx::bench::BenchRunner* runner, const Corpus& corpus) {
+  dbgx::mcp::AsyncLog log(dbgx::mcp::AsyncLogOptions{}, [](std::span<const dbgx::mcp::LogRecord>) {});
+  dbgx::mcp::IoTraceContext trace_context;
+  trace_context.trace_id = "rpc:42";
+  trace_context.stage = "request_received";
+
+  for (const CorpusMessage& message : corpus.requests) {
+    const std::string summary = dbgx::mcp::BuildRequestIoSummary(MakeHttpRequest(message.body), trace_context);
+    runner->Run("AsyncLog::Enqueue", message.name, summary.size(), [&log, &summary]() {
+      dbgx::bench::KeepAlive(log.Enqueue(dbgx::mcp::LogLevel::kInfo, summary));
+    });
+  }
+}
+
+void RunMetricsBenchmarks(dbgx::bench::BenchRunner* runner) {
+  dbgx::mcp::LatencyHistogram histogram;
+  dbgx::mcp::ShardedCounter counter;
+  std::uint64_t value = 1;
+  runner->Run("LatencyHistogram::Record", "spread", sizeof(value), [&histogram, &value]() {
+    value = value * 6364136223846793005ull + 1442695040888963407ull;
+    histogram.Record(value >> 34);
+  });
+  runner->Run("ShardedCounter::Add", "one", sizeof(value), [&counter]() { counter.Add(1); });
+}
+
+void RunSpanTracerBenchmarks(dbgx::bench::BenchRunner* runner) {
+  dbgx::mcp::SpanTracer tracer;
+  runner->Run("TraceScope", "stopped", 0, [&tracer]() {
+    dbgx::mcp::TraceScope scope(&tracer, dbgx::mcp::TraceStage::kEscape);
+  });
+  tracer.Start();
+  runner->Run("TraceScope", "recording", 0, [&tracer]() {
+    dbgx::mcp::TraceScope scope(&tracer, dbgx::mcp::TraceStage::kEscape);
+  });
+  tracer.Stop();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  dbgx::bench::BenchOptions options;
+  options.corpus_dir = DBGX_BENCH_CORPUS_DIR;
+
+  std::string error_message;
+  if (!dbgx::bench::ParseBenchOptions(argc, argv, &options, &error_message)) {
+    std::fprintf(stderr, "%s\n", error_message.c_str());
+    std::fprintf(stderr, "usage: dbgx_json_bench [--corpus DIR] [--filter TEXT] [--min-time-ms N]\n");
+    return 2;
+  }
+
+  Corpus corpus;
+  if (!LoadCorpus(options.corpus_dir, &corpus)) {
+    return 1;
+  }
+
+  dbgx::bench::BenchRunner runner(options);
+  runner.PrintHeader();
+  RunParseBenchmarks(&runner, corpus);
+  RunTryGetObjectFieldBenchmarks(&runner, corpus);
+  RunEscapeBenchmarks(&runner, corpus);
+  RunIoSummaryBenchmarks(&runner, corpus);
+  RunAsyncLogBenchmarks(&runner, corpus);
+  RunMetricsBenchmarks(&runner);
+  RunSpanTracerBenchmarks(&runner);
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "bench_harness.hpp"
+#include "dbgx/mcp/json.hpp"
+#include "dbgx/windbg/line_filter.hpp"
+
+#ifndef DBGX_BENCH_CORPUS_DIR
+#define DBGX_BENCH_CORPUS_DIR "bench/corpus"
+#endif
+
+namespace {
+
+constexpr std::size_t kOutputBytes = 4 * 1024 * 1024;
+
+std::string RepeatToSize(std::string_view sample, std::size_t target_size) {
+  std::string output;
+  output.reserve(target_size);
+  while (output.size() < target_size) {
+    output.append(sample.substr(0, target_size - output.size()));
+  }
+  return output;
+}
+
+dbgx::windbg::LineFilter CompileFilter(dbgx::windbg::LineFilterOptions options) {
+  dbgx::windbg::LineFilter filter;
+  std::string error_message;
+  if (!dbgx::windbg::LineFilter::Compile(std::move(options), &filter, &error_message)) {
+    std::fprintf(stderr, "%s\n", error_message.c_str());
+  }
+  return filter;
+}
+
+void RunSubstringBenchmarks(dbgx::bench::BenchRunner* runner, const std::string& output) {
+  // The needle never occurs, so both searches scan the whole output.
+  constexpr std::string_view kNeedle = "ntdll!LdrpInitializeProcess";
+  runner->Run("std::string_view::find", "4MB", output.size(), [&output]() {
+    dbgx::bench::KeepAlive(std::string_view(output).find(kNeedle));
+  });
+  runner->Run("FindSubstring", "4MB", output.size(), [&output]() {
+    dbgx::bench::KeepAlive(dbgx::windbg::FindSubstring(output, kNeedle));
+  });
+}
+
+void RunFilterBenchmarks(dbgx::bench::BenchRunner* runner, const std::string& output) {
+  runner->Run("Escape full output", "4MB", output.size(), [&output]() {
+    dbgx::bench::KeepAlive(dbgx::json::Escape(output).size());
+  });
+
+  dbgx::windbg::LineFilterOptions substring_options;
+  substring_options.include = {"KERNELBASE!"};
+  const dbgx::windbg::LineFilter substring_filter = CompileFilter(substring_options);
+  runner->Run("FilterLines+Escape include", "4MB", output.size(), [&output, &substring_filter]() {
+    dbgx::bench::KeepAlive(dbgx::json::Escape(dbgx::windbg::FilterLines(output, substring_filter)).size());
+  });
+
+  dbgx::windbg::LineFilterOptions context_options = substring_options;
+  context_options.context_lines = 2;
+  const dbgx::windbg::LineFilter context_filter = CompileFilter(context_options);
+  runner->Run("FilterLines+Escape context=2", "4MB", output.size(), [&output, &context_filter]() {
+    dbgx::bench::KeepAlive(dbgx::json::Escape(dbgx::windbg::FilterLines(output, context_filter)).size());
+  });
+
+  dbgx::windbg::LineFilterOptions regex_options;
+  regex_options.include_regex = R"(\+0x[0-9a-f]{2}$)";
+  const dbgx::windbg::LineFilter regex_filter = CompileFilter(regex_options);
+  runner->Run("FilterLines+Escape regex", "4MB", output.size(), [&output, &regex_filter]() {
+    dbgx::bench::KeepAlive(dbgx::json::Escape(dbgx::windbg::FilterLines(output, regex_filter)).size());
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  dbgx::bench::BenchOptions options;
+  options.corpus_dir = DBGX_BENCH_CORPUS_DIR;
+
+  std::string error_message;
+  if (!dbgx::bench::ParseBenchOptions(argc, argv, &options, &error_message)) {
+    std::fprintf(stderr, "%s\n", error_message.c_str());
+    std::fprintf(stderr, "usage: dbgx_line_filter_bench [--corpus DIR] [--filter TEXT] [--min-time-ms N]\n");
+    return 2;
+  }
+
+  std::string sample;
+  if (!dbgx::bench::ReadFileText(options.corpus_dir + "/eval_output_sample.txt", &sample)) {
+    std::fprintf(stderr, "failed to read corpus file %s/eval_output_sample.txt\n", options.corpus_dir.c_str());
+    return 1;
+  }
+  const std::string output = RepeatToSize(sample, kOutputBytes);
+
+  dbgx::bench::BenchRunner runner(options);
+  runner.PrintHeader();
+  RunSubstringBenchmarks(&runner, output);
+  RunFilterBenchmarks(&runner, output);
+  return 0;
+}
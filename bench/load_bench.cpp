@@ -0,0 +1,93 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_harness.hpp"
+#include "dbgx/mcp/json_rpc.hpp"
+#include "dbgx/windbg/simulated_executor.hpp"
+
+namespace {
+
+constexpr int kCommandsPerClient = 8;
+
+struct LoadShape {
+  const char* name;
+  dbgx::windbg::SimulationOptions options;
+};
+
+std::vector<LoadShape> BuildLoadShapes() {
+  std::vector<LoadShape> shapes;
+
+  dbgx::windbg::SimulationOptions fixed;
+  fixed.defaults.latency.median = std::chrono::microseconds(200);
+  fixed.defaults.min_output_bytes = 4 * 1024;
+  fixed.defaults.max_output_bytes = 4 * 1024;
+  shapes.push_back({"fixed_200us", fixed});
+
+  dbgx::windbg::SimulationOptions heavy_tail = fixed;
+  heavy_tail.defaults.latency.distribution = dbgx::windbg::LatencyDistribution::kLogNormal;
+  heavy_tail.defaults.latency.sigma = 1.0;
+  heavy_tail.defaults.latency.max = std::chrono::milliseconds(20);
+  heavy_tail.defaults.min_output_bytes = 256;
+  heavy_tail.defaults.max_output_bytes = 256 * 1024;
+  shapes.push_back({"lognormal_200us", heavy_tail});
+
+  return shapes;
+}
+
+std::string BuildEvalRequest(int id) {
+  return "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) +
+         ",\"method\":\"tools/call\",\"params\":{\"name\":\"windbg.eval\",\"arguments\":{\"command\":\"db @rsp\"}}}";
+}
+
+void RunLoadBenchmarks(dbgx::bench::BenchRunner* runner, const LoadShape& shape) {
+  for (const int clients : {1, 4, 16}) {
+    dbgx::windbg::SimulatedCommandExecutor executor(shape.options);
+    dbgx::mcp::JsonRpcRouter router(&executor);
+    std::vector<std::string> requests;
+    std::size_t request_bytes = 0;
+    for (int index = 0; index < clients * kCommandsPerClient; ++index) {
+      requests.push_back(BuildEvalRequest(index + 1));
+      request_bytes += requests.back().size();
+    }
+
+    const std::string case_name = std::string(shape.name) + "/clients_" + std::to_string(clients);
+    runner->Run("windbg.eval concurrent", case_name, request_bytes, [&router, &requests, clients]() {
+      std::vector<std::thread> threads;
+      threads.reserve(static_cast<std::size_t>(clients));
+      for (int client = 0; client < clients; ++client) {
+        threads.emplace_back([&router, &requests, client]() {
+          for (int index = 0; index < kCommandsPerClient; ++index) {
+            const std::string& request = requests[static_cast<std::size_t>(client * kCommandsPerClient + index)];
+            dbgx::bench::KeepAlive(router.HandleJsonRpcPost(request).body.size());
+          }
+        });
+      }
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+    });
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  dbgx::bench::BenchOptions options;
+
+  std::string error_message;
+  if (!dbgx::bench::ParseBenchOptions(argc, argv, &options, &error_message)) {
+    std::fprintf(stderr, "%s\n", error_message.c_str());
+    std::fprintf(stderr, "usage: dbgx_load_bench [--filter TEXT] [--min-time-ms N]\n");
+    return 2;
+  }
+
+  dbgx::bench::BenchRunner runner(options);
+  runner.PrintHeader();
+  for (const LoadShape& shape : BuildLoadShapes()) {
+    RunLoadBenchmarks(&runner, shape);
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include <array>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "bench_harness.hpp"
+#include "dbgx/mcp/json.hpp"
+#include "dbgx/mcp/structured_output.hpp"
+#include "dbgx/windbg/output_parsers.hpp"
+
+#ifndef DBGX_BENCH_CORPUS_DIR
+#define DBGX_BENCH_CORPUS_DIR "bench/corpus"
+#endif
+
+namespace {
+
+struct ParserCorpusCase {
+  std::string_view command;
+  std::string_view file_name;
+};
+
+constexpr std::array kParserCorpus = {
+    ParserCorpusCase{"db", "db_output_sample.txt"},
+    ParserCorpusCase{"dq", "dq_output_sample.txt"},
+    ParserCorpusCase{"lm", "lm_output_sample.txt"},
+    ParserCorpusCase{"kn", "k_output_sample.txt"},
+    ParserCorpusCase{"r", "r_output_sample.txt"},
+};
+
+// Large dumps are repeated samples; 64 KB is the inline output limit of windbg.eval.
+constexpr std::size_t kLargeOutputBytes = 64 * 1024;
+
+std::string RepeatToSize(std::string_view sample, std::size_t target_size) {
+  std::string output;
+  output.reserve(target_size + sample.size());
+  while (output.size() < target_size) {
+    output.append(sample);
+  }
+  return output;
+}
+
+void RunParserBenchmarks(
+    dbgx::bench::BenchRunner* runner,
+    const ParserCorpusCase& corpus_case,
+    const std::string& case_name,
+    const std::string& output) {
+  runner->Run("Escape text", case_name, output.size(), [&output]() {
+    dbgx::bench::KeepAlive(dbgx::json::Escape(output).size());
+  });
+  runner->Run("ParseCommandOutput", case_name, output.size(), [&corpus_case, &output]() {
+    dbgx::windbg::ParsedOutput parsed;
+    dbgx::windbg::ParseCommandOutput(corpus_case.command, output, &parsed);
+    dbgx::bench::KeepAlive(parsed.skipped_lines);
+  });
+  runner->Run("Parse+AppendParsedOutputJson", case_name, output.size(), [&corpus_case, &output]() {
+    dbgx::windbg::ParsedOutput parsed;
+    dbgx::windbg::ParseCommandOutput(corpus_case.command, output, &parsed);
+    std::string json;
+    json.reserve(output.size());
+    dbgx::mcp::AppendParsedOutputJson(parsed, &json);
+    dbgx::bench::KeepAlive(json.size());
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  dbgx::bench::BenchOptions options;
+  options.corpus_dir = DBGX_BENCH_CORPUS_DIR;
+
+  std::string error_message;
+  if (!dbgx::bench::ParseBenchOptions(argc, argv, &options, &error_message)) {
+    std::fprintf(stderr, "%s\n", error_message.c_str());
+    std::fprintf(stderr, "usage: dbgx_output_parsers_bench [--corpus DIR] [--filter TEXT] [--min-time-ms N]\n");
+    return 2;
+  }
+
+  dbgx::bench::BenchRunner runner(options);
+  runner.PrintHeader();
+  for (const ParserCorpusCase& corpus_case : kParserCorpus) {
+    const std::string path = options.corpus_dir + "/" + std::string(corpus_case.file_name);
+    std::string sample;
+    if (!dbgx::bench::ReadFileText(path, &sample)) {
+      std::fprintf(stderr, "failed to read corpus file %s\n", path.c_str());
+      return 1;
+    }
+    RunParserBenchmarks(&runner, corpus_case, std::string(corpus_case.command), sample);
+    RunParserBenchmarks(
+        &runner, corpus_case, std::string(corpus_case.command) + " 64KB", RepeatToSize(sample, kLargeOutputBytes));
+  }
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bench_harness.hpp"
+#include "dbgx/mcp/json.hpp"
+#include "dbgx/mcp/json_rpc.hpp"
+#include "dbgx/windbg/session_trace.hpp"
+
+#ifndef DBGX_BENCH_CORPUS_DIR
+#define DBGX_BENCH_CORPUS_DIR "bench/corpus"
+#endif
+
+namespace {
+
+struct RecordedCommand {
+  std::string_view command;
+  std::string_view file_name;
+  std::uint64_t duration_us;
+  std::size_t repeat;
+};
+
+// A short triage session over the corpus samples; the repeated dump takes the output store path.
+constexpr std::array kCorpusSession = {
+    RecordedCommand{"r", "r_output_sample.txt", 900, 1},
+    RecordedCommand{"kn", "k_output_sample.txt", 2500, 1},
+    RecordedCommand{"lm", "lm_output_sample.txt", 4000, 1},
+    RecordedCommand{"db @rsp L100", "db_output_sample.txt", 700, 1},
+    RecordedCommand{"dq @rsp L100", "dq_output_sample.txt", 700, 1},
+    RecordedCommand{"!analyze -v", "eval_output_sample.txt", 250000, 1},
+    RecordedCommand{"db @rsp L10000", "db_output_sample.txt", 9000, 512},
+};
+
+class CorpusExecutor final : public dbgx::windbg::IWinDbgCommandExecutor {
+ public:
+  explicit CorpusExecutor(std::vector<dbgx::windbg::CommandExecutionResult> results) : results_(std::move(results)) {}
+
+  dbgx::windbg::CommandExecutionResult Execute(const std::string& /*command*/) override {
+    return results_[next_++ % results_.size()];
+  }
+
+ private:
+  std::vector<dbgx::windbg::CommandExecutionResult> results_;
+  std::size_t next_ = 0;
+};
+
+bool RecordCorpusSession(const std::string& corpus_dir, const std::string& trace_path, std::string* error_message) {
+  std::vector<dbgx::windbg::CommandExecutionResult> results;
+  for (const RecordedCommand& recorded : kCorpusSession) {
+    const std::string path = corpus_dir + "/" + std::string(recorded.file_name);
+    std::string sample;
+    if (!dbgx::bench::ReadFileText(path, &sample)) {
+      *error_message = "failed to read corpus file " + path;
+      return false;
+    }
+    dbgx::windbg::CommandExecutionResult result;
+    result.success = true;
+    result.duration_us = recorded.duration_us;
+    for (std::size_t index = 0; index < recorded.repeat; ++index) {
+      result.output += sample;
+    }
+    results.push_back(std::move(result));
+  }
+
+  dbgx::windbg::SessionTraceWriter writer;
+  if (!writer.Open(trace_path, error_message)) {
+    return false;
+  }
+  CorpusExecutor corpus(std::move(results));
+  dbgx::windbg::RecordingCommandExecutor recorder(&corpus, &writer);
+  for (const RecordedCommand& recorded : kCorpusSession) {
+    recorder.Execute(std::string(recorded.command));
+  }
+  return true;
+}
+
+void RunReplayBenchmarks(dbgx::bench::BenchRunner* runner, const dbgx::windbg::SessionTrace& trace) {
+  const std::vector<dbgx::windbg::TraceRecord>& records = trace.Records();
+  std::vector<std::string> commands;
+  std::vector<std::string> requests;
+  std::size_t output_bytes = 0;
+  for (std::size_t index = 0; index < records.size(); ++index) {
+    commands.emplace_back(records[index].command);
+    requests.push_back(
+        "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(index + 1) +
+        ",\"method\":\"tools/call\",\"params\":{\"name\":\"windbg.eval\",\"arguments\":{\"command\":\"" +
+        dbgx::json::Escape(commands.back()) + "\"}}}");
+    output_bytes += records[index].output.size();
+  }
+  const std::string case_name = std::to_string(records.size()) + "_commands";
+
+  dbgx::windbg::ReplayExecutor replay(&trace);
+  runner->Run("ReplayExecutor", case_name, output_bytes, [&replay, &commands]() {
+    for (const std::string& command : commands) {
+      dbgx::bench::KeepAlive(replay.Execute(command).output.size());
+    }
+  });
+
+  dbgx::mcp::JsonRpcRouter router(&replay);
+  runner->Run("windbg.eval replay", case_name, output_bytes, [&router, &requests]() {
+    for (const std::string& request : requests) {
+      dbgx::bench::KeepAlive(router.HandleJsonRpcPost(request).body.size());
+    }
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  dbgx::bench::BenchOptions options;
+  options.corpus_dir = DBGX_BENCH_CORPUS_DIR;
+
+  std::string error_message;
+  if (!dbgx::bench::ParseBenchOptions(argc, argv, &options, &error_message)) {
+    std::fprintf(stderr, "%s\n", error_message.c_str());
+    std::fprintf(
+        stderr, "usage: dbgx_replay_bench [--trace FILE] [--corpus DIR] [--filter TEXT] [--min-time-ms N]\n");
+    return 2;
+  }
+
+  // Without --trace, a trace is recorded from the corpus first so the bench runs anywhere.
+  std::string trace_path = options.trace_path;
+  const bool recorded_here = trace_path.empty();
+  if (recorded_here) {
+    trace_path = (std::filesystem::temp_directory_path() / "dbgx_replay_bench.trace").string();
+    if (!RecordCorpusSession(options.corpus_dir, trace_path, &error_message)) {
+      std::fprintf(stderr, "%s\n", error_message.c_str());
+      return 1;
+    }
+  }
+
+  dbgx::windbg::SessionTrace trace;
+  if (!dbgx::windbg::SessionTrace::Load(trace_path, &trace, &error_message)) {
+    std::fprintf(stderr, "%s\n", error_message.c_str());
+    return 1;
+  }
+
+  dbgx::bench::BenchRunner runner(options);
+  runner.PrintHeader();
+  RunReplayBenchmarks(&runner, trace);
+
+  trace = dbgx::windbg::SessionTrace();
+  if (recorded_here) {
+    std::filesystem::remove(trace_path);
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Lowest level compiled in: 0 debug, 1 info, 2 warning, 3 error.
+#ifndef DBGX_MIN_LOG_LEVEL
+#define DBGX_MIN_LOG_LEVEL 0
+#endif
+
+namespace dbgx::mcp {
+
+enum class LogLevel : std::uint8_t {
+  kDebug,
+  kInfo,
+  kWarning,
+  kError,
+};
+
+// Call sites test this with a constant level in `if constexpr`, so records below the build's floor
+// compile to nothing.
+constexpr bool IsLogLevelCompiled(LogLevel level) {
+  return level >= static_cast<LogLevel>(DBGX_MIN_LOG_LEVEL);
+}
+
+// Accepts debug, info, warning and error.
+bool ParseLogLevel(std::string_view text, LogLevel* out_level);
+
+struct StageSampling {
+  std::string stage;
+  // Keeps the first of every keep_one_in records for the stage.
+  std::uint32_t keep_one_in = 1;
+};
+
+// Parses "stage=N,stage=N", e.g. "route_dispatch=10,tool_execute_start=10".
+bool ParseStageSampling(std::string_view spec, std::vector<StageSampling>* out_sampling, std::string* error_message);
+
+struct AsyncLogOptions {
+  // Ring slots, rounded up to a power of two.
+  std::size_t capacity = 1024;
+  // Longer records are cut to this many bytes.
+  std::size_t max_record_bytes = 2048;
+  LogLevel min_level = LogLevel::kDebug;
+  std::vector<StageSampling> sampling;
+};
+
+struct AsyncLogStats {
+  std::uint64_t enqueued = 0;
+  std::uint64_t dropped = 0;
+  std::uint64_t sampled_out = 0;
+  std::uint64_t truncated = 0;
+};
+
+struct LogRecord {
+  LogLevel level = LogLevel::kInfo;
+  std::string_view text;
+};
+
+// Receives records in enqueue order on the flusher thread; the views are valid only during the call.
+using LogSink = std::function<void(std::span<const LogRecord> records)>;
+
+// Bounded multi-producer ring of preformatted records, drained by one background flusher. Producers claim
+// a slot with a CAS and copy their text into it; they never wait for the flusher, and a record that finds
+// the ring full is dropped and counted.
+class AsyncLog {
+ public:
+  AsyncLog(AsyncLogOptions options, LogSink sink);
+  // Hands every record already enqueued to the sink, then stops the flusher.
+  ~AsyncLog();
+
+  AsyncLog(const AsyncLog&) = delete;
+  AsyncLog& operator=(const AsyncLog&) = delete;
+
+  // Applies the level and the stage's sampling; callers check it before formatting a record. A level
+  // below the minimum costs one branch.
+  bool ShouldLog(LogLevel level, std::string_view stage) {
+    return level >= min_level_ && (sampling_count_ == 0 || Sample(stage));
+  }
+  // Returns false if the record was dropped because the ring is full.
+  bool Enqueue(LogLevel level, std::string_view text);
+  bool Log(LogLevel level, std::string_view stage, std::string_view text);
+
+  // Waits until every record enqueued before the call has been handed to the sink.
+  void Flush();
+
+  AsyncLogStats Stats() const;
+
+ private:
+  struct Slot {
+    std::atomic<std::size_t> sequence{0};
+    LogLevel level = LogLevel::kInfo;
+    std::size_t size = 0;
+  };
+
+  struct SamplingCounter {
+    std::string stage;
+    std::uint32_t keep_one_in = 1;
+    std::atomic<std::uint64_t> seen{0};
+  };
+
+  bool Sample(std::string_view stage);
+  char* SlotText(std::size_t index) const;
+  void FlusherLoop();
+  bool DrainOnce();
+
+  std::size_t mask_;
+  std::size_t max_record_bytes_;
+  LogLevel min_level_;
+  LogSink sink_;
+  std::unique_ptr<Slot[]> slots_;
+  std::unique_ptr<char[]> text_;
+  std::unique_ptr<SamplingCounter[]> sampling_;
+  std::size_t sampling_count_ = 0;
+
+  alignas(64) std::atomic<std::size_t> enqueue_position_{0};
+  // Bumped after each publish so the idle flusher can wait on it.
+  alignas(64) std::atomic<std::uint64_t> published_{0};
+  alignas(64) std::atomic<std::size_t> flushed_position_{0};
+  std::size_t dequeue_position_ = 0;
+  std::atomic<bool> stopping_{false};
+
+  std::atomic<std::uint64_t> enqueued_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::atomic<std::uint64_t> sampled_out_{0};
+  std::atomic<std::uint64_t> truncated_{0};
+
+  std::vector<LogRecord> batch_;
+  std::thread flusher_;
+};
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "dbgx/windbg/command_executor.hpp"
+
+namespace dbgx::mcp {
+
+struct CommandJobTableOptions {
+  std::size_t max_jobs = 16;
+  // Each job keeps only the most recent output_window_bytes of its output, so the table never holds
+  // more than max_jobs * output_window_bytes.
+  std::size_t output_window_bytes = 4 * 1024 * 1024;
+  std::chrono::milliseconds finished_job_ttl = std::chrono::minutes(10);
+};
+
+enum class CommandJobState {
+  kRunning,
+  kSucceeded,
+  kFailed,
+  kCancelled,
+};
+
+std::string_view CommandJobStateName(CommandJobState state);
+
+struct CommandJobStatus {
+  std::string job_id;
+  std::string command;
+  CommandJobState state = CommandJobState::kRunning;
+  std::uint64_t output_bytes = 0;
+  std::uint64_t retained_from_offset = 0;
+  std::uint64_t duration_ms = 0;
+  std::string error_message;
+};
+
+struct CommandJobOutputSlice {
+  std::string text;
+  std::uint64_t offset = 0;
+  std::uint64_t next_offset = 0;
+  std::uint64_t total_bytes = 0;
+  CommandJobState state = CommandJobState::kRunning;
+};
+
+using CommandJobRunner = std::function<windbg::CommandExecutionResult(windbg::CommandExecutionContext* context)>;
+
+class CommandJobTable {
+ public:
+  explicit CommandJobTable(CommandJobTableOptions options = {});
+  ~CommandJobTable();
+
+  CommandJobTable(const CommandJobTable&) = delete;
+  CommandJobTable& operator=(const CommandJobTable&) = delete;
+
+  bool Start(std::string command, CommandJobRunner runner, std::string* out_job_id, std::string* error_message);
+  bool GetStatus(std::string_view job_id, CommandJobStatus* out_status);
+  // Returns output from offset on; an offset older than the retained window starts at the window.
+  bool ReadOutput(
+      std::string_view job_id,
+      std::uint64_t offset,
+      std::size_t max_bytes,
+      CommandJobOutputSlice* out_slice);
+  bool Cancel(std::string_view job_id);
+  // Cancels every job and refuses new ones; finished jobs stay readable.
+  void Shutdown();
+  std::size_t JobCount();
+
+ private:
+  struct Job;
+
+  std::shared_ptr<Job> FindJob(std::string_view job_id);
+  void EvictExpiredLocked(std::chrono::steady_clock::time_point now);
+  bool EvictOldestFinishedLocked();
+
+  CommandJobTableOptions options_;
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<Job>> jobs_;
+  std::uint64_t next_job_number_ = 1;
+  bool shut_down_ = false;
+};
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "dbgx/windbg/command_executor.hpp"
+
+namespace dbgx::mcp {
+
+// Serializes engine access on one dedicated thread. Producers push onto a lock-free stack; the engine thread
+// takes the whole stack at once and runs it in submission order, so callers never contend on a lock while
+// another command is running.
+class EngineDispatchQueue {
+ public:
+  EngineDispatchQueue();
+  // Runs tasks that were already submitted, then stops the engine thread.
+  ~EngineDispatchQueue();
+
+  EngineDispatchQueue(const EngineDispatchQueue&) = delete;
+  EngineDispatchQueue& operator=(const EngineDispatchQueue&) = delete;
+
+  // Runs task on the engine thread and returns once it has finished, rethrowing anything it threw. While
+  // waiting, on_wait is called on the caller's thread every wait_interval. Calls made from the engine
+  // thread run inline.
+  void Run(
+      const std::function<void()>& task,
+      std::chrono::milliseconds wait_interval = std::chrono::milliseconds::zero(),
+      const std::function<void()>& on_wait = nullptr);
+
+  bool OnEngineThread() const;
+  // Tasks submitted from other threads that the engine thread has not started yet.
+  std::size_t Depth() const { return depth_.load(std::memory_order_relaxed); }
+
+ private:
+  // Lives on the submitting thread's stack until the engine thread reports it finished.
+  struct Node {
+    const std::function<void()>* task = nullptr;
+    Node* next = nullptr;
+    std::mutex mutex;
+    std::condition_variable finished_changed;
+    bool finished = false;
+    std::exception_ptr error;
+  };
+
+  void Push(Node* node);
+  void EngineLoop();
+
+  std::atomic<Node*> head_{nullptr};
+  std::atomic<std::size_t> depth_{0};
+  bool stopping_ = false;
+  std::thread engine_thread_;
+};
+
+// Keeps an executor session open for as long as it lives; the session is opened and closed on the engine
+// thread, so every command in between reuses it. Must be destroyed before the queue.
+class EngineSession {
+ public:
+  EngineSession() = default;
+  ~EngineSession();
+
+  EngineSession(const EngineSession&) = delete;
+  EngineSession& operator=(const EngineSession&) = delete;
+
+  bool Open(EngineDispatchQueue* engine, windbg::IWinDbgCommandExecutor* executor, std::string* error_message);
+
+ private:
+  EngineDispatchQueue* engine_ = nullptr;
+  windbg::IWinDbgCommandExecutor* executor_ = nullptr;
+};
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace dbgx::mcp {
+
+// Short text kept inline in a record, so recording never allocates; longer text is cut on a UTF-8 code point
+// boundary.
+struct FlightText {
+  static constexpr std::size_t kCapacity = 31;
+
+  void Assign(std::string_view text);
+  std::string_view View() const { return std::string_view(bytes.data(), size); }
+
+  std::array<char, kCapacity> bytes{};
+  std::uint8_t size = 0;
+};
+
+enum class FlightOutcome : std::uint8_t {
+  kOk,
+  // Answered with a result whose isError is true.
+  kToolError,
+  // Answered with a JSON-RPC error.
+  kError,
+};
+
+std::string_view FlightOutcomeName(FlightOutcome outcome);
+
+// One answered message. Stage times are in nanoseconds.
+struct FlightRecord {
+  // Assigned by the recorder, starting at 1.
+  std::uint64_t sequence = 0;
+  std::uint64_t unix_ms = 0;
+  // The router's metric series, which names the method and tool.
+  std::uint32_t series = 0;
+  std::int32_t error_code = 0;
+  FlightOutcome outcome = FlightOutcome::kOk;
+  bool ran_on_engine = false;
+  // Explicit and zeroed, so the record has no padding and its bit_cast to words is fully defined.
+  std::uint8_t reserved[6]{};
+  std::uint64_t request_bytes = 0;
+  std::uint64_t response_bytes = 0;
+  std::uint64_t parse_ns = 0;
+  std::uint64_t queue_wait_ns = 0;
+  std::uint64_t executor_ns = 0;
+  std::uint64_t serialization_ns = 0;
+  std::uint64_t total_ns = 0;
+  FlightText id;
+  FlightText command;
+};
+
+static_assert(std::is_trivially_copyable_v<FlightRecord> && std::has_unique_object_representations_v<FlightRecord> &&
+              sizeof(FlightRecord) % sizeof(std::uint64_t) == 0);
+
+struct FlightRecorderOptions {
+  // Most recent records kept; rounded up to a power of two.
+  std::size_t capacity = 256;
+};
+
+// A fixed ring of the most recent records, written by any number of threads. Recording is wait-free: a
+// ticket from one fetch_add picks the slot, and a single compare-exchange claims it. A record whose slot is
+// still being written by another thread, or already holds a newer record, is dropped and counted rather
+// than waited for. Each slot is a seqlock, so a snapshot copies records without blocking writers and skips
+// any record that changed while it was copied.
+class FlightRecorder {
+ public:
+  explicit FlightRecorder(FlightRecorderOptions options = {});
+  ~FlightRecorder();
+
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  void Record(const FlightRecord& record);
+
+  // Complete records still in the ring, oldest first.
+  std::vector<FlightRecord> Snapshot() const;
+
+  std::size_t Capacity() const { return mask_ + 1; }
+  std::uint64_t RecordedCount() const { return next_ticket_.load(std::memory_order_relaxed); }
+  std::uint64_t DroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+ private:
+  static constexpr std::size_t kRecordWords = sizeof(FlightRecord) / sizeof(std::uint64_t);
+
+  struct alignas(64) Slot {
+    // 0 while empty; 2 * ticket + 1 while ticket is written, 2 * ticket + 2 once it is complete.
+    std::atomic<std::uint64_t> state{0};
+    std::array<std::atomic<std::uint64_t>, kRecordWords> words{};
+  };
+
+  std::size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<std::uint64_t> next_ticket_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+};
+
+struct LatencyPercentiles {
+  std::uint64_t count = 0;
+  std::uint64_t p50 = 0;
+  std::uint64_t p90 = 0;
+  std::uint64_t p99 = 0;
+  std::uint64_t max = 0;
+};
+
+// Nearest-rank percentiles; values is reordered.
+LatencyPercentiles ComputeLatencyPercentiles(std::span<std::uint64_t> values);
+
+}  // namespace dbgx::mcp
@@ -7,6 +7,9 @@
 #include <string_view>
 #include <unordered_map>
 
+#include "dbgx/mcp/metrics.hpp"
+#include "dbgx/mcp/span_tracer.hpp"
+
 namespace dbgx::mcp {
 
 struct HttpRequest {
@@ -16,15 +19,27 @@ struct HttpRequest {
   std::string body;
 };
 
+using HttpBodyWriter = std::function<bool(std::string_view chunk)>;
+using HttpBodyStreamer = std::function<void(const HttpBodyWriter& write_chunk)>;
+
 struct HttpResponse {
   int status_code = 200;
   std::string content_type = "application/json; charset=utf-8";
   std::string body;
   bool has_body = true;
+  HttpBodyStreamer body_stream;
 };
 
+using MetricsExporter = std::function<void(PrometheusWriter* writer)>;
+
 struct HttpServerStartOptions {
   std::uint16_t max_port_attempts = 16;
+  // When set, the server answers GET /metrics itself in Prometheus text format: its connection gauges
+  // followed by whatever the exporter writes. Other paths still go to the request handler.
+  MetricsExporter metrics_exporter;
+  // When set, connections record accept, recv and send spans, and the server answers POST /trace/start,
+  // POST /trace/stop and GET /trace (the Chrome trace JSON) itself.
+  SpanTracer* tracer = nullptr;
 };
 
 struct HttpServerStartReport {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -26,9 +28,31 @@ struct IoTraceContext {
   std::string tool_name;
   std::string outcome;
   std::uint64_t duration_ms = 0;
+  // The tools/call result reported isError; taken from the router so the result body is not rescanned.
+  bool is_error = false;
 };
 
+// Each field value contributes at most kSummaryValueLimit bytes, so a summary always fits; the Format
+// functions write into the buffer without allocating and return a view of it.
+constexpr std::size_t kSummaryValueLimit = 160;
+constexpr std::size_t kIoSummaryBufferBytes = 2048;
+using IoSummaryBuffer = std::array<char, kIoSummaryBufferBytes>;
+
 RequestIoMeta ParseRequestIoMeta(const HttpRequest& request);
+
+std::string_view FormatLifecycleIoSummary(
+    const IoTraceContext& trace_context,
+    std::string_view message,
+    IoSummaryBuffer* buffer);
+std::string_view FormatRequestIoSummary(
+    const HttpRequest& request,
+    const IoTraceContext& trace_context,
+    IoSummaryBuffer* buffer);
+std::string_view FormatResponseIoSummary(
+    const HttpResponse& response,
+    const IoTraceContext& trace_context,
+    IoSummaryBuffer* buffer);
+
 std::string BuildLifecycleIoSummary(const IoTraceContext& trace_context, std::string_view message);
 
 std::string BuildRequestIoSummary(const HttpRequest& request);
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace dbgx::json {
 
@@ -17,7 +19,60 @@ bool TryGetObjectField(
     std::string* error_message);
 bool TryGetRawField(const FieldMap& fields, const std::string& key, std::string* out_raw_value);
 
+class ObjectFieldCursor {
+ public:
+  explicit ObjectFieldCursor(std::string_view object_text);
+
+  bool Next(std::string_view* out_key, std::string_view* out_raw_value);
+  bool Failed() const;
+  const std::string& ErrorMessage() const;
+
+ private:
+  bool Fail(std::string message);
+
+  std::string_view text_;
+  std::size_t pos_ = 0;
+  bool started_ = false;
+  bool finished_ = false;
+  bool failed_ = false;
+  std::string key_;
+  std::string error_message_;
+};
+
+class ArrayElementCursor {
+ public:
+  explicit ArrayElementCursor(std::string_view array_text);
+
+  bool Next(std::string_view* out_raw_value);
+  bool Failed() const;
+  const std::string& ErrorMessage() const;
+
+ private:
+  bool Fail(std::string message);
+
+  std::string_view text_;
+  std::size_t pos_ = 0;
+  bool started_ = false;
+  bool finished_ = false;
+  bool failed_ = false;
+  std::string error_message_;
+};
+
+bool IsArrayText(std::string_view json_text);
+
+bool ParseStringValue(std::string_view raw_value, std::string* out_value);
+bool ParseBooleanValue(std::string_view raw_value, bool* out_value);
+bool ParseUnsignedValue(std::string_view raw_value, std::uint64_t* out_value);
+bool ParseStringArrayValue(std::string_view raw_value, std::vector<std::string>* out_values);
+
 std::string Escape(std::string_view text);
+// Appends standard base64 (RFC 4648, padded); the result never needs JSON escaping.
+void AppendBase64(std::string_view bytes, std::string* out);
+// Longest prefix of at most max_bytes that does not end inside a UTF-8 sequence.
+std::size_t Utf8PrefixLength(std::string_view text, std::size_t max_bytes);
+// As Utf8PrefixLength, but a nonzero budget too small for the first character takes that whole character, so
+// a reader paging through text always advances.
+std::size_t Utf8PageLength(std::string_view text, std::size_t max_bytes);
 std::string Trim(std::string_view value);
 bool IsNull(std::string_view value);
 
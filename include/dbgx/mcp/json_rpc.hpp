@@ -1,27 +1,75 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
 
+#include "dbgx/mcp/metrics.hpp"
+#include "dbgx/mcp/span_tracer.hpp"
 #include "dbgx/windbg/command_executor.hpp"
+#include "dbgx/windbg/memory_reader.hpp"
+#include "dbgx/windbg/symbol_resolver.hpp"
 
 namespace dbgx::mcp {
 
+using JsonRpcChunkWriter = std::function<bool(std::string_view chunk)>;
+using JsonRpcBodyStreamer = std::function<void(const JsonRpcChunkWriter& write_chunk)>;
+
 struct JsonRpcHttpResult {
   int status_code = 200;
   std::string content_type = "application/json; charset=utf-8";
   std::string body;
   bool has_body = true;
+  JsonRpcBodyStreamer body_stream;
+  // Set when a tools/call result carries isError:true.
+  bool is_error = false;
+};
+
+struct JsonRpcRouterOptions {
+  // Applies to windbg.eval calls without timeout_ms; zero leaves them unbounded.
+  std::chrono::milliseconds default_command_timeout{0};
+  // Receives parse, queue wait, execute, escape and serialize spans; must outlive the router.
+  SpanTracer* tracer = nullptr;
+  // Answered messages kept for dbgx/stats; rounded up to a power of two.
+  std::size_t flight_records = 256;
+};
+
+struct JsonRpcRouterStats {
+  std::uint64_t timed_out_commands = 0;
 };
 
 class JsonRpcRouter {
  public:
-  explicit JsonRpcRouter(windbg::IWinDbgCommandExecutor* executor);
+  // memory_reader backs windbg.read_memory and symbol_provider backs windbg.resolve_addresses; without
+  // them those tools report that they are unavailable.
+  explicit JsonRpcRouter(
+      windbg::IWinDbgCommandExecutor* executor,
+      windbg::IWinDbgMemoryReader* memory_reader = nullptr,
+      windbg::IWinDbgSymbolProvider* symbol_provider = nullptr,
+      JsonRpcRouterOptions options = {});
 
+  // Safe to call from concurrent connections: engine work is queued to a single engine thread, while
+  // metadata methods and notifications/cancelled are answered on the calling thread without waiting for it.
   JsonRpcHttpResult HandleJsonRpcPost(std::string_view request_body) const;
 
+  // Cancels every running or queued command and job, and cancels commands that arrive later before they
+  // reach the engine, so connections blocked on them finish promptly. Call before stopping the server.
+  void Shutdown() const;
+
+  JsonRpcRouterStats Stats() const;
+  // Per-method and per-tool request counts, byte totals and parse, queue wait, executor and serialization
+  // latency histograms, plus the engine queue depth.
+  void ExportMetrics(PrometheusWriter* writer) const;
+
+  struct Runtime;
+
  private:
   windbg::IWinDbgCommandExecutor* executor_;
+  std::shared_ptr<Runtime> runtime_;
 };
 
 }  // namespace dbgx::mcp
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace dbgx::mcp {
+
+// Recording goes to one of these cache-line-aligned shards, chosen per thread, so concurrent connections
+// never write the same line; readers sum the shards.
+inline constexpr std::size_t kMetricShards = 16;
+
+std::size_t AssignMetricShard();
+
+// Fixed for the life of the calling thread; threads are assigned shards round-robin.
+inline std::size_t MetricShardIndex() {
+  static thread_local const std::size_t shard = AssignMetricShard();
+  return shard;
+}
+
+std::uint64_t MonotonicNanoseconds();
+
+class ShardedCounter {
+ public:
+  void Add(std::uint64_t value) { shards_[MetricShardIndex()].value.fetch_add(value, std::memory_order_relaxed); }
+  std::uint64_t Value() const;
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic<std::uint64_t> value{0};
+  };
+
+  std::array<Shard, kMetricShards> shards_;
+};
+
+// Log-linear (HDR-style) buckets over nanoseconds: exact below 8, then eight linear sub-buckets per power
+// of two, so a bucket's bounds are within 12.5% of any value in it. Values from 2^40 ns (about 18 minutes)
+// up share the last bucket.
+inline constexpr int kLatencySubBucketBits = 3;
+inline constexpr std::uint64_t kLatencySubBuckets = std::uint64_t{1} << kLatencySubBucketBits;
+inline constexpr int kLatencyMaxExponent = 40;
+inline constexpr std::size_t kLatencyBucketCount =
+    kLatencySubBuckets * (kLatencyMaxExponent - kLatencySubBucketBits + 1);
+
+constexpr std::size_t LatencyBucketIndex(std::uint64_t nanoseconds) {
+  if (nanoseconds < kLatencySubBuckets) {
+    return static_cast<std::size_t>(nanoseconds);
+  }
+  const int exponent = std::bit_width(nanoseconds) - 1;
+  if (exponent >= kLatencyMaxExponent) {
+    return kLatencyBucketCount - 1;
+  }
+  const std::uint64_t sub_bucket = (nanoseconds >> (exponent - kLatencySubBucketBits)) & (kLatencySubBuckets - 1);
+  return static_cast<std::size_t>((exponent - kLatencySubBucketBits + 1) * kLatencySubBuckets + sub_bucket);
+}
+
+// Largest value that lands in the bucket.
+constexpr std::uint64_t LatencyBucketUpperBound(std::size_t index) {
+  if (index < kLatencySubBuckets) {
+    return index;
+  }
+  const int shift = static_cast<int>(index / kLatencySubBuckets) - 1;
+  const std::uint64_t sub_bucket = index % kLatencySubBuckets;
+  return ((kLatencySubBuckets + sub_bucket + 1) << shift) - 1;
+}
+
+struct HistogramSnapshot {
+  std::array<std::uint64_t, kLatencyBucketCount> counts{};
+  std::uint64_t count = 0;
+  std::uint64_t sum_nanoseconds = 0;
+};
+
+// Recording is two relaxed adds on the calling thread's shard. A shard's buckets are allocated the first
+// time a thread on it records, so series that are never hit stay small.
+class LatencyHistogram {
+ public:
+  LatencyHistogram() = default;
+  ~LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void Record(std::uint64_t nanoseconds);
+  HistogramSnapshot Snapshot() const;
+
+ private:
+  struct Shard {
+    std::array<std::atomic<std::uint64_t>, kLatencyBucketCount> counts{};
+    std::atomic<std::uint64_t> sum{0};
+  };
+
+  Shard* ShardForThread();
+
+  std::array<std::atomic<Shard*>, kMetricShards> shards_{};
+};
+
+struct MetricLabel {
+  std::string_view name;
+  std::string_view value;
+};
+
+inline constexpr std::string_view kPrometheusContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+// Builds the Prometheus text exposition format. Each family starts with BeginFamily and its samples follow
+// before the next family begins.
+class PrometheusWriter {
+ public:
+  void BeginFamily(std::string_view name, std::string_view type, std::string_view help);
+  void WriteSample(std::string_view name, std::span<const MetricLabel> labels, std::uint64_t value);
+  // Cumulative _bucket lines for the non-empty buckets and +Inf, then _sum and _count, all in seconds.
+  void WriteHistogram(std::string_view name, std::span<const MetricLabel> labels, const HistogramSnapshot& snapshot);
+
+  const std::string& Text() const { return text_; }
+  std::string TakeText() { return std::move(text_); }
+
+ private:
+  void WriteSeries(std::string_view name, std::span<const MetricLabel> labels, std::string_view le = {});
+
+  std::string text_;
+};
+
+}  // namespace dbgx::mcp
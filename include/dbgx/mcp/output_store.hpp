@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dbgx::mcp {
+
+struct OutputStoreOptions {
+  std::size_t max_entries = 32;
+  std::size_t max_total_bytes = 64 * 1024 * 1024;
+};
+
+struct StoredOutputInfo {
+  std::string uri;
+  std::string name;
+  std::uint64_t total_bytes = 0;
+  std::uint64_t total_lines = 0;
+};
+
+struct OutputPage {
+  std::string text;
+  std::uint64_t offset = 0;
+  std::uint64_t next_offset = 0;
+  std::uint64_t first_line = 0;
+  std::uint64_t next_line = 0;
+  std::uint64_t total_bytes = 0;
+  std::uint64_t total_lines = 0;
+};
+
+// Keeps large command outputs server-side so responses can carry an excerpt plus a dbgx://output/<n>
+// URI. Each entry has a line-offset index, so a page starting at any line is located in O(1).
+// The oldest entries are evicted once either bound is exceeded.
+class OutputStore {
+ public:
+  explicit OutputStore(OutputStoreOptions options = {});
+
+  // Returns false when the text alone exceeds max_total_bytes.
+  bool Put(std::string name, std::string text, StoredOutputInfo* out_info);
+  bool ReadLines(std::string_view uri, std::uint64_t first_line, std::size_t max_lines, OutputPage* out_page) const;
+  // The page starts at or before offset and ends at or before offset + max_bytes, on UTF-8 character boundaries.
+  bool ReadBytes(std::string_view uri, std::uint64_t offset, std::size_t max_bytes, OutputPage* out_page) const;
+  std::vector<StoredOutputInfo> List() const;
+
+ private:
+  struct Entry {
+    StoredOutputInfo info;
+    std::string text;
+    std::vector<std::size_t> line_starts;
+
+    std::uint64_t LineAt(std::uint64_t offset) const;
+  };
+
+  std::shared_ptr<const Entry> Find(std::string_view uri) const;
+
+  OutputStoreOptions options_;
+  mutable std::mutex mutex_;
+  std::deque<std::shared_ptr<const Entry>> entries_;
+  std::size_t total_bytes_ = 0;
+  std::uint64_t next_id_ = 1;
+};
+
+}  // namespace dbgx::mcp
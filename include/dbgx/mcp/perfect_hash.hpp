@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace dbgx::mcp {
+
+constexpr std::uint64_t HashName(std::string_view name, std::uint64_t seed) {
+  std::uint64_t hash = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+  for (const char ch : name) {
+    hash ^= static_cast<unsigned char>(ch);
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 29;
+  return hash;
+}
+
+template <std::size_t KeyCount>
+class PerfectHashTable {
+ public:
+  static constexpr std::size_t kNotFound = static_cast<std::size_t>(-1);
+
+  constexpr explicit PerfectHashTable(const std::array<std::string_view, KeyCount>& keys) : keys_(keys) {
+    for (std::size_t left = 0; left < KeyCount; ++left) {
+      for (std::size_t right = left + 1; right < KeyCount; ++right) {
+        if (keys_[left] == keys_[right]) {
+          throw std::logic_error("duplicate key registered in perfect hash table");
+        }
+      }
+    }
+    for (std::uint64_t seed = 1; seed <= kMaxSeedAttempts; ++seed) {
+      if (TryBuild(seed)) {
+        seed_ = seed;
+        return;
+      }
+    }
+    throw std::logic_error("no collision-free seed found for perfect hash table");
+  }
+
+  constexpr std::size_t Find(std::string_view key) const {
+    const std::size_t slot = static_cast<std::size_t>(HashName(key, seed_) & (kSlotCount - 1));
+    const std::size_t index = slots_[slot];
+    if (index == kNotFound || keys_[index] != key) {
+      return kNotFound;
+    }
+    return index;
+  }
+
+ private:
+  static constexpr std::size_t ComputeSlotCount() {
+    std::size_t count = 8;
+    while (count < KeyCount * 2) {
+      count *= 2;
+    }
+    return count;
+  }
+
+  static constexpr std::size_t kSlotCount = ComputeSlotCount();
+  static constexpr std::uint64_t kMaxSeedAttempts = 1U << 16;
+
+  constexpr bool TryBuild(std::uint64_t seed) {
+    for (std::size_t& slot : slots_) {
+      slot = kNotFound;
+    }
+    for (std::size_t index = 0; index < KeyCount; ++index) {
+      const std::size_t slot = static_cast<std::size_t>(HashName(keys_[index], seed) & (kSlotCount - 1));
+      if (slots_[slot] != kNotFound) {
+        return false;
+      }
+      slots_[slot] = index;
+    }
+    return true;
+  }
+
+  std::array<std::string_view, KeyCount> keys_{};
+  std::array<std::size_t, kSlotCount> slots_{};
+  std::uint64_t seed_ = 0;
+};
+
+template <typename Registration, std::size_t Count>
+constexpr PerfectHashTable<Count> BuildPerfectHashTable(const std::array<Registration, Count>& registrations) {
+  std::array<std::string_view, Count> keys{};
+  for (std::size_t index = 0; index < Count; ++index) {
+    keys[index] = registrations[index].name;
+  }
+  return PerfectHashTable<Count>(keys);
+}
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "dbgx/mcp/metrics.hpp"
+
+namespace dbgx::mcp {
+
+enum class TraceStage : std::uint8_t {
+  kAccept,
+  kReceive,
+  kParse,
+  kQueueWait,
+  kExecute,
+  kEscape,
+  kSerialize,
+  kSend,
+};
+
+std::string_view TraceStageName(TraceStage stage);
+
+struct SpanTracerOptions {
+  // Most recent spans kept per thread; older spans are overwritten.
+  std::size_t spans_per_thread = 4096;
+};
+
+struct SpanTracerState;
+
+// Records begin/end spans with steady-clock nanosecond timestamps into a ring owned by the recording thread,
+// so recording takes no locks and never waits for a dump. A thread takes a ring on its first span and hands
+// it back when it exits, for the next thread to reuse. While stopped, recording costs one relaxed load.
+class SpanTracer {
+ public:
+  explicit SpanTracer(SpanTracerOptions options = {});
+  ~SpanTracer();
+
+  SpanTracer(const SpanTracer&) = delete;
+  SpanTracer& operator=(const SpanTracer&) = delete;
+
+  // Starts recording; spans from earlier runs are left out of later dumps.
+  void Start();
+  void Stop();
+  bool IsEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  void Record(TraceStage stage, std::uint64_t begin_ns, std::uint64_t end_ns);
+
+  // Chrome trace event JSON with one complete ("X") event per span since the last Start, ordered by begin
+  // time; each recording thread is its own track. Loads in chrome://tracing and Perfetto. Safe to call while
+  // threads are recording: spans overwritten during the copy are skipped.
+  std::string ChromeTraceJson() const;
+
+ private:
+  std::atomic<bool> enabled_{false};
+  std::shared_ptr<SpanTracerState> state_;
+};
+
+// Records a span from construction to destruction when tracer is non-null and recording.
+class TraceScope {
+ public:
+  TraceScope(SpanTracer* tracer, TraceStage stage)
+      : tracer_(tracer != nullptr && tracer->IsEnabled() ? tracer : nullptr),
+        stage_(stage),
+        begin_ns_(tracer_ != nullptr ? MonotonicNanoseconds() : 0) {}
+  ~TraceScope() {
+    if (tracer_ != nullptr) {
+      tracer_->Record(stage_, begin_ns_, MonotonicNanoseconds());
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  SpanTracer* tracer_;
+  TraceStage stage_;
+  std::uint64_t begin_ns_;
+};
+
+}  // namespace dbgx::mcp
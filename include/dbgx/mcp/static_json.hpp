@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace dbgx::mcp {
+
+class StaticJsonWriter {
+ public:
+  constexpr explicit StaticJsonWriter(char* buffer) : buffer_(buffer) {}
+
+  constexpr void Append(std::string_view text) {
+    for (const char ch : text) {
+      Put(ch);
+    }
+  }
+
+  constexpr void AppendEscaped(std::string_view text) {
+    for (const char ch : text) {
+      if (ch == '"' || ch == '\\') {
+        Put('\\');
+      }
+      Put(ch);
+    }
+  }
+
+  constexpr void AppendUnsigned(std::size_t value) {
+    char digits[20] = {};
+    std::size_t count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value != 0);
+    while (count > 0) {
+      Put(digits[--count]);
+    }
+  }
+
+  constexpr std::size_t Size() const {
+    return size_;
+  }
+
+ private:
+  constexpr void Put(char ch) {
+    if (buffer_ != nullptr) {
+      buffer_[size_] = ch;
+    }
+    ++size_;
+  }
+
+  char* buffer_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+template <std::size_t Size>
+struct StaticJson {
+  std::array<char, Size + 1> text{};
+
+  constexpr std::string_view View() const {
+    return std::string_view(text.data(), Size);
+  }
+};
+
+template <typename Writer>
+constexpr std::size_t MeasureStaticJson(Writer write) {
+  StaticJsonWriter writer(nullptr);
+  write(writer);
+  return writer.Size();
+}
+
+template <std::size_t Size, typename Writer>
+constexpr StaticJson<Size> RenderStaticJson(Writer write) {
+  StaticJson<Size> rendered;
+  StaticJsonWriter writer(rendered.text.data());
+  write(writer);
+  return rendered;
+}
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+#include "dbgx/windbg/output_parsers.hpp"
+
+namespace dbgx::mcp {
+
+// Appends parsed command output as a JSON object. Addresses and values are "0x"-prefixed hex strings,
+// since 64-bit values do not fit in a JSON number.
+void AppendParsedOutputJson(const windbg::ParsedOutput& parsed, std::string* out);
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,301 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dbgx/mcp/json.hpp"
+#include "dbgx/mcp/static_json.hpp"
+
+namespace dbgx::mcp {
+
+enum class ToolFieldType {
+  kString,
+  kBoolean,
+  kUnsignedInteger,
+  kStringArray,
+};
+
+template <typename Arguments>
+struct ToolField {
+  std::string_view name;
+  ToolFieldType type = ToolFieldType::kString;
+  std::string_view description;
+  bool required = false;
+  std::size_t min_length = 0;
+  std::string Arguments::*string_member = nullptr;
+  bool Arguments::*boolean_member = nullptr;
+  std::uint64_t Arguments::*unsigned_member = nullptr;
+  std::vector<std::string> Arguments::*string_array_member = nullptr;
+};
+
+template <typename Arguments, std::size_t FieldCount>
+struct ToolDescriptor {
+  using ArgumentsType = Arguments;
+
+  std::string_view name;
+  std::string_view description;
+  std::array<ToolField<Arguments>, FieldCount> fields;
+};
+
+template <typename Arguments>
+constexpr ToolField<Arguments> StringField(
+    std::string_view name,
+    std::string Arguments::*member,
+    std::string_view description,
+    bool required,
+    std::size_t min_length = 0) {
+  ToolField<Arguments> field;
+  field.name = name;
+  field.type = ToolFieldType::kString;
+  field.description = description;
+  field.required = required;
+  field.min_length = min_length;
+  field.string_member = member;
+  return field;
+}
+
+template <typename Arguments>
+constexpr ToolField<Arguments> BooleanField(
+    std::string_view name,
+    bool Arguments::*member,
+    std::string_view description) {
+  ToolField<Arguments> field;
+  field.name = name;
+  field.type = ToolFieldType::kBoolean;
+  field.description = description;
+  field.boolean_member = member;
+  return field;
+}
+
+template <typename Arguments>
+constexpr ToolField<Arguments> UnsignedField(
+    std::string_view name,
+    std::uint64_t Arguments::*member,
+    std::string_view description,
+    bool required = false) {
+  ToolField<Arguments> field;
+  field.name = name;
+  field.type = ToolFieldType::kUnsignedInteger;
+  field.description = description;
+  field.required = required;
+  field.unsigned_member = member;
+  return field;
+}
+
+template <typename Arguments>
+constexpr ToolField<Arguments> StringArrayField(
+    std::string_view name,
+    std::vector<std::string> Arguments::*member,
+    std::string_view description,
+    bool required,
+    std::size_t min_length = 0) {
+  ToolField<Arguments> field;
+  field.name = name;
+  field.type = ToolFieldType::kStringArray;
+  field.description = description;
+  field.required = required;
+  field.min_length = min_length;
+  field.string_array_member = member;
+  return field;
+}
+
+namespace detail {
+
+template <typename Arguments>
+constexpr void WriteFieldSchema(const ToolField<Arguments>& field, StaticJsonWriter& writer) {
+  writer.Append("\"");
+  writer.AppendEscaped(field.name);
+  writer.Append("\":{");
+  switch (field.type) {
+    case ToolFieldType::kString:
+      writer.Append("\"type\":\"string\"");
+      if (field.min_length != 0) {
+        writer.Append(",\"minLength\":");
+        writer.AppendUnsigned(field.min_length);
+      }
+      break;
+    case ToolFieldType::kBoolean:
+      writer.Append("\"type\":\"boolean\"");
+      break;
+    case ToolFieldType::kUnsignedInteger:
+      writer.Append("\"type\":\"integer\",\"minimum\":0");
+      break;
+    case ToolFieldType::kStringArray:
+      writer.Append("\"type\":\"array\",\"items\":{\"type\":\"string\"}");
+      if (field.min_length != 0) {
+        writer.Append(",\"minItems\":");
+        writer.AppendUnsigned(field.min_length);
+      }
+      break;
+  }
+  writer.Append(",\"description\":\"");
+  writer.AppendEscaped(field.description);
+  writer.Append("\"}");
+}
+
+template <typename Descriptor>
+constexpr void WriteToolDefinition(const Descriptor& tool, StaticJsonWriter& writer) {
+  writer.Append("{\"name\":\"");
+  writer.AppendEscaped(tool.name);
+  writer.Append("\",\"description\":\"");
+  writer.AppendEscaped(tool.description);
+  writer.Append("\",\"inputSchema\":{\"type\":\"object\",\"properties\":{");
+
+  bool first = true;
+  for (const auto& field : tool.fields) {
+    if (!first) {
+      writer.Append(",");
+    }
+    first = false;
+    WriteFieldSchema(field, writer);
+  }
+  writer.Append("}");
+
+  bool has_required = false;
+  for (const auto& field : tool.fields) {
+    if (!field.required) {
+      continue;
+    }
+    writer.Append(has_required ? ",\"" : ",\"required\":[\"");
+    writer.AppendEscaped(field.name);
+    writer.Append("\"");
+    has_required = true;
+  }
+  if (has_required) {
+    writer.Append("]");
+  }
+
+  writer.Append(",\"additionalProperties\":false}}");
+}
+
+template <const auto&... Tools>
+constexpr void WriteToolList(StaticJsonWriter& writer) {
+  writer.Append("{\"tools\":[");
+  bool first = true;
+  ((writer.Append(first ? "" : ","), first = false, WriteToolDefinition(Tools, writer)), ...);
+  writer.Append("]}");
+}
+
+template <const auto&... Tools>
+constexpr void WriteToolNames(StaticJsonWriter& writer) {
+  writer.Append("[");
+  bool first = true;
+  ((writer.Append(first ? "\"" : ",\""), first = false, writer.AppendEscaped(Tools.name), writer.Append("\"")), ...);
+  writer.Append("]");
+}
+
+}  // namespace detail
+
+template <const auto&... Tools>
+struct ToolCatalog {
+  static constexpr auto kWriteList = [](StaticJsonWriter& writer) {
+    detail::WriteToolList<Tools...>(writer);
+  };
+  static constexpr auto kWriteNames = [](StaticJsonWriter& writer) {
+    detail::WriteToolNames<Tools...>(writer);
+  };
+
+  static constexpr auto kToolsListJson = RenderStaticJson<MeasureStaticJson(kWriteList)>(kWriteList);
+  static constexpr auto kToolNamesJson = RenderStaticJson<MeasureStaticJson(kWriteNames)>(kWriteNames);
+
+  static constexpr std::string_view ToolsListJson() {
+    return kToolsListJson.View();
+  }
+
+  static constexpr std::string_view ToolNamesJson() {
+    return kToolNamesJson.View();
+  }
+};
+
+template <typename Arguments>
+std::string DescribeFieldRequirement(const ToolField<Arguments>& field) {
+  std::string message = "Invalid params: " + std::string(field.name);
+  switch (field.type) {
+    case ToolFieldType::kString:
+      message += field.min_length != 0 ? " must be a non-empty string" : " must be a string";
+      break;
+    case ToolFieldType::kBoolean:
+      message += " must be a boolean";
+      break;
+    case ToolFieldType::kUnsignedInteger:
+      message += " must be a non-negative integer";
+      break;
+    case ToolFieldType::kStringArray:
+      message += field.min_length != 0 ? " must be a non-empty array of strings" : " must be an array of strings";
+      break;
+  }
+  return message;
+}
+
+template <typename Arguments>
+bool DecodeToolField(const ToolField<Arguments>& field, std::string_view raw_value, Arguments* out_arguments) {
+  switch (field.type) {
+    case ToolFieldType::kString: {
+      std::string& target = out_arguments->*field.string_member;
+      return json::ParseStringValue(raw_value, &target) && target.size() >= field.min_length;
+    }
+    case ToolFieldType::kBoolean:
+      return json::ParseBooleanValue(raw_value, &(out_arguments->*field.boolean_member));
+    case ToolFieldType::kUnsignedInteger:
+      return json::ParseUnsignedValue(raw_value, &(out_arguments->*field.unsigned_member));
+    case ToolFieldType::kStringArray: {
+      std::vector<std::string>& target = out_arguments->*field.string_array_member;
+      return json::ParseStringArrayValue(raw_value, &target) && target.size() >= field.min_length;
+    }
+  }
+  return false;
+}
+
+template <typename Arguments, std::size_t FieldCount>
+bool DecodeToolArguments(
+    const ToolDescriptor<Arguments, FieldCount>& tool,
+    std::string_view arguments_json,
+    Arguments* out_arguments,
+    std::string* error_message) {
+  static_assert(FieldCount <= 64, "tool descriptors support at most 64 fields");
+
+  std::uint64_t seen_fields = 0;
+  json::ObjectFieldCursor cursor(arguments_json);
+  std::string_view key;
+  std::string_view raw_value;
+  while (cursor.Next(&key, &raw_value)) {
+    for (std::size_t index = 0; index < FieldCount; ++index) {
+      const ToolField<Arguments>& field = tool.fields[index];
+      if (field.name != key) {
+        continue;
+      }
+      if (!DecodeToolField(field, raw_value, out_arguments)) {
+        if (error_message != nullptr) {
+          *error_message = DescribeFieldRequirement(field);
+        }
+        return false;
+      }
+      seen_fields |= (std::uint64_t{1} << index);
+      break;
+    }
+  }
+
+  if (cursor.Failed()) {
+    if (error_message != nullptr) {
+      *error_message = "Invalid params: arguments must be an object";
+    }
+    return false;
+  }
+
+  for (std::size_t index = 0; index < FieldCount; ++index) {
+    const ToolField<Arguments>& field = tool.fields[index];
+    if (field.required && (seen_fields & (std::uint64_t{1} << index)) == 0) {
+      if (error_message != nullptr) {
+        *error_message = DescribeFieldRequirement(field);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dbgx/mcp/tool_schema.hpp"
+
+namespace dbgx::mcp {
+
+struct EvalToolArguments {
+  std::string command;
+  bool async = false;
+  std::uint64_t max_output_bytes = 0;
+  std::uint64_t head_lines = 0;
+  std::uint64_t tail_lines = 0;
+  std::vector<std::string> include;
+  std::vector<std::string> exclude;
+  std::string include_regex;
+  std::string exclude_regex;
+  std::uint64_t context_lines = 0;
+  bool structured = false;
+  std::uint64_t timeout_ms = 0;
+};
+
+inline constexpr ToolDescriptor<EvalToolArguments, 12> kEvalTool{
+    "windbg.eval",
+    "Execute one WinDbg command at a time and return text output; clients MUST run calls serially and wait for "
+    "each call to finish before sending the next",
+    {
+        StringField(
+            "command",
+            &EvalToolArguments::command,
+            "WinDbg command to execute; send commands one by one and wait for completion before the next command",
+            true,
+            1),
+        BooleanField(
+            "async",
+            &EvalToolArguments::async,
+            "Start the command as a background job and return its jobId immediately; poll it with "
+            "windbg.job_status and windbg.job_output"),
+        UnsignedField(
+            "max_output_bytes",
+            &EvalToolArguments::max_output_bytes,
+            "Keep at most this many output bytes (default and maximum 33554432); output beyond it is dropped "
+            "while the command runs"),
+        UnsignedField(
+            "head_lines",
+            &EvalToolArguments::head_lines,
+            "Keep only the first N lines; without tail_lines the command is interrupted once they are captured"),
+        UnsignedField("tail_lines", &EvalToolArguments::tail_lines, "Keep only the last N lines"),
+        StringArrayField(
+            "include",
+            &EvalToolArguments::include,
+            "Return only lines containing any of these substrings",
+            false),
+        StringArrayField(
+            "exclude",
+            &EvalToolArguments::exclude,
+            "Drop lines containing any of these substrings",
+            false),
+        StringField(
+            "include_regex",
+            &EvalToolArguments::include_regex,
+            "Also return lines matching this ECMAScript regex",
+            false),
+        StringField(
+            "exclude_regex",
+            &EvalToolArguments::exclude_regex,
+            "Drop lines matching this ECMAScript regex",
+            false),
+        UnsignedField(
+            "context_lines",
+            &EvalToolArguments::context_lines,
+            "Lines of context to keep before and after each matching line"),
+        BooleanField(
+            "structured",
+            &EvalToolArguments::structured,
+            "Also parse db/dw/dd/dq/dp, lm, k and r output into structuredContent.parsed (null for other "
+            "commands)"),
+        UnsignedField(
+            "timeout_ms",
+            &EvalToolArguments::timeout_ms,
+            "Interrupt the command after this many milliseconds and return its partial output with "
+            "structuredContent.timedOut (default: the server timeout; background jobs have none by default)"),
+    },
+};
+
+struct EvalBatchToolArguments {
+  std::vector<std::string> commands;
+  bool stop_on_error = false;
+};
+
+inline constexpr ToolDescriptor<EvalBatchToolArguments, 2> kEvalBatchTool{
+    "windbg.eval_batch",
+    "Execute an ordered list of WinDbg commands back-to-back in one call and return one text content item per "
+    "executed command, with per-command success flags and timings in structuredContent",
+    {
+        StringArrayField(
+            "commands",
+            &EvalBatchToolArguments::commands,
+            "WinDbg commands to execute in order",
+            true,
+            1),
+        BooleanField(
+            "stop_on_error",
+            &EvalBatchToolArguments::stop_on_error,
+            "Stop after the first failing command; remaining commands are reported as skipped"),
+    },
+};
+
+struct JobToolArguments {
+  std::string job_id;
+};
+
+inline constexpr ToolDescriptor<JobToolArguments, 1> kJobStatusTool{
+    "windbg.job_status",
+    "Report the state, captured output size and duration of a background job started by windbg.eval with async",
+    {
+        StringField("job_id", &JobToolArguments::job_id, "Job id returned by windbg.eval", true, 1),
+    },
+};
+
+inline constexpr ToolDescriptor<JobToolArguments, 1> kJobCancelTool{
+    "windbg.job_cancel",
+    "Request cancellation of a running background job; poll windbg.job_status for the final state",
+    {
+        StringField("job_id", &JobToolArguments::job_id, "Job id returned by windbg.eval", true, 1),
+    },
+};
+
+struct JobOutputToolArguments {
+  std::string job_id;
+  std::uint64_t offset = 0;
+  std::uint64_t max_bytes = 0;
+};
+
+inline constexpr ToolDescriptor<JobOutputToolArguments, 3> kJobOutputTool{
+    "windbg.job_output",
+    "Read captured output of a background job starting at a byte offset; pass nextOffset from the previous read "
+    "to fetch only new output",
+    {
+        StringField("job_id", &JobOutputToolArguments::job_id, "Job id returned by windbg.eval", true, 1),
+        UnsignedField("offset", &JobOutputToolArguments::offset, "Byte offset to read from (default 0)"),
+        UnsignedField(
+            "max_bytes",
+            &JobOutputToolArguments::max_bytes,
+            "Maximum bytes to return (default 65536, capped at 1048576)"),
+    },
+};
+
+struct ReadMemoryToolArguments {
+  std::string address;
+  std::uint64_t size = 0;
+  std::string encoding;
+};
+
+inline constexpr ToolDescriptor<ReadMemoryToolArguments, 3> kReadMemoryTool{
+    "windbg.read_memory",
+    "Read raw bytes of target virtual memory without command text formatting; unreadable pages are "
+    "zero-filled and listed as holes in structuredContent",
+    {
+        StringField(
+            "address",
+            &ReadMemoryToolArguments::address,
+            "Start address in hex, such as 0x7ff64a1b0000 or 00007ff6`4a1b0000",
+            true,
+            1),
+        UnsignedField(
+            "size",
+            &ReadMemoryToolArguments::size,
+            "Number of bytes to read (1 to 16777216)",
+            true),
+        StringField(
+            "encoding",
+            &ReadMemoryToolArguments::encoding,
+            "blob (default) returns an embedded application/octet-stream resource; base64 returns base64 text",
+            false),
+    },
+};
+
+struct ResolveAddressesToolArguments {
+  std::vector<std::string> addresses;
+};
+
+inline constexpr ToolDescriptor<ResolveAddressesToolArguments, 1> kResolveAddressesTool{
+    "windbg.resolve_addresses",
+    "Resolve many addresses in one call to their module, module offset and nearest symbol, served from a "
+    "cached index of loaded modules",
+    {
+        StringArrayField(
+            "addresses",
+            &ResolveAddressesToolArguments::addresses,
+            "Addresses in hex, such as 0x7ffa1c2d3e4e or 00007ffa`1c2d3e4e (at most 4096)",
+            true,
+            1),
+    },
+};
+
+using BuiltinToolCatalog = ToolCatalog<
+    kEvalTool,
+    kEvalBatchTool,
+    kJobStatusTool,
+    kJobOutputTool,
+    kJobCancelTool,
+    kReadMemoryTool,
+    kResolveAddressesTool>;
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace dbgx::windbg {
+
+// ASCII-only helpers for command text and debugger output; locale-independent on purpose.
+
+inline bool IsSpace(char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+inline char ToLowerAscii(char ch) {
+  return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+inline bool EqualsIgnoreCase(std::string_view left, std::string_view right) {
+  if (left.size() != right.size()) {
+    return false;
+  }
+  for (std::size_t index = 0; index < left.size(); ++index) {
+    if (ToLowerAscii(left[index]) != ToLowerAscii(right[index])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace dbgx::windbg
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "dbgx/windbg/segmented_buffer.hpp"
+
+namespace dbgx::windbg {
+
+// Zero means "no limit" for every field.
+struct OutputLimits {
+  std::size_t max_output_bytes = 0;
+  std::size_t head_lines = 0;
+  std::size_t tail_lines = 0;
+  // Total captured bytes after which the command is interrupted even though a tail is still wanted.
+  std::uint64_t interrupt_after_bytes = 0;
+
+  bool Enabled() const;
+};
+
+// Capture sink whose memory is O(max_output_bytes) regardless of how much the command prints. It keeps
+// a head in pooled segments, a ring buffer for the tail and a count of the bytes dropped in between.
+// Without tail_lines the byte budget goes to the head; with both, it is split evenly.
+class BoundedOutputBuffer {
+ public:
+  explicit BoundedOutputBuffer(OutputLimits limits, SegmentPool* pool = &SegmentPool::Shared());
+
+  // Returns false once nothing more can be kept (head full and no tail wanted) or interrupt_after_bytes
+  // is exceeded; the caller should then interrupt the command.
+  bool Append(std::string_view text);
+  std::uint64_t TotalBytes() const;
+
+  // Returns head, an omission marker when bytes were dropped, and tail. Leaves the buffer empty.
+  std::string Finish(std::uint64_t* out_dropped_bytes);
+
+ private:
+  void AppendTail(std::string_view text);
+  std::string TakeTail();
+
+  OutputLimits limits_;
+  std::size_t head_budget_ = 0;
+  std::size_t tail_budget_ = 0;
+  SegmentedBuffer head_;
+  bool head_ends_line_ = true;
+  std::size_t head_line_count_ = 0;
+  bool head_full_ = false;
+  std::string tail_ring_;
+  std::size_t tail_pos_ = 0;
+  std::uint64_t total_bytes_ = 0;
+};
+
+// Applies limits to an already captured output, for executors that cannot bound their capture.
+std::string LimitOutput(std::string_view output, const OutputLimits& limits, std::uint64_t* out_dropped_bytes);
+
+}  // namespace dbgx::windbg
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "dbgx/windbg/command_executor.hpp"
+
+namespace dbgx::windbg {
+
+enum class CommandCachePolicy {
+  // Output depends only on debugger state, so it can be reused until the state generation changes.
+  kCacheable,
+  // Changes debugger state (execution, context, memory or symbols), or is not known to be read-only;
+  // invalidates every cached result.
+  kMutating,
+  // Read-only, but its output depends on more than debugger state; always executed and never cached.
+  kUncached,
+};
+
+// Trims the command and collapses whitespace runs outside double quotes.
+std::string NormalizeCommand(std::string_view command);
+
+// Classifies a normalized command with the built-in table; commands not in it are mutating. Commands joined
+// with ';' are mutating if any part is, and cacheable only if every part is. Memory display and disassembly commands without a start
+// address continue from the previous display, so they are never cached.
+CommandCachePolicy ClassifyCommand(std::string_view normalized_command);
+
+struct CommandCacheOptions {
+  std::size_t max_entries = 256;
+  std::size_t max_output_bytes = 16 * 1024 * 1024;
+};
+
+struct CommandCacheStats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t invalidations = 0;
+  std::uint64_t saved_us = 0;
+};
+
+// Serves repeated read-only commands from memory while the debugger state is unchanged. The state
+// generation combines the inner executor's StateGeneration with a counter bumped by mutating commands.
+// A display served from the cache does not move the engine's display position, so it is run for real
+// before the next command that continues that display.
+class CachingCommandExecutor final : public IWinDbgCommandExecutor {
+ public:
+  explicit CachingCommandExecutor(IWinDbgCommandExecutor* inner, CommandCacheOptions options = {});
+
+  CommandExecutionResult Execute(const std::string& command) override;
+  std::vector<CommandExecutionResult> ExecuteBatch(
+      const std::vector<std::string>& commands,
+      bool stop_on_error) override;
+  CommandExecutionResult ExecuteWithContext(const std::string& command, CommandExecutionContext* context) override;
+  std::uint64_t StateGeneration() override;
+  bool OpenSession(std::string* error_message) override;
+  void CloseSession() override;
+
+  CommandCacheStats Stats() const;
+
+ private:
+  struct Entry {
+    std::string key;
+    CommandExecutionResult result;
+  };
+
+  struct Generation {
+    std::uint64_t engine = 0;
+    std::uint64_t local = 0;
+    bool operator==(const Generation&) const = default;
+  };
+
+  Generation CurrentGeneration();
+  bool TryGetCached(const std::string& key, Generation generation, CommandExecutionResult* out_result);
+  void Store(const std::string& key, Generation generation, const CommandExecutionResult& result);
+  void NoteDisplayHit(const std::string& command, std::string_view key);
+  bool NeedsDisplayReplay(std::string_view key);
+  // Runs the display replays key continues, and forgets those it supersedes.
+  void PrepareDisplays(std::string_view key);
+  void NoteMutation();
+  void InvalidateLocked();
+
+  IWinDbgCommandExecutor* inner_;
+  CommandCacheOptions options_;
+  mutable std::mutex mutex_;
+  Generation generation_;
+  std::uint64_t local_generation_ = 0;
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  std::size_t cached_bytes_ = 0;
+  CommandCacheStats stats_;
+  // Per display family (memory, disassembly): the last display served from the cache since the engine
+  // last ran one.
+  std::array<std::string, 2> display_replays_;
+};
+
+}  // namespace dbgx::windbg
@@ -1,6 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "dbgx/windbg/bounded_output.hpp"
+#include "dbgx/windbg/line_filter.hpp"
 
 namespace dbgx::windbg {
 
@@ -8,12 +20,89 @@ struct CommandExecutionResult {
   bool success = false;
   std::string output;
   std::string error_message;
+  std::uint64_t duration_us = 0;
+  bool cancelled = false;
+  // Set together with cancelled when the command was interrupted because its deadline passed.
+  bool timed_out = false;
+  // Bytes removed from output by the context's OutputLimits.
+  std::uint64_t dropped_output_bytes = 0;
+};
+
+// Shared between a running command and the threads that observe or cancel it.
+class CommandExecutionContext {
+ public:
+  // Marks the command cancelled and runs the executor's interrupt handler, if one is installed.
+  void RequestCancel();
+  bool CancelRequested() const;
+  // Marks the command timed out, then cancels it as RequestCancel does.
+  void RequestTimeout();
+  bool TimedOut() const;
+
+  // Installed by executors that can interrupt the engine while a command runs.
+  void SetInterruptHandler(std::function<void()> handler);
+  void ClearInterruptHandler();
+
+  // Called by executors as output is captured; counts the bytes and forwards the text to the observer.
+  void AppendOutput(std::string_view text);
+  std::uint64_t OutputBytes() const;
+
+  // Set before the command starts; invoked on the executing thread for each piece of captured output.
+  void SetOutputObserver(std::function<void(std::string_view text)> observer);
+  // The installed observer, so an executor wrapping another can chain its own in front and restore it.
+  const std::function<void(std::string_view text)>& OutputObserver() const;
+
+  // Set before the command starts; executors bound the returned output accordingly.
+  void SetOutputLimits(OutputLimits limits);
+  OutputLimits Limits() const;
+
+  // Optional; applied to captured output before the limits, so limits count only kept lines.
+  void SetLineFilter(std::shared_ptr<const LineFilter> filter);
+  std::shared_ptr<const LineFilter> Filter() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::function<void()> interrupt_handler_;
+  std::function<void(std::string_view text)> output_observer_;
+  OutputLimits output_limits_;
+  std::shared_ptr<const LineFilter> line_filter_;
+  std::atomic<bool> cancel_requested_{false};
+  std::atomic<bool> timed_out_{false};
+  std::atomic<std::uint64_t> output_bytes_{0};
 };
 
 class IWinDbgCommandExecutor {
  public:
   virtual ~IWinDbgCommandExecutor() = default;
   virtual CommandExecutionResult Execute(const std::string& command) = 0;
+
+  // Runs commands back-to-back and returns one result per executed command. With stop_on_error the
+  // batch ends after the first failure, so the result list may be shorter than the command list.
+  virtual std::vector<CommandExecutionResult> ExecuteBatch(
+      const std::vector<std::string>& commands,
+      bool stop_on_error);
+
+  // Executes one command while reporting captured output to context and honouring its cancellation.
+  // The default implementation cannot interrupt Execute and only checks for cancellation up front.
+  virtual CommandExecutionResult ExecuteWithContext(const std::string& command, CommandExecutionContext* context);
+
+  // Changes whenever debugger state that command output depends on may have changed (execution, current
+  // context, loaded modules). Executors that cannot observe the engine return a constant 0.
+  virtual std::uint64_t StateGeneration();
+
+  // Optional session lifecycle: OpenSession sets up engine state that later commands reuse, CloseSession
+  // releases it. Both run on the thread that executes commands. Without an open session every command
+  // sets itself up; the defaults do nothing.
+  virtual bool OpenSession(std::string* error_message);
+  virtual void CloseSession();
 };
 
+CommandExecutionResult MakeCancelledResult(std::string partial_output = std::string());
+
+// For executors that stand in for a slow engine: blocks until deadline passes or context is cancelled, and
+// returns false if it was cancelled. A null context just waits; time_point::max() waits for cancellation.
+bool WaitUntilDeadlineOrCancelled(CommandExecutionContext* context, std::chrono::steady_clock::time_point deadline);
+
+// Applies the context's line filter and output limits to output that was captured without them.
+void ShapeCapturedOutput(const CommandExecutionContext& context, CommandExecutionResult* result);
+
 }  // namespace dbgx::windbg
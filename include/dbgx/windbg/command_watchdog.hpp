@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
+#include "dbgx/windbg/command_executor.hpp"
+
+namespace dbgx::windbg {
+
+// One thread that times out commands past their deadline through CommandExecutionContext::RequestTimeout,
+// so it works with any executor that honours cancellation.
+class CommandWatchdog {
+ public:
+  using Token = std::uint64_t;
+
+  CommandWatchdog();
+  ~CommandWatchdog();
+
+  CommandWatchdog(const CommandWatchdog&) = delete;
+  CommandWatchdog& operator=(const CommandWatchdog&) = delete;
+
+  // The context is timed out once deadline passes unless Disarm is called with the returned token first.
+  Token Arm(CommandExecutionContext* context, std::chrono::steady_clock::time_point deadline);
+  // Once this returns the watchdog no longer touches the context, even if its deadline was firing.
+  void Disarm(Token token);
+
+  // Commands timed out so far.
+  std::uint64_t ExpiredCount() const;
+
+ private:
+  using DeadlineKey = std::pair<std::chrono::steady_clock::time_point, Token>;
+
+  void Run();
+
+  mutable std::mutex mutex_;
+  std::condition_variable changed_;
+  std::condition_variable fired_;
+  bool stopping_ = false;
+  Token next_token_ = 1;
+  // Token whose context is being timed out outside the lock, or zero.
+  Token firing_ = 0;
+  std::uint64_t expired_count_ = 0;
+  // Ordered by deadline; deadline_by_token_ finds an entry again on Disarm.
+  std::map<DeadlineKey, CommandExecutionContext*> armed_;
+  std::unordered_map<Token, std::chrono::steady_clock::time_point> deadline_by_token_;
+  std::thread thread_;
+};
+
+}  // namespace dbgx::windbg
@@ -1,12 +1,58 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
 #include "dbgx/windbg/command_executor.hpp"
 
+struct IDebugClient;
+
 namespace dbgx::windbg {
 
 class DbgEngCommandExecutor final : public IWinDbgCommandExecutor {
  public:
+  DbgEngCommandExecutor();
+  ~DbgEngCommandExecutor() override;
+
   CommandExecutionResult Execute(const std::string& command) override;
+  std::vector<CommandExecutionResult> ExecuteBatch(
+      const std::vector<std::string>& commands,
+      bool stop_on_error) override;
+  CommandExecutionResult ExecuteWithContext(const std::string& command, CommandExecutionContext* context) override;
+  // Derived from a snapshot of execution status, current process/thread, instruction pointer and module
+  // counts; the generation advances whenever the snapshot differs from the previous one.
+  std::uint64_t StateGeneration() override;
+  // Keeps one client with the capture callbacks installed until CloseSession. Commands on the opening thread
+  // reuse it; calls from any other thread still create a client of their own.
+  bool OpenSession(std::string* error_message) override;
+  void CloseSession() override;
+  // The open session's client when called on the session thread, otherwise null. The pointer is not
+  // add-ref'd and stays valid until CloseSession.
+  IDebugClient* SessionClient() const;
+
+ private:
+  struct Session;
+
+  Session* ActiveSession() const;
+
+  struct EngineStateSnapshot {
+    unsigned long execution_status = 0;
+    unsigned long process_id = 0;
+    unsigned long thread_id = 0;
+    std::uint64_t instruction_offset = 0;
+    unsigned long loaded_modules = 0;
+    unsigned long unloaded_modules = 0;
+    bool operator==(const EngineStateSnapshot&) const = default;
+  };
+
+  std::unique_ptr<Session> session_;
+  std::thread::id session_thread_;
+  std::mutex state_mutex_;
+  EngineStateSnapshot last_state_;
+  std::uint64_t state_generation_ = 0;
 };
 
 }  // namespace dbgx::windbg
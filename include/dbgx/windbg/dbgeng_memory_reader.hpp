@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include "dbgx/windbg/memory_reader.hpp"
+
+namespace dbgx::windbg {
+
+class DbgEngCommandExecutor;
+
+// Reads through the engine's open session client when called on its thread, so a chunked read does not
+// create a client per chunk; elsewhere each call creates its own.
+class DbgEngMemoryReader final : public IWinDbgMemoryReader {
+ public:
+  explicit DbgEngMemoryReader(const DbgEngCommandExecutor* engine = nullptr) : engine_(engine) {}
+
+  bool ReadVirtual(std::uint64_t address, void* buffer, std::uint32_t size, std::uint32_t* bytes_read) override;
+
+ private:
+  const DbgEngCommandExecutor* engine_;
+};
+
+}  // namespace dbgx::windbg
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#include "dbgx/windbg/symbol_resolver.hpp"
+
+namespace dbgx::windbg {
+
+class DbgEngCommandExecutor;
+
+// Queries symbols through the engine's open session client when called on its thread; elsewhere each call
+// creates its own client.
+class DbgEngSymbolProvider final : public IWinDbgSymbolProvider {
+ public:
+  explicit DbgEngSymbolProvider(const DbgEngCommandExecutor* engine = nullptr) : engine_(engine) {}
+
+  bool ListModules(std::vector<ModuleRange>* out_modules, std::string* error_message) override;
+  bool GetNameByOffset(std::uint64_t address, std::string* out_name, std::uint64_t* out_displacement) override;
+  // Derived from a hash of every loaded module's base, size, timestamp, checksum and symbol type, so module
+  // loads, unloads and symbol reloads all advance it.
+  std::uint64_t SymbolGeneration() override;
+
+ private:
+  const DbgEngCommandExecutor* engine_;
+  std::mutex generation_mutex_;
+  std::uint64_t last_module_hash_ = 0;
+  std::uint64_t generation_ = 0;
+};
+
+}  // namespace dbgx::windbg
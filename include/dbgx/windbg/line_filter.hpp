@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dbgx::windbg {
+
+struct LineFilterOptions {
+  std::vector<std::string> include;
+  std::vector<std::string> exclude;
+  std::string include_regex;
+  std::string exclude_regex;
+  std::size_t context_lines = 0;
+
+  bool Enabled() const;
+};
+
+// Same result as haystack.find(needle); uses an SSE2 first/last-byte scan where available.
+std::size_t FindSubstring(std::string_view haystack, std::string_view needle);
+
+// Compiled, immutable line predicate shared by every stream that applies it.
+class LineFilter {
+ public:
+  // std::regex recurses once per character, so regex patterns see at most this many bytes of a line.
+  static constexpr std::size_t kMaxRegexLineBytes = 2048;
+
+  static bool Compile(LineFilterOptions options, LineFilter* out_filter, std::string* error_message);
+
+  // A line matches when it satisfies any include pattern (or none are given) and no exclude pattern. If a regex
+  // match throws, the line does not match and error_message (when given) receives the reason.
+  bool Matches(std::string_view line, std::string* error_message = nullptr) const;
+  std::size_t ContextLines() const;
+
+ private:
+  LineFilterOptions options_;
+  std::optional<std::regex> include_regex_;
+  std::optional<std::regex> exclude_regex_;
+};
+
+// Applies a LineFilter to output arriving in arbitrary chunks, grep-style: matching lines plus up to
+// context_lines lines around them, with "--" between non-adjacent groups.
+class StreamingLineFilter {
+ public:
+  explicit StreamingLineFilter(const LineFilter* filter);
+
+  // Appends the kept lines completed by chunk to out; a trailing partial line is held until later.
+  void Feed(std::string_view chunk, std::string* out);
+  void Finish(std::string* out);
+
+  std::uint64_t MatchedLines() const;
+  // Set by the first line whose match failed; no lines are kept after it.
+  const std::string& Error() const;
+
+ private:
+  void ProcessLine(std::string_view line, std::string* out);
+  void EmitLine(std::string_view line, std::string* out);
+
+  const LineFilter* filter_;
+  std::string partial_;
+  std::deque<std::string> before_;
+  std::size_t after_remaining_ = 0;
+  std::uint64_t line_number_ = 0;
+  std::uint64_t last_emitted_line_ = 0;
+  bool emitted_any_ = false;
+  std::uint64_t matched_lines_ = 0;
+  std::string error_;
+};
+
+std::string FilterLines(std::string_view output, const LineFilter& filter, std::string* error_message = nullptr);
+
+}  // namespace dbgx::windbg
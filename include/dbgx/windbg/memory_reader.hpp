@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dbgx/windbg/command_executor.hpp"
+
+namespace dbgx::windbg {
+
+// Raw access to target virtual memory, bypassing command text formatting.
+class IWinDbgMemoryReader {
+ public:
+  virtual ~IWinDbgMemoryReader() = default;
+
+  // Same contract as IDebugDataSpaces::ReadVirtual: reads the readable prefix of [address, address + size)
+  // and returns false when not even the first byte is readable.
+  virtual bool ReadVirtual(std::uint64_t address, void* buffer, std::uint32_t size, std::uint32_t* bytes_read) = 0;
+};
+
+struct MemoryHole {
+  std::uint64_t address = 0;
+  std::uint64_t size = 0;
+};
+
+struct MemoryRangeRead {
+  // Always the requested size; bytes inside holes are zero.
+  std::string bytes;
+  std::vector<MemoryHole> holes;
+  std::uint64_t bytes_read = 0;
+  bool cancelled = false;
+};
+
+struct MemoryRangeOptions {
+  std::uint32_t chunk_bytes = 64 * 1024;
+  // Granularity at which a failed chunk is retried, so holes are reported per unreadable page.
+  std::uint32_t page_bytes = 4 * 1024;
+};
+
+// Reads [address, address + size) in page-aligned chunks. Unreadable pages become holes instead of failing
+// the whole read; context, when given, is checked for cancellation between chunks.
+bool ReadMemoryRange(
+    IWinDbgMemoryReader* reader,
+    std::uint64_t address,
+    std::size_t size,
+    MemoryRangeRead* out_read,
+    std::string* error_message,
+    const CommandExecutionContext* context = nullptr,
+    MemoryRangeOptions options = {});
+
+}  // namespace dbgx::windbg
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace dbgx::windbg {
+
+enum class OutputFormat {
+  kNone,
+  kMemory,
+  kModules,
+  kStack,
+  kRegisters,
+};
+
+std::string_view OutputFormatName(OutputFormat format);
+
+struct OutputParserSelection {
+  OutputFormat format = OutputFormat::kNone;
+  // Element size for memory dumps; 0 means pointer-sized, taken from the address width.
+  unsigned unit_size = 0;
+};
+
+// Picks the parser for a command from its first token (db/dw/dd/dq/dp, lm, k and r with their option letters).
+OutputParserSelection SelectOutputParser(std::string_view command);
+
+struct MemoryRow {
+  std::uint64_t address = 0;
+  std::size_t first_value = 0;
+  std::size_t value_count = 0;
+  bool unreadable = false;
+};
+
+struct MemoryDump {
+  unsigned unit_size = 0;
+  std::vector<MemoryRow> rows;
+  std::vector<std::uint64_t> values;
+};
+
+struct ModuleEntry {
+  std::uint64_t start = 0;
+  std::uint64_t end = 0;
+  std::string_view name;
+  std::string_view symbol_status;
+  std::string_view image_path;
+  bool unloaded = false;
+};
+
+struct StackFrame {
+  bool has_number = false;
+  std::uint32_t number = 0;
+  bool is_inline = false;
+  std::uint64_t child_sp = 0;
+  std::uint64_t return_address = 0;
+  std::array<std::uint64_t, 4> args{};
+  std::size_t arg_count = 0;
+  std::string_view call_site;
+  std::string_view module;
+  std::string_view function;
+  bool has_offset = false;
+  std::uint64_t offset = 0;
+  std::string_view source;
+};
+
+struct RegisterValue {
+  std::string_view name;
+  std::uint64_t value = 0;
+};
+
+// Views point into the parsed output text, which must outlive the result.
+struct ParsedOutput {
+  OutputFormat format = OutputFormat::kNone;
+  MemoryDump memory;
+  std::vector<ModuleEntry> modules;
+  std::vector<StackFrame> frames;
+  std::vector<RegisterValue> registers;
+  std::size_t skipped_lines = 0;
+  // Set when parsing stopped at max_entries rows, modules, frames or registers.
+  bool truncated = false;
+};
+
+// Returns false when no parser applies; lines a parser does not recognize are counted in skipped_lines.
+// A max_entries of 0 means no limit.
+bool ParseOutput(
+    OutputParserSelection selection,
+    std::string_view output,
+    ParsedOutput* parsed,
+    std::size_t max_entries = 0);
+bool ParseCommandOutput(
+    std::string_view command,
+    std::string_view output,
+    ParsedOutput* parsed,
+    std::size_t max_entries = 0);
+
+}  // namespace dbgx::windbg
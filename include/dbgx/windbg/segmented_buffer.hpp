@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dbgx::windbg {
+
+// Free list of fixed-size segments shared by capture buffers, so steady-state capture allocates nothing.
+class SegmentPool {
+ public:
+  explicit SegmentPool(std::size_t segment_bytes = 64 * 1024, std::size_t max_free_segments = 64);
+
+  SegmentPool(const SegmentPool&) = delete;
+  SegmentPool& operator=(const SegmentPool&) = delete;
+
+  // Process-wide pool with the default sizes.
+  static SegmentPool& Shared();
+
+  std::unique_ptr<char[]> Acquire();
+  // Keeps up to max_free_segments for reuse and frees the rest.
+  void Release(std::unique_ptr<char[]> segment);
+
+  std::size_t SegmentBytes() const;
+  std::size_t FreeCount() const;
+
+ private:
+  std::size_t segment_bytes_;
+  std::size_t max_free_segments_;
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<char[]>> free_;
+};
+
+// Append-only rope of pooled segments. Appends never move captured bytes; the pool is only touched when a
+// segment fills. Not synchronized: one thread appends, and ownership moves with the buffer.
+class SegmentedBuffer {
+ public:
+  explicit SegmentedBuffer(SegmentPool* pool = &SegmentPool::Shared());
+  ~SegmentedBuffer();
+
+  SegmentedBuffer(SegmentedBuffer&& other) noexcept;
+  SegmentedBuffer& operator=(SegmentedBuffer&& other) noexcept;
+  SegmentedBuffer(const SegmentedBuffer&) = delete;
+  SegmentedBuffer& operator=(const SegmentedBuffer&) = delete;
+
+  void Append(std::string_view text);
+  std::size_t Size() const;
+  bool Empty() const;
+
+  // Filled part of each segment in order, for scatter writes; valid until the buffer is next modified.
+  std::vector<std::string_view> Segments() const;
+  // Copies the contents with a single exact-size reservation.
+  void AppendTo(std::string* out) const;
+  std::string ToString() const;
+
+  // Returns every segment to the pool.
+  void Clear();
+
+ private:
+  struct Segment {
+    std::unique_ptr<char[]> data;
+    std::size_t size = 0;
+  };
+
+  SegmentPool* pool_;
+  std::vector<Segment> segments_;
+  std::size_t size_ = 0;
+};
+
+}  // namespace dbgx::windbg
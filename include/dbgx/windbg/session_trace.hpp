@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "dbgx/windbg/command_executor.hpp"
+
+namespace dbgx::windbg {
+
+// A session trace is an 8-byte magic followed by one record per executed command: a flags byte, the
+// command, error and output sizes, the duration in microseconds (all little-endian) and then the bytes.
+// Records are appended and flushed as commands finish, so a trace cut short by a crash stays readable.
+struct TraceRecord {
+  std::string_view command;
+  std::string_view output;
+  std::string_view error_message;
+  std::uint64_t duration_us = 0;
+  bool success = false;
+  bool cancelled = false;
+  bool timed_out = false;
+};
+
+class SessionTraceWriter {
+ public:
+  SessionTraceWriter() = default;
+  ~SessionTraceWriter();
+
+  SessionTraceWriter(const SessionTraceWriter&) = delete;
+  SessionTraceWriter& operator=(const SessionTraceWriter&) = delete;
+
+  // Truncates path and writes the trace header.
+  bool Open(const std::string& path, std::string* error_message);
+  // Safe to call from several threads; records are written whole and in call order.
+  bool Append(std::string_view command, const CommandExecutionResult& result);
+  void Close();
+
+  std::uint64_t RecordCount() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::ofstream file_;
+  std::uint64_t record_count_ = 0;
+};
+
+// Forwards every call to inner and appends each finished command to writer. Commands run with a context
+// are recorded with their raw captured output, before the context's filter and limits.
+class RecordingCommandExecutor final : public IWinDbgCommandExecutor {
+ public:
+  RecordingCommandExecutor(IWinDbgCommandExecutor* inner, SessionTraceWriter* writer);
+
+  CommandExecutionResult Execute(const std::string& command) override;
+  std::vector<CommandExecutionResult> ExecuteBatch(
+      const std::vector<std::string>& commands,
+      bool stop_on_error) override;
+  CommandExecutionResult ExecuteWithContext(const std::string& command, CommandExecutionContext* context) override;
+  std::uint64_t StateGeneration() override;
+  bool OpenSession(std::string* error_message) override;
+  void CloseSession() override;
+
+ private:
+  IWinDbgCommandExecutor* inner_;
+  SessionTraceWriter* writer_;
+};
+
+// A trace file mapped read-only into memory. Record fields point into the mapping, so loading copies no
+// output and the records stay valid for as long as the trace (or whatever it was moved into) lives.
+class SessionTrace {
+ public:
+  SessionTrace();
+  ~SessionTrace();
+
+  SessionTrace(SessionTrace&& other) noexcept;
+  SessionTrace& operator=(SessionTrace&& other) noexcept;
+  SessionTrace(const SessionTrace&) = delete;
+  SessionTrace& operator=(const SessionTrace&) = delete;
+
+  // A record cut short at the end of the file is ignored; any other malformed record fails the load.
+  static bool Load(const std::string& path, SessionTrace* out_trace, std::string* error_message);
+
+  const std::vector<TraceRecord>& Records() const;
+
+ private:
+  struct Mapping;
+
+  std::unique_ptr<Mapping> mapping_;
+  std::vector<TraceRecord> records_;
+};
+
+struct ReplayOptions {
+  // Holds each command for its recorded duration, or until it is cancelled.
+  bool original_timing = false;
+};
+
+// Serves a recorded session back. Each command string gets its recorded results in recording order and
+// starts over once they are used up, so a replay is deterministic however often it is repeated. Commands
+// that were never recorded fail.
+class ReplayExecutor final : public IWinDbgCommandExecutor {
+ public:
+  explicit ReplayExecutor(const SessionTrace* trace, ReplayOptions options = {});
+
+  CommandExecutionResult Execute(const std::string& command) override;
+  CommandExecutionResult ExecuteWithContext(const std::string& command, CommandExecutionContext* context) override;
+
+  std::uint64_t ReplayedCount() const;
+
+ private:
+  const TraceRecord* Next(std::string_view command);
+
+  ReplayOptions options_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string_view, std::vector<const TraceRecord*>> by_command_;
+  std::unordered_map<std::string_view, std::size_t> cursors_;
+  std::uint64_t replayed_count_ = 0;
+};
+
+}  // namespace dbgx::windbg
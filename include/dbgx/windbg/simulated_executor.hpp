@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dbgx/windbg/command_executor.hpp"
+
+namespace dbgx::windbg {
+
+enum class LatencyDistribution {
+  // Always median.
+  kFixed,
+  // Uniform in [median - spread, median + spread].
+  kUniform,
+  // Exponential with mean median.
+  kExponential,
+  // Log-normal with the given median and log-space standard deviation sigma; heavy-tailed like real
+  // debugger commands.
+  kLogNormal,
+};
+
+struct LatencyModel {
+  LatencyDistribution distribution = LatencyDistribution::kFixed;
+  std::chrono::microseconds median{0};
+  std::chrono::microseconds spread{0};
+  double sigma = 1.0;
+  // Upper bound on any drawn latency.
+  std::chrono::microseconds max{std::chrono::seconds(60)};
+};
+
+struct SimulationProfile {
+  LatencyModel latency;
+  // Output size is drawn uniformly from [min_output_bytes, max_output_bytes].
+  std::size_t min_output_bytes = 64;
+  std::size_t max_output_bytes = 64;
+  // 0 produces an all-zero memory dump, 1 fully random bytes; in between, each byte is random with this
+  // probability.
+  double output_entropy = 0.5;
+  // Probability that a command fails instead of producing output.
+  double failure_rate = 0.0;
+  std::string failure_message = "Simulated command failure";
+  // Ignores latency and runs until the command is cancelled, so it needs an execution context.
+  bool block_until_cancelled = false;
+};
+
+struct SimulationRule {
+  // Commands starting with this prefix use profile.
+  std::string command_prefix;
+  SimulationProfile profile;
+};
+
+struct SimulationOptions {
+  SimulationProfile defaults;
+  // Checked in order; the first matching rule wins.
+  std::vector<SimulationRule> rules;
+  // Draws are reproducible for a given seed and command order.
+  std::uint64_t seed = 1;
+};
+
+struct SimulationStats {
+  std::uint64_t executed = 0;
+  std::uint64_t failed = 0;
+  std::uint64_t cancelled = 0;
+  std::uint64_t output_bytes = 0;
+};
+
+// Stands in for the debugger engine under load: each command sleeps for a drawn latency while its output
+// is reported to the context in pieces, so queueing, progress, cancellation, timeouts and large outputs
+// can be exercised without a live target. Thread-safe.
+class SimulatedCommandExecutor final : public IWinDbgCommandExecutor {
+ public:
+  explicit SimulatedCommandExecutor(SimulationOptions options = {});
+
+  CommandExecutionResult Execute(const std::string& command) override;
+  CommandExecutionResult ExecuteWithContext(const std::string& command, CommandExecutionContext* context) override;
+
+  SimulationStats Stats() const;
+
+ private:
+  struct Draw {
+    std::chrono::microseconds latency{0};
+    std::size_t output_bytes = 0;
+    double output_entropy = 0.0;
+    std::uint64_t output_seed = 0;
+    bool fail = false;
+    bool block = false;
+    std::string failure_message;
+  };
+
+  const SimulationProfile& ProfileFor(std::string_view command) const;
+  Draw DrawFor(std::string_view command);
+  void Count(const CommandExecutionResult& result);
+
+  SimulationOptions options_;
+  mutable std::mutex mutex_;
+  std::mt19937_64 random_;
+  SimulationStats stats_;
+};
+
+// Debugger-style dump text of exactly size bytes; the same seed gives the same text.
+std::string GenerateSimulatedOutput(std::size_t size, double entropy, std::uint64_t seed);
+
+}  // namespace dbgx::windbg
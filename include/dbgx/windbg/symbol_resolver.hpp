@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace dbgx::windbg {
+
+struct ModuleRange {
+  std::uint64_t base = 0;
+  std::uint64_t size = 0;
+  std::string name;
+};
+
+// Module list and address-to-symbol lookups of the target, without command text formatting.
+class IWinDbgSymbolProvider {
+ public:
+  virtual ~IWinDbgSymbolProvider() = default;
+
+  virtual bool ListModules(std::vector<ModuleRange>* out_modules, std::string* error_message) = 0;
+  // Same contract as IDebugSymbols::GetNameByOffset: "module!symbol" and the displacement from it.
+  virtual bool GetNameByOffset(std::uint64_t address, std::string* out_name, std::uint64_t* out_displacement) = 0;
+  // Changes whenever a module is loaded or unloaded or symbols are reloaded.
+  virtual std::uint64_t SymbolGeneration() = 0;
+};
+
+struct ResolvedAddress {
+  std::uint64_t address = 0;
+  // Empty when the address is outside every loaded module.
+  std::string module;
+  std::uint64_t module_offset = 0;
+  // Empty when the provider has no symbol for the address.
+  std::string symbol;
+  std::uint64_t displacement = 0;
+};
+
+struct SymbolResolverOptions {
+  std::size_t max_cached_symbols = 16384;
+};
+
+struct SymbolResolverStats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t index_rebuilds = 0;
+};
+
+// True for commands that change symbol state (.reload, .sympath, .symfix, ld).
+bool InvalidatesSymbols(std::string_view command);
+
+// Resolves addresses against a sorted interval index of loaded modules (O(log n) per address) and an LRU
+// of symbol lookups. Both are rebuilt when the provider's SymbolGeneration changes or Invalidate is called.
+class SymbolResolver {
+ public:
+  explicit SymbolResolver(SymbolResolverOptions options = {});
+
+  bool Resolve(
+      IWinDbgSymbolProvider* provider,
+      const std::vector<std::uint64_t>& addresses,
+      std::vector<ResolvedAddress>* out_results,
+      std::string* error_message);
+  void Invalidate();
+
+  SymbolResolverStats Stats() const;
+
+ private:
+  struct CachedSymbol {
+    std::uint64_t address = 0;
+    std::string symbol;
+    std::uint64_t displacement = 0;
+  };
+
+  bool RefreshLocked(IWinDbgSymbolProvider* provider, std::string* error_message);
+  const ModuleRange* FindModuleLocked(std::uint64_t address) const;
+  void LookupSymbolLocked(IWinDbgSymbolProvider* provider, ResolvedAddress* result);
+
+  SymbolResolverOptions options_;
+  mutable std::mutex mutex_;
+  bool valid_ = false;
+  std::uint64_t generation_ = 0;
+  // Sorted by base; ranges do not overlap.
+  std::vector<ModuleRange> modules_;
+  std::list<CachedSymbol> symbols_;
+  std::unordered_map<std::uint64_t, std::list<CachedSymbol>::iterator> symbol_index_;
+  SymbolResolverStats stats_;
+};
+
+}  // namespace dbgx::windbg
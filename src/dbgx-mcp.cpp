@@ -1,7 +1,12 @@
+#include "dbgx/mcp/async_log.hpp"
 #include "dbgx/mcp/http_server.hpp"
 #include "dbgx/mcp/io_echo.hpp"
 #include "dbgx/mcp/json_rpc.hpp"
+#include "dbgx/windbg/caching_command_executor.hpp"
 #include "dbgx/windbg/dbgeng_command_executor.hpp"
+#include "dbgx/windbg/dbgeng_memory_reader.hpp"
+#include "dbgx/windbg/dbgeng_symbol_provider.hpp"
+#include "dbgx/windbg/session_trace.hpp"
 
 #include <DbgEng.h>
 #include <windows.h>
@@ -11,6 +16,7 @@
 #include <cstdint>
 #include <memory>
 #include <mutex>
+#include <span>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -18,6 +24,8 @@
 namespace {
 
 constexpr std::uint16_t kDefaultPort = 5678;
+// Synchronous windbg.eval calls without timeout_ms are interrupted after this long.
+constexpr auto kDefaultCommandTimeout = std::chrono::minutes(10);
 
 struct RequestTraceState {
   std::string trace_id;
@@ -27,11 +35,23 @@ struct RequestTraceState {
   std::chrono::steady_clock::time_point started_at = std::chrono::steady_clock::now();
 };
 
+// The mutex guards start/stop only. Connections take a shared reference to the router and run
+// without it, so cancellation and metadata requests are not blocked by a running command.
 struct ExtensionState {
   std::mutex mutex;
-  std::unique_ptr<dbgx::windbg::DbgEngCommandExecutor> executor;
-  std::unique_ptr<dbgx::mcp::JsonRpcRouter> router;
+  std::shared_ptr<dbgx::windbg::DbgEngCommandExecutor> executor;
+  std::shared_ptr<dbgx::windbg::SessionTraceWriter> trace_writer;
+  std::shared_ptr<dbgx::windbg::RecordingCommandExecutor> recorder;
+  std::shared_ptr<dbgx::windbg::CachingCommandExecutor> command_cache;
+  std::shared_ptr<dbgx::windbg::DbgEngMemoryReader> memory_reader;
+  std::shared_ptr<dbgx::windbg::DbgEngSymbolProvider> symbol_provider;
+  // Declared before the router and server, which record into it.
+  std::unique_ptr<dbgx::mcp::SpanTracer> tracer;
+  std::shared_ptr<dbgx::mcp::JsonRpcRouter> router;
   std::unique_ptr<dbgx::mcp::HttpServer> server;
+  // Owned here; log is the pointer request threads read, cleared before the log is destroyed.
+  std::unique_ptr<dbgx::mcp::AsyncLog> async_log;
+  std::atomic<dbgx::mcp::AsyncLog*> log{nullptr};
   std::atomic<std::uint64_t> next_local_trace_id{1};
 };
 
@@ -40,27 +60,78 @@ ExtensionState& State() {
   return state;
 }
 
-void LogMessage(const std::string& message) {
-  const std::string text = "[windbg-mcp] " + message;
+ULONG OutputMask(dbgx::mcp::LogLevel level) {
+  switch (level) {
+    case dbgx::mcp::LogLevel::kWarning:
+      return DEBUG_OUTPUT_WARNING;
+    case dbgx::mcp::LogLevel::kError:
+      return DEBUG_OUTPUT_ERROR;
+    default:
+      return DEBUG_OUTPUT_NORMAL;
+  }
+}
 
+// Writes records to the debugger output, or to OutputDebugString when no engine client is available.
+// Runs on the log's flusher thread, or on the caller's thread before the log exists and after it is gone.
+void WriteLogRecords(std::span<const dbgx::mcp::LogRecord> records) {
   IDebugClient* debug_client = nullptr;
+  IDebugControl* debug_control = nullptr;
   if (SUCCEEDED(DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(&debug_client))) &&
       debug_client != nullptr) {
-    IDebugControl* debug_control = nullptr;
-    if (SUCCEEDED(debug_client->QueryInterface(__uuidof(IDebugControl), reinterpret_cast<void**>(&debug_control))) &&
-        debug_control != nullptr) {
-      std::string line = text + "\n";
-      debug_control->Output(DEBUG_OUTPUT_NORMAL, "%s", line.c_str());
-      debug_control->Release();
-      debug_client->Release();
-      return;
+    if (FAILED(debug_client->QueryInterface(__uuidof(IDebugControl), reinterpret_cast<void**>(&debug_control)))) {
+      debug_control = nullptr;
+    }
+  }
+
+  std::string line;
+  for (const dbgx::mcp::LogRecord& record : records) {
+    line.assign("[windbg-mcp] ");
+    line.append(record.text);
+    line.push_back('\n');
+    if (debug_control != nullptr) {
+      debug_control->Output(OutputMask(record.level), "%s", line.c_str());
+    } else {
+      OutputDebugStringA(line.c_str());
     }
+  }
 
+  if (debug_control != nullptr) {
+    debug_control->Release();
+  }
+  if (debug_client != nullptr) {
     debug_client->Release();
   }
+}
+
+// Request threads only pay for a copy into the log's ring; when the ring is full the record is dropped.
+void LogMessage(dbgx::mcp::LogLevel level, std::string_view message) {
+  if (!dbgx::mcp::IsLogLevelCompiled(level)) {
+    return;
+  }
+  if (dbgx::mcp::AsyncLog* log = State().log.load(std::memory_order_acquire)) {
+    log->Log(level, std::string_view(), message);
+    return;
+  }
+  const dbgx::mcp::LogRecord record{level, message};
+  WriteLogRecords(std::span<const dbgx::mcp::LogRecord>(&record, 1));
+}
+
+void LogMessage(std::string_view message) {
+  LogMessage(dbgx::mcp::LogLevel::kInfo, message);
+}
+
+// Checked before an echo summary is built, so filtered and sampled-out stages cost no formatting.
+bool ShouldEcho(dbgx::mcp::LogLevel level, std::string_view stage) {
+  dbgx::mcp::AsyncLog* log = State().log.load(std::memory_order_acquire);
+  return log == nullptr || log->ShouldLog(level, stage);
+}
 
-  std::string fallback_line = text + "\n";
-  OutputDebugStringA(fallback_line.c_str());
+void EchoMessage(dbgx::mcp::LogLevel level, std::string_view message) {
+  if (dbgx::mcp::AsyncLog* log = State().log.load(std::memory_order_acquire)) {
+    log->Enqueue(level, message);
+    return;
+  }
+  LogMessage(level, message);
 }
 
 std::uint64_t ElapsedMillis(const RequestTraceState& trace_state) {
@@ -75,7 +146,8 @@ std::uint64_t ElapsedMillis(const RequestTraceState& trace_state) {
 dbgx::mcp::IoTraceContext BuildTraceContext(
     const RequestTraceState& trace_state,
     std::string_view stage,
-    std::string_view outcome = std::string_view()) {
+    std::string_view outcome = std::string_view(),
+    bool is_error = false) {
   dbgx::mcp::IoTraceContext context;
   context.trace_id = trace_state.trace_id;
   context.stage = std::string(stage);
@@ -84,6 +156,7 @@ dbgx::mcp::IoTraceContext BuildTraceContext(
   context.tool_name = trace_state.tool_name;
   context.outcome = std::string(outcome);
   context.duration_ms = ElapsedMillis(trace_state);
+  context.is_error = is_error;
   return context;
 }
 
@@ -115,45 +188,82 @@ RequestTraceState BuildRequestTraceState(const dbgx::mcp::HttpRequest& request)
   return trace_state;
 }
 
+// Summaries are formatted into a stack buffer and copied once into the log's ring.
+template <dbgx::mcp::LogLevel kLevel>
 void LogStageEcho(
     const RequestTraceState& trace_state,
     std::string_view stage,
     std::string_view outcome,
     std::string_view message) noexcept {
-  try {
-    const dbgx::mcp::IoTraceContext trace_context = BuildTraceContext(trace_state, stage, outcome);
-    LogMessage(dbgx::mcp::BuildLifecycleIoSummary(trace_context, message));
-  } catch (...) {
-    LogMessage("mcp.stage echo unavailable");
+  if constexpr (dbgx::mcp::IsLogLevelCompiled(kLevel)) {
+    try {
+      if (!ShouldEcho(kLevel, stage)) {
+        return;
+      }
+      dbgx::mcp::IoSummaryBuffer buffer;
+      const dbgx::mcp::IoTraceContext trace_context = BuildTraceContext(trace_state, stage, outcome);
+      EchoMessage(kLevel, dbgx::mcp::FormatLifecycleIoSummary(trace_context, message, &buffer));
+    } catch (...) {
+      LogMessage(dbgx::mcp::LogLevel::kWarning, "mcp.stage echo unavailable");
+    }
   }
 }
 
 void LogRequestEcho(const dbgx::mcp::HttpRequest& request, const RequestTraceState& trace_state) noexcept {
-  try {
-    const dbgx::mcp::IoTraceContext trace_context = BuildTraceContext(trace_state, "request_received");
-    LogMessage(dbgx::mcp::BuildRequestIoSummary(request, trace_context));
-  } catch (...) {
-    LogMessage("mcp.request echo unavailable");
+  if constexpr (dbgx::mcp::IsLogLevelCompiled(dbgx::mcp::LogLevel::kInfo)) {
+    try {
+      if (!ShouldEcho(dbgx::mcp::LogLevel::kInfo, "request_received")) {
+        return;
+      }
+      dbgx::mcp::IoSummaryBuffer buffer;
+      const dbgx::mcp::IoTraceContext trace_context = BuildTraceContext(trace_state, "request_received");
+      EchoMessage(dbgx::mcp::LogLevel::kInfo, dbgx::mcp::FormatRequestIoSummary(request, trace_context, &buffer));
+    } catch (...) {
+      LogMessage(dbgx::mcp::LogLevel::kWarning, "mcp.request echo unavailable");
+    }
   }
 }
 
 void LogResponseEcho(
     const dbgx::mcp::HttpResponse& response,
     const RequestTraceState& trace_state,
-    std::string_view stage) noexcept {
-  try {
-    const dbgx::mcp::IoTraceContext trace_context = BuildTraceContext(trace_state, stage);
-    LogMessage(dbgx::mcp::BuildResponseIoSummary(response, trace_context));
-  } catch (...) {
-    LogMessage("mcp.response echo unavailable");
+    std::string_view stage,
+    bool is_error = false) noexcept {
+  if constexpr (dbgx::mcp::IsLogLevelCompiled(dbgx::mcp::LogLevel::kInfo)) {
+    try {
+      if (!ShouldEcho(dbgx::mcp::LogLevel::kInfo, stage)) {
+        return;
+      }
+      dbgx::mcp::IoSummaryBuffer buffer;
+      const dbgx::mcp::IoTraceContext trace_context =
+          BuildTraceContext(trace_state, stage, std::string_view(), is_error);
+      EchoMessage(dbgx::mcp::LogLevel::kInfo, dbgx::mcp::FormatResponseIoSummary(response, trace_context, &buffer));
+    } catch (...) {
+      LogMessage(dbgx::mcp::LogLevel::kWarning, "mcp.response echo unavailable");
+    }
   }
 }
 
-dbgx::mcp::HttpResponse FinishMcpRequest(dbgx::mcp::HttpResponse response, const RequestTraceState& trace_state) {
-  LogResponseEcho(response, trace_state, "response_sent");
+dbgx::mcp::HttpResponse FinishMcpRequest(
+    dbgx::mcp::HttpResponse response,
+    const RequestTraceState& trace_state,
+    bool is_error = false) {
+  LogResponseEcho(response, trace_state, "response_sent", is_error);
   return response;
 }
 
+void ExportMetrics(dbgx::mcp::PrometheusWriter* writer) {
+  std::shared_ptr<dbgx::mcp::JsonRpcRouter> router;
+  {
+    ExtensionState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    router = state.router;
+  }
+  if (router != nullptr) {
+    router->ExportMetrics(writer);
+  }
+}
+
 dbgx::mcp::HttpResponse HandleRequest(const dbgx::mcp::HttpRequest& request) {
   dbgx::mcp::HttpResponse response;
   const RequestTraceState trace_state = BuildRequestTraceState(request);
@@ -197,40 +307,162 @@ dbgx::mcp::HttpResponse HandleRequest(const dbgx::mcp::HttpRequest& request) {
     return FinishMcpRequest(std::move(response), trace_state);
   }
 
-  LogStageEcho(trace_state, "route_dispatch", "in_progress", "dispatching JSON-RPC request");
+  LogStageEcho<dbgx::mcp::LogLevel::kDebug>(
+      trace_state, "route_dispatch", "in_progress", "dispatching JSON-RPC request");
   if (trace_state.rpc_method == "tools/call") {
-    LogStageEcho(trace_state, "tool_execute_start", "in_progress", "entering tool executor");
+    LogStageEcho<dbgx::mcp::LogLevel::kDebug>(
+        trace_state, "tool_execute_start", "in_progress", "entering tool executor");
   }
 
-  ExtensionState& state = State();
-  std::lock_guard<std::mutex> lock(state.mutex);
-  if (state.router == nullptr) {
+  std::shared_ptr<dbgx::mcp::JsonRpcRouter> router;
+  std::shared_ptr<dbgx::windbg::DbgEngCommandExecutor> executor;
+  std::shared_ptr<dbgx::windbg::SessionTraceWriter> trace_writer;
+  std::shared_ptr<dbgx::windbg::RecordingCommandExecutor> recorder;
+  std::shared_ptr<dbgx::windbg::CachingCommandExecutor> command_cache;
+  std::shared_ptr<dbgx::windbg::DbgEngMemoryReader> memory_reader;
+  std::shared_ptr<dbgx::windbg::DbgEngSymbolProvider> symbol_provider;
+  {
+    ExtensionState& state = State();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    router = state.router;
+    executor = state.executor;
+    trace_writer = state.trace_writer;
+    recorder = state.recorder;
+    command_cache = state.command_cache;
+    memory_reader = state.memory_reader;
+    symbol_provider = state.symbol_provider;
+  }
+  if (router == nullptr) {
     response.status_code = 500;
     response.body = "{\"error\":\"Router is not initialized\"}";
     return FinishMcpRequest(std::move(response), trace_state);
   }
 
-  const dbgx::mcp::JsonRpcHttpResult rpc_result = state.router->HandleJsonRpcPost(request.body);
+  dbgx::mcp::JsonRpcHttpResult rpc_result = router->HandleJsonRpcPost(request.body);
   response.status_code = rpc_result.status_code;
-  response.content_type = rpc_result.content_type;
+  response.content_type = std::move(rpc_result.content_type);
   response.has_body = rpc_result.has_body;
-  response.body = rpc_result.body;
+  // Moved, not copied: the body can hold megabytes of escaped command output.
+  response.body = std::move(rpc_result.body);
+  if (rpc_result.body_stream) {
+    // Streamed responses run their commands after this handler returns, so they keep the router alive.
+    response.body_stream = [stream = std::move(rpc_result.body_stream),
+                            router,
+                            command_cache,
+                            recorder,
+                            trace_writer,
+                            executor,
+                            memory_reader,
+                            symbol_provider,
+                            trace_state](const dbgx::mcp::HttpBodyWriter& write_chunk) {
+      std::size_t streamed_bytes = 0;
+      stream([&](std::string_view chunk) {
+        streamed_bytes += chunk.size();
+        return write_chunk(chunk);
+      });
+      LogStageEcho<dbgx::mcp::LogLevel::kInfo>(
+          trace_state, "response_sent", "streamed", "bytes=" + std::to_string(streamed_bytes));
+    };
+    LogStageEcho<dbgx::mcp::LogLevel::kDebug>(
+        trace_state, "response_streaming", "in_progress", "streaming JSON-RPC response");
+    return response;
+  }
   if (trace_state.rpc_method == "tools/call") {
-    LogResponseEcho(response, trace_state, "tool_execute_end");
+    LogResponseEcho(response, trace_state, "tool_execute_end", rpc_result.is_error);
   }
-  return FinishMcpRequest(std::move(response), trace_state);
+  return FinishMcpRequest(std::move(response), trace_state, rpc_result.is_error);
+}
+
+std::string EnvironmentValue(const char* name) {
+  char buffer[MAX_PATH] = {};
+  const DWORD length = GetEnvironmentVariableA(name, buffer, MAX_PATH);
+  return length > 0 && length < MAX_PATH ? std::string(buffer, length) : std::string();
+}
+
+// DBGX_MCP_RECORD_TRACE names a file that receives every engine command, for replay off the debugger.
+std::string RecordTracePath() {
+  return EnvironmentValue("DBGX_MCP_RECORD_TRACE");
+}
+
+// Span tracing can also be started and stopped later through POST /trace/start and /trace/stop.
+bool SpanTracingRequested() {
+  return EnvironmentValue("DBGX_MCP_SPAN_TRACE") == "1";
+}
+
+// DBGX_MCP_LOG_LEVEL sets the lowest level written (debug by default); DBGX_MCP_LOG_SAMPLE keeps one
+// in N echoes per stage, e.g. "route_dispatch=100,tool_execute_start=100".
+dbgx::mcp::AsyncLogOptions LogOptionsFromEnvironment() {
+  dbgx::mcp::AsyncLogOptions options;
+  const std::string level = EnvironmentValue("DBGX_MCP_LOG_LEVEL");
+  if (!level.empty() && !dbgx::mcp::ParseLogLevel(level, &options.min_level)) {
+    LogMessage(dbgx::mcp::LogLevel::kWarning, "Ignoring DBGX_MCP_LOG_LEVEL: unknown level '" + level + "'");
+  }
+  std::string sampling_error;
+  if (!dbgx::mcp::ParseStageSampling(EnvironmentValue("DBGX_MCP_LOG_SAMPLE"), &options.sampling, &sampling_error)) {
+    LogMessage(dbgx::mcp::LogLevel::kWarning, "Ignoring DBGX_MCP_LOG_SAMPLE: " + sampling_error);
+  }
+  return options;
+}
+
+void StartLog(ExtensionState* state) {
+  state->async_log = std::make_unique<dbgx::mcp::AsyncLog>(LogOptionsFromEnvironment(), WriteLogRecords);
+  state->log.store(state->async_log.get(), std::memory_order_release);
+}
+
+// The destructor writes every queued record before the flusher stops; later messages are written directly.
+void StopLog(ExtensionState* state) {
+  state->log.store(nullptr, std::memory_order_release);
+  state->async_log.reset();
 }
 
 void Cleanup() {
   ExtensionState& state = State();
-  std::lock_guard<std::mutex> lock(state.mutex);
+  std::unique_ptr<dbgx::mcp::HttpServer> server;
+  std::shared_ptr<dbgx::mcp::JsonRpcRouter> router;
+  {
+    std::lock_guard<std::mutex> lock(state.mutex);
+    server = std::move(state.server);
+    router = state.router;
+  }
 
-  if (state.server != nullptr) {
-    state.server->Stop();
-    state.server.reset();
+  // Stop waits for in-flight connections, which briefly take the state lock; do not hold it here. Those
+  // connections may be blocked on engine commands, so cancel those first.
+  if (router != nullptr) {
+    router->Shutdown();
+  }
+  if (server != nullptr) {
+    server->Stop();
+    server.reset();
   }
 
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (state.command_cache != nullptr) {
+    const dbgx::windbg::CommandCacheStats stats = state.command_cache->Stats();
+    LogMessage(
+        "Command cache: hits=" + std::to_string(stats.hits) + ", misses=" + std::to_string(stats.misses) +
+        ", invalidations=" + std::to_string(stats.invalidations) +
+        ", saved_ms=" + std::to_string(stats.saved_us / 1000));
+  }
+  if (state.trace_writer != nullptr) {
+    LogMessage("Session trace: records=" + std::to_string(state.trace_writer->RecordCount()));
+  }
+  if (state.router != nullptr) {
+    LogMessage("Command timeouts: " + std::to_string(state.router->Stats().timed_out_commands));
+  }
+  if (state.async_log != nullptr) {
+    const dbgx::mcp::AsyncLogStats stats = state.async_log->Stats();
+    LogMessage(
+        "Log: enqueued=" + std::to_string(stats.enqueued) + ", dropped=" + std::to_string(stats.dropped) +
+        ", sampled_out=" + std::to_string(stats.sampled_out) + ", truncated=" + std::to_string(stats.truncated));
+  }
+  StopLog(&state);
   state.router.reset();
+  state.tracer.reset();
+  state.symbol_provider.reset();
+  state.memory_reader.reset();
+  state.command_cache.reset();
+  state.recorder.reset();
+  state.trace_writer.reset();
   state.executor.reset();
 }
 
@@ -251,20 +483,60 @@ extern "C" HRESULT CALLBACK DebugExtensionInitialize(PULONG version, PULONG flag
     return S_OK;
   }
 
-  state.executor = std::make_unique<dbgx::windbg::DbgEngCommandExecutor>();
-  state.router = std::make_unique<dbgx::mcp::JsonRpcRouter>(state.executor.get());
+  StartLog(&state);
+  state.executor = std::make_shared<dbgx::windbg::DbgEngCommandExecutor>();
+  dbgx::windbg::IWinDbgCommandExecutor* engine_executor = state.executor.get();
+  const std::string trace_path = RecordTracePath();
+  if (!trace_path.empty()) {
+    auto trace_writer = std::make_shared<dbgx::windbg::SessionTraceWriter>();
+    std::string trace_error;
+    if (trace_writer->Open(trace_path, &trace_error)) {
+      state.trace_writer = std::move(trace_writer);
+      state.recorder =
+          std::make_shared<dbgx::windbg::RecordingCommandExecutor>(state.executor.get(), state.trace_writer.get());
+      engine_executor = state.recorder.get();
+      LogMessage("Recording session trace to " + trace_path);
+    } else {
+      LogMessage(dbgx::mcp::LogLevel::kWarning, "Session trace disabled: " + trace_error);
+    }
+  }
+  state.command_cache = std::make_shared<dbgx::windbg::CachingCommandExecutor>(engine_executor);
+  state.memory_reader = std::make_shared<dbgx::windbg::DbgEngMemoryReader>(state.executor.get());
+  state.symbol_provider = std::make_shared<dbgx::windbg::DbgEngSymbolProvider>(state.executor.get());
+  state.tracer = std::make_unique<dbgx::mcp::SpanTracer>();
+  if (SpanTracingRequested()) {
+    state.tracer->Start();
+    LogMessage("Span tracing started; GET /trace returns it as Chrome trace JSON");
+  }
+  dbgx::mcp::JsonRpcRouterOptions router_options;
+  router_options.default_command_timeout = kDefaultCommandTimeout;
+  router_options.tracer = state.tracer.get();
+  state.router = std::make_shared<dbgx::mcp::JsonRpcRouter>(
+      state.command_cache.get(), state.memory_reader.get(), state.symbol_provider.get(), router_options);
   state.server = std::make_unique<dbgx::mcp::HttpServer>();
 
   std::string error_message;
   dbgx::mcp::HttpServerStartReport start_report;
-  if (!state.server->Start("127.0.0.1", kDefaultPort, HandleRequest, &error_message, &start_report)) {
+  dbgx::mcp::HttpServerStartOptions start_options;
+  start_options.metrics_exporter = ExportMetrics;
+  start_options.tracer = state.tracer.get();
+  if (!state.server->Start(
+          "127.0.0.1", kDefaultPort, HandleRequest, &error_message, &start_report, &start_options)) {
     LogMessage(
+        dbgx::mcp::LogLevel::kError,
         "Failed to start HTTP server: " + error_message + " (initial_port=" + std::to_string(kDefaultPort) +
         ", attempts=" + std::to_string(start_report.attempt_count) +
         ", conflicts=" + std::to_string(start_report.conflict_count) + ")");
     state.server.reset();
     state.router.reset();
+    state.tracer.reset();
+    state.symbol_provider.reset();
+    state.memory_reader.reset();
+    state.command_cache.reset();
+    state.recorder.reset();
+    state.trace_writer.reset();
     state.executor.reset();
+    StopLog(&state);
     return E_FAIL;
   }
 
@@ -0,0 +1,208 @@
+#include "dbgx/mcp/async_log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <utility>
+
+namespace dbgx::mcp {
+
+namespace {
+
+std::string_view TrimView(std::string_view text) {
+  const std::size_t first = text.find_first_not_of(" \t\r\n");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  const std::size_t last = text.find_last_not_of(" \t\r\n");
+  return text.substr(first, last - first + 1);
+}
+
+}  // namespace
+
+bool ParseLogLevel(std::string_view text, LogLevel* out_level) {
+  text = TrimView(text);
+  if (text == "debug") {
+    *out_level = LogLevel::kDebug;
+  } else if (text == "info") {
+    *out_level = LogLevel::kInfo;
+  } else if (text == "warning") {
+    *out_level = LogLevel::kWarning;
+  } else if (text == "error") {
+    *out_level = LogLevel::kError;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ParseStageSampling(std::string_view spec, std::vector<StageSampling>* out_sampling, std::string* error_message) {
+  std::vector<StageSampling> sampling;
+  while (!TrimView(spec).empty()) {
+    const std::size_t comma = spec.find(',');
+    const std::string_view entry = TrimView(spec.substr(0, comma));
+    spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+
+    const std::size_t equals = entry.find('=');
+    const std::string_view stage = TrimView(entry.substr(0, equals));
+    const std::string_view count =
+        equals == std::string_view::npos ? std::string_view() : TrimView(entry.substr(equals + 1));
+    std::uint32_t keep_one_in = 0;
+    const auto parsed = std::from_chars(count.data(), count.data() + count.size(), keep_one_in);
+    if (stage.empty() || parsed.ec != std::errc() || parsed.ptr != count.data() + count.size() || keep_one_in == 0) {
+      *error_message = "Invalid stage sampling entry '" + std::string(entry) + "'; expected stage=N with N >= 1";
+      return false;
+    }
+    sampling.push_back(StageSampling{std::string(stage), keep_one_in});
+  }
+  *out_sampling = std::move(sampling);
+  return true;
+}
+
+AsyncLog::AsyncLog(AsyncLogOptions options, LogSink sink)
+    : mask_(std::bit_ceil(std::max<std::size_t>(options.capacity, 2)) - 1),
+      max_record_bytes_(std::max<std::size_t>(options.max_record_bytes, 1)),
+      min_level_(options.min_level),
+      sink_(std::move(sink)),
+      slots_(std::make_unique<Slot[]>(mask_ + 1)),
+      text_(std::make_unique_for_overwrite<char[]>((mask_ + 1) * max_record_bytes_)),
+      sampling_(std::make_unique<SamplingCounter[]>(options.sampling.size())),
+      sampling_count_(options.sampling.size()) {
+  for (std::size_t index = 0; index <= mask_; ++index) {
+    slots_[index].sequence.store(index, std::memory_order_relaxed);
+  }
+  for (std::size_t index = 0; index < sampling_count_; ++index) {
+    sampling_[index].stage = std::move(options.sampling[index].stage);
+    sampling_[index].keep_one_in = std::max<std::uint32_t>(options.sampling[index].keep_one_in, 1);
+  }
+  batch_.reserve(mask_ + 1);
+  flusher_ = std::thread([this]() { FlusherLoop(); });
+}
+
+AsyncLog::~AsyncLog() {
+  stopping_.store(true, std::memory_order_release);
+  published_.fetch_add(1, std::memory_order_release);
+  published_.notify_one();
+  flusher_.join();
+}
+
+bool AsyncLog::Sample(std::string_view stage) {
+  for (std::size_t index = 0; index < sampling_count_; ++index) {
+    SamplingCounter& counter = sampling_[index];
+    if (counter.stage != stage) {
+      continue;
+    }
+    if (counter.seen.fetch_add(1, std::memory_order_relaxed) % counter.keep_one_in != 0) {
+      sampled_out_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    break;
+  }
+  return true;
+}
+
+bool AsyncLog::Enqueue(LogLevel level, std::string_view text) {
+  if (text.size() > max_record_bytes_) {
+    text = text.substr(0, max_record_bytes_);
+    truncated_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Vyukov-style bounded ring with a single consumer: a slot is free for position p when its sequence equals p,
+  // and holds a record for the flusher once its sequence is p + 1.
+  std::size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  Slot* slot = nullptr;
+  while (true) {
+    slot = &slots_[position & mask_];
+    const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+    if (difference == 0) {
+      if (enqueue_position_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+
+  std::memcpy(SlotText(position & mask_), text.data(), text.size());
+  slot->level = level;
+  slot->size = text.size();
+  slot->sequence.store(position + 1, std::memory_order_release);
+  enqueued_.fetch_add(1, std::memory_order_relaxed);
+  published_.fetch_add(1, std::memory_order_release);
+  published_.notify_one();
+  return true;
+}
+
+bool AsyncLog::Log(LogLevel level, std::string_view stage, std::string_view text) {
+  return ShouldLog(level, stage) && Enqueue(level, text);
+}
+
+void AsyncLog::Flush() {
+  const std::size_t target = enqueue_position_.load(std::memory_order_acquire);
+  std::size_t flushed = flushed_position_.load(std::memory_order_acquire);
+  while (flushed < target) {
+    flushed_position_.wait(flushed, std::memory_order_acquire);
+    flushed = flushed_position_.load(std::memory_order_acquire);
+  }
+}
+
+AsyncLogStats AsyncLog::Stats() const {
+  AsyncLogStats stats;
+  stats.enqueued = enqueued_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.sampled_out = sampled_out_.load(std::memory_order_relaxed);
+  stats.truncated = truncated_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+char* AsyncLog::SlotText(std::size_t index) const {
+  return text_.get() + index * max_record_bytes_;
+}
+
+void AsyncLog::FlusherLoop() {
+  while (true) {
+    const std::uint64_t seen = published_.load(std::memory_order_acquire);
+    if (DrainOnce()) {
+      continue;
+    }
+    if (stopping_.load(std::memory_order_acquire)) {
+      return;
+    }
+    published_.wait(seen, std::memory_order_acquire);
+  }
+}
+
+bool AsyncLog::DrainOnce() {
+  batch_.clear();
+  std::size_t position = dequeue_position_;
+  while (batch_.size() <= mask_) {
+    const Slot& slot = slots_[position & mask_];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+      break;
+    }
+    batch_.push_back(LogRecord{slot.level, std::string_view(SlotText(position & mask_), slot.size)});
+    ++position;
+  }
+  if (batch_.empty()) {
+    return false;
+  }
+
+  // The sink reads straight from the slots, so they are handed back to producers only afterwards.
+  try {
+    sink_(batch_);
+  } catch (...) {
+  }
+  for (; dequeue_position_ < position; ++dequeue_position_) {
+    slots_[dequeue_position_ & mask_].sequence.store(dequeue_position_ + mask_ + 1, std::memory_order_release);
+  }
+  flushed_position_.store(position, std::memory_order_release);
+  flushed_position_.notify_all();
+  return true;
+}
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,269 @@
+#include "dbgx/mcp/command_jobs.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+#include "dbgx/mcp/json.hpp"
+
+namespace dbgx::mcp {
+
+struct CommandJobTable::Job {
+  std::string id;
+  std::string command;
+  std::shared_ptr<windbg::CommandExecutionContext> context;
+  std::chrono::steady_clock::time_point started_at;
+
+  std::mutex mutex;
+  std::string window;
+  std::uint64_t window_offset = 0;
+  std::uint64_t total_bytes = 0;
+  CommandJobState state = CommandJobState::kRunning;
+  std::string error_message;
+  std::chrono::steady_clock::time_point finished_at;
+
+  std::thread worker;
+
+  void AppendOutput(std::string_view text, std::size_t window_bytes) {
+    std::lock_guard<std::mutex> job_lock(mutex);
+    total_bytes += text.size();
+    if (text.size() >= window_bytes) {
+      window.assign(text.substr(text.size() - window_bytes));
+      window_offset = total_bytes - window_bytes;
+      return;
+    }
+
+    window.append(text);
+    if (window.size() > window_bytes) {
+      // Drop a quarter of the window at a time so appends stay amortized O(1).
+      const std::size_t excess = window.size() - window_bytes;
+      const std::size_t drop = std::min(window.size(), std::max(excess, window_bytes / 4));
+      window.erase(0, drop);
+      window_offset += drop;
+    }
+  }
+};
+
+namespace {
+
+std::uint64_t MillisBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+  if (to <= from) {
+    return 0;
+  }
+  return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count());
+}
+
+}  // namespace
+
+std::string_view CommandJobStateName(CommandJobState state) {
+  switch (state) {
+    case CommandJobState::kRunning:
+      return "running";
+    case CommandJobState::kSucceeded:
+      return "succeeded";
+    case CommandJobState::kFailed:
+      return "failed";
+    case CommandJobState::kCancelled:
+      return "cancelled";
+  }
+  return "unknown";
+}
+
+CommandJobTable::CommandJobTable(CommandJobTableOptions options) : options_(options) {
+  if (options_.max_jobs == 0) {
+    options_.max_jobs = 1;
+  }
+  if (options_.output_window_bytes == 0) {
+    options_.output_window_bytes = 1;
+  }
+}
+
+CommandJobTable::~CommandJobTable() {
+  std::unordered_map<std::string, std::shared_ptr<Job>> jobs;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs.swap(jobs_);
+  }
+  for (auto& [id, job] : jobs) {
+    job->context->RequestCancel();
+  }
+  for (auto& [id, job] : jobs) {
+    if (job->worker.joinable()) {
+      job->worker.join();
+    }
+  }
+}
+
+bool CommandJobTable::Start(
+    std::string command,
+    CommandJobRunner runner,
+    std::string* out_job_id,
+    std::string* error_message) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (shut_down_) {
+    if (error_message != nullptr) {
+      *error_message = "Server is shutting down";
+    }
+    return false;
+  }
+  EvictExpiredLocked(std::chrono::steady_clock::now());
+  if (jobs_.size() >= options_.max_jobs && !EvictOldestFinishedLocked()) {
+    if (error_message != nullptr) {
+      *error_message = "Too many running jobs (limit " + std::to_string(options_.max_jobs) + ")";
+    }
+    return false;
+  }
+
+  auto job = std::make_shared<Job>();
+  job->id = "job-" + std::to_string(next_job_number_++);
+  job->command = std::move(command);
+  job->context = std::make_shared<windbg::CommandExecutionContext>();
+  job->started_at = std::chrono::steady_clock::now();
+
+  Job* raw_job = job.get();
+  const std::size_t window_bytes = options_.output_window_bytes;
+  job->context->SetOutputObserver(
+      [raw_job, window_bytes](std::string_view text) { raw_job->AppendOutput(text, window_bytes); });
+
+  job->worker = std::thread([raw_job, runner = std::move(runner)]() {
+    const windbg::CommandExecutionResult result = runner(raw_job->context.get());
+    std::lock_guard<std::mutex> job_lock(raw_job->mutex);
+    raw_job->finished_at = std::chrono::steady_clock::now();
+    if (result.cancelled) {
+      raw_job->state = CommandJobState::kCancelled;
+    } else if (result.success) {
+      raw_job->state = CommandJobState::kSucceeded;
+    } else {
+      raw_job->state = CommandJobState::kFailed;
+    }
+    raw_job->error_message = result.error_message;
+  });
+
+  *out_job_id = job->id;
+  jobs_.emplace(job->id, std::move(job));
+  return true;
+}
+
+bool CommandJobTable::GetStatus(std::string_view job_id, CommandJobStatus* out_status) {
+  const std::shared_ptr<Job> job = FindJob(job_id);
+  if (job == nullptr) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> job_lock(job->mutex);
+  out_status->job_id = job->id;
+  out_status->command = job->command;
+  out_status->state = job->state;
+  out_status->output_bytes = job->total_bytes;
+  out_status->retained_from_offset = job->window_offset;
+  out_status->duration_ms = MillisBetween(
+      job->started_at,
+      job->state == CommandJobState::kRunning ? std::chrono::steady_clock::now() : job->finished_at);
+  out_status->error_message = job->error_message;
+  return true;
+}
+
+bool CommandJobTable::ReadOutput(
+    std::string_view job_id,
+    std::uint64_t offset,
+    std::size_t max_bytes,
+    CommandJobOutputSlice* out_slice) {
+  const std::shared_ptr<Job> job = FindJob(job_id);
+  if (job == nullptr) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> job_lock(job->mutex);
+  // The slice is moved back to character boundaries at both ends, as resources/read byte pages are.
+  const std::string_view window = job->window;
+  const std::uint64_t requested = std::clamp(offset, job->window_offset, job->total_bytes);
+  std::size_t window_start =
+      json::Utf8PrefixLength(window, static_cast<std::size_t>(requested - job->window_offset));
+  // Trimming can cut the window inside a character; the orphaned continuation bytes are skipped.
+  while (window_start < window.size() && window_start < 3 &&
+         (static_cast<unsigned char>(window[window_start]) & 0xC0) == 0x80) {
+    ++window_start;
+  }
+  const std::size_t length = json::Utf8PageLength(window.substr(window_start), max_bytes);
+  const std::uint64_t start = job->window_offset + window_start;
+  out_slice->text.assign(window, window_start, length);
+  out_slice->offset = start;
+  out_slice->next_offset = start + length;
+  out_slice->total_bytes = job->total_bytes;
+  out_slice->state = job->state;
+  return true;
+}
+
+bool CommandJobTable::Cancel(std::string_view job_id) {
+  const std::shared_ptr<Job> job = FindJob(job_id);
+  if (job == nullptr) {
+    return false;
+  }
+  job->context->RequestCancel();
+  return true;
+}
+
+void CommandJobTable::Shutdown() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  shut_down_ = true;
+  for (auto& [id, job] : jobs_) {
+    job->context->RequestCancel();
+  }
+}
+
+std::size_t CommandJobTable::JobCount() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EvictExpiredLocked(std::chrono::steady_clock::now());
+  return jobs_.size();
+}
+
+std::shared_ptr<CommandJobTable::Job> CommandJobTable::FindJob(std::string_view job_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EvictExpiredLocked(std::chrono::steady_clock::now());
+  const auto it = jobs_.find(std::string(job_id));
+  return it == jobs_.end() ? nullptr : it->second;
+}
+
+void CommandJobTable::EvictExpiredLocked(std::chrono::steady_clock::time_point now) {
+  for (auto it = jobs_.begin(); it != jobs_.end();) {
+    Job& job = *it->second;
+    bool expired = false;
+    {
+      std::lock_guard<std::mutex> job_lock(job.mutex);
+      expired = job.state != CommandJobState::kRunning && now - job.finished_at >= options_.finished_job_ttl;
+    }
+    if (!expired) {
+      ++it;
+      continue;
+    }
+    if (job.worker.joinable()) {
+      job.worker.join();
+    }
+    it = jobs_.erase(it);
+  }
+}
+
+bool CommandJobTable::EvictOldestFinishedLocked() {
+  auto oldest = jobs_.end();
+  std::chrono::steady_clock::time_point oldest_finished_at;
+  for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
+    std::lock_guard<std::mutex> job_lock(it->second->mutex);
+    if (it->second->state == CommandJobState::kRunning) {
+      continue;
+    }
+    if (oldest == jobs_.end() || it->second->finished_at < oldest_finished_at) {
+      oldest = it;
+      oldest_finished_at = it->second->finished_at;
+    }
+  }
+  if (oldest == jobs_.end()) {
+    return false;
+  }
+  if (oldest->second->worker.joinable()) {
+    oldest->second->worker.join();
+  }
+  jobs_.erase(oldest);
+  return true;
+}
+
+}  // namespace dbgx::mcp
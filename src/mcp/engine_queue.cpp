@@ -0,0 +1,113 @@
+#include "dbgx/mcp/engine_queue.hpp"
+
+namespace dbgx::mcp {
+
+EngineDispatchQueue::EngineDispatchQueue() : engine_thread_([this]() { EngineLoop(); }) {}
+
+EngineDispatchQueue::~EngineDispatchQueue() {
+  // stopping_ is only read on the engine thread, and the stop task runs after everything queued before it.
+  Run([this]() { stopping_ = true; });
+  engine_thread_.join();
+}
+
+void EngineDispatchQueue::Run(
+    const std::function<void()>& task,
+    std::chrono::milliseconds wait_interval,
+    const std::function<void()>& on_wait) {
+  if (OnEngineThread()) {
+    task();
+    return;
+  }
+
+  Node node;
+  node.task = &task;
+  Push(&node);
+  {
+    std::unique_lock<std::mutex> lock(node.mutex);
+    if (on_wait == nullptr || wait_interval <= std::chrono::milliseconds::zero()) {
+      node.finished_changed.wait(lock, [&node]() { return node.finished; });
+    } else {
+      while (!node.finished_changed.wait_for(lock, wait_interval, [&node]() { return node.finished; })) {
+        lock.unlock();
+        on_wait();
+        lock.lock();
+      }
+    }
+  }
+  if (node.error != nullptr) {
+    std::rethrow_exception(node.error);
+  }
+}
+
+bool EngineDispatchQueue::OnEngineThread() const {
+  return std::this_thread::get_id() == engine_thread_.get_id();
+}
+
+void EngineDispatchQueue::Push(Node* node) {
+  depth_.fetch_add(1, std::memory_order_relaxed);
+  Node* head = head_.load(std::memory_order_relaxed);
+  do {
+    node->next = head;
+  } while (!head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+  // The engine thread only parks on an empty stack, so only the push that ends it needs to wake it.
+  if (head == nullptr) {
+    head_.notify_one();
+  }
+}
+
+void EngineDispatchQueue::EngineLoop() {
+  while (!stopping_) {
+    Node* stack = head_.exchange(nullptr, std::memory_order_acquire);
+    if (stack == nullptr) {
+      head_.wait(nullptr, std::memory_order_acquire);
+      continue;
+    }
+
+    // The stack is newest first; reverse it to run tasks in submission order.
+    Node* ordered = nullptr;
+    while (stack != nullptr) {
+      Node* next = stack->next;
+      stack->next = ordered;
+      ordered = stack;
+      stack = next;
+    }
+
+    while (ordered != nullptr) {
+      Node* node = ordered;
+      ordered = node->next;
+      depth_.fetch_sub(1, std::memory_order_relaxed);
+      std::exception_ptr error;
+      try {
+        (*node->task)();
+      } catch (...) {
+        error = std::current_exception();
+      }
+      // Notify under the lock: the submitter may destroy the node as soon as it can take the lock.
+      std::lock_guard<std::mutex> lock(node->mutex);
+      node->error = error;
+      node->finished = true;
+      node->finished_changed.notify_all();
+    }
+  }
+}
+
+EngineSession::~EngineSession() {
+  if (executor_ != nullptr) {
+    engine_->Run([this]() { executor_->CloseSession(); });
+  }
+}
+
+bool EngineSession::Open(
+    EngineDispatchQueue* engine,
+    windbg::IWinDbgCommandExecutor* executor,
+    std::string* error_message) {
+  bool opened = false;
+  engine->Run([&]() { opened = executor->OpenSession(error_message); });
+  if (opened) {
+    engine_ = engine;
+    executor_ = executor;
+  }
+  return opened;
+}
+
+}  // namespace dbgx::mcp
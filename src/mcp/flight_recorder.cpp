@@ -0,0 +1,99 @@
+#include "dbgx/mcp/flight_recorder.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "dbgx/mcp/json.hpp"
+
+namespace dbgx::mcp {
+
+void FlightText::Assign(std::string_view text) {
+  size = static_cast<std::uint8_t>(json::Utf8PrefixLength(text, kCapacity));
+  text.copy(bytes.data(), size);
+}
+
+std::string_view FlightOutcomeName(FlightOutcome outcome) {
+  switch (outcome) {
+    case FlightOutcome::kOk:
+      return "ok";
+    case FlightOutcome::kToolError:
+      return "tool_error";
+    case FlightOutcome::kError:
+      return "error";
+  }
+  return "unknown";
+}
+
+FlightRecorder::FlightRecorder(FlightRecorderOptions options)
+    : mask_(std::bit_ceil(std::max<std::size_t>(options.capacity, 1)) - 1),
+      slots_(std::make_unique<Slot[]>(mask_ + 1)) {}
+
+FlightRecorder::~FlightRecorder() = default;
+
+void FlightRecorder::Record(const FlightRecord& record) {
+  const std::uint64_t ticket = next_ticket_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[ticket & mask_];
+
+  // A slot is only claimed from a complete, older record; losing the race costs this record, not a wait.
+  std::uint64_t state = slot.state.load(std::memory_order_relaxed);
+  if ((state & 1) != 0 || (state != 0 && state / 2 - 1 >= ticket) ||
+      !slot.state.compare_exchange_strong(state, 2 * ticket + 1, std::memory_order_relaxed)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+
+  FlightRecord stamped = record;
+  stamped.sequence = ticket + 1;
+  const auto words = std::bit_cast<std::array<std::uint64_t, kRecordWords>>(stamped);
+  for (std::size_t index = 0; index < kRecordWords; ++index) {
+    slot.words[index].store(words[index], std::memory_order_relaxed);
+  }
+  slot.state.store(2 * ticket + 2, std::memory_order_release);
+}
+
+std::vector<FlightRecord> FlightRecorder::Snapshot() const {
+  std::vector<FlightRecord> records;
+  records.reserve(mask_ + 1);
+  std::array<std::uint64_t, kRecordWords> words;
+  for (std::size_t index = 0; index <= mask_; ++index) {
+    const Slot& slot = slots_[index];
+    const std::uint64_t state = slot.state.load(std::memory_order_acquire);
+    if (state == 0 || (state & 1) != 0) {
+      continue;
+    }
+    for (std::size_t word = 0; word < kRecordWords; ++word) {
+      words[word] = slot.words[word].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.state.load(std::memory_order_relaxed) != state) {
+      continue;
+    }
+    records.push_back(std::bit_cast<FlightRecord>(words));
+  }
+
+  std::sort(records.begin(), records.end(), [](const FlightRecord& left, const FlightRecord& right) {
+    return left.sequence < right.sequence;
+  });
+  return records;
+}
+
+LatencyPercentiles ComputeLatencyPercentiles(std::span<std::uint64_t> values) {
+  LatencyPercentiles percentiles;
+  percentiles.count = values.size();
+  if (values.empty()) {
+    return percentiles;
+  }
+  std::sort(values.begin(), values.end());
+  const auto rank = [&values](std::uint64_t percent) {
+    const std::uint64_t position = (percent * values.size() + 99) / 100;
+    return values[static_cast<std::size_t>(std::max<std::uint64_t>(position, 1) - 1)];
+  };
+  percentiles.p50 = rank(50);
+  percentiles.p90 = rank(90);
+  percentiles.p99 = rank(99);
+  percentiles.max = values.back();
+  return percentiles;
+}
+
+}  // namespace dbgx::mcp
@@ -2,10 +2,13 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <limits>
 #include <mutex>
+#include <span>
 #include <sstream>
+#include <string_view>
 #include <thread>
 
 #ifndef WIN32_LEAN_AND_MEAN
@@ -21,6 +24,9 @@ namespace {
 constexpr std::size_t kMaxHeaderBytes = 64 * 1024;
 constexpr std::size_t kMaxBodyBytes = 2 * 1024 * 1024;
 constexpr std::uint16_t kDefaultMaxPortAttempts = 16;
+constexpr std::size_t kMaxConcurrentConnections = 32;
+constexpr std::size_t kMaxSendBuffers = 16;
+constexpr std::size_t kMaxSendBufferBytes = 1U << 30;
 
 std::uint16_t ResolveMaxPortAttempts(const HttpServerStartOptions* start_options) {
   if (start_options == nullptr || start_options->max_port_attempts == 0) {
@@ -75,25 +81,50 @@ std::string StatusText(int status_code) {
       return "Method Not Allowed";
     case 500:
       return "Internal Server Error";
+    case 503:
+      return "Service Unavailable";
     default:
       return "Error";
   }
 }
 
-bool SendAll(SOCKET socket, const std::string& text) {
-  std::size_t sent_total = 0;
-  while (sent_total < text.size()) {
-    const int sent = send(
-        socket,
-        text.data() + sent_total,
-        static_cast<int>(text.size() - sent_total),
-        0);
-    if (sent <= 0) {
+// Sends the pieces back to back with one scatter-gather WSASend per round, so headers, body and chunk
+// framing are never concatenated into a single copy. Pieces are advanced in place past what was sent.
+bool SendBuffers(SOCKET socket, std::span<std::string_view> pieces) {
+  std::size_t first = 0;
+  while (true) {
+    while (first < pieces.size() && pieces[first].empty()) {
+      ++first;
+    }
+    if (first == pieces.size()) {
+      return true;
+    }
+
+    WSABUF buffers[kMaxSendBuffers];
+    DWORD buffer_count = 0;
+    for (std::size_t index = first; index < pieces.size() && buffer_count < kMaxSendBuffers; ++index) {
+      buffers[buffer_count].buf = const_cast<char*>(pieces[index].data());
+      buffers[buffer_count].len = static_cast<ULONG>(std::min(pieces[index].size(), kMaxSendBufferBytes));
+      ++buffer_count;
+    }
+    DWORD sent = 0;
+    if (WSASend(socket, buffers, buffer_count, &sent, 0, nullptr, nullptr) == SOCKET_ERROR || sent == 0) {
       return false;
     }
-    sent_total += static_cast<std::size_t>(sent);
+
+    std::size_t remaining = sent;
+    while (remaining != 0 && remaining >= pieces[first].size()) {
+      remaining -= pieces[first].size();
+      ++first;
+    }
+    if (remaining != 0) {
+      pieces[first].remove_prefix(remaining);
+    }
   }
-  return true;
+}
+
+bool SendAll(SOCKET socket, std::string_view text) {
+  return SendBuffers(socket, std::span<std::string_view>(&text, 1));
 }
 
 bool ParseRequestLine(std::string_view line, HttpRequest* request) {
@@ -269,7 +300,8 @@ bool ReceiveRequest(SOCKET socket, HttpRequest* out_request, std::string* error_
   return false;
 }
 
-std::string BuildHttpResponseText(const HttpResponse& response) {
+// Status line and headers only; the body is sent from response.body as its own scatter piece.
+std::string BuildHttpResponseHead(const HttpResponse& response) {
   std::ostringstream output;
   output << "HTTP/1.1 " << response.status_code << ' ' << StatusText(response.status_code) << "\r\n";
   output << "Connection: close\r\n";
@@ -280,7 +312,6 @@ std::string BuildHttpResponseText(const HttpResponse& response) {
            << "\r\n";
     output << "Content-Length: " << response.body.size() << "\r\n";
     output << "\r\n";
-    output << response.body;
   } else {
     output << "Content-Length: 0\r\n\r\n";
   }
@@ -288,6 +319,92 @@ std::string BuildHttpResponseText(const HttpResponse& response) {
   return output.str();
 }
 
+bool SendResponse(SOCKET socket, const HttpResponse& response) {
+  const std::string head = BuildHttpResponseHead(response);
+  std::string_view pieces[] = {head, response.has_body ? std::string_view(response.body) : std::string_view()};
+  return SendBuffers(socket, pieces);
+}
+
+std::string BuildStreamedResponseHead(const HttpResponse& response) {
+  std::ostringstream output;
+  output << "HTTP/1.1 " << response.status_code << ' ' << StatusText(response.status_code) << "\r\n";
+  output << "Connection: close\r\n";
+  output << "Content-Type: "
+         << (response.content_type.empty() ? "application/json; charset=utf-8" : response.content_type)
+         << "\r\n";
+  output << "Transfer-Encoding: chunked\r\n\r\n";
+  return output.str();
+}
+
+bool SendChunk(SOCKET socket, std::string_view chunk) {
+  if (chunk.empty()) {
+    return true;
+  }
+
+  static constexpr char kHex[] = "0123456789abcdef";
+  char size_line[2 * sizeof(std::size_t) + 2];
+  char* size_begin = size_line + sizeof(size_line) - 2;
+  size_begin[0] = '\r';
+  size_begin[1] = '\n';
+  std::size_t size = chunk.size();
+  do {
+    *--size_begin = kHex[size & 0x0F];
+    size >>= 4;
+  } while (size != 0);
+  std::string_view pieces[] = {
+      std::string_view(size_begin, static_cast<std::size_t>(size_line + sizeof(size_line) - size_begin)),
+      chunk,
+      "\r\n"};
+  return SendBuffers(socket, pieces);
+}
+
+void SendStreamedResponse(SOCKET socket, const HttpResponse& response) {
+  if (!SendAll(socket, BuildStreamedResponseHead(response))) {
+    return;
+  }
+
+  bool connection_ok = true;
+  response.body_stream([socket, &connection_ok](std::string_view chunk) {
+    if (connection_ok) {
+      connection_ok = SendChunk(socket, chunk);
+    }
+    return connection_ok;
+  });
+
+  if (connection_ok) {
+    SendAll(socket, "0\r\n\r\n");
+  }
+}
+
+void ServeConnection(SOCKET client_socket, const HttpRequestHandler& handler, SpanTracer* tracer) {
+  HttpRequest request;
+  std::string parse_error;
+  HttpResponse response;
+  bool received = false;
+  {
+    const TraceScope receive_span(tracer, TraceStage::kReceive);
+    received = ReceiveRequest(client_socket, &request, &parse_error);
+  }
+  if (received) {
+    response = handler(request);
+  } else {
+    response.status_code = 400;
+    response.body = "{\"error\":\"" + parse_error + "\"}";
+  }
+
+  {
+    // A streamed body is produced while it is sent, so its handling nests inside this span.
+    const TraceScope send_span(tracer, TraceStage::kSend);
+    if (response.body_stream) {
+      SendStreamedResponse(client_socket, response);
+    } else {
+      SendResponse(client_socket, response);
+    }
+  }
+  shutdown(client_socket, SD_BOTH);
+  closesocket(client_socket);
+}
+
 }  // namespace
 
 struct HttpServer::Impl {
@@ -297,10 +414,91 @@ struct HttpServer::Impl {
   SOCKET listen_socket = INVALID_SOCKET;
   std::thread worker;
   HttpRequestHandler handler;
+  MetricsExporter metrics_exporter;
+  SpanTracer* tracer = nullptr;
   std::uint16_t bound_port = 0;
   bool wsa_initialized = false;
+
+  // Each accepted connection is served on its own detached thread so a long tools/call does not block
+  // notifications/cancelled or metadata requests. Stop waits for the count to drain.
+  std::mutex connections_mutex;
+  std::condition_variable connections_drained;
+  std::size_t active_connections = 0;
+  std::atomic<std::uint64_t> rejected_connections{0};
+
+  HttpResponse ServeMetrics(const HttpRequest& request);
+  HttpResponse ServeTrace(const HttpRequest& request);
 };
 
+namespace {
+
+bool RejectForeignOrigin(const HttpRequest& request, HttpResponse* response) {
+  const auto origin_it = request.headers.find("origin");
+  if (origin_it == request.headers.end() || IsOriginAllowed(origin_it->second)) {
+    return false;
+  }
+  response->status_code = 403;
+  response->body = "{\"error\":\"Forbidden origin\"}";
+  return true;
+}
+
+}  // namespace
+
+HttpResponse HttpServer::Impl::ServeMetrics(const HttpRequest& request) {
+  HttpResponse response;
+  if (RejectForeignOrigin(request, &response)) {
+    return response;
+  }
+  if (request.method != "GET") {
+    response.status_code = 405;
+    response.body = "{\"error\":\"Method Not Allowed\"}";
+    return response;
+  }
+
+  std::size_t connections = 0;
+  {
+    std::lock_guard<std::mutex> connections_lock(connections_mutex);
+    connections = active_connections;
+  }
+  PrometheusWriter writer;
+  writer.BeginFamily("dbgx_mcp_active_connections", "gauge", "Connections being served, including this one.");
+  writer.WriteSample("dbgx_mcp_active_connections", {}, connections);
+  writer.BeginFamily(
+      "dbgx_mcp_rejected_connections_total", "counter", "Connections refused because too many were open.");
+  writer.WriteSample(
+      "dbgx_mcp_rejected_connections_total", {}, rejected_connections.load(std::memory_order_relaxed));
+  metrics_exporter(&writer);
+
+  response.content_type = std::string(kPrometheusContentType);
+  response.body = writer.TakeText();
+  return response;
+}
+
+HttpResponse HttpServer::Impl::ServeTrace(const HttpRequest& request) {
+  HttpResponse response;
+  if (RejectForeignOrigin(request, &response)) {
+    return response;
+  }
+  const bool is_get = request.method == "GET";
+  const bool is_post = request.method == "POST";
+  if (request.path == "/trace" && is_get) {
+    response.body = tracer->ChromeTraceJson();
+  } else if (request.path == "/trace/start" && is_post) {
+    tracer->Start();
+    response.body = "{\"tracing\":true}";
+  } else if (request.path == "/trace/stop" && is_post) {
+    tracer->Stop();
+    response.body = "{\"tracing\":false}";
+  } else if (request.path == "/trace" || request.path == "/trace/start" || request.path == "/trace/stop") {
+    response.status_code = 405;
+    response.body = "{\"error\":\"Method Not Allowed\"}";
+  } else {
+    response.status_code = 404;
+    response.body = "{\"error\":\"Not Found\"}";
+  }
+  return response;
+}
+
 bool IsOriginAllowed(std::string_view origin_header) {
   if (origin_header.empty()) {
     return true;
@@ -482,6 +680,19 @@ bool HttpServer::Start(
   update_start_report();
 
   impl_->handler = std::move(handler);
+  impl_->metrics_exporter = start_options != nullptr ? start_options->metrics_exporter : nullptr;
+  impl_->tracer = start_options != nullptr ? start_options->tracer : nullptr;
+  if (impl_->metrics_exporter || impl_->tracer != nullptr) {
+    impl_->handler = [impl = impl_.get(), handler = std::move(impl_->handler)](const HttpRequest& request) {
+      if (impl->metrics_exporter && request.path == "/metrics") {
+        return impl->ServeMetrics(request);
+      }
+      if (impl->tracer != nullptr && request.path.starts_with("/trace")) {
+        return impl->ServeTrace(request);
+      }
+      return handler(request);
+    };
+  }
   impl_->stop_requested.store(false);
   impl_->running.store(true);
 
@@ -505,20 +716,38 @@ bool HttpServer::Start(
         continue;
       }
 
-      HttpRequest request;
-      std::string parse_error;
-      HttpResponse response;
-      if (ReceiveRequest(client_socket, &request, &parse_error)) {
-        response = impl_->handler(request);
-      } else {
-        response.status_code = 400;
-        response.body = "{\"error\":\"" + parse_error + "\"}";
+      bool accepted = false;
+      {
+        std::lock_guard<std::mutex> connections_lock(impl_->connections_mutex);
+        if (impl_->active_connections < kMaxConcurrentConnections) {
+          ++impl_->active_connections;
+          accepted = true;
+        }
       }
 
-      const std::string response_text = BuildHttpResponseText(response);
-      SendAll(client_socket, response_text);
-      shutdown(client_socket, SD_BOTH);
-      closesocket(client_socket);
+      if (!accepted) {
+        impl_->rejected_connections.fetch_add(1, std::memory_order_relaxed);
+        HttpResponse busy_response;
+        busy_response.status_code = 503;
+        busy_response.body = "{\"error\":\"Too many concurrent connections\"}";
+        SendResponse(client_socket, busy_response);
+        shutdown(client_socket, SD_BOTH);
+        closesocket(client_socket);
+        continue;
+      }
+
+      const std::uint64_t accepted_at =
+          impl_->tracer != nullptr && impl_->tracer->IsEnabled() ? MonotonicNanoseconds() : 0;
+      std::thread([impl = impl_.get(), client_socket, accepted_at]() {
+        // Covers handing the socket to its connection thread.
+        if (accepted_at != 0) {
+          impl->tracer->Record(TraceStage::kAccept, accepted_at, MonotonicNanoseconds());
+        }
+        ServeConnection(client_socket, impl->handler, impl->tracer);
+        std::lock_guard<std::mutex> connections_lock(impl->connections_mutex);
+        --impl->active_connections;
+        impl->connections_drained.notify_all();
+      }).detach();
     }
 
     impl_->running.store(false);
@@ -549,6 +778,11 @@ void HttpServer::Stop() {
     impl_->worker.join();
   }
 
+  {
+    std::unique_lock<std::mutex> connections_lock(impl_->connections_mutex);
+    impl_->connections_drained.wait(connections_lock, [this]() { return impl_->active_connections == 0; });
+  }
+
   impl_->running.store(false);
 
   if (impl_->wsa_initialized) {
@@ -1,11 +1,12 @@
 #include "dbgx/mcp/io_echo.hpp"
 
 #include <algorithm>
-#include <cctype>
+#include <array>
+#include <charconv>
 #include <cstdint>
+#include <cstring>
 #include <string>
 #include <string_view>
-#include <vector>
 
 #include "dbgx/mcp/json.hpp"
 
@@ -13,353 +14,436 @@ namespace dbgx::mcp {
 
 namespace {
 
-constexpr std::size_t kSummaryValueLimit = 160;
 constexpr std::string_view kTruncatedSuffix = "...(truncated)";
+// Listed in the order the summary reports them.
+constexpr std::array<std::string_view, 3> kSensitiveHeaderNames = {
+    "authorization",
+    "proxy-authorization",
+    "x-api-key",
+};
 
-struct ResponseIoMeta {
+// Views into the body, or into the storage strings for the rare escaped JSON string. Filled in place
+// because the views may point into the storage.
+struct RequestIoView {
   bool parseable = false;
+  bool has_rpc_method = false;
   bool has_rpc_id = false;
-  std::string rpc_id_raw;
+  bool has_tool_name = false;
+  std::string_view rpc_method;
+  std::string_view rpc_id_raw;
+  std::string_view tool_name;
+  std::string rpc_method_storage;
+  std::string tool_name_storage;
+};
+
+struct ResponseIoView {
+  bool parseable = false;
+  bool has_rpc_id = false;
+  std::string_view rpc_id_raw;
   bool has_error = false;
-  std::string error_raw;
+  std::string_view error_raw;
   bool has_result = false;
-  std::string result_raw;
-  std::string rpc_outcome = "unknown";
+  std::string_view result_raw;
+  std::string_view rpc_outcome = "unknown";
 };
 
-std::string ToLowerAscii(std::string_view value) {
-  std::string lowered;
-  lowered.reserve(value.size());
-  for (const unsigned char ch : value) {
-    lowered.push_back(static_cast<char>(std::tolower(ch)));
-  }
-  return lowered;
-}
-
-bool IsSensitiveHeaderName(std::string_view header_name) {
-  const std::string lowered = ToLowerAscii(header_name);
-  return lowered == "authorization" || lowered == "proxy-authorization" || lowered == "x-api-key";
-}
-
-bool IsJsonTrueLiteral(std::string_view raw) {
-  return json::Trim(raw) == "true";
-}
-
-std::string SanitizeSingleLine(std::string_view value) {
-  std::string sanitized;
-  sanitized.reserve(value.size());
-
-  for (const char ch : value) {
-    if (ch == '\r' || ch == '\n' || ch == '\t') {
-      sanitized.push_back(' ');
-      continue;
+// Appends to a fixed buffer and silently stops at its end. Values are cut before they are copied, so a
+// 10 MB result costs the same as a short one.
+class SummaryWriter {
+ public:
+  explicit SummaryWriter(IoSummaryBuffer* buffer) : buffer_(buffer) {}
+
+  void Append(std::string_view text) {
+    const std::size_t count = std::min(text.size(), buffer_->size() - size_);
+    std::memcpy(buffer_->data() + size_, text.data(), count);
+    size_ += count;
+  }
+
+  template <typename Number>
+  void AppendNumber(Number value) {
+    char digits[24];
+    const std::to_chars_result converted = std::to_chars(digits, digits + sizeof(digits), value);
+    Append(std::string_view(digits, static_cast<std::size_t>(converted.ptr - digits)));
+  }
+
+  // Keeps the value on one line and marks anything beyond kSummaryValueLimit as truncated.
+  void AppendValue(std::string_view value) {
+    const std::size_t start = size_;
+    Append(value.substr(0, kSummaryValueLimit));
+    for (std::size_t index = start; index < size_; ++index) {
+      char& ch = (*buffer_)[index];
+      if (ch == '\r' || ch == '\n' || ch == '\t') {
+        ch = ' ';
+      }
+    }
+    if (value.size() > kSummaryValueLimit) {
+      Append(kTruncatedSuffix);
     }
-    sanitized.push_back(ch);
   }
 
-  return sanitized;
-}
-
-std::string TruncateForSummary(std::string_view value) {
-  const std::string sanitized = SanitizeSingleLine(value);
-  if (sanitized.size() <= kSummaryValueLimit) {
-    return sanitized;
+  void AppendField(std::string_view prefix, std::string_view value) {
+    Append(prefix);
+    AppendValue(value);
   }
 
-  std::string truncated = sanitized.substr(0, kSummaryValueLimit);
-  truncated += kTruncatedSuffix;
-  return truncated;
-}
-
-std::string JoinValues(const std::vector<std::string>& values) {
-  if (values.empty()) {
-    return {};
+  std::string_view View() const {
+    return std::string_view(buffer_->data(), size_);
   }
 
-  std::string joined = values.front();
-  for (std::size_t i = 1; i < values.size(); ++i) {
-    joined += ",";
-    joined += values[i];
-  }
-  return joined;
-}
+ private:
+  IoSummaryBuffer* buffer_;
+  std::size_t size_ = 0;
+};
 
-std::string BuildSensitiveHeadersSummary(const HttpRequest& request) {
-  std::vector<std::string> masked_headers;
-  masked_headers.reserve(request.headers.size());
+bool EqualsIgnoreAsciiCase(std::string_view left, std::string_view right) {
+  return std::equal(left.begin(), left.end(), right.begin(), right.end(), [](char lhs, char rhs) {
+    const auto lower = [](char ch) { return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch; };
+    return lower(lhs) == lower(rhs);
+  });
+}
 
+void AppendSensitiveHeaders(const HttpRequest& request, SummaryWriter* writer) {
+  std::array<std::size_t, kSensitiveHeaderNames.size()> counts{};
   for (const auto& [header_name, header_value] : request.headers) {
-    if (!IsSensitiveHeaderName(header_name)) {
-      continue;
+    for (std::size_t index = 0; index < kSensitiveHeaderNames.size(); ++index) {
+      if (EqualsIgnoreAsciiCase(header_name, kSensitiveHeaderNames[index])) {
+        ++counts[index];
+        break;
+      }
     }
+  }
 
-    const std::string lower_name = ToLowerAscii(header_name);
-    if (header_value.empty()) {
-      masked_headers.push_back(lower_name + "=<masked>");
-      continue;
+  writer->Append(" sensitive_headers=");
+  bool any = false;
+  for (std::size_t index = 0; index < kSensitiveHeaderNames.size(); ++index) {
+    for (std::size_t count = 0; count < counts[index]; ++count) {
+      if (any) {
+        writer->Append(",");
+      }
+      writer->Append(kSensitiveHeaderNames[index]);
+      writer->Append("=<masked>");
+      any = true;
     }
-
-    masked_headers.push_back(lower_name + "=<masked>");
   }
-
-  std::sort(masked_headers.begin(), masked_headers.end());
-
-  if (masked_headers.empty()) {
-    return "sensitive_headers=none";
+  if (!any) {
+    writer->Append("none");
   }
-
-  return "sensitive_headers=" + JoinValues(masked_headers);
 }
 
-RequestIoMeta ParseRequestIoMetaFromBody(std::string_view request_body) {
-  RequestIoMeta meta;
+bool StringValueView(std::string_view raw_value, std::string* storage, std::string_view* out_value) {
+  if (raw_value.size() >= 2 && raw_value.front() == '"' && raw_value.back() == '"' &&
+      raw_value.find('\\') == std::string_view::npos) {
+    *out_value = raw_value.substr(1, raw_value.size() - 2);
+    return true;
+  }
+  if (!json::ParseStringValue(raw_value, storage)) {
+    return false;
+  }
+  *out_value = *storage;
+  return true;
+}
 
-  json::FieldMap root_fields;
-  std::string parse_error;
-  if (!json::ParseObjectFields(request_body, &root_fields, &parse_error)) {
-    return meta;
+void ParseRequestIoView(std::string_view request_body, RequestIoView* view) {
+  if (json::IsArrayText(request_body)) {
+    view->parseable = true;
+    view->has_rpc_method = true;
+    view->rpc_method = "batch";
+    return;
   }
 
-  meta.parseable = true;
-  if (json::TryGetStringField(root_fields, "method", &meta.rpc_method)) {
-    meta.has_rpc_method = true;
+  bool has_method = false;
+  bool has_params = false;
+  std::string_view method_raw;
+  std::string_view id_raw;
+  std::string_view params_raw;
+  json::ObjectFieldCursor root(request_body);
+  std::string_view key;
+  std::string_view raw_value;
+  while (root.Next(&key, &raw_value)) {
+    if (key == "method") {
+      has_method = true;
+      method_raw = raw_value;
+    } else if (key == "id") {
+      view->has_rpc_id = true;
+      id_raw = raw_value;
+    } else if (key == "params") {
+      has_params = true;
+      params_raw = raw_value;
+    }
   }
-  if (json::TryGetRawField(root_fields, "id", &meta.rpc_id_raw)) {
-    meta.has_rpc_id = true;
+  if (root.Failed()) {
+    view->has_rpc_id = false;
+    return;
   }
 
-  if (!meta.has_rpc_method || meta.rpc_method != "tools/call") {
-    return meta;
+  view->parseable = true;
+  view->rpc_id_raw = id_raw;
+  view->has_rpc_method = has_method && StringValueView(method_raw, &view->rpc_method_storage, &view->rpc_method);
+  if (!view->has_rpc_method || view->rpc_method != "tools/call" || !has_params) {
+    return;
   }
 
-  json::FieldMap params_fields;
-  if (!json::TryGetObjectField(root_fields, "params", &params_fields, &parse_error)) {
-    return meta;
+  bool has_name = false;
+  std::string_view name_raw;
+  json::ObjectFieldCursor params(params_raw);
+  while (params.Next(&key, &raw_value)) {
+    if (key == "name") {
+      has_name = true;
+      name_raw = raw_value;
+    }
   }
-
-  if (json::TryGetStringField(params_fields, "name", &meta.tool_name)) {
-    meta.has_tool_name = true;
+  if (params.Failed()) {
+    return;
   }
-  return meta;
+  view->has_tool_name = has_name && StringValueView(name_raw, &view->tool_name_storage, &view->tool_name);
 }
 
-ResponseIoMeta ParseResponseIoMeta(std::string_view response_body) {
-  ResponseIoMeta meta;
-
-  json::FieldMap root_fields;
-  std::string parse_error;
-  if (!json::ParseObjectFields(response_body, &root_fields, &parse_error)) {
-    return meta;
+ResponseIoView ParseResponseIoView(std::string_view response_body) {
+  ResponseIoView view;
+
+  json::ObjectFieldCursor root(response_body);
+  std::string_view key;
+  std::string_view raw_value;
+  while (root.Next(&key, &raw_value)) {
+    if (key == "id") {
+      view.has_rpc_id = true;
+      view.rpc_id_raw = raw_value;
+    } else if (key == "error") {
+      view.has_error = true;
+      view.error_raw = raw_value;
+    } else if (key == "result") {
+      view.has_result = true;
+      view.result_raw = raw_value;
+    }
   }
-
-  meta.parseable = true;
-  if (json::TryGetRawField(root_fields, "id", &meta.rpc_id_raw)) {
-    meta.has_rpc_id = true;
+  if (root.Failed()) {
+    return ResponseIoView{};
   }
 
-  if (json::TryGetRawField(root_fields, "error", &meta.error_raw)) {
-    meta.has_error = true;
-    meta.rpc_outcome = "error";
-    return meta;
+  view.parseable = true;
+  if (view.has_error) {
+    view.has_result = false;
+    view.rpc_outcome = "error";
+    return view;
   }
 
-  if (json::TryGetRawField(root_fields, "result", &meta.result_raw)) {
-    meta.has_result = true;
-    meta.rpc_outcome = "success";
-
-    json::FieldMap result_fields;
-    if (json::ParseObjectFields(meta.result_raw, &result_fields, &parse_error)) {
-      std::string is_error_raw;
-      if (json::TryGetRawField(result_fields, "isError", &is_error_raw) && IsJsonTrueLiteral(is_error_raw)) {
-        meta.rpc_outcome = "error";
-      }
-    }
-    return meta;
+  if (view.has_result) {
+    view.rpc_outcome = "success";
   }
-
-  return meta;
+  return view;
 }
 
-void AppendTraceContext(const IoTraceContext* trace_context, std::string* summary) {
-  if (trace_context == nullptr) {
-    return;
-  }
-
-  if (!trace_context->trace_id.empty()) {
-    *summary += " trace_id=" + TruncateForSummary(trace_context->trace_id);
+void AppendTraceContext(const IoTraceContext& trace_context, SummaryWriter* writer) {
+  if (!trace_context.trace_id.empty()) {
+    writer->AppendField(" trace_id=", trace_context.trace_id);
   }
-  if (!trace_context->stage.empty()) {
-    *summary += " stage=" + TruncateForSummary(trace_context->stage);
+  if (!trace_context.stage.empty()) {
+    writer->AppendField(" stage=", trace_context.stage);
   }
-  *summary += " duration_ms=" + std::to_string(trace_context->duration_ms);
+  writer->Append(" duration_ms=");
+  writer->AppendNumber(trace_context.duration_ms);
 }
 
-void AppendRpcRequestMeta(
-    const RequestIoMeta& request_meta,
-    const IoTraceContext* trace_context,
-    std::string* summary) {
-  std::string rpc_method = "(missing)";
-  if (trace_context != nullptr && !trace_context->rpc_method.empty()) {
-    rpc_method = trace_context->rpc_method;
-  } else if (request_meta.has_rpc_method) {
-    rpc_method = request_meta.rpc_method;
+void AppendRpcRequestMeta(const RequestIoView& request_view, const IoTraceContext& trace_context, SummaryWriter* writer) {
+  std::string_view rpc_method = "(missing)";
+  if (!trace_context.rpc_method.empty()) {
+    rpc_method = trace_context.rpc_method;
+  } else if (request_view.has_rpc_method) {
+    rpc_method = request_view.rpc_method;
   }
-  *summary += " rpc_method=" + TruncateForSummary(rpc_method);
+  writer->AppendField(" rpc_method=", rpc_method);
 
-  std::string rpc_id = "(missing)";
-  if (trace_context != nullptr && !trace_context->rpc_id.empty()) {
-    rpc_id = trace_context->rpc_id;
-  } else if (request_meta.has_rpc_id) {
-    rpc_id = request_meta.rpc_id_raw;
+  std::string_view rpc_id = "(missing)";
+  if (!trace_context.rpc_id.empty()) {
+    rpc_id = trace_context.rpc_id;
+  } else if (request_view.has_rpc_id) {
+    rpc_id = request_view.rpc_id_raw;
   }
-  *summary += " rpc_id=" + TruncateForSummary(rpc_id);
+  writer->AppendField(" rpc_id=", rpc_id);
 
-  std::string tool_name;
-  if (trace_context != nullptr && !trace_context->tool_name.empty()) {
-    tool_name = trace_context->tool_name;
-  } else if (request_meta.has_tool_name) {
-    tool_name = request_meta.tool_name;
+  std::string_view tool_name;
+  if (!trace_context.tool_name.empty()) {
+    tool_name = trace_context.tool_name;
+  } else if (request_view.has_tool_name) {
+    tool_name = request_view.tool_name;
   }
 
   if (!tool_name.empty() || rpc_method == "tools/call") {
-    *summary += " tool=" + TruncateForSummary(tool_name.empty() ? "(missing)" : tool_name);
+    writer->AppendField(" tool=", tool_name.empty() ? "(missing)" : tool_name);
   }
 }
 
 void AppendRpcResponseMeta(
-    const ResponseIoMeta& response_meta,
-    const IoTraceContext* trace_context,
-    std::string* summary) {
-  std::string rpc_id;
-  if (trace_context != nullptr && !trace_context->rpc_id.empty()) {
-    rpc_id = trace_context->rpc_id;
-  } else if (response_meta.has_rpc_id) {
-    rpc_id = response_meta.rpc_id_raw;
+    const ResponseIoView& response_view,
+    const IoTraceContext& trace_context,
+    SummaryWriter* writer) {
+  std::string_view rpc_id;
+  if (!trace_context.rpc_id.empty()) {
+    rpc_id = trace_context.rpc_id;
+  } else if (response_view.has_rpc_id) {
+    rpc_id = response_view.rpc_id_raw;
   }
   if (!rpc_id.empty()) {
-    *summary += " rpc_id=" + TruncateForSummary(rpc_id);
+    writer->AppendField(" rpc_id=", rpc_id);
   }
 
-  std::string rpc_outcome;
-  if (trace_context != nullptr && !trace_context->outcome.empty()) {
-    rpc_outcome = trace_context->outcome;
-  } else {
-    rpc_outcome = response_meta.rpc_outcome;
+  std::string_view rpc_outcome = response_view.rpc_outcome;
+  if (!trace_context.outcome.empty()) {
+    rpc_outcome = trace_context.outcome;
+  } else if (trace_context.is_error) {
+    rpc_outcome = "error";
   }
-  *summary += " rpc_outcome=" + TruncateForSummary(rpc_outcome.empty() ? "unknown" : rpc_outcome);
+  writer->AppendField(" rpc_outcome=", rpc_outcome.empty() ? "unknown" : rpc_outcome);
 
-  if (trace_context != nullptr && !trace_context->tool_name.empty()) {
-    *summary += " tool=" + TruncateForSummary(trace_context->tool_name);
+  if (!trace_context.tool_name.empty()) {
+    writer->AppendField(" tool=", trace_context.tool_name);
   }
 
-  if (response_meta.has_error) {
-    *summary += " error=" + TruncateForSummary(response_meta.error_raw);
+  if (response_view.has_error) {
+    writer->AppendField(" error=", response_view.error_raw);
     return;
   }
 
-  if (response_meta.has_result) {
-    *summary += " result=" + TruncateForSummary(response_meta.result_raw);
+  if (response_view.has_result) {
+    writer->AppendField(" result=", response_view.result_raw);
   }
 }
 
-}  // namespace
-
-std::string BuildRequestIoSummary(const HttpRequest& request) {
-  return BuildRequestIoSummary(request, IoTraceContext{});
+void AppendContextRpcFields(const IoTraceContext& trace_context, SummaryWriter* writer) {
+  if (!trace_context.rpc_id.empty()) {
+    writer->AppendField(" rpc_id=", trace_context.rpc_id);
+  }
+  if (!trace_context.outcome.empty()) {
+    writer->AppendField(" rpc_outcome=", trace_context.outcome);
+  }
+  if (!trace_context.tool_name.empty()) {
+    writer->AppendField(" tool=", trace_context.tool_name);
+  }
 }
 
-std::string BuildRequestIoSummary(const HttpRequest& request, const IoTraceContext& trace_context) {
-  std::string summary = "mcp.request method=" + TruncateForSummary(request.method);
-  AppendTraceContext(&trace_context, &summary);
-  summary += " path=" + TruncateForSummary(request.path);
+}  // namespace
 
-  const RequestIoMeta request_meta = ParseRequestIoMetaFromBody(request.body);
-  if (request_meta.parseable) {
-    AppendRpcRequestMeta(request_meta, &trace_context, &summary);
+std::string_view FormatRequestIoSummary(
+    const HttpRequest& request,
+    const IoTraceContext& trace_context,
+    IoSummaryBuffer* buffer) {
+  SummaryWriter writer(buffer);
+  writer.AppendField("mcp.request method=", request.method);
+  AppendTraceContext(trace_context, &writer);
+  writer.AppendField(" path=", request.path);
+
+  RequestIoView request_view;
+  ParseRequestIoView(request.body, &request_view);
+  if (request_view.parseable) {
+    AppendRpcRequestMeta(request_view, trace_context, &writer);
   } else {
-    summary += " rpc_meta=unparseable";
+    writer.Append(" rpc_meta=unparseable");
     if (!trace_context.rpc_method.empty()) {
-      summary += " rpc_method=" + TruncateForSummary(trace_context.rpc_method);
+      writer.AppendField(" rpc_method=", trace_context.rpc_method);
     }
     if (!trace_context.rpc_id.empty()) {
-      summary += " rpc_id=" + TruncateForSummary(trace_context.rpc_id);
+      writer.AppendField(" rpc_id=", trace_context.rpc_id);
     }
     if (!trace_context.tool_name.empty()) {
-      summary += " tool=" + TruncateForSummary(trace_context.tool_name);
+      writer.AppendField(" tool=", trace_context.tool_name);
     }
   }
 
-  summary += " body_bytes=" + std::to_string(request.body.size());
-  summary += " " + BuildSensitiveHeadersSummary(request);
-  return summary;
+  writer.Append(" body_bytes=");
+  writer.AppendNumber(request.body.size());
+  AppendSensitiveHeaders(request, &writer);
+  return writer.View();
+}
+
+std::string BuildRequestIoSummary(const HttpRequest& request) {
+  return BuildRequestIoSummary(request, IoTraceContext{});
+}
+
+std::string BuildRequestIoSummary(const HttpRequest& request, const IoTraceContext& trace_context) {
+  IoSummaryBuffer buffer;
+  return std::string(FormatRequestIoSummary(request, trace_context, &buffer));
 }
 
 RequestIoMeta ParseRequestIoMeta(const HttpRequest& request) {
-  return ParseRequestIoMetaFromBody(request.body);
+  RequestIoView view;
+  ParseRequestIoView(request.body, &view);
+
+  RequestIoMeta meta;
+  meta.parseable = view.parseable;
+  meta.has_rpc_method = view.has_rpc_method;
+  meta.has_rpc_id = view.has_rpc_id;
+  meta.has_tool_name = view.has_tool_name;
+  meta.rpc_method = view.rpc_method;
+  meta.rpc_id_raw = view.rpc_id_raw;
+  meta.tool_name = view.tool_name;
+  return meta;
 }
 
-std::string BuildLifecycleIoSummary(const IoTraceContext& trace_context, std::string_view message) {
-  std::string summary = "mcp.stage";
-  AppendTraceContext(&trace_context, &summary);
+std::string_view FormatLifecycleIoSummary(
+    const IoTraceContext& trace_context,
+    std::string_view message,
+    IoSummaryBuffer* buffer) {
+  SummaryWriter writer(buffer);
+  writer.Append("mcp.stage");
+  AppendTraceContext(trace_context, &writer);
 
   if (!trace_context.rpc_method.empty()) {
-    summary += " rpc_method=" + TruncateForSummary(trace_context.rpc_method);
+    writer.AppendField(" rpc_method=", trace_context.rpc_method);
   }
   if (!trace_context.rpc_id.empty()) {
-    summary += " rpc_id=" + TruncateForSummary(trace_context.rpc_id);
+    writer.AppendField(" rpc_id=", trace_context.rpc_id);
   }
   if (!trace_context.tool_name.empty()) {
-    summary += " tool=" + TruncateForSummary(trace_context.tool_name);
+    writer.AppendField(" tool=", trace_context.tool_name);
   }
   if (!trace_context.outcome.empty()) {
-    summary += " outcome=" + TruncateForSummary(trace_context.outcome);
+    writer.AppendField(" outcome=", trace_context.outcome);
   }
   if (!message.empty()) {
-    summary += " msg=" + TruncateForSummary(message);
+    writer.AppendField(" msg=", message);
   }
-  return summary;
+  return writer.View();
 }
 
-std::string BuildResponseIoSummary(const HttpResponse& response) {
-  return BuildResponseIoSummary(response, IoTraceContext{});
+std::string BuildLifecycleIoSummary(const IoTraceContext& trace_context, std::string_view message) {
+  IoSummaryBuffer buffer;
+  return std::string(FormatLifecycleIoSummary(trace_context, message, &buffer));
 }
 
-std::string BuildResponseIoSummary(const HttpResponse& response, const IoTraceContext& trace_context) {
-  std::string summary = "mcp.response status=" + std::to_string(response.status_code);
-  AppendTraceContext(&trace_context, &summary);
-  summary += response.has_body ? " has_body=true" : " has_body=false";
+std::string_view FormatResponseIoSummary(
+    const HttpResponse& response,
+    const IoTraceContext& trace_context,
+    IoSummaryBuffer* buffer) {
+  SummaryWriter writer(buffer);
+  writer.Append("mcp.response status=");
+  writer.AppendNumber(response.status_code);
+  AppendTraceContext(trace_context, &writer);
+  writer.Append(response.has_body ? " has_body=true" : " has_body=false");
 
   if (!response.has_body) {
-    if (!trace_context.rpc_id.empty()) {
-      summary += " rpc_id=" + TruncateForSummary(trace_context.rpc_id);
-    }
-    if (!trace_context.outcome.empty()) {
-      summary += " rpc_outcome=" + TruncateForSummary(trace_context.outcome);
-    }
-    if (!trace_context.tool_name.empty()) {
-      summary += " tool=" + TruncateForSummary(trace_context.tool_name);
-    }
-    return summary;
+    AppendContextRpcFields(trace_context, &writer);
+    return writer.View();
   }
 
-  const ResponseIoMeta response_meta = ParseResponseIoMeta(response.body);
-  if (response_meta.parseable) {
-    AppendRpcResponseMeta(response_meta, &trace_context, &summary);
-    return summary;
+  const ResponseIoView response_view = ParseResponseIoView(response.body);
+  if (response_view.parseable) {
+    AppendRpcResponseMeta(response_view, trace_context, &writer);
+    return writer.View();
   }
 
-  summary += " rpc_meta=unparseable";
-  if (!trace_context.rpc_id.empty()) {
-    summary += " rpc_id=" + TruncateForSummary(trace_context.rpc_id);
-  }
-  if (!trace_context.outcome.empty()) {
-    summary += " rpc_outcome=" + TruncateForSummary(trace_context.outcome);
-  }
-  if (!trace_context.tool_name.empty()) {
-    summary += " tool=" + TruncateForSummary(trace_context.tool_name);
-  }
-  summary += " body=" + TruncateForSummary(response.body.empty() ? "(empty)" : response.body);
-  return summary;
+  writer.Append(" rpc_meta=unparseable");
+  AppendContextRpcFields(trace_context, &writer);
+  writer.AppendField(" body=", response.body.empty() ? std::string_view("(empty)") : std::string_view(response.body));
+  return writer.View();
+}
+
+std::string BuildResponseIoSummary(const HttpResponse& response) {
+  return BuildResponseIoSummary(response, IoTraceContext{});
+}
+
+std::string BuildResponseIoSummary(const HttpResponse& response, const IoTraceContext& trace_context) {
+  IoSummaryBuffer buffer;
+  return std::string(FormatResponseIoSummary(response, trace_context, &buffer));
 }
 
 }  // namespace dbgx::mcp
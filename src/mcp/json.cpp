@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdint>
+#include <utility>
 
 namespace dbgx::json {
 
@@ -54,6 +55,13 @@ void AppendUtf8(std::uint32_t code_point, std::string* out) {
   out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
 }
 
+void AppendChar(char ch, std::string* out) {
+  if (out != nullptr) {
+    out->push_back(ch);
+  }
+}
+
+// A null out validates the string without decoding it, which is all skipping a value needs.
 bool ParseJsonString(
     std::string_view text,
     std::size_t* pos,
@@ -67,7 +75,9 @@ bool ParseJsonString(
   }
 
   ++(*pos);
-  out->clear();
+  if (out != nullptr) {
+    out->clear();
+  }
 
   while (*pos < text.size()) {
     const char ch = text[*pos];
@@ -91,22 +101,22 @@ bool ParseJsonString(
         case '"':
         case '\\':
         case '/':
-          out->push_back(escaped);
+          AppendChar(escaped, out);
           break;
         case 'b':
-          out->push_back('\b');
+          AppendChar('\b', out);
           break;
         case 'f':
-          out->push_back('\f');
+          AppendChar('\f', out);
           break;
         case 'n':
-          out->push_back('\n');
+          AppendChar('\n', out);
           break;
         case 'r':
-          out->push_back('\r');
+          AppendChar('\r', out);
           break;
         case 't':
-          out->push_back('\t');
+          AppendChar('\t', out);
           break;
         case 'u': {
           if (*pos + 4 > text.size()) {
@@ -128,7 +138,9 @@ bool ParseJsonString(
             value = (value << 4) | static_cast<std::uint32_t>(HexDigitValue(hex));
           }
           *pos += 4;
-          AppendUtf8(value, out);
+          if (out != nullptr) {
+            AppendUtf8(value, out);
+          }
           break;
         }
         default:
@@ -147,7 +159,7 @@ bool ParseJsonString(
       return false;
     }
 
-    out->push_back(ch);
+    AppendChar(ch, out);
   }
 
   if (error_message != nullptr) {
@@ -295,8 +307,7 @@ bool SkipJsonValue(std::string_view text, std::size_t* pos, std::string* error_m
     return SkipJsonArray(text, pos, error_message);
   }
   if (ch == '"') {
-    std::string unused;
-    return ParseJsonString(text, pos, &unused, error_message);
+    return ParseJsonString(text, pos, nullptr, error_message);
   }
 
   const std::size_t value_start = *pos;
@@ -459,6 +470,266 @@ bool TryGetRawField(const FieldMap& fields, const std::string& key, std::string*
   return true;
 }
 
+ObjectFieldCursor::ObjectFieldCursor(std::string_view object_text) : text_(object_text) {}
+
+bool ObjectFieldCursor::Next(std::string_view* out_key, std::string_view* out_raw_value) {
+  if (finished_ || failed_) {
+    return false;
+  }
+
+  if (!started_) {
+    started_ = true;
+    SkipWhitespace(text_, &pos_);
+    if (pos_ >= text_.size() || text_[pos_] != '{') {
+      return Fail("Expected object");
+    }
+    ++pos_;
+    SkipWhitespace(text_, &pos_);
+  } else {
+    SkipWhitespace(text_, &pos_);
+    if (pos_ >= text_.size()) {
+      return Fail("Unterminated object");
+    }
+    if (text_[pos_] == ',') {
+      ++pos_;
+      SkipWhitespace(text_, &pos_);
+    } else if (text_[pos_] != '}') {
+      return Fail("Expected ',' or '}'");
+    }
+  }
+
+  if (pos_ < text_.size() && text_[pos_] == '}') {
+    ++pos_;
+    SkipWhitespace(text_, &pos_);
+    if (pos_ != text_.size()) {
+      return Fail("Unexpected trailing content");
+    }
+    finished_ = true;
+    return false;
+  }
+
+  std::string error_message;
+  if (!ParseJsonString(text_, &pos_, &key_, &error_message)) {
+    return Fail(std::move(error_message));
+  }
+
+  SkipWhitespace(text_, &pos_);
+  if (pos_ >= text_.size() || text_[pos_] != ':') {
+    return Fail("Expected ':' after key");
+  }
+
+  ++pos_;
+  SkipWhitespace(text_, &pos_);
+
+  const std::size_t value_start = pos_;
+  if (!SkipJsonValue(text_, &pos_, &error_message)) {
+    return Fail(std::move(error_message));
+  }
+
+  if (out_key != nullptr) {
+    *out_key = key_;
+  }
+  if (out_raw_value != nullptr) {
+    *out_raw_value = text_.substr(value_start, pos_ - value_start);
+  }
+  return true;
+}
+
+bool ObjectFieldCursor::Failed() const {
+  return failed_;
+}
+
+const std::string& ObjectFieldCursor::ErrorMessage() const {
+  return error_message_;
+}
+
+bool ObjectFieldCursor::Fail(std::string message) {
+  failed_ = true;
+  error_message_ = std::move(message);
+  return false;
+}
+
+ArrayElementCursor::ArrayElementCursor(std::string_view array_text) : text_(array_text) {}
+
+bool ArrayElementCursor::Next(std::string_view* out_raw_value) {
+  if (finished_ || failed_) {
+    return false;
+  }
+
+  if (!started_) {
+    started_ = true;
+    SkipWhitespace(text_, &pos_);
+    if (pos_ >= text_.size() || text_[pos_] != '[') {
+      return Fail("Expected array");
+    }
+    ++pos_;
+    SkipWhitespace(text_, &pos_);
+  } else {
+    SkipWhitespace(text_, &pos_);
+    if (pos_ >= text_.size()) {
+      return Fail("Unterminated array");
+    }
+    if (text_[pos_] == ',') {
+      ++pos_;
+      SkipWhitespace(text_, &pos_);
+    } else if (text_[pos_] != ']') {
+      return Fail("Expected ',' or ']'");
+    }
+  }
+
+  if (pos_ < text_.size() && text_[pos_] == ']') {
+    ++pos_;
+    SkipWhitespace(text_, &pos_);
+    if (pos_ != text_.size()) {
+      return Fail("Unexpected trailing content");
+    }
+    finished_ = true;
+    return false;
+  }
+
+  const std::size_t value_start = pos_;
+  std::string error_message;
+  if (!SkipJsonValue(text_, &pos_, &error_message)) {
+    return Fail(std::move(error_message));
+  }
+
+  if (out_raw_value != nullptr) {
+    *out_raw_value = text_.substr(value_start, pos_ - value_start);
+  }
+  return true;
+}
+
+bool ArrayElementCursor::Failed() const {
+  return failed_;
+}
+
+const std::string& ArrayElementCursor::ErrorMessage() const {
+  return error_message_;
+}
+
+bool ArrayElementCursor::Fail(std::string message) {
+  failed_ = true;
+  error_message_ = std::move(message);
+  return false;
+}
+
+bool IsArrayText(std::string_view json_text) {
+  std::size_t pos = 0;
+  SkipWhitespace(json_text, &pos);
+  return pos < json_text.size() && json_text[pos] == '[';
+}
+
+bool ParseStringValue(std::string_view raw_value, std::string* out_value) {
+  if (out_value == nullptr) {
+    return false;
+  }
+
+  std::size_t pos = 0;
+  SkipWhitespace(raw_value, &pos);
+  std::string ignored_error;
+  if (!ParseJsonString(raw_value, &pos, out_value, &ignored_error)) {
+    return false;
+  }
+
+  SkipWhitespace(raw_value, &pos);
+  return pos == raw_value.size();
+}
+
+bool ParseBooleanValue(std::string_view raw_value, bool* out_value) {
+  if (out_value == nullptr) {
+    return false;
+  }
+
+  const std::string trimmed = Trim(raw_value);
+  if (trimmed == "true") {
+    *out_value = true;
+    return true;
+  }
+  if (trimmed == "false") {
+    *out_value = false;
+    return true;
+  }
+  return false;
+}
+
+bool ParseUnsignedValue(std::string_view raw_value, std::uint64_t* out_value) {
+  if (out_value == nullptr) {
+    return false;
+  }
+
+  const std::string trimmed = Trim(raw_value);
+  if (trimmed.empty()) {
+    return false;
+  }
+
+  std::uint64_t result = 0;
+  for (const char ch : trimmed) {
+    if (ch < '0' || ch > '9') {
+      return false;
+    }
+
+    const std::uint64_t digit = static_cast<std::uint64_t>(ch - '0');
+    if (result > (UINT64_MAX - digit) / 10) {
+      return false;
+    }
+    result = result * 10 + digit;
+  }
+
+  *out_value = result;
+  return true;
+}
+
+bool ParseStringArrayValue(std::string_view raw_value, std::vector<std::string>* out_values) {
+  if (out_values == nullptr) {
+    return false;
+  }
+
+  out_values->clear();
+
+  std::size_t pos = 0;
+  SkipWhitespace(raw_value, &pos);
+  if (pos >= raw_value.size() || raw_value[pos] != '[') {
+    return false;
+  }
+
+  ++pos;
+  SkipWhitespace(raw_value, &pos);
+  if (pos < raw_value.size() && raw_value[pos] == ']') {
+    ++pos;
+    SkipWhitespace(raw_value, &pos);
+    return pos == raw_value.size();
+  }
+
+  std::string ignored_error;
+  while (pos < raw_value.size()) {
+    std::string element;
+    if (!ParseJsonString(raw_value, &pos, &element, &ignored_error)) {
+      return false;
+    }
+    out_values->push_back(std::move(element));
+
+    SkipWhitespace(raw_value, &pos);
+    if (pos >= raw_value.size()) {
+      return false;
+    }
+
+    if (raw_value[pos] == ',') {
+      ++pos;
+      SkipWhitespace(raw_value, &pos);
+      continue;
+    }
+
+    if (raw_value[pos] == ']') {
+      ++pos;
+      SkipWhitespace(raw_value, &pos);
+      return pos == raw_value.size();
+    }
+    return false;
+  }
+
+  return false;
+}
+
 std::string Escape(std::string_view text) {
   std::string escaped;
   escaped.reserve(text.size());
@@ -502,6 +773,61 @@ std::string Escape(std::string_view text) {
   return escaped;
 }
 
+void AppendBase64(std::string_view bytes, std::string* out) {
+  static constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  const std::size_t start = out->size();
+  out->resize(start + (bytes.size() + 2) / 3 * 4);
+  char* cursor = out->data() + start;
+
+  std::size_t index = 0;
+  for (; index + 3 <= bytes.size(); index += 3) {
+    const std::uint32_t triple = (static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[index])) << 16) |
+                                 (static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[index + 1])) << 8) |
+                                 static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[index + 2]));
+    *cursor++ = kAlphabet[(triple >> 18) & 0x3F];
+    *cursor++ = kAlphabet[(triple >> 12) & 0x3F];
+    *cursor++ = kAlphabet[(triple >> 6) & 0x3F];
+    *cursor++ = kAlphabet[triple & 0x3F];
+  }
+
+  const std::size_t remaining = bytes.size() - index;
+  if (remaining != 0) {
+    std::uint32_t triple = static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[index])) << 16;
+    if (remaining == 2) {
+      triple |= static_cast<std::uint32_t>(static_cast<unsigned char>(bytes[index + 1])) << 8;
+    }
+    *cursor++ = kAlphabet[(triple >> 18) & 0x3F];
+    *cursor++ = kAlphabet[(triple >> 12) & 0x3F];
+    *cursor++ = remaining == 2 ? kAlphabet[(triple >> 6) & 0x3F] : '=';
+    *cursor++ = '=';
+  }
+}
+
+std::size_t Utf8PrefixLength(std::string_view text, std::size_t max_bytes) {
+  if (text.size() <= max_bytes) {
+    return text.size();
+  }
+  // Back off over continuation bytes (10xxxxxx) to the lead byte of the sequence the cut would split;
+  // a sequence is at most four bytes, so invalid input cannot push the cut back further.
+  std::size_t length = max_bytes;
+  for (int step = 0; step < 3 && length > 0 && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80; ++step) {
+    --length;
+  }
+  return length;
+}
+
+std::size_t Utf8PageLength(std::string_view text, std::size_t max_bytes) {
+  std::size_t length = Utf8PrefixLength(text, max_bytes);
+  if (length != 0 || max_bytes == 0 || text.empty()) {
+    return length;
+  }
+  length = 1;
+  while (length < text.size() && (static_cast<unsigned char>(text[length]) & 0xC0) == 0x80) {
+    ++length;
+  }
+  return length;
+}
+
 std::string Trim(std::string_view value) {
   std::size_t begin = 0;
   std::size_t end = value.size();
@@ -1,23 +1,167 @@
 #include "dbgx/mcp/json_rpc.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "dbgx/mcp/command_jobs.hpp"
+#include "dbgx/mcp/engine_queue.hpp"
+#include "dbgx/mcp/flight_recorder.hpp"
 #include "dbgx/mcp/json.hpp"
+#include "dbgx/mcp/metrics.hpp"
+#include "dbgx/mcp/output_store.hpp"
+#include "dbgx/mcp/perfect_hash.hpp"
+#include "dbgx/mcp/span_tracer.hpp"
+#include "dbgx/mcp/static_json.hpp"
+#include "dbgx/mcp/structured_output.hpp"
+#include "dbgx/mcp/tools.hpp"
+#include "dbgx/windbg/command_watchdog.hpp"
+#include "dbgx/windbg/output_parsers.hpp"
+#include "dbgx/windbg/symbol_resolver.hpp"
 
 namespace dbgx::mcp {
 
+struct JsonRpcRouter::Runtime {
+  // One per metric series; recorded by the connection threads without locks.
+  struct MethodMetrics {
+    ShardedCounter requests;
+    ShardedCounter request_bytes;
+    ShardedCounter response_bytes;
+    LatencyHistogram parse;
+    LatencyHistogram queue_wait;
+    LatencyHistogram executor;
+    LatencyHistogram serialization;
+  };
+
+  JsonRpcRouterOptions options;
+  windbg::IWinDbgMemoryReader* memory_reader = nullptr;
+  windbg::IWinDbgSymbolProvider* symbol_provider = nullptr;
+  windbg::SymbolResolver symbols;
+  // Declared before engine so it outlives every command the engine thread could still be running.
+  windbg::CommandWatchdog watchdog;
+  std::atomic<std::uint64_t> timed_out_commands{0};
+  std::unique_ptr<MethodMetrics[]> metrics;
+  // The most recent answered messages, served by dbgx/stats.
+  std::unique_ptr<FlightRecorder> flight;
+  // Every executor, memory reader and symbol provider call runs here; metadata methods never touch it.
+  EngineDispatchQueue engine;
+  // Declared after engine so the executor session is closed on the engine thread before it stops.
+  EngineSession session;
+  std::mutex in_flight_mutex;
+  // Keyed by raw JSON-RPC id; commands without one get a "#n" key, which no raw id can match.
+  std::unordered_map<std::string, std::shared_ptr<windbg::CommandExecutionContext>> in_flight;
+  std::uint64_t unnamed_in_flight = 0;
+  bool shutting_down = false;
+  OutputStore outputs;
+  // Declared last so running jobs are joined while the engine thread is still alive.
+  CommandJobTable jobs;
+};
+
 namespace {
 
-constexpr const char* kProtocolVersion = "2025-11-25";
+constexpr std::string_view kProtocolVersion = "2025-11-25";
+constexpr auto kProgressInterval = std::chrono::milliseconds(250);
+constexpr std::uint64_t kDefaultJobOutputBytes = 64 * 1024;
+constexpr std::uint64_t kMaxJobOutputBytes = 1024 * 1024;
+// Outputs above the inline limit are moved to the output store and answered with a head excerpt.
+constexpr std::size_t kInlineOutputBytes = 64 * 1024;
+constexpr std::size_t kOutputExcerptBytes = 8 * 1024;
+constexpr std::uint64_t kDefaultResourcePageLines = 1000;
+constexpr std::uint64_t kDefaultResourcePageBytes = 64 * 1024;
+constexpr std::uint64_t kMaxResourcePageBytes = 1024 * 1024;
+// Capture bounds for windbg.eval: the default and ceiling for max_output_bytes, and the total output after
+// which a command still feeding a tail is interrupted.
+constexpr std::uint64_t kMaxEvalOutputBytes = 32 * 1024 * 1024;
+constexpr std::uint64_t kEvalInterruptAfterBytes = 256 * 1024 * 1024;
+// Rows, modules, frames or registers reported by windbg.eval with structured:true.
+constexpr std::size_t kMaxStructuredEntries = 4096;
+constexpr std::uint64_t kMaxReadMemoryBytes = 16 * 1024 * 1024;
+constexpr std::size_t kMaxResolveAddresses = 4096;
 
 struct MethodOutcome {
   bool ok = false;
   std::string result_json;
+  // A tool result whose isError is true.
+  bool is_error = false;
+  std::string_view cached_response_tail;
   int error_code = -32603;
   std::string error_message = "Internal error";
   int http_status_on_error = 200;
 };
 
+using ProgressReporter = std::function<void(std::uint64_t output_bytes)>;
+
+// Messages that are not a JSON-RPC request object; the remaining series are laid out after the registries.
+constexpr std::size_t kInvalidMessageSeries = 0;
+
+// Filled in while one message is handled and recorded once it is answered.
+struct MessageMetrics {
+  std::size_t series = kInvalidMessageSeries;
+  std::size_t request_bytes = 0;
+  std::uint64_t parse_ns = 0;
+  bool ran_on_engine = false;
+  std::uint64_t queue_wait_ns = 0;
+  std::uint64_t executor_ns = 0;
+  FlightOutcome outcome = FlightOutcome::kOk;
+  int error_code = 0;
+  FlightText id;
+  FlightText command;
+};
+
+struct DispatchContext {
+  const json::FieldMap& root_fields;
+  windbg::IWinDbgCommandExecutor* executor;
+  JsonRpcRouter::Runtime* runtime = nullptr;
+  std::string_view request_id_raw;
+  const ProgressReporter* report_progress = nullptr;
+  MessageMetrics* metrics = nullptr;
+};
+
+using MethodHandler = MethodOutcome (*)(const DispatchContext& context);
+using ToolHandler = MethodOutcome (*)(std::string_view arguments_json, const DispatchContext& context);
+
+struct MethodRegistration {
+  std::string_view name;
+  MethodHandler handler;
+};
+
+struct ToolRegistration {
+  std::string_view name;
+  ToolHandler handler;
+};
+
+constexpr auto kWriteInitializeResponseTail = [](StaticJsonWriter& writer) {
+  writer.Append(",\"result\":{\"protocolVersion\":\"");
+  writer.Append(kProtocolVersion);
+  writer.Append("\",\"capabilities\":{\"tools\":{\"listChanged\":false,\"availableTools\":");
+  writer.Append(BuiltinToolCatalog::ToolNamesJson());
+  writer.Append("},\"resources\":{\"listChanged\":false}},\"serverInfo\":{\"name\":\"dbgx-mcp\",\"version\":\"");
+  writer.AppendEscaped(DBGX_VERSION_STRING);
+  writer.Append("\"}}}");
+};
+
+constexpr auto kWriteToolsListResponseTail = [](StaticJsonWriter& writer) {
+  writer.Append(",\"result\":");
+  writer.Append(BuiltinToolCatalog::ToolsListJson());
+  writer.Append("}");
+};
+
+constexpr auto kInitializeResponseTail =
+    RenderStaticJson<MeasureStaticJson(kWriteInitializeResponseTail)>(kWriteInitializeResponseTail);
+constexpr auto kToolsListResponseTail =
+    RenderStaticJson<MeasureStaticJson(kWriteToolsListResponseTail)>(kWriteToolsListResponseTail);
+
+constexpr std::string_view kJsonRpcResponseHead = "{\"jsonrpc\":\"2.0\",\"id\":";
+
 std::string BuildJsonRpcSuccess(std::string_view id_raw, std::string_view result_json) {
   std::string body = "{";
   body += "\"jsonrpc\":\"2.0\",";
@@ -29,6 +173,15 @@ std::string BuildJsonRpcSuccess(std::string_view id_raw, std::string_view result
   return body;
 }
 
+std::string BuildCachedJsonRpcSuccess(std::string_view id_raw, std::string_view response_tail) {
+  std::string body;
+  body.reserve(kJsonRpcResponseHead.size() + id_raw.size() + response_tail.size());
+  body += kJsonRpcResponseHead;
+  body += id_raw;
+  body += response_tail;
+  return body;
+}
+
 std::string BuildJsonRpcError(std::string_view id_raw, int code, std::string_view message) {
   std::string body = "{";
   body += "\"jsonrpc\":\"2.0\",";
@@ -43,160 +196,1234 @@ std::string BuildJsonRpcError(std::string_view id_raw, int code, std::string_vie
   return body;
 }
 
-MethodOutcome HandleInitialize() {
+MethodOutcome HandleInitialize(const DispatchContext& /*context*/) {
   MethodOutcome outcome;
   outcome.ok = true;
-  outcome.result_json =
-      "{"
-      "\"protocolVersion\":\"2025-11-25\","
-      "\"capabilities\":{\"tools\":{\"listChanged\":false,\"availableTools\":[\"windbg.eval\"]}},"
-      "\"serverInfo\":{\"name\":\"dbgx-mcp\",\"version\":\"" DBGX_VERSION_STRING "\"}"
-      "}";
+  outcome.cached_response_tail = kInitializeResponseTail.View();
   return outcome;
 }
 
-MethodOutcome HandleInitializedNotification() {
+MethodOutcome HandleInitializedNotification(const DispatchContext& /*context*/) {
   MethodOutcome outcome;
   outcome.ok = true;
   outcome.result_json = "{}";
   return outcome;
 }
 
-MethodOutcome HandleToolsList() {
+MethodOutcome HandleToolsList(const DispatchContext& /*context*/) {
+  MethodOutcome outcome;
+  outcome.ok = true;
+  outcome.cached_response_tail = kToolsListResponseTail.View();
+  return outcome;
+}
+
+std::string ExecutionPayloadText(const windbg::CommandExecutionResult& execution) {
+  if (execution.success) {
+    return execution.output.empty() ? "(no output)" : execution.output;
+  }
+  if (execution.cancelled && !execution.output.empty()) {
+    return execution.error_message + "; partial output:\n" + execution.output;
+  }
+  return execution.error_message.empty() ? "Command execution failed" : execution.error_message;
+}
+
+struct ToolOutputText {
+  std::string text;
+  bool stored = false;
+  StoredOutputInfo info;
+};
+
+// Cuts the excerpt at the last line break inside the budget so it never ends mid-line, or failing that at
+// a code point boundary.
+std::size_t ExcerptLength(std::string_view text) {
+  if (text.size() <= kOutputExcerptBytes) {
+    return text.size();
+  }
+  const std::size_t line_end = text.rfind('\n', kOutputExcerptBytes - 1);
+  return line_end == std::string_view::npos ? json::Utf8PrefixLength(text, kOutputExcerptBytes) : line_end + 1;
+}
+
+ToolOutputText PrepareToolOutput(
+    std::string_view name,
+    windbg::CommandExecutionResult execution,
+    const DispatchContext& context) {
+  ToolOutputText output;
+  output.text = execution.success ? std::move(execution.output) : ExecutionPayloadText(execution);
+  if (output.text.empty() && execution.success) {
+    output.text = "(no output)";
+  }
+  if (output.text.size() <= kInlineOutputBytes || context.runtime == nullptr) {
+    return output;
+  }
+
+  const std::size_t total_bytes = output.text.size();
+  std::string excerpt = output.text.substr(0, ExcerptLength(output.text));
+  std::string note;
+  if (context.runtime->outputs.Put(std::string(name), std::move(output.text), &output.info)) {
+    output.stored = true;
+    note = "... [output truncated: showing " + std::to_string(excerpt.size()) + " of " +
+           std::to_string(total_bytes) + " bytes, " + std::to_string(output.info.total_lines) +
+           " lines; read the rest with resources/read on " + output.info.uri + "]";
+  } else {
+    note = "... [output truncated: showing " + std::to_string(excerpt.size()) + " of " +
+           std::to_string(total_bytes) + " bytes; the full output exceeds the output store capacity]";
+  }
+  if (!excerpt.empty() && excerpt.back() != '\n') {
+    excerpt += "\n";
+  }
+  output.text = std::move(excerpt) + note;
+  return output;
+}
+
+// Keeps a running command reachable by its JSON-RPC id so notifications/cancelled can interrupt it, and
+// reachable by Shutdown either way.
+class InFlightRegistration {
+ public:
+  InFlightRegistration(
+      JsonRpcRouter::Runtime* runtime,
+      std::string_view request_id_raw,
+      std::shared_ptr<windbg::CommandExecutionContext> execution_context)
+      : runtime_(runtime), key_(json::Trim(request_id_raw)), execution_context_(std::move(execution_context)) {
+    if (runtime_ == nullptr) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(runtime_->in_flight_mutex);
+    if (runtime_->shutting_down) {
+      execution_context_->RequestCancel();
+    }
+    if (key_.empty() || json::IsNull(key_)) {
+      key_ = "#" + std::to_string(runtime_->unnamed_in_flight++);
+    }
+    runtime_->in_flight.insert_or_assign(key_, execution_context_);
+  }
+
+  ~InFlightRegistration() {
+    if (runtime_ == nullptr) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(runtime_->in_flight_mutex);
+    const auto it = runtime_->in_flight.find(key_);
+    if (it != runtime_->in_flight.end() && it->second == execution_context_) {
+      runtime_->in_flight.erase(it);
+    }
+  }
+
+  InFlightRegistration(const InFlightRegistration&) = delete;
+  InFlightRegistration& operator=(const InFlightRegistration&) = delete;
+
+ private:
+  JsonRpcRouter::Runtime* runtime_;
+  std::string key_;
+  std::shared_ptr<windbg::CommandExecutionContext> execution_context_;
+};
+
+SpanTracer* ContextTracer(const DispatchContext& context) {
+  return context.runtime != nullptr ? context.runtime->options.tracer : nullptr;
+}
+
+void TraceSpan(JsonRpcRouter::Runtime* runtime, TraceStage stage, std::uint64_t begin_ns, std::uint64_t end_ns) {
+  if (runtime->options.tracer != nullptr) {
+    runtime->options.tracer->Record(stage, begin_ns, end_ns);
+  }
+}
+
+// Adds the time task waited in the engine queue and the time it ran to metrics. Both spans are traced on
+// the waiting thread, so they line up with the rest of the request.
+void RunMeasuredOnEngine(
+    JsonRpcRouter::Runtime* runtime,
+    MessageMetrics* metrics,
+    const std::function<void()>& task,
+    std::chrono::milliseconds wait_interval = std::chrono::milliseconds::zero(),
+    const std::function<void()>& on_wait = nullptr) {
+  const std::uint64_t queued_at = MonotonicNanoseconds();
+  std::uint64_t started_at = queued_at;
+  std::uint64_t finished_at = queued_at;
+  runtime->engine.Run(
+      [&]() {
+        started_at = MonotonicNanoseconds();
+        metrics->ran_on_engine = true;
+        metrics->queue_wait_ns += started_at - queued_at;
+        task();
+        finished_at = MonotonicNanoseconds();
+        metrics->executor_ns += finished_at - started_at;
+      },
+      wait_interval,
+      on_wait);
+  TraceSpan(runtime, TraceStage::kQueueWait, queued_at, started_at);
+  TraceSpan(runtime, TraceStage::kExecute, started_at, finished_at);
+}
+
+// Runs task on the engine thread and waits for it; without a runtime there is nothing to serialize against.
+void RunOnEngine(
+    const DispatchContext& context,
+    const std::function<void()>& task,
+    std::chrono::milliseconds wait_interval = std::chrono::milliseconds::zero(),
+    const std::function<void()>& on_wait = nullptr) {
+  if (context.runtime == nullptr) {
+    task();
+    return;
+  }
+  RunMeasuredOnEngine(context.runtime, context.metrics, task, wait_interval, on_wait);
+}
+
+// Commands such as .reload change symbol state in ways the provider's generation may not reflect.
+void NoteExecutedCommand(JsonRpcRouter::Runtime* runtime, std::string_view command) {
+  if (runtime != nullptr && windbg::InvalidatesSymbols(command)) {
+    runtime->symbols.Invalidate();
+  }
+}
+
+// Runs command on the current (engine) thread. The deadline is armed only once the command starts, so time
+// spent queued behind other commands never counts against it.
+windbg::CommandExecutionResult ExecuteCommand(
+    JsonRpcRouter::Runtime* runtime,
+    windbg::IWinDbgCommandExecutor* executor,
+    const std::string& command,
+    windbg::CommandExecutionContext* execution_context,
+    std::chrono::milliseconds timeout) {
+  if (execution_context->CancelRequested()) {
+    return windbg::MakeCancelledResult();
+  }
+  const bool timed = runtime != nullptr && timeout.count() > 0;
+  const windbg::CommandWatchdog::Token token =
+      timed ? runtime->watchdog.Arm(execution_context, std::chrono::steady_clock::now() + timeout) : 0;
+  windbg::CommandExecutionResult result = executor->ExecuteWithContext(command, execution_context);
+  if (timed) {
+    runtime->watchdog.Disarm(token);
+  }
+  if (timed && execution_context->TimedOut()) {
+    result.success = false;
+    result.cancelled = true;
+    result.timed_out = true;
+    result.error_message = "Command timed out after " + std::to_string(timeout.count()) + " ms";
+    runtime->timed_out_commands.fetch_add(1, std::memory_order_relaxed);
+  }
+  NoteExecutedCommand(runtime, command);
+  return result;
+}
+
+struct EvalOutputShaping {
+  windbg::OutputLimits limits;
+  std::shared_ptr<const windbg::LineFilter> filter;
+
+  void ApplyTo(windbg::CommandExecutionContext* execution_context) const {
+    execution_context->SetOutputLimits(limits);
+    execution_context->SetLineFilter(filter);
+  }
+};
+
+// What eval applies when the caller passes no shaping arguments; eval_batch takes none.
+EvalOutputShaping DefaultOutputShaping() {
+  EvalOutputShaping shaping;
+  shaping.limits.max_output_bytes = static_cast<std::size_t>(kMaxEvalOutputBytes);
+  shaping.limits.interrupt_after_bytes = kEvalInterruptAfterBytes;
+  return shaping;
+}
+
+bool BuildOutputShaping(EvalToolArguments& arguments, EvalOutputShaping* out_shaping, std::string* error_message) {
+  windbg::OutputLimits& limits = out_shaping->limits;
+  const std::uint64_t max_output_bytes =
+      arguments.max_output_bytes == 0 ? kMaxEvalOutputBytes : std::min(arguments.max_output_bytes, kMaxEvalOutputBytes);
+  limits.max_output_bytes = static_cast<std::size_t>(max_output_bytes);
+  limits.head_lines = static_cast<std::size_t>(arguments.head_lines);
+  limits.tail_lines = static_cast<std::size_t>(arguments.tail_lines);
+  limits.interrupt_after_bytes = kEvalInterruptAfterBytes;
+
+  windbg::LineFilterOptions filter_options;
+  filter_options.include = std::move(arguments.include);
+  filter_options.exclude = std::move(arguments.exclude);
+  filter_options.include_regex = std::move(arguments.include_regex);
+  filter_options.exclude_regex = std::move(arguments.exclude_regex);
+  filter_options.context_lines = static_cast<std::size_t>(arguments.context_lines);
+  if (!filter_options.Enabled()) {
+    return true;
+  }
+  auto filter = std::make_shared<windbg::LineFilter>();
+  std::string compile_error;
+  if (!windbg::LineFilter::Compile(std::move(filter_options), filter.get(), &compile_error)) {
+    *error_message = "Invalid params: " + compile_error;
+    return false;
+  }
+  out_shaping->filter = std::move(filter);
+  return true;
+}
+
+windbg::CommandExecutionResult RunToolCommand(
+    const std::string& command,
+    const EvalOutputShaping& shaping,
+    std::chrono::milliseconds timeout,
+    const DispatchContext& context) {
+  auto execution_context = std::make_shared<windbg::CommandExecutionContext>();
+  shaping.ApplyTo(execution_context.get());
+  const InFlightRegistration registration(context.runtime, context.request_id_raw, execution_context);
+
+  windbg::CommandExecutionResult result;
+  const auto execute = [&]() {
+    result = ExecuteCommand(context.runtime, context.executor, command, execution_context.get(), timeout);
+  };
+  if (context.report_progress == nullptr) {
+    RunOnEngine(context, execute);
+    return result;
+  }
+
+  // Progress is reported from this thread while the engine thread runs the command.
+  std::uint64_t reported_bytes = 0;
+  RunOnEngine(context, execute, kProgressInterval, [&]() {
+    const std::uint64_t output_bytes = execution_context->OutputBytes();
+    if (output_bytes != reported_bytes) {
+      (*context.report_progress)(output_bytes);
+      reported_bytes = output_bytes;
+    }
+  });
+  return result;
+}
+
+MethodOutcome StartEvalJob(
+    const std::string& command,
+    const EvalOutputShaping& shaping,
+    std::chrono::milliseconds timeout,
+    const DispatchContext& context) {
+  MethodOutcome outcome;
+  if (context.runtime == nullptr) {
+    outcome.error_code = -32603;
+    outcome.error_message = "Background jobs are unavailable";
+    return outcome;
+  }
+
+  JsonRpcRouter::Runtime* runtime = context.runtime;
+  windbg::IWinDbgCommandExecutor* executor = context.executor;
+  const std::size_t series = context.metrics->series;
+  std::string job_id;
+  std::string start_error;
+  const bool started = runtime->jobs.Start(
+      command,
+      [runtime, executor, command, shaping, timeout, series](windbg::CommandExecutionContext* execution_context) {
+        shaping.ApplyTo(execution_context);
+        windbg::CommandExecutionResult result;
+        // The starting call has already been answered, so the job's engine time goes straight to its series.
+        MessageMetrics job_metrics;
+        RunMeasuredOnEngine(runtime, &job_metrics, [&]() {
+          result = ExecuteCommand(runtime, executor, command, execution_context, timeout);
+        });
+        runtime->metrics[series].queue_wait.Record(job_metrics.queue_wait_ns);
+        runtime->metrics[series].executor.Record(job_metrics.executor_ns);
+        return result;
+      },
+      &job_id,
+      &start_error);
+
+  outcome.ok = true;
+  if (!started) {
+    outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"" + json::Escape(start_error) +
+                          "\"}],\"isError\":true}";
+    outcome.is_error = true;
+    return outcome;
+  }
+  outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"Started job " + json::Escape(job_id) +
+                        "\"}],\"structuredContent\":{\"jobId\":\"" + json::Escape(job_id) +
+                        "\",\"state\":\"running\"},\"isError\":false}";
+  return outcome;
+}
+
+MethodOutcome HandleEvalTool(std::string_view arguments_json, const DispatchContext& context) {
+  MethodOutcome outcome;
+
+  EvalToolArguments arguments;
+  std::string decode_error;
+  if (!DecodeToolArguments(kEvalTool, arguments_json, &arguments, &decode_error)) {
+    outcome.error_code = -32602;
+    outcome.error_message = decode_error;
+    return outcome;
+  }
+  context.metrics->command.Assign(arguments.command);
+
+  EvalOutputShaping shaping;
+  std::string shaping_error;
+  if (!BuildOutputShaping(arguments, &shaping, &shaping_error)) {
+    outcome.error_code = -32602;
+    outcome.error_message = shaping_error;
+    return outcome;
+  }
+  // Background jobs exist for long commands, so only an explicit timeout_ms bounds them.
+  std::chrono::milliseconds timeout(arguments.timeout_ms);
+  if (arguments.async) {
+    return StartEvalJob(arguments.command, shaping, timeout, context);
+  }
+  if (timeout.count() == 0 && context.runtime != nullptr) {
+    timeout = context.runtime->options.default_command_timeout;
+  }
+
+  windbg::CommandExecutionResult execution = RunToolCommand(arguments.command, shaping, timeout, context);
+  const bool success = execution.success;
+  const bool timed_out = execution.timed_out;
+  const std::uint64_t dropped_output_bytes = execution.dropped_output_bytes;
+  std::string parsed_json;
+  if (arguments.structured && success) {
+    windbg::ParsedOutput parsed;
+    if (windbg::ParseCommandOutput(arguments.command, execution.output, &parsed, kMaxStructuredEntries)) {
+      AppendParsedOutputJson(parsed, &parsed_json);
+    } else {
+      parsed_json = "null";
+    }
+  }
+  const ToolOutputText output = PrepareToolOutput(kEvalTool.name, std::move(execution), context);
+
+  outcome.ok = true;
+  {
+    const TraceScope escape_span(ContextTracer(context), TraceStage::kEscape);
+    outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"" + json::Escape(output.text) + "\"}";
+  }
+  std::string structured_fields;
+  if (output.stored) {
+    outcome.result_json += ",{\"type\":\"resource_link\",\"uri\":\"" + output.info.uri + "\",\"name\":\"" +
+                           json::Escape(output.info.name) + " output\",\"mimeType\":\"text/plain\",\"size\":" +
+                           std::to_string(output.info.total_bytes) + "}";
+    structured_fields = "\"outputUri\":\"" + output.info.uri + "\",\"totalBytes\":" +
+                        std::to_string(output.info.total_bytes) + ",\"totalLines\":" +
+                        std::to_string(output.info.total_lines) + ",\"droppedBytes\":" +
+                        std::to_string(dropped_output_bytes);
+  } else if (dropped_output_bytes != 0) {
+    structured_fields = "\"droppedBytes\":" + std::to_string(dropped_output_bytes);
+  }
+  if (!parsed_json.empty()) {
+    structured_fields += structured_fields.empty() ? "\"parsed\":" : ",\"parsed\":";
+    structured_fields += parsed_json;
+  }
+  if (timed_out) {
+    structured_fields += structured_fields.empty() ? "\"timedOut\":true" : ",\"timedOut\":true";
+  }
+  outcome.result_json += "]";
+  if (!structured_fields.empty()) {
+    outcome.result_json += ",\"structuredContent\":{" + structured_fields + "}";
+  }
+  outcome.result_json += std::string(",\"isError\":") + (success ? "false" : "true") + "}";
+  outcome.is_error = !success;
+
+  return outcome;
+}
+
+MethodOutcome HandleEvalBatchTool(std::string_view arguments_json, const DispatchContext& context) {
+  MethodOutcome outcome;
+
+  EvalBatchToolArguments arguments;
+  std::string decode_error;
+  if (!DecodeToolArguments(kEvalBatchTool, arguments_json, &arguments, &decode_error)) {
+    outcome.error_code = -32602;
+    outcome.error_message = decode_error;
+    return outcome;
+  }
+  // The flight recorder keeps only a prefix, so the list is joined until that is filled.
+  std::string command_list;
+  for (const std::string& command : arguments.commands) {
+    if (command_list.size() >= FlightText::kCapacity) {
+      break;
+    }
+    command_list += command_list.empty() ? command : "; " + command;
+  }
+  context.metrics->command.Assign(command_list);
+
+  // Each command goes through ExecuteCommand with its own context, so eval's output caps and the default
+  // timeout apply to every one. The batch context is what cancellation and shutdown find in flight; while a
+  // command runs, cancelling it interrupts that command.
+  const EvalOutputShaping shaping = DefaultOutputShaping();
+  const std::chrono::milliseconds timeout =
+      context.runtime != nullptr ? context.runtime->options.default_command_timeout : std::chrono::milliseconds::zero();
+  auto batch_context = std::make_shared<windbg::CommandExecutionContext>();
+  const InFlightRegistration registration(context.runtime, context.request_id_raw, batch_context);
+
+  std::vector<windbg::CommandExecutionResult> executions;
+  executions.reserve(arguments.commands.size());
+  RunOnEngine(context, [&]() {
+    for (const std::string& command : arguments.commands) {
+      if (batch_context->CancelRequested()) {
+        break;
+      }
+      auto execution_context = std::make_shared<windbg::CommandExecutionContext>();
+      shaping.ApplyTo(execution_context.get());
+      batch_context->SetInterruptHandler([execution_context]() { execution_context->RequestCancel(); });
+      // A cancel that landed before the handler was installed would otherwise be missed.
+      if (batch_context->CancelRequested()) {
+        execution_context->RequestCancel();
+      }
+      const auto started_at = std::chrono::steady_clock::now();
+      windbg::CommandExecutionResult execution =
+          ExecuteCommand(context.runtime, context.executor, command, execution_context.get(), timeout);
+      batch_context->ClearInterruptHandler();
+      if (execution.duration_us == 0) {
+        execution.duration_us = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_at)
+                .count());
+      }
+      const bool failed = !execution.success;
+      executions.push_back(std::move(execution));
+      if (failed && arguments.stop_on_error) {
+        break;
+      }
+    }
+  });
+
+  bool any_failed = false;
+  std::string content = "[";
+  std::string results = "[";
+  for (std::size_t index = 0; index < executions.size() && index < arguments.commands.size(); ++index) {
+    windbg::CommandExecutionResult& execution = executions[index];
+    any_failed = any_failed || !execution.success;
+    if (index != 0) {
+      content += ",";
+      results += ",";
+    }
+    results += "{\"command\":\"" + json::Escape(arguments.commands[index]) +
+               "\",\"success\":" + (execution.success ? "true" : "false") +
+               ",\"durationUs\":" + std::to_string(execution.duration_us);
+    const ToolOutputText output = PrepareToolOutput(kEvalBatchTool.name, std::move(execution), context);
+    {
+      const TraceScope escape_span(ContextTracer(context), TraceStage::kEscape);
+      content += "{\"type\":\"text\",\"text\":\"" + json::Escape(output.text) + "\"}";
+    }
+    if (output.stored) {
+      results += ",\"outputUri\":\"" + output.info.uri + "\"";
+    }
+    results += "}";
+  }
+  content += "]";
+  results += "]";
+
+  const std::size_t executed = std::min(executions.size(), arguments.commands.size());
+  outcome.ok = true;
+  outcome.result_json = "{\"content\":" + content + ",\"structuredContent\":{\"results\":" + results +
+                        ",\"skipped\":" + std::to_string(arguments.commands.size() - executed) +
+                        "},\"isError\":" + (any_failed ? "true" : "false") + "}";
+  outcome.is_error = any_failed;
+  return outcome;
+}
+
+MethodOutcome UnknownJobOutcome() {
+  MethodOutcome outcome;
+  outcome.error_code = -32602;
+  outcome.error_message = "Invalid params: unknown job id";
+  return outcome;
+}
+
+std::string BuildJobStatusJson(const CommandJobStatus& status) {
+  std::string json = "{\"jobId\":\"" + json::Escape(status.job_id) + "\",\"command\":\"" +
+                     json::Escape(status.command) + "\",\"state\":\"" +
+                     std::string(CommandJobStateName(status.state)) +
+                     "\",\"outputBytes\":" + std::to_string(status.output_bytes) +
+                     ",\"retainedFromOffset\":" + std::to_string(status.retained_from_offset) +
+                     ",\"durationMs\":" + std::to_string(status.duration_ms);
+  if (!status.error_message.empty()) {
+    json += ",\"error\":\"" + json::Escape(status.error_message) + "\"";
+  }
+  json += "}";
+  return json;
+}
+
+MethodOutcome HandleJobStatusTool(std::string_view arguments_json, const DispatchContext& context) {
+  MethodOutcome outcome;
+
+  JobToolArguments arguments;
+  std::string decode_error;
+  if (!DecodeToolArguments(kJobStatusTool, arguments_json, &arguments, &decode_error)) {
+    outcome.error_code = -32602;
+    outcome.error_message = decode_error;
+    return outcome;
+  }
+
+  CommandJobStatus status;
+  if (context.runtime == nullptr || !context.runtime->jobs.GetStatus(arguments.job_id, &status)) {
+    return UnknownJobOutcome();
+  }
+
+  const std::string status_json = BuildJobStatusJson(status);
+  outcome.ok = true;
+  outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"" + json::Escape(status_json) +
+                        "\"}],\"structuredContent\":" + status_json + ",\"isError\":false}";
+  return outcome;
+}
+
+MethodOutcome HandleJobOutputTool(std::string_view arguments_json, const DispatchContext& context) {
+  MethodOutcome outcome;
+
+  JobOutputToolArguments arguments;
+  std::string decode_error;
+  if (!DecodeToolArguments(kJobOutputTool, arguments_json, &arguments, &decode_error)) {
+    outcome.error_code = -32602;
+    outcome.error_message = decode_error;
+    return outcome;
+  }
+
+  const std::uint64_t max_bytes =
+      arguments.max_bytes == 0 ? kDefaultJobOutputBytes : std::min(arguments.max_bytes, kMaxJobOutputBytes);
+  CommandJobOutputSlice slice;
+  if (context.runtime == nullptr ||
+      !context.runtime->jobs.ReadOutput(
+          arguments.job_id, arguments.offset, static_cast<std::size_t>(max_bytes), &slice)) {
+    return UnknownJobOutcome();
+  }
+
+  outcome.ok = true;
+  const TraceScope escape_span(ContextTracer(context), TraceStage::kEscape);
+  outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"" + json::Escape(slice.text) +
+                        "\"}],\"structuredContent\":{\"jobId\":\"" + json::Escape(arguments.job_id) +
+                        "\",\"state\":\"" + std::string(CommandJobStateName(slice.state)) +
+                        "\",\"offset\":" + std::to_string(slice.offset) +
+                        ",\"nextOffset\":" + std::to_string(slice.next_offset) +
+                        ",\"totalBytes\":" + std::to_string(slice.total_bytes) + "},\"isError\":false}";
+  return outcome;
+}
+
+MethodOutcome HandleJobCancelTool(std::string_view arguments_json, const DispatchContext& context) {
+  MethodOutcome outcome;
+
+  JobToolArguments arguments;
+  std::string decode_error;
+  if (!DecodeToolArguments(kJobCancelTool, arguments_json, &arguments, &decode_error)) {
+    outcome.error_code = -32602;
+    outcome.error_message = decode_error;
+    return outcome;
+  }
+
+  if (context.runtime == nullptr || !context.runtime->jobs.Cancel(arguments.job_id)) {
+    return UnknownJobOutcome();
+  }
+
+  outcome.ok = true;
+  outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"Cancellation requested for " +
+                        json::Escape(arguments.job_id) + "\"}],\"isError\":false}";
+  return outcome;
+}
+
+// Accepts WinDbg-style hex: an optional 0x prefix and one backtick between the high and low halves.
+bool ParseTargetAddress(std::string_view text, std::uint64_t* out_address) {
+  if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+    text.remove_prefix(2);
+  }
+  std::string digits;
+  digits.reserve(text.size());
+  for (const char ch : text) {
+    if (ch != '`') {
+      digits.push_back(ch);
+    }
+  }
+  if (digits.empty() || digits.size() > 16 || digits.size() + 1 < text.size()) {
+    return false;
+  }
+  const std::from_chars_result result =
+      std::from_chars(digits.data(), digits.data() + digits.size(), *out_address, 16);
+  return result.ec == std::errc() && result.ptr == digits.data() + digits.size();
+}
+
+std::string HexAddress(std::uint64_t address) {
+  char buffer[2 + 16] = {'0', 'x'};
+  const std::to_chars_result result = std::to_chars(buffer + 2, buffer + sizeof(buffer), address, 16);
+  return std::string(buffer, result.ptr);
+}
+
+MethodOutcome HandleReadMemoryTool(std::string_view arguments_json, const DispatchContext& context) {
+  MethodOutcome outcome;
+
+  ReadMemoryToolArguments arguments;
+  std::string decode_error;
+  if (!DecodeToolArguments(kReadMemoryTool, arguments_json, &arguments, &decode_error)) {
+    outcome.error_code = -32602;
+    outcome.error_message = decode_error;
+    return outcome;
+  }
+  std::uint64_t address = 0;
+  if (!ParseTargetAddress(arguments.address, &address)) {
+    outcome.error_code = -32602;
+    outcome.error_message = "Invalid params: address must be a hexadecimal number";
+    return outcome;
+  }
+  if (arguments.size == 0 || arguments.size > kMaxReadMemoryBytes) {
+    outcome.error_code = -32602;
+    outcome.error_message = "Invalid params: size must be between 1 and " + std::to_string(kMaxReadMemoryBytes);
+    return outcome;
+  }
+  const bool as_blob = arguments.encoding.empty() || arguments.encoding == "blob";
+  if (!as_blob && arguments.encoding != "base64") {
+    outcome.error_code = -32602;
+    outcome.error_message = "Invalid params: encoding must be blob or base64";
+    return outcome;
+  }
+  if (context.runtime == nullptr || context.runtime->memory_reader == nullptr) {
+    outcome.error_code = -32603;
+    outcome.error_message = "Memory reads are unavailable";
+    return outcome;
+  }
+
+  auto execution_context = std::make_shared<windbg::CommandExecutionContext>();
+  const InFlightRegistration registration(context.runtime, context.request_id_raw, execution_context);
+  windbg::MemoryRangeRead read;
+  std::string read_error;
+  bool read_ok = false;
+  RunOnEngine(context, [&]() {
+    read_ok = windbg::ReadMemoryRange(
+        context.runtime->memory_reader,
+        address,
+        static_cast<std::size_t>(arguments.size),
+        &read,
+        &read_error,
+        execution_context.get());
+  });
+
+  outcome.ok = true;
+  if (!read_ok || read.cancelled || read.bytes_read == 0) {
+    const std::string message = !read_ok       ? read_error
+                                : read.cancelled ? "Memory read cancelled"
+                                                 : "Memory at " + HexAddress(address) + " is not readable";
+    outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"" + json::Escape(message) +
+                          "\"}],\"isError\":true}";
+    outcome.is_error = true;
+    return outcome;
+  }
+
+  std::string& result = outcome.result_json;
+  result.reserve((read.bytes.size() + 2) / 3 * 4 + 256 + read.holes.size() * 48);
+  if (as_blob) {
+    result += "{\"content\":[{\"type\":\"resource\",\"resource\":{\"uri\":\"dbgx://memory/" + HexAddress(address) +
+             "?size=" + std::to_string(arguments.size) + "\",\"mimeType\":\"application/octet-stream\",\"blob\":\"";
+    json::AppendBase64(read.bytes, &result);
+    result += "\"}}]";
+  } else {
+    result += "{\"content\":[{\"type\":\"text\",\"text\":\"";
+    json::AppendBase64(read.bytes, &result);
+    result += "\"}]";
+  }
+  result += ",\"structuredContent\":{\"address\":\"" + HexAddress(address) +
+            "\",\"size\":" + std::to_string(arguments.size) + ",\"bytesRead\":" + std::to_string(read.bytes_read) +
+            ",\"holes\":[";
+  for (std::size_t index = 0; index < read.holes.size(); ++index) {
+    result += index == 0 ? "{\"address\":\"" : ",{\"address\":\"";
+    result += HexAddress(read.holes[index].address) + "\",\"size\":" + std::to_string(read.holes[index].size) + "}";
+  }
+  result += "]},\"isError\":false}";
+  return outcome;
+}
+
+MethodOutcome HandleResolveAddressesTool(std::string_view arguments_json, const DispatchContext& context) {
   MethodOutcome outcome;
+
+  ResolveAddressesToolArguments arguments;
+  std::string decode_error;
+  if (!DecodeToolArguments(kResolveAddressesTool, arguments_json, &arguments, &decode_error)) {
+    outcome.error_code = -32602;
+    outcome.error_message = decode_error;
+    return outcome;
+  }
+  if (arguments.addresses.size() > kMaxResolveAddresses) {
+    outcome.error_code = -32602;
+    outcome.error_message = "Invalid params: at most " + std::to_string(kMaxResolveAddresses) + " addresses";
+    return outcome;
+  }
+  std::vector<std::uint64_t> addresses(arguments.addresses.size());
+  for (std::size_t index = 0; index < arguments.addresses.size(); ++index) {
+    if (!ParseTargetAddress(arguments.addresses[index], &addresses[index])) {
+      outcome.error_code = -32602;
+      outcome.error_message = "Invalid params: addresses[" + std::to_string(index) + "] must be a hexadecimal number";
+      return outcome;
+    }
+  }
+  if (context.runtime == nullptr || context.runtime->symbol_provider == nullptr) {
+    outcome.error_code = -32603;
+    outcome.error_message = "Symbol resolution is unavailable";
+    return outcome;
+  }
+
+  std::vector<windbg::ResolvedAddress> resolved;
+  std::string resolve_error;
+  bool resolved_ok = false;
+  RunOnEngine(context, [&]() {
+    resolved_ok =
+        context.runtime->symbols.Resolve(context.runtime->symbol_provider, addresses, &resolved, &resolve_error);
+  });
   outcome.ok = true;
-  outcome.result_json =
-      "{"
-      "\"tools\":["
-      "{"
-      "\"name\":\"windbg.eval\","
-      "\"description\":\"Execute one WinDbg command at a time and return text output; clients MUST run calls serially and wait for each call to finish before sending the next\","
-      "\"inputSchema\":{"
-      "\"type\":\"object\","
-      "\"properties\":{"
-      "\"command\":{\"type\":\"string\",\"description\":\"WinDbg command to execute; send commands one by one and wait for completion before the next command\"}"
-      "},"
-      "\"required\":[\"command\"],"
-      "\"additionalProperties\":false"
-      "}"
-      "}"
-      "]"
-      "}";
-  return outcome;
-}
-
-MethodOutcome HandleToolsCall(const json::FieldMap& root_fields, windbg::IWinDbgCommandExecutor* executor) {
-  MethodOutcome outcome;
-
-  if (executor == nullptr) {
+  if (!resolved_ok) {
+    outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"" + json::Escape(resolve_error) +
+                          "\"}],\"isError\":true}";
+    outcome.is_error = true;
+    return outcome;
+  }
+
+  // One "address symbol+displacement" line per address in the text, compact entries in structuredContent.
+  std::string text;
+  std::string results = "[";
+  for (std::size_t index = 0; index < resolved.size(); ++index) {
+    const windbg::ResolvedAddress& entry = resolved[index];
+    const std::string address = HexAddress(entry.address);
+    text += address;
+    results += index == 0 ? "{\"address\":\"" : ",{\"address\":\"";
+    results += address + "\"";
+    if (!entry.module.empty()) {
+      results += ",\"module\":\"" + json::Escape(entry.module) + "\",\"moduleOffset\":\"" +
+                 HexAddress(entry.module_offset) + "\"";
+    }
+    if (!entry.symbol.empty()) {
+      results += ",\"symbol\":\"" + json::Escape(entry.symbol) + "\",\"displacement\":\"" +
+                 HexAddress(entry.displacement) + "\"";
+      text += " " + entry.symbol;
+      if (entry.displacement != 0) {
+        text += "+" + HexAddress(entry.displacement);
+      }
+    } else if (!entry.module.empty()) {
+      text += " " + entry.module + "+" + HexAddress(entry.module_offset);
+    }
+    results += "}";
+    text += "\n";
+  }
+  results += "]";
+
+  outcome.result_json = "{\"content\":[{\"type\":\"text\",\"text\":\"" + json::Escape(text) +
+                        "\"}],\"structuredContent\":{\"results\":" + results + "},\"isError\":false}";
+  return outcome;
+}
+
+constexpr std::array kToolRegistry = {
+    ToolRegistration{kEvalTool.name, &HandleEvalTool},
+    ToolRegistration{kEvalBatchTool.name, &HandleEvalBatchTool},
+    ToolRegistration{kJobStatusTool.name, &HandleJobStatusTool},
+    ToolRegistration{kJobOutputTool.name, &HandleJobOutputTool},
+    ToolRegistration{kJobCancelTool.name, &HandleJobCancelTool},
+    ToolRegistration{kReadMemoryTool.name, &HandleReadMemoryTool},
+    ToolRegistration{kResolveAddressesTool.name, &HandleResolveAddressesTool},
+};
+
+constexpr auto kToolTable = BuildPerfectHashTable(kToolRegistry);
+
+// Metric series after kInvalidMessageSeries: methods outside the registry, one per tool (tools/call
+// labeled with the tool), then one per method. Labels come only from the registries, so the set is fixed.
+constexpr std::size_t kUnknownMethodSeries = 1;
+constexpr std::size_t kFirstToolSeries = 2;
+constexpr std::size_t kFirstMethodSeries = kFirstToolSeries + kToolRegistry.size();
+
+MethodOutcome HandleToolsCall(const DispatchContext& context) {
+  MethodOutcome outcome;
+
+  if (context.executor == nullptr) {
     outcome.error_code = -32603;
     outcome.error_message = "Command executor is not available";
     return outcome;
   }
 
-  json::FieldMap params_fields;
-  std::string parse_error;
-  if (!json::TryGetObjectField(root_fields, "params", &params_fields, &parse_error)) {
+  const auto params_it = context.root_fields.find("params");
+  if (params_it == context.root_fields.end()) {
     outcome.error_code = -32602;
     outcome.error_message = "Invalid params: params must be an object";
     return outcome;
   }
 
   std::string tool_name;
-  if (!json::TryGetStringField(params_fields, "name", &tool_name)) {
+  bool has_tool_name = false;
+  bool has_arguments = false;
+  std::string_view arguments_raw;
+  json::ObjectFieldCursor params_cursor(params_it->second);
+  std::string_view key;
+  std::string_view raw_value;
+  while (params_cursor.Next(&key, &raw_value)) {
+    if (key == "name") {
+      has_tool_name = json::ParseStringValue(raw_value, &tool_name);
+    } else if (key == "arguments") {
+      has_arguments = true;
+      arguments_raw = raw_value;
+    }
+  }
+
+  if (params_cursor.Failed()) {
+    outcome.error_code = -32602;
+    outcome.error_message = "Invalid params: params must be an object";
+    return outcome;
+  }
+
+  if (!has_tool_name) {
     outcome.error_code = -32602;
     outcome.error_message = "Invalid params: missing tool name";
     return outcome;
   }
 
-  if (tool_name != "windbg.eval") {
+  const std::size_t tool_index = kToolTable.Find(tool_name);
+  if (tool_index == kToolTable.kNotFound) {
     outcome.error_code = -32602;
     outcome.error_message = "Invalid params: unknown tool name";
     return outcome;
   }
+  context.metrics->series = kFirstToolSeries + tool_index;
 
-  json::FieldMap arguments_fields;
-  if (!json::TryGetObjectField(params_fields, "arguments", &arguments_fields, &parse_error)) {
+  if (!has_arguments) {
     outcome.error_code = -32602;
     outcome.error_message = "Invalid params: arguments must be an object";
     return outcome;
   }
 
-  std::string command;
-  if (!json::TryGetStringField(arguments_fields, "command", &command) || command.empty()) {
-    outcome.error_code = -32602;
-    outcome.error_message = "Invalid params: command must be a non-empty string";
+  return kToolRegistry[tool_index].handler(arguments_raw, context);
+}
+
+MethodOutcome HandleCancelledNotification(const DispatchContext& context) {
+  MethodOutcome outcome;
+  outcome.ok = true;
+  outcome.result_json = "{}";
+
+  json::FieldMap params_fields;
+  std::string params_error;
+  std::string request_id_raw;
+  if (context.runtime == nullptr ||
+      !json::TryGetObjectField(context.root_fields, "params", &params_fields, &params_error) ||
+      !json::TryGetRawField(params_fields, "requestId", &request_id_raw)) {
     return outcome;
   }
 
-  const windbg::CommandExecutionResult execution = executor->Execute(command);
-
-  const std::string payload_text = execution.success
-                                       ? (execution.output.empty() ? "(no output)" : execution.output)
-                                       : (execution.error_message.empty() ? "Command execution failed"
-                                                                          : execution.error_message);
+  std::shared_ptr<windbg::CommandExecutionContext> execution_context;
+  {
+    std::lock_guard<std::mutex> lock(context.runtime->in_flight_mutex);
+    const auto it = context.runtime->in_flight.find(json::Trim(request_id_raw));
+    if (it != context.runtime->in_flight.end()) {
+      execution_context = it->second;
+    }
+  }
+  if (execution_context != nullptr) {
+    execution_context->RequestCancel();
+  }
+  return outcome;
+}
 
+MethodOutcome HandleResourcesList(const DispatchContext& context) {
+  MethodOutcome outcome;
   outcome.ok = true;
-  outcome.result_json =
-      "{\"content\":[{\"type\":\"text\",\"text\":\"" + json::Escape(payload_text) +
-      "\"}],\"isError\":" + (execution.success ? "false" : "true") + "}";
+  outcome.result_json = "{\"resources\":[";
+  if (context.runtime != nullptr) {
+    bool first = true;
+    for (const StoredOutputInfo& info : context.runtime->outputs.List()) {
+      if (!first) {
+        outcome.result_json += ",";
+      }
+      first = false;
+      outcome.result_json += "{\"uri\":\"" + info.uri + "\",\"name\":\"" + json::Escape(info.name) +
+                             " output\",\"mimeType\":\"text/plain\",\"size\":" +
+                             std::to_string(info.total_bytes) + "}";
+    }
+  }
+  outcome.result_json += "]}";
+  return outcome;
+}
+
+// Splits "dbgx://output/3?line=10&lines=50" into the resource URI and its paging parameters.
+bool ParseResourceQuery(
+    std::string_view uri,
+    std::string_view* out_resource_uri,
+    std::unordered_map<std::string, std::uint64_t>* out_parameters) {
+  const std::size_t query_start = uri.find('?');
+  *out_resource_uri = uri.substr(0, query_start);
+  if (query_start == std::string_view::npos) {
+    return true;
+  }
+
+  std::string_view query = uri.substr(query_start + 1);
+  while (!query.empty()) {
+    const std::size_t pair_end = std::min(query.find('&'), query.size());
+    const std::string_view pair = query.substr(0, pair_end);
+    const std::size_t equals = pair.find('=');
+    if (equals == std::string_view::npos) {
+      return false;
+    }
+    std::uint64_t value = 0;
+    if (!json::ParseUnsignedValue(pair.substr(equals + 1), &value)) {
+      return false;
+    }
+    out_parameters->insert_or_assign(std::string(pair.substr(0, equals)), value);
+    query.remove_prefix(std::min(pair_end + 1, query.size()));
+  }
+  return true;
+}
+
+MethodOutcome HandleResourcesRead(const DispatchContext& context) {
+  MethodOutcome outcome;
+  outcome.error_code = -32602;
+
+  json::FieldMap params_fields;
+  std::string params_error;
+  std::string uri;
+  if (!json::TryGetObjectField(context.root_fields, "params", &params_fields, &params_error) ||
+      !json::TryGetStringField(params_fields, "uri", &uri)) {
+    outcome.error_message = "Invalid params: uri is required";
+    return outcome;
+  }
+
+  std::string_view resource_uri;
+  std::unordered_map<std::string, std::uint64_t> parameters;
+  if (!ParseResourceQuery(uri, &resource_uri, &parameters)) {
+    outcome.error_message = "Invalid params: malformed paging query in uri";
+    return outcome;
+  }
+  const auto parameter = [&parameters](const char* name, std::uint64_t fallback) {
+    const auto it = parameters.find(name);
+    return it == parameters.end() ? fallback : it->second;
+  };
+
+  OutputPage page;
+  bool found = false;
+  if (context.runtime != nullptr) {
+    if (parameters.count("offset") != 0 || parameters.count("bytes") != 0) {
+      const std::uint64_t max_bytes = std::min(parameter("bytes", kDefaultResourcePageBytes), kMaxResourcePageBytes);
+      found = context.runtime->outputs.ReadBytes(
+          resource_uri, parameter("offset", 0), static_cast<std::size_t>(max_bytes), &page);
+    } else {
+      found = context.runtime->outputs.ReadLines(
+          resource_uri,
+          parameter("line", 0),
+          static_cast<std::size_t>(parameter("lines", kDefaultResourcePageLines)),
+          &page);
+      if (found && page.text.size() > kMaxResourcePageBytes) {
+        found = context.runtime->outputs.ReadBytes(
+            resource_uri, page.offset, static_cast<std::size_t>(kMaxResourcePageBytes), &page);
+      }
+    }
+  }
+  if (!found) {
+    outcome.error_code = -32002;
+    outcome.error_message = "Resource not found";
+    return outcome;
+  }
 
+  outcome.ok = true;
+  const TraceScope escape_span(ContextTracer(context), TraceStage::kEscape);
+  outcome.result_json = "{\"contents\":[{\"uri\":\"" + json::Escape(uri) +
+                        "\",\"mimeType\":\"text/plain\",\"text\":\"" + json::Escape(page.text) +
+                        "\"}],\"_meta\":{\"offset\":" + std::to_string(page.offset) +
+                        ",\"nextOffset\":" + std::to_string(page.next_offset) +
+                        ",\"firstLine\":" + std::to_string(page.first_line) +
+                        ",\"nextLine\":" + std::to_string(page.next_line) +
+                        ",\"totalBytes\":" + std::to_string(page.total_bytes) +
+                        ",\"totalLines\":" + std::to_string(page.total_lines) + "}}";
   return outcome;
 }
 
-MethodOutcome DispatchMethod(
-    std::string_view method,
-    const json::FieldMap& root_fields,
-    windbg::IWinDbgCommandExecutor* executor) {
-  if (method == "notifications/initialized" || method == "initialized") {
-    return HandleInitializedNotification();
+std::span<const MetricLabel> MetricSeriesLabels(std::size_t series, std::array<MetricLabel, 2>* storage);
+
+void AppendPercentilesJson(std::string_view name, std::vector<std::uint64_t>* values, std::string* out) {
+  const LatencyPercentiles percentiles = ComputeLatencyPercentiles(*values);
+  *out += "\"" + std::string(name) + "\":{\"count\":" + std::to_string(percentiles.count) +
+          ",\"p50\":" + std::to_string(percentiles.p50) + ",\"p90\":" + std::to_string(percentiles.p90) +
+          ",\"p99\":" + std::to_string(percentiles.p99) + ",\"max\":" + std::to_string(percentiles.max) + "}";
+}
+
+void AppendFlightRecordJson(const FlightRecord& record, std::string* out) {
+  std::array<MetricLabel, 2> labels;
+  const std::span<const MetricLabel> series_labels = MetricSeriesLabels(record.series, &labels);
+  *out += "{\"sequence\":" + std::to_string(record.sequence) + ",\"unixMs\":" + std::to_string(record.unix_ms);
+  for (const MetricLabel& label : series_labels) {
+    *out += ",\"" + std::string(label.name) + "\":\"" + json::Escape(label.value) + "\"";
+  }
+  if (record.id.size != 0) {
+    *out += ",\"id\":\"" + json::Escape(record.id.View()) + "\"";
+  }
+  if (record.command.size != 0) {
+    *out += ",\"command\":\"" + json::Escape(record.command.View()) + "\"";
+  }
+  *out += ",\"outcome\":\"" + std::string(FlightOutcomeName(record.outcome)) + "\"";
+  if (record.outcome == FlightOutcome::kError) {
+    *out += ",\"errorCode\":" + std::to_string(record.error_code);
+  }
+  *out += ",\"requestBytes\":" + std::to_string(record.request_bytes) +
+          ",\"responseBytes\":" + std::to_string(record.response_bytes) +
+          ",\"parseNs\":" + std::to_string(record.parse_ns);
+  if (record.ran_on_engine) {
+    *out += ",\"queueWaitNs\":" + std::to_string(record.queue_wait_ns) +
+            ",\"executorNs\":" + std::to_string(record.executor_ns);
+  }
+  *out += ",\"serializationNs\":" + std::to_string(record.serialization_ns) +
+          ",\"totalNs\":" + std::to_string(record.total_ns) + "}";
+}
+
+// Answered from a snapshot of the flight recorder on the calling thread, so it works while a command runs.
+// Percentiles cover every record in the ring; params.limit only bounds how many are listed.
+MethodOutcome HandleDbgxStats(const DispatchContext& context) {
+  MethodOutcome outcome;
+  if (context.runtime == nullptr) {
+    outcome.error_code = -32603;
+    outcome.error_message = "Request statistics are unavailable";
+    return outcome;
+  }
+
+  std::uint64_t limit = std::numeric_limits<std::uint64_t>::max();
+  json::FieldMap params_fields;
+  std::string params_error;
+  std::string limit_raw;
+  if (json::TryGetObjectField(context.root_fields, "params", &params_fields, &params_error) &&
+      json::TryGetRawField(params_fields, "limit", &limit_raw) && !json::ParseUnsignedValue(limit_raw, &limit)) {
+    outcome.error_code = -32602;
+    outcome.error_message = "Invalid params: limit must be a non-negative integer";
+    return outcome;
   }
-  if (method == "initialize") {
-    return HandleInitialize();
+
+  const FlightRecorder& flight = *context.runtime->flight;
+  const std::vector<FlightRecord> records = flight.Snapshot();
+  std::vector<std::uint64_t> total_ns;
+  std::vector<std::uint64_t> queue_wait_ns;
+  std::vector<std::uint64_t> executor_ns;
+  std::uint64_t errors = 0;
+  for (const FlightRecord& record : records) {
+    total_ns.push_back(record.total_ns);
+    if (record.ran_on_engine) {
+      queue_wait_ns.push_back(record.queue_wait_ns);
+      executor_ns.push_back(record.executor_ns);
+    }
+    if (record.outcome != FlightOutcome::kOk) {
+      ++errors;
+    }
   }
-  if (method == "tools/list") {
-    return HandleToolsList();
+
+  outcome.ok = true;
+  outcome.result_json = "{\"capacity\":" + std::to_string(flight.Capacity()) +
+                        ",\"recorded\":" + std::to_string(flight.RecordedCount()) +
+                        ",\"dropped\":" + std::to_string(flight.DroppedCount()) +
+                        ",\"summary\":{\"requests\":" + std::to_string(records.size()) +
+                        ",\"errors\":" + std::to_string(errors) + ",";
+  AppendPercentilesJson("totalNs", &total_ns, &outcome.result_json);
+  outcome.result_json += ",";
+  AppendPercentilesJson("queueWaitNs", &queue_wait_ns, &outcome.result_json);
+  outcome.result_json += ",";
+  AppendPercentilesJson("executorNs", &executor_ns, &outcome.result_json);
+  outcome.result_json += "},\"requests\":[";
+  const std::size_t first = records.size() > limit ? records.size() - static_cast<std::size_t>(limit) : 0;
+  for (std::size_t index = first; index < records.size(); ++index) {
+    if (index != first) {
+      outcome.result_json += ",";
+    }
+    AppendFlightRecordJson(records[index], &outcome.result_json);
   }
-  if (method == "tools/call") {
-    return HandleToolsCall(root_fields, executor);
+  outcome.result_json += "]}";
+  return outcome;
+}
+
+constexpr std::array kMethodRegistry = {
+    MethodRegistration{"initialize", &HandleInitialize},
+    MethodRegistration{"notifications/initialized", &HandleInitializedNotification},
+    MethodRegistration{"initialized", &HandleInitializedNotification},
+    MethodRegistration{"tools/list", &HandleToolsList},
+    MethodRegistration{"tools/call", &HandleToolsCall},
+    MethodRegistration{"notifications/cancelled", &HandleCancelledNotification},
+    MethodRegistration{"resources/list", &HandleResourcesList},
+    MethodRegistration{"resources/read", &HandleResourcesRead},
+    MethodRegistration{"dbgx/stats", &HandleDbgxStats},
+};
+
+constexpr auto kMethodTable = BuildPerfectHashTable(kMethodRegistry);
+constexpr std::size_t kMetricSeriesCount = kFirstMethodSeries + kMethodRegistry.size();
+
+MethodOutcome DispatchMethod(std::string_view method, const DispatchContext& context) {
+  const std::size_t method_index = kMethodTable.Find(method);
+  if (method_index != kMethodTable.kNotFound) {
+    context.metrics->series = kFirstMethodSeries + method_index;
+    return kMethodRegistry[method_index].handler(context);
   }
 
+  context.metrics->series = kUnknownMethodSeries;
   MethodOutcome outcome;
   outcome.error_code = -32601;
   outcome.error_message = "Method not found";
   return outcome;
 }
 
-}  // namespace
+// Labels for a series; tools/call series carry the tool, and the rest only the method.
+std::span<const MetricLabel> MetricSeriesLabels(std::size_t series, std::array<MetricLabel, 2>* storage) {
+  if (series == kInvalidMessageSeries) {
+    (*storage)[0] = MetricLabel{"method", "(invalid)"};
+    return std::span<const MetricLabel>(storage->data(), 1);
+  }
+  if (series == kUnknownMethodSeries) {
+    (*storage)[0] = MetricLabel{"method", "(unknown)"};
+    return std::span<const MetricLabel>(storage->data(), 1);
+  }
+  if (series < kFirstMethodSeries) {
+    (*storage)[0] = MetricLabel{"method", "tools/call"};
+    (*storage)[1] = MetricLabel{"tool", kToolRegistry[series - kFirstToolSeries].name};
+    return std::span<const MetricLabel>(storage->data(), 2);
+  }
+  (*storage)[0] = MetricLabel{"method", kMethodRegistry[series - kFirstMethodSeries].name};
+  return std::span<const MetricLabel>(storage->data(), 1);
+}
 
-JsonRpcRouter::JsonRpcRouter(windbg::IWinDbgCommandExecutor* executor) : executor_(executor) {}
+// Serialization is the time spent on the message outside the engine queue: decoding arguments and
+// shaping output into the response. The same timings go to the metric series and the flight recorder.
+void RecordMessage(
+    JsonRpcRouter::Runtime* runtime,
+    const MessageMetrics& metrics,
+    std::size_t response_bytes,
+    std::uint64_t handled_ns) {
+  JsonRpcRouter::Runtime::MethodMetrics& series = runtime->metrics[metrics.series];
+  series.requests.Add(1);
+  series.request_bytes.Add(metrics.request_bytes);
+  series.response_bytes.Add(response_bytes);
+  series.parse.Record(metrics.parse_ns);
+  const std::uint64_t engine_ns = metrics.queue_wait_ns + metrics.executor_ns;
+  if (metrics.ran_on_engine) {
+    series.queue_wait.Record(metrics.queue_wait_ns);
+    series.executor.Record(metrics.executor_ns);
+  }
+  const std::uint64_t serialization_ns = handled_ns > engine_ns ? handled_ns - engine_ns : 0;
+  series.serialization.Record(serialization_ns);
 
-JsonRpcHttpResult JsonRpcRouter::HandleJsonRpcPost(std::string_view request_body) const {
+  FlightRecord record;
+  record.unix_ms = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                  std::chrono::system_clock::now().time_since_epoch())
+                                                  .count());
+  record.series = static_cast<std::uint32_t>(metrics.series);
+  record.error_code = metrics.error_code;
+  record.outcome = metrics.outcome;
+  record.ran_on_engine = metrics.ran_on_engine;
+  record.request_bytes = metrics.request_bytes;
+  record.response_bytes = response_bytes;
+  record.parse_ns = metrics.parse_ns;
+  record.queue_wait_ns = metrics.queue_wait_ns;
+  record.executor_ns = metrics.executor_ns;
+  record.serialization_ns = serialization_ns;
+  record.total_ns = metrics.parse_ns + handled_ns;
+  record.id = metrics.id;
+  record.command = metrics.command;
+  runtime->flight->Record(record);
+}
+
+void NoteError(MessageMetrics* metrics, int code) {
+  metrics->outcome = FlightOutcome::kError;
+  metrics->error_code = code;
+}
+
+// Answers a message that could not be parsed into a request object, recording it under the invalid series.
+std::string BuildInvalidMessageError(
+    JsonRpcRouter::Runtime* runtime,
+    MessageMetrics metrics,
+    int code,
+    std::string_view message) {
+  const std::uint64_t started_at = MonotonicNanoseconds();
+  std::string body = BuildJsonRpcError("null", code, message);
+  metrics.series = kInvalidMessageSeries;
+  NoteError(&metrics, code);
+  RecordMessage(runtime, metrics, body.size(), MonotonicNanoseconds() - started_at);
+  return body;
+}
+
+JsonRpcHttpResult RespondToMessage(
+    const json::FieldMap& root_fields,
+    windbg::IWinDbgCommandExecutor* executor,
+    JsonRpcRouter::Runtime* runtime,
+    MessageMetrics* metrics,
+    const ProgressReporter* report_progress) {
   JsonRpcHttpResult http_result;
 
-  json::FieldMap root_fields;
-  std::string parse_error;
-  if (!json::ParseObjectFields(request_body, &root_fields, &parse_error)) {
-    http_result.status_code = 400;
-    http_result.body = BuildJsonRpcError("null", -32700, "Parse error: " + parse_error);
-    return http_result;
+  std::string id_raw = "null";
+  const bool has_id = json::TryGetRawField(root_fields, "id", &id_raw);
+  if (!has_id) {
+    id_raw = "null";
   }
+  metrics->id.Assign(has_id ? std::string_view(id_raw) : std::string_view());
 
   std::string jsonrpc;
   if (!json::TryGetStringField(root_fields, "jsonrpc", &jsonrpc) || jsonrpc != "2.0") {
     http_result.status_code = 200;
-    std::string id_raw = "null";
-    json::TryGetRawField(root_fields, "id", &id_raw);
     http_result.body = BuildJsonRpcError(id_raw, -32600, "Invalid Request: jsonrpc must be 2.0");
+    NoteError(metrics, -32600);
     return http_result;
   }
 
-  std::string id_raw = "null";
-  const bool has_id = json::TryGetRawField(root_fields, "id", &id_raw);
-  if (!has_id) {
-    id_raw = "null";
-  }
-
   std::string method;
   if (!json::TryGetStringField(root_fields, "method", &method)) {
     if (!has_id) {
@@ -207,11 +1434,18 @@ JsonRpcHttpResult JsonRpcRouter::HandleJsonRpcPost(std::string_view request_body
     }
 
     http_result.body = BuildJsonRpcError(id_raw, -32600, "Invalid Request: missing method");
+    NoteError(metrics, -32600);
     return http_result;
   }
 
-  const MethodOutcome outcome = DispatchMethod(method, root_fields, executor_);
+  const DispatchContext context{root_fields, executor, runtime, id_raw, report_progress, metrics};
+  const MethodOutcome outcome = DispatchMethod(method, context);
+  const TraceScope serialize_span(runtime->options.tracer, TraceStage::kSerialize);
   if (outcome.ok) {
+    if (outcome.is_error) {
+      metrics->outcome = FlightOutcome::kToolError;
+      http_result.is_error = true;
+    }
     if (!has_id) {
       http_result.status_code = 202;
       http_result.has_body = false;
@@ -220,10 +1454,13 @@ JsonRpcHttpResult JsonRpcRouter::HandleJsonRpcPost(std::string_view request_body
     }
 
     http_result.status_code = 200;
-    http_result.body = BuildJsonRpcSuccess(id_raw, outcome.result_json);
+    http_result.body = outcome.cached_response_tail.empty()
+                           ? BuildJsonRpcSuccess(id_raw, outcome.result_json)
+                           : BuildCachedJsonRpcSuccess(id_raw, outcome.cached_response_tail);
     return http_result;
   }
 
+  NoteError(metrics, outcome.error_code);
   if (!has_id) {
     http_result.status_code = outcome.http_status_on_error;
     http_result.body = BuildJsonRpcError("null", outcome.error_code, outcome.error_message);
@@ -235,4 +1472,310 @@ JsonRpcHttpResult JsonRpcRouter::HandleJsonRpcPost(std::string_view request_body
   return http_result;
 }
 
+JsonRpcHttpResult HandleJsonRpcMessage(
+    const json::FieldMap& root_fields,
+    windbg::IWinDbgCommandExecutor* executor,
+    JsonRpcRouter::Runtime* runtime,
+    MessageMetrics metrics,
+    const ProgressReporter* report_progress = nullptr) {
+  const std::uint64_t started_at = MonotonicNanoseconds();
+  JsonRpcHttpResult http_result = RespondToMessage(root_fields, executor, runtime, &metrics, report_progress);
+  RecordMessage(
+      runtime, metrics, http_result.has_body ? http_result.body.size() : 0, MonotonicNanoseconds() - started_at);
+  return http_result;
+}
+
+// A tools/call that carries params._meta.progressToken is answered as an SSE stream: progress
+// notifications while the command runs, then the response itself.
+bool TryGetProgressToken(const json::FieldMap& root_fields, std::string* out_token_raw) {
+  std::string method;
+  if (!json::TryGetStringField(root_fields, "method", &method) || method != "tools/call" ||
+      root_fields.find("id") == root_fields.end()) {
+    return false;
+  }
+
+  json::FieldMap params_fields;
+  json::FieldMap meta_fields;
+  std::string error_message;
+  return json::TryGetObjectField(root_fields, "params", &params_fields, &error_message) &&
+         json::TryGetObjectField(params_fields, "_meta", &meta_fields, &error_message) &&
+         json::TryGetRawField(meta_fields, "progressToken", out_token_raw) && !json::IsNull(*out_token_raw);
+}
+
+std::string BuildSseMessageEvent(std::string_view message_json) {
+  std::string event = "event: message\ndata: ";
+  event += message_json;
+  event += "\n\n";
+  return event;
+}
+
+std::string BuildProgressNotification(std::string_view progress_token_raw, std::uint64_t output_bytes) {
+  const std::string bytes_text = std::to_string(output_bytes);
+  return "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\",\"params\":{\"progressToken\":" +
+         std::string(progress_token_raw) + ",\"progress\":" + bytes_text + ",\"message\":\"" + bytes_text +
+         " output bytes captured\"}}";
+}
+
+JsonRpcHttpResult HandleJsonRpcMessageWithProgress(
+    json::FieldMap root_fields,
+    std::string progress_token_raw,
+    MessageMetrics metrics,
+    windbg::IWinDbgCommandExecutor* executor,
+    std::shared_ptr<JsonRpcRouter::Runtime> runtime) {
+  JsonRpcHttpResult http_result;
+  http_result.status_code = 200;
+  http_result.content_type = "text/event-stream";
+  auto fields = std::make_shared<json::FieldMap>(std::move(root_fields));
+  http_result.body_stream = [fields, token = std::move(progress_token_raw), metrics, executor, runtime](
+                                const JsonRpcChunkWriter& write_chunk) {
+    bool connected = true;
+    const ProgressReporter report_progress = [&](std::uint64_t output_bytes) {
+      if (connected) {
+        connected = write_chunk(BuildSseMessageEvent(BuildProgressNotification(token, output_bytes)));
+      }
+    };
+
+    const JsonRpcHttpResult result =
+        HandleJsonRpcMessage(*fields, executor, runtime.get(), metrics, &report_progress);
+    if (connected) {
+      write_chunk(BuildSseMessageEvent(result.body));
+    }
+  };
+  return http_result;
+}
+
+struct BatchItem {
+  json::FieldMap root_fields;
+  MessageMetrics metrics;
+  bool is_object = false;
+  bool expects_response = false;
+  bool calls_tool = false;
+};
+
+std::string HandleBatchItem(
+    const BatchItem& item,
+    windbg::IWinDbgCommandExecutor* executor,
+    JsonRpcRouter::Runtime* runtime) {
+  if (!item.is_object) {
+    return BuildInvalidMessageError(runtime, item.metrics, -32600, "Invalid Request: batch item must be an object");
+  }
+
+  JsonRpcHttpResult item_result = HandleJsonRpcMessage(item.root_fields, executor, runtime, item.metrics);
+  if (!item.expects_response || !item_result.has_body) {
+    return {};
+  }
+  return std::move(item_result.body);
+}
+
+JsonRpcHttpResult HandleJsonRpcBatch(
+    std::string_view request_body,
+    windbg::IWinDbgCommandExecutor* executor,
+    const std::shared_ptr<JsonRpcRouter::Runtime>& runtime) {
+  JsonRpcHttpResult http_result;
+
+  auto items = std::make_shared<std::vector<BatchItem>>();
+  json::ArrayElementCursor cursor(request_body);
+  std::string_view raw_item;
+  while (cursor.Next(&raw_item)) {
+    BatchItem item;
+    std::string item_error;
+    const std::uint64_t parse_started_at = MonotonicNanoseconds();
+    item.is_object = json::ParseObjectFields(raw_item, &item.root_fields, &item_error);
+    const std::uint64_t parse_finished_at = MonotonicNanoseconds();
+    item.metrics.parse_ns = parse_finished_at - parse_started_at;
+    TraceSpan(runtime.get(), TraceStage::kParse, parse_started_at, parse_finished_at);
+    item.metrics.request_bytes = raw_item.size();
+    item.expects_response = !item.is_object || item.root_fields.find("id") != item.root_fields.end();
+
+    std::string method;
+    item.calls_tool =
+        item.is_object && json::TryGetStringField(item.root_fields, "method", &method) && method == "tools/call";
+    items->push_back(std::move(item));
+  }
+
+  if (cursor.Failed()) {
+    MessageMetrics metrics;
+    metrics.request_bytes = request_body.size();
+    http_result.status_code = 400;
+    http_result.body =
+        BuildInvalidMessageError(runtime.get(), metrics, -32700, "Parse error: " + cursor.ErrorMessage());
+    return http_result;
+  }
+
+  if (items->empty()) {
+    MessageMetrics metrics;
+    metrics.request_bytes = request_body.size();
+    http_result.body = BuildInvalidMessageError(runtime.get(), metrics, -32600, "Invalid Request: empty batch");
+    return http_result;
+  }
+
+  const bool expects_any_response = std::any_of(
+      items->begin(), items->end(), [](const BatchItem& item) { return item.expects_response; });
+  if (!expects_any_response) {
+    for (const bool tool_pass : {false, true}) {
+      for (const BatchItem& item : *items) {
+        if (item.calls_tool == tool_pass) {
+          HandleBatchItem(item, executor, runtime.get());
+        }
+      }
+    }
+    http_result.status_code = 202;
+    http_result.has_body = false;
+    return http_result;
+  }
+
+  http_result.status_code = 200;
+  http_result.body_stream = [items, executor, runtime](const JsonRpcChunkWriter& write_chunk) {
+    bool first = true;
+    bool connected = true;
+    for (const bool tool_pass : {false, true}) {
+      for (const BatchItem& item : *items) {
+        if (item.calls_tool != tool_pass || !connected) {
+          continue;
+        }
+
+        std::string response = HandleBatchItem(item, executor, runtime.get());
+        if (response.empty()) {
+          continue;
+        }
+        response.insert(response.begin(), first ? '[' : ',');
+        first = false;
+        connected = write_chunk(response);
+      }
+    }
+    if (connected) {
+      write_chunk("]");
+    }
+  };
+  return http_result;
+}
+
+}  // namespace
+
+JsonRpcRouter::JsonRpcRouter(
+    windbg::IWinDbgCommandExecutor* executor,
+    windbg::IWinDbgMemoryReader* memory_reader,
+    windbg::IWinDbgSymbolProvider* symbol_provider,
+    JsonRpcRouterOptions options)
+    : executor_(executor), runtime_(std::make_shared<Runtime>()) {
+  runtime_->options = options;
+  runtime_->metrics = std::make_unique<Runtime::MethodMetrics[]>(kMetricSeriesCount);
+  runtime_->flight = std::make_unique<FlightRecorder>(FlightRecorderOptions{options.flight_records});
+  runtime_->memory_reader = memory_reader;
+  runtime_->symbol_provider = symbol_provider;
+  // Without a session each command sets up its own engine client, which is slower but still correct.
+  std::string session_error;
+  if (executor_ != nullptr) {
+    (void)runtime_->session.Open(&runtime_->engine, executor_, &session_error);
+  }
+}
+
+JsonRpcHttpResult JsonRpcRouter::HandleJsonRpcPost(std::string_view request_body) const {
+  if (json::IsArrayText(request_body)) {
+    return HandleJsonRpcBatch(request_body, executor_, runtime_);
+  }
+
+  MessageMetrics metrics;
+  metrics.request_bytes = request_body.size();
+  const std::uint64_t parse_started_at = MonotonicNanoseconds();
+  json::FieldMap root_fields;
+  std::string parse_error;
+  const bool parsed = json::ParseObjectFields(request_body, &root_fields, &parse_error);
+  const std::uint64_t parse_finished_at = MonotonicNanoseconds();
+  metrics.parse_ns = parse_finished_at - parse_started_at;
+  TraceSpan(runtime_.get(), TraceStage::kParse, parse_started_at, parse_finished_at);
+  if (!parsed) {
+    JsonRpcHttpResult http_result;
+    http_result.status_code = 400;
+    http_result.body = BuildInvalidMessageError(runtime_.get(), metrics, -32700, "Parse error: " + parse_error);
+    return http_result;
+  }
+
+  std::string progress_token_raw;
+  if (TryGetProgressToken(root_fields, &progress_token_raw)) {
+    return HandleJsonRpcMessageWithProgress(
+        std::move(root_fields), std::move(progress_token_raw), metrics, executor_, runtime_);
+  }
+
+  return HandleJsonRpcMessage(root_fields, executor_, runtime_.get(), metrics);
+}
+
+void JsonRpcRouter::Shutdown() const {
+  std::vector<std::shared_ptr<windbg::CommandExecutionContext>> running;
+  {
+    std::lock_guard<std::mutex> lock(runtime_->in_flight_mutex);
+    runtime_->shutting_down = true;
+    for (const auto& [id, execution_context] : runtime_->in_flight) {
+      running.push_back(execution_context);
+    }
+  }
+  for (const std::shared_ptr<windbg::CommandExecutionContext>& execution_context : running) {
+    execution_context->RequestCancel();
+  }
+  runtime_->jobs.Shutdown();
+}
+
+JsonRpcRouterStats JsonRpcRouter::Stats() const {
+  JsonRpcRouterStats stats;
+  stats.timed_out_commands = runtime_->timed_out_commands.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void JsonRpcRouter::ExportMetrics(PrometheusWriter* writer) const {
+  using Counter = ShardedCounter Runtime::MethodMetrics::*;
+  using Histogram = LatencyHistogram Runtime::MethodMetrics::*;
+  struct CounterFamily {
+    std::string_view name;
+    std::string_view help;
+    Counter counter;
+  };
+  struct HistogramFamily {
+    std::string_view name;
+    std::string_view help;
+    Histogram histogram;
+  };
+  static constexpr CounterFamily kCounterFamilies[] = {
+      {"dbgx_mcp_requests_total", "JSON-RPC messages handled.", &Runtime::MethodMetrics::requests},
+      {"dbgx_mcp_request_bytes_total", "JSON-RPC message bytes received.", &Runtime::MethodMetrics::request_bytes},
+      {"dbgx_mcp_response_bytes_total", "JSON-RPC response bytes sent.", &Runtime::MethodMetrics::response_bytes},
+  };
+  static constexpr HistogramFamily kHistogramFamilies[] = {
+      {"dbgx_mcp_parse_seconds", "Time parsing the JSON-RPC message.", &Runtime::MethodMetrics::parse},
+      {"dbgx_mcp_queue_wait_seconds",
+       "Time engine work waited for the engine thread.",
+       &Runtime::MethodMetrics::queue_wait},
+      {"dbgx_mcp_executor_seconds", "Time engine work ran on the engine thread.", &Runtime::MethodMetrics::executor},
+      {"dbgx_mcp_serialization_seconds",
+       "Time handling the message off the engine thread, mostly building the response.",
+       &Runtime::MethodMetrics::serialization},
+  };
+
+  std::array<MetricLabel, 2> labels;
+  for (const CounterFamily& family : kCounterFamilies) {
+    writer->BeginFamily(family.name, "counter", family.help);
+    for (std::size_t series = 0; series < kMetricSeriesCount; ++series) {
+      const std::uint64_t value = (runtime_->metrics[series].*family.counter).Value();
+      if (value != 0) {
+        writer->WriteSample(family.name, MetricSeriesLabels(series, &labels), value);
+      }
+    }
+  }
+  for (const HistogramFamily& family : kHistogramFamilies) {
+    writer->BeginFamily(family.name, "histogram", family.help);
+    for (std::size_t series = 0; series < kMetricSeriesCount; ++series) {
+      const HistogramSnapshot snapshot = (runtime_->metrics[series].*family.histogram).Snapshot();
+      if (snapshot.count != 0) {
+        writer->WriteHistogram(family.name, MetricSeriesLabels(series, &labels), snapshot);
+      }
+    }
+  }
+
+  writer->BeginFamily("dbgx_mcp_engine_queue_depth", "gauge", "Engine tasks waiting for the engine thread.");
+  writer->WriteSample("dbgx_mcp_engine_queue_depth", {}, runtime_->engine.Depth());
+  writer->BeginFamily(
+      "dbgx_mcp_timed_out_commands_total", "counter", "Commands interrupted by their timeout.");
+  writer->WriteSample(
+      "dbgx_mcp_timed_out_commands_total", {}, runtime_->timed_out_commands.load(std::memory_order_relaxed));
+}
+
 }  // namespace dbgx::mcp
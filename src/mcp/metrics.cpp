@@ -0,0 +1,170 @@
+#include "dbgx/mcp/metrics.hpp"
+
+#include <charconv>
+#include <chrono>
+
+namespace dbgx::mcp {
+
+namespace {
+
+void AppendUnsigned(std::uint64_t value, std::string* out) {
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out->append(buffer, result.ptr);
+}
+
+void AppendSeconds(std::uint64_t nanoseconds, std::string* out) {
+  char buffer[32];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<double>(nanoseconds) / 1e9);
+  out->append(buffer, result.ptr);
+}
+
+void AppendLabelValue(std::string_view value, std::string* out) {
+  for (const char ch : value) {
+    if (ch == '\\' || ch == '"') {
+      out->push_back('\\');
+      out->push_back(ch);
+    } else if (ch == '\n') {
+      out->append("\\n");
+    } else {
+      out->push_back(ch);
+    }
+  }
+}
+
+}  // namespace
+
+std::size_t AssignMetricShard() {
+  static std::atomic<std::size_t> next_shard{0};
+  return next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+}
+
+std::uint64_t MonotonicNanoseconds() {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+std::uint64_t ShardedCounter::Value() const {
+  std::uint64_t total = 0;
+  for (const Shard& shard : shards_) {
+    total += shard.value.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+LatencyHistogram::~LatencyHistogram() {
+  for (std::atomic<Shard*>& shard : shards_) {
+    delete shard.load(std::memory_order_relaxed);
+  }
+}
+
+LatencyHistogram::Shard* LatencyHistogram::ShardForThread() {
+  std::atomic<Shard*>& slot = shards_[MetricShardIndex()];
+  Shard* shard = slot.load(std::memory_order_acquire);
+  if (shard != nullptr) {
+    return shard;
+  }
+  // Threads sharing the slot may race to allocate it; the loser frees its copy and uses the winner's.
+  auto allocated = std::make_unique<Shard>();
+  if (slot.compare_exchange_strong(shard, allocated.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+    return allocated.release();
+  }
+  return shard;
+}
+
+void LatencyHistogram::Record(std::uint64_t nanoseconds) {
+  Shard* shard = ShardForThread();
+  shard->counts[LatencyBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  shard->sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+HistogramSnapshot LatencyHistogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  for (const std::atomic<Shard*>& slot : shards_) {
+    const Shard* shard = slot.load(std::memory_order_acquire);
+    if (shard == nullptr) {
+      continue;
+    }
+    for (std::size_t index = 0; index < kLatencyBucketCount; ++index) {
+      const std::uint64_t count = shard->counts[index].load(std::memory_order_relaxed);
+      snapshot.counts[index] += count;
+      snapshot.count += count;
+    }
+    snapshot.sum_nanoseconds += shard->sum.load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+void PrometheusWriter::BeginFamily(std::string_view name, std::string_view type, std::string_view help) {
+  text_ += "# HELP ";
+  text_ += name;
+  text_ += ' ';
+  text_ += help;
+  text_ += "\n# TYPE ";
+  text_ += name;
+  text_ += ' ';
+  text_ += type;
+  text_ += '\n';
+}
+
+void PrometheusWriter::WriteSample(std::string_view name, std::span<const MetricLabel> labels, std::uint64_t value) {
+  WriteSeries(name, labels);
+  AppendUnsigned(value, &text_);
+  text_ += '\n';
+}
+
+void PrometheusWriter::WriteHistogram(
+    std::string_view name,
+    std::span<const MetricLabel> labels,
+    const HistogramSnapshot& snapshot) {
+  const std::string bucket_name = std::string(name) + "_bucket";
+  std::string le;
+  std::uint64_t cumulative = 0;
+  // The last bucket also holds every clamped value, so it has no finite bound and is covered by +Inf.
+  for (std::size_t index = 0; index + 1 < kLatencyBucketCount; ++index) {
+    if (snapshot.counts[index] == 0) {
+      continue;
+    }
+    cumulative += snapshot.counts[index];
+    le.clear();
+    AppendSeconds(LatencyBucketUpperBound(index), &le);
+    WriteSeries(bucket_name, labels, le);
+    AppendUnsigned(cumulative, &text_);
+    text_ += '\n';
+  }
+  WriteSeries(bucket_name, labels, "+Inf");
+  AppendUnsigned(snapshot.count, &text_);
+  text_ += '\n';
+
+  WriteSeries(std::string(name) + "_sum", labels);
+  AppendSeconds(snapshot.sum_nanoseconds, &text_);
+  text_ += '\n';
+  WriteSample(std::string(name) + "_count", labels, snapshot.count);
+}
+
+void PrometheusWriter::WriteSeries(std::string_view name, std::span<const MetricLabel> labels, std::string_view le) {
+  text_ += name;
+  if (labels.empty() && le.empty()) {
+    text_ += ' ';
+    return;
+  }
+  char separator = '{';
+  for (const MetricLabel& label : labels) {
+    text_ += separator;
+    text_ += label.name;
+    text_ += "=\"";
+    AppendLabelValue(label.value, &text_);
+    text_ += '"';
+    separator = ',';
+  }
+  if (!le.empty()) {
+    text_ += separator;
+    text_ += "le=\"";
+    text_ += le;
+    text_ += '"';
+  }
+  text_ += "} ";
+}
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,138 @@
+#include "dbgx/mcp/output_store.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "dbgx/mcp/json.hpp"
+
+namespace dbgx::mcp {
+
+namespace {
+
+constexpr std::string_view kOutputUriPrefix = "dbgx://output/";
+
+std::vector<std::size_t> BuildLineIndex(std::string_view text) {
+  std::vector<std::size_t> line_starts;
+  if (text.empty()) {
+    return line_starts;
+  }
+  line_starts.reserve(static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n')) + 1);
+  line_starts.push_back(0);
+  for (std::size_t pos = text.find('\n'); pos != std::string_view::npos; pos = text.find('\n', pos + 1)) {
+    if (pos + 1 < text.size()) {
+      line_starts.push_back(pos + 1);
+    }
+  }
+  return line_starts;
+}
+
+}  // namespace
+
+std::uint64_t OutputStore::Entry::LineAt(std::uint64_t offset) const {
+  const auto it = std::upper_bound(line_starts.begin(), line_starts.end(), static_cast<std::size_t>(offset));
+  return it == line_starts.begin() ? 0 : static_cast<std::uint64_t>(it - line_starts.begin() - 1);
+}
+
+OutputStore::OutputStore(OutputStoreOptions options) : options_(options) {
+  if (options_.max_entries == 0) {
+    options_.max_entries = 1;
+  }
+}
+
+bool OutputStore::Put(std::string name, std::string text, StoredOutputInfo* out_info) {
+  if (text.size() > options_.max_total_bytes) {
+    return false;
+  }
+
+  auto entry = std::make_shared<Entry>();
+  entry->line_starts = BuildLineIndex(text);
+  entry->info.name = std::move(name);
+  entry->info.total_bytes = text.size();
+  entry->info.total_lines = entry->line_starts.size();
+  entry->text = std::move(text);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  entry->info.uri = std::string(kOutputUriPrefix) + std::to_string(next_id_++);
+  while (!entries_.empty() &&
+         (entries_.size() >= options_.max_entries || total_bytes_ + entry->text.size() > options_.max_total_bytes)) {
+    total_bytes_ -= entries_.front()->text.size();
+    entries_.pop_front();
+  }
+  total_bytes_ += entry->text.size();
+  *out_info = entry->info;
+  entries_.push_back(std::move(entry));
+  return true;
+}
+
+bool OutputStore::ReadLines(
+    std::string_view uri,
+    std::uint64_t first_line,
+    std::size_t max_lines,
+    OutputPage* out_page) const {
+  const std::shared_ptr<const Entry> entry = Find(uri);
+  if (entry == nullptr) {
+    return false;
+  }
+
+  const std::uint64_t total_lines = entry->info.total_lines;
+  const std::uint64_t start_line = std::min(first_line, total_lines);
+  const std::uint64_t end_line = start_line + std::min<std::uint64_t>(max_lines, total_lines - start_line);
+  const std::size_t start = start_line < total_lines ? entry->line_starts[start_line] : entry->text.size();
+  const std::size_t end = end_line < total_lines ? entry->line_starts[end_line] : entry->text.size();
+
+  out_page->text.assign(entry->text, start, end - start);
+  out_page->offset = start;
+  out_page->next_offset = end;
+  out_page->first_line = start_line;
+  out_page->next_line = end_line;
+  out_page->total_bytes = entry->info.total_bytes;
+  out_page->total_lines = total_lines;
+  return true;
+}
+
+bool OutputStore::ReadBytes(
+    std::string_view uri,
+    std::uint64_t offset,
+    std::size_t max_bytes,
+    OutputPage* out_page) const {
+  const std::shared_ptr<const Entry> entry = Find(uri);
+  if (entry == nullptr) {
+    return false;
+  }
+
+  // Both ends are moved back to character boundaries, so a page never splits a UTF-8 sequence.
+  const std::string_view text = entry->text;
+  const std::size_t start =
+      json::Utf8PrefixLength(text, static_cast<std::size_t>(std::min<std::uint64_t>(offset, text.size())));
+  const std::size_t length = json::Utf8PageLength(text.substr(start), max_bytes);
+  out_page->text.assign(text, start, length);
+  out_page->offset = start;
+  out_page->next_offset = start + length;
+  out_page->first_line = entry->LineAt(start);
+  out_page->next_line = start + length < entry->text.size() ? entry->LineAt(start + length) : entry->info.total_lines;
+  out_page->total_bytes = entry->info.total_bytes;
+  out_page->total_lines = entry->info.total_lines;
+  return true;
+}
+
+std::vector<StoredOutputInfo> OutputStore::List() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<StoredOutputInfo> infos;
+  infos.reserve(entries_.size());
+  for (const auto& entry : entries_) {
+    infos.push_back(entry->info);
+  }
+  return infos;
+}
+
+std::shared_ptr<const OutputStore::Entry> OutputStore::Find(std::string_view uri) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& entry : entries_) {
+    if (entry->info.uri == uri) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace dbgx::mcp
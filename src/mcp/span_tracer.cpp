@@ -0,0 +1,195 @@
+#include "dbgx/mcp/span_tracer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <mutex>
+#include <vector>
+
+namespace dbgx::mcp {
+
+namespace {
+
+struct SpanSlot {
+  std::atomic<std::uint64_t> begin_ns{0};
+  std::atomic<std::uint64_t> end_ns{0};
+  // Stage in the low byte, recording thread number above it.
+  std::atomic<std::uint64_t> tag{0};
+};
+
+struct ThreadSpans {
+  explicit ThreadSpans(std::size_t capacity) : mask(capacity - 1), slots(std::make_unique<SpanSlot[]>(capacity)) {}
+
+  std::size_t mask;
+  std::unique_ptr<SpanSlot[]> slots;
+  // Written only by the owning thread; a span is published by storing its index + 1 here.
+  std::atomic<std::uint64_t> written{0};
+  std::uint64_t thread_number = 0;
+};
+
+struct SpanEvent {
+  std::uint64_t begin_ns = 0;
+  std::uint64_t end_ns = 0;
+  std::uint64_t tag = 0;
+};
+
+void AppendMicroseconds(std::uint64_t nanoseconds, std::string* out) {
+  char buffer[32];
+  const auto result = std::to_chars(
+      buffer, buffer + sizeof(buffer), static_cast<double>(nanoseconds) / 1000.0, std::chars_format::fixed, 3);
+  out->append(buffer, result.ptr);
+}
+
+void AppendUnsigned(std::uint64_t value, std::string* out) {
+  char buffer[24];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out->append(buffer, result.ptr);
+}
+
+}  // namespace
+
+struct SpanTracerState {
+  std::size_t spans_per_thread = 0;
+  // At least one slot more than is kept, so the slot the owner may be writing is never part of a dump.
+  std::size_t ring_capacity = 0;
+  std::atomic<std::uint64_t> started_at_ns{0};
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadSpans>> rings;
+  std::vector<ThreadSpans*> free_rings;
+  std::uint64_t next_thread_number = 1;
+};
+
+namespace {
+
+// The calling thread's ring. The binding keeps the tracer's state alive, so a thread that outlives the
+// tracer can still hand its ring back.
+struct ThreadBinding {
+  ~ThreadBinding() { Release(); }
+
+  void Release() {
+    if (state != nullptr) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->free_rings.push_back(ring);
+    }
+    state.reset();
+    ring = nullptr;
+  }
+
+  ThreadSpans* Bind(const std::shared_ptr<SpanTracerState>& tracer_state) {
+    if (state == tracer_state) {
+      return ring;
+    }
+    Release();
+    std::lock_guard<std::mutex> lock(tracer_state->mutex);
+    if (tracer_state->free_rings.empty()) {
+      tracer_state->rings.push_back(std::make_unique<ThreadSpans>(tracer_state->ring_capacity));
+      ring = tracer_state->rings.back().get();
+    } else {
+      ring = tracer_state->free_rings.back();
+      tracer_state->free_rings.pop_back();
+    }
+    ring->thread_number = tracer_state->next_thread_number++;
+    state = tracer_state;
+    return ring;
+  }
+
+  std::shared_ptr<SpanTracerState> state;
+  ThreadSpans* ring = nullptr;
+};
+
+thread_local ThreadBinding thread_binding;
+
+}  // namespace
+
+std::string_view TraceStageName(TraceStage stage) {
+  static constexpr std::array<std::string_view, 8> kNames = {
+      "accept", "recv", "parse", "queue_wait", "execute", "escape", "serialize", "send"};
+  const auto index = static_cast<std::size_t>(stage);
+  return index < kNames.size() ? kNames[index] : "unknown";
+}
+
+SpanTracer::SpanTracer(SpanTracerOptions options) : state_(std::make_shared<SpanTracerState>()) {
+  state_->spans_per_thread = std::max<std::size_t>(options.spans_per_thread, 1);
+  state_->ring_capacity = std::bit_ceil(state_->spans_per_thread + 1);
+}
+
+SpanTracer::~SpanTracer() = default;
+
+void SpanTracer::Start() {
+  state_->started_at_ns.store(MonotonicNanoseconds(), std::memory_order_relaxed);
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void SpanTracer::Stop() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+void SpanTracer::Record(TraceStage stage, std::uint64_t begin_ns, std::uint64_t end_ns) {
+  if (!IsEnabled()) {
+    return;
+  }
+  ThreadSpans* ring = thread_binding.Bind(state_);
+  const std::uint64_t index = ring->written.load(std::memory_order_relaxed);
+  SpanSlot& slot = ring->slots[index & ring->mask];
+  slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+  slot.end_ns.store(end_ns, std::memory_order_relaxed);
+  slot.tag.store(ring->thread_number << 8 | static_cast<std::uint64_t>(stage), std::memory_order_relaxed);
+  ring->written.store(index + 1, std::memory_order_release);
+}
+
+std::string SpanTracer::ChromeTraceJson() const {
+  const std::uint64_t started_at_ns = state_->started_at_ns.load(std::memory_order_relaxed);
+  std::vector<SpanEvent> events;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    for (const std::unique_ptr<ThreadSpans>& ring : state_->rings) {
+      const std::uint64_t capacity = ring->mask + 1;
+      const std::uint64_t kept = state_->spans_per_thread;
+      const std::uint64_t written = ring->written.load(std::memory_order_acquire);
+      const std::uint64_t first = written > kept ? written - kept : 0;
+      const std::size_t copied_from = events.size();
+      for (std::uint64_t index = first; index < written; ++index) {
+        const SpanSlot& slot = ring->slots[index & ring->mask];
+        events.push_back(SpanEvent{
+            slot.begin_ns.load(std::memory_order_relaxed),
+            slot.end_ns.load(std::memory_order_relaxed),
+            slot.tag.load(std::memory_order_relaxed)});
+      }
+      // Seqlock-style check: the owner may have moved on while the ring was copied. Slots it could have
+      // started overwriting, up to the one for its next unpublished span, are dropped.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      const std::uint64_t written_after = ring->written.load(std::memory_order_relaxed);
+      const std::uint64_t stable_from = written_after + 1 > capacity ? written_after + 1 - capacity : 0;
+      if (stable_from > first) {
+        const std::size_t unstable = static_cast<std::size_t>(std::min(stable_from, written) - first);
+        events.erase(events.begin() + static_cast<std::ptrdiff_t>(copied_from),
+                     events.begin() + static_cast<std::ptrdiff_t>(copied_from + unstable));
+      }
+    }
+  }
+
+  std::erase_if(events, [started_at_ns](const SpanEvent& event) { return event.begin_ns < started_at_ns; });
+  std::sort(events.begin(), events.end(), [](const SpanEvent& left, const SpanEvent& right) {
+    return left.begin_ns < right.begin_ns;
+  });
+
+  std::string json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (const SpanEvent& event : events) {
+    json += first ? "{\"name\":\"" : ",{\"name\":\"";
+    first = false;
+    json += TraceStageName(static_cast<TraceStage>(event.tag & 0xFF));
+    json += "\",\"cat\":\"dbgx\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+    AppendUnsigned(event.tag >> 8, &json);
+    json += ",\"ts\":";
+    AppendMicroseconds(event.begin_ns - started_at_ns, &json);
+    json += ",\"dur\":";
+    AppendMicroseconds(event.end_ns > event.begin_ns ? event.end_ns - event.begin_ns : 0, &json);
+    json += '}';
+  }
+  json += "]}";
+  return json;
+}
+
+}  // namespace dbgx::mcp
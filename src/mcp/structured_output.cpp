@@ -0,0 +1,189 @@
+#include "dbgx/mcp/structured_output.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <string_view>
+
+#include "dbgx/mcp/json.hpp"
+
+namespace dbgx::mcp {
+
+namespace {
+
+void AppendString(std::string_view text, std::string* out) {
+  out->push_back('"');
+  std::size_t run_start = 0;
+  for (std::size_t index = 0; index < text.size(); ++index) {
+    const char ch = text[index];
+    if (ch != '"' && ch != '\\' && static_cast<unsigned char>(ch) >= 0x20U) {
+      continue;
+    }
+    out->append(text.substr(run_start, index - run_start));
+    out->append(json::Escape(text.substr(index, 1)));
+    run_start = index + 1;
+  }
+  out->append(text.substr(run_start));
+  out->push_back('"');
+}
+
+void AppendHex(std::uint64_t value, std::string* out) {
+  char buffer[2 + 16];
+  buffer[0] = '0';
+  buffer[1] = 'x';
+  const std::to_chars_result result = std::to_chars(buffer + 2, buffer + sizeof(buffer), value, 16);
+  out->push_back('"');
+  out->append(buffer, result.ptr);
+  out->push_back('"');
+}
+
+void AppendUnsigned(std::uint64_t value, std::string* out) {
+  char buffer[20];
+  const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  out->append(buffer, result.ptr);
+}
+
+void AppendMemory(const windbg::MemoryDump& dump, std::string* out) {
+  out->append(",\"unitSize\":");
+  AppendUnsigned(dump.unit_size, out);
+  out->append(",\"rows\":[");
+  for (std::size_t row_index = 0; row_index < dump.rows.size(); ++row_index) {
+    const windbg::MemoryRow& row = dump.rows[row_index];
+    out->append(row_index == 0 ? "{\"address\":" : ",{\"address\":");
+    AppendHex(row.address, out);
+    out->append(",\"values\":[");
+    for (std::size_t index = 0; index < row.value_count; ++index) {
+      if (index != 0) {
+        out->push_back(',');
+      }
+      AppendHex(dump.values[row.first_value + index], out);
+    }
+    out->push_back(']');
+    if (row.unreadable) {
+      out->append(",\"unreadable\":true");
+    }
+    out->push_back('}');
+  }
+  out->push_back(']');
+}
+
+void AppendModules(const std::vector<windbg::ModuleEntry>& modules, std::string* out) {
+  out->append(",\"modules\":[");
+  for (std::size_t index = 0; index < modules.size(); ++index) {
+    const windbg::ModuleEntry& module = modules[index];
+    out->append(index == 0 ? "{\"name\":" : ",{\"name\":");
+    AppendString(module.name, out);
+    out->append(",\"start\":");
+    AppendHex(module.start, out);
+    out->append(",\"end\":");
+    AppendHex(module.end, out);
+    if (!module.symbol_status.empty()) {
+      out->append(",\"symbols\":");
+      AppendString(module.symbol_status, out);
+    }
+    if (!module.image_path.empty()) {
+      out->append(",\"imagePath\":");
+      AppendString(module.image_path, out);
+    }
+    if (module.unloaded) {
+      out->append(",\"unloaded\":true");
+    }
+    out->push_back('}');
+  }
+  out->push_back(']');
+}
+
+void AppendFrames(const std::vector<windbg::StackFrame>& frames, std::string* out) {
+  out->append(",\"frames\":[");
+  for (std::size_t index = 0; index < frames.size(); ++index) {
+    const windbg::StackFrame& frame = frames[index];
+    out->append(index == 0 ? "{" : ",{");
+    if (frame.has_number) {
+      out->append("\"frame\":");
+      AppendUnsigned(frame.number, out);
+      out->push_back(',');
+    }
+    if (frame.is_inline) {
+      out->append("\"inline\":true");
+    } else {
+      out->append("\"childSp\":");
+      AppendHex(frame.child_sp, out);
+      out->append(",\"returnAddress\":");
+      AppendHex(frame.return_address, out);
+    }
+    if (frame.arg_count != 0) {
+      out->append(",\"args\":[");
+      for (std::size_t arg = 0; arg < frame.arg_count; ++arg) {
+        if (arg != 0) {
+          out->push_back(',');
+        }
+        AppendHex(frame.args[arg], out);
+      }
+      out->push_back(']');
+    }
+    out->append(",\"callSite\":");
+    AppendString(frame.call_site, out);
+    if (!frame.module.empty()) {
+      out->append(",\"module\":");
+      AppendString(frame.module, out);
+    }
+    if (!frame.function.empty()) {
+      out->append(",\"function\":");
+      AppendString(frame.function, out);
+    }
+    if (frame.has_offset) {
+      out->append(",\"offset\":");
+      AppendHex(frame.offset, out);
+    }
+    if (!frame.source.empty()) {
+      out->append(",\"source\":");
+      AppendString(frame.source, out);
+    }
+    out->push_back('}');
+  }
+  out->push_back(']');
+}
+
+void AppendRegisters(const std::vector<windbg::RegisterValue>& registers, std::string* out) {
+  out->append(",\"registers\":{");
+  for (std::size_t index = 0; index < registers.size(); ++index) {
+    if (index != 0) {
+      out->push_back(',');
+    }
+    AppendString(registers[index].name, out);
+    out->push_back(':');
+    AppendHex(registers[index].value, out);
+  }
+  out->push_back('}');
+}
+
+}  // namespace
+
+void AppendParsedOutputJson(const windbg::ParsedOutput& parsed, std::string* out) {
+  out->append("{\"format\":\"");
+  out->append(windbg::OutputFormatName(parsed.format));
+  out->push_back('"');
+  switch (parsed.format) {
+    case windbg::OutputFormat::kMemory:
+      AppendMemory(parsed.memory, out);
+      break;
+    case windbg::OutputFormat::kModules:
+      AppendModules(parsed.modules, out);
+      break;
+    case windbg::OutputFormat::kStack:
+      AppendFrames(parsed.frames, out);
+      break;
+    case windbg::OutputFormat::kRegisters:
+      AppendRegisters(parsed.registers, out);
+      break;
+    case windbg::OutputFormat::kNone:
+      break;
+  }
+  out->append(",\"skippedLines\":");
+  AppendUnsigned(parsed.skipped_lines, out);
+  if (parsed.truncated) {
+    out->append(",\"truncated\":true");
+  }
+  out->push_back('}');
+}
+
+}  // namespace dbgx::mcp
@@ -0,0 +1,165 @@
+#include "dbgx/windbg/bounded_output.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace dbgx::windbg {
+
+namespace {
+
+constexpr std::size_t kUnlimitedBytes = std::numeric_limits<std::size_t>::max() / 2;
+
+}  // namespace
+
+bool OutputLimits::Enabled() const {
+  return max_output_bytes != 0 || head_lines != 0 || tail_lines != 0 || interrupt_after_bytes != 0;
+}
+
+BoundedOutputBuffer::BoundedOutputBuffer(OutputLimits limits, SegmentPool* pool) : limits_(limits), head_(pool) {
+  const std::size_t budget = limits_.max_output_bytes != 0 ? limits_.max_output_bytes : kUnlimitedBytes;
+  if (limits_.tail_lines == 0) {
+    head_budget_ = budget;
+  } else if (limits_.head_lines == 0) {
+    tail_budget_ = budget;
+  } else {
+    head_budget_ = budget / 2;
+    tail_budget_ = budget - head_budget_;
+  }
+  head_full_ = head_budget_ == 0;
+}
+
+bool BoundedOutputBuffer::Append(std::string_view text) {
+  total_bytes_ += text.size();
+
+  while (!head_full_ && !text.empty()) {
+    std::size_t take = std::min(text.size(), head_budget_ - head_.Size());
+    if (limits_.head_lines != 0) {
+      const std::size_t remaining_lines = limits_.head_lines - head_line_count_;
+      std::size_t pos = 0;
+      std::size_t lines = 0;
+      while (lines < remaining_lines) {
+        const std::size_t newline = text.find('\n', pos);
+        if (newline == std::string_view::npos || newline >= take) {
+          break;
+        }
+        pos = newline + 1;
+        ++lines;
+      }
+      if (lines == remaining_lines) {
+        take = pos;
+      }
+      head_line_count_ += lines;
+    }
+    if (take != 0) {
+      head_.Append(text.substr(0, take));
+      head_ends_line_ = text[take - 1] == '\n';
+    }
+    text.remove_prefix(take);
+    head_full_ = head_.Size() >= head_budget_ ||
+                 (limits_.head_lines != 0 && head_line_count_ >= limits_.head_lines);
+  }
+
+  AppendTail(text);
+
+  if (limits_.interrupt_after_bytes != 0 && total_bytes_ > limits_.interrupt_after_bytes) {
+    return false;
+  }
+  return !(head_full_ && tail_budget_ == 0 && total_bytes_ > head_.Size());
+}
+
+std::uint64_t BoundedOutputBuffer::TotalBytes() const {
+  return total_bytes_;
+}
+
+std::string BoundedOutputBuffer::Finish(std::uint64_t* out_dropped_bytes) {
+  std::string tail = TakeTail();
+  if (limits_.tail_lines != 0 && !tail.empty()) {
+    // Keep the last tail_lines lines; a trailing newline terminates the last line rather than starting one.
+    std::size_t lines = 0;
+    std::size_t pos = tail.size() - (tail.back() == '\n' ? 1 : 0);
+    while (pos > 0) {
+      const std::size_t newline = tail.rfind('\n', pos - 1);
+      if (newline == std::string::npos) {
+        pos = 0;
+        break;
+      }
+      if (++lines == limits_.tail_lines) {
+        pos = newline + 1;
+        break;
+      }
+      pos = newline;
+    }
+    tail.erase(0, pos);
+  }
+
+  const std::uint64_t dropped = total_bytes_ - head_.Size() - tail.size();
+  if (out_dropped_bytes != nullptr) {
+    *out_dropped_bytes = dropped;
+  }
+
+  std::string output;
+  if (dropped == 0 && tail.empty()) {
+    head_.AppendTo(&output);
+  } else {
+    const std::string marker =
+        dropped == 0 ? std::string() : "... [" + std::to_string(dropped) + " bytes omitted] ...\n";
+    output.reserve(head_.Size() + 1 + marker.size() + tail.size());
+    head_.AppendTo(&output);
+    if (!marker.empty() && !head_ends_line_) {
+      output += "\n";
+    }
+    output += marker;
+    output += tail;
+  }
+
+  head_.Clear();
+  head_ends_line_ = true;
+  head_line_count_ = 0;
+  head_full_ = head_budget_ == 0;
+  total_bytes_ = 0;
+  return output;
+}
+
+void BoundedOutputBuffer::AppendTail(std::string_view text) {
+  if (tail_budget_ == 0 || text.empty()) {
+    return;
+  }
+  if (text.size() >= tail_budget_) {
+    tail_ring_.assign(text.substr(text.size() - tail_budget_));
+    tail_pos_ = 0;
+    return;
+  }
+
+  // The ring grows lazily up to its budget, then overwrites the oldest bytes at tail_pos_.
+  if (tail_ring_.size() < tail_budget_) {
+    const std::size_t take = std::min(text.size(), tail_budget_ - tail_ring_.size());
+    tail_ring_.append(text.substr(0, take));
+    text.remove_prefix(take);
+  }
+  while (!text.empty()) {
+    const std::size_t take = std::min(text.size(), tail_budget_ - tail_pos_);
+    std::memcpy(tail_ring_.data() + tail_pos_, text.data(), take);
+    tail_pos_ = (tail_pos_ + take) % tail_budget_;
+    text.remove_prefix(take);
+  }
+}
+
+std::string BoundedOutputBuffer::TakeTail() {
+  std::string tail;
+  tail.reserve(tail_ring_.size());
+  tail.append(tail_ring_, tail_pos_, std::string::npos);
+  tail.append(tail_ring_, 0, tail_pos_);
+  tail_ring_.clear();
+  tail_pos_ = 0;
+  return tail;
+}
+
+std::string LimitOutput(std::string_view output, const OutputLimits& limits, std::uint64_t* out_dropped_bytes) {
+  BoundedOutputBuffer buffer(limits);
+  buffer.Append(output);
+  return buffer.Finish(out_dropped_bytes);
+}
+
+}  // namespace dbgx::windbg
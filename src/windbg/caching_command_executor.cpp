@@ -0,0 +1,501 @@
+#include "dbgx/windbg/caching_command_executor.hpp"
+
+#include <array>
+#include <chrono>
+#include <utility>
+
+#include "dbgx/windbg/ascii.hpp"
+
+namespace dbgx::windbg {
+
+namespace {
+
+// Memory display (d*) and disassembly (u*) commands given no address continue from where the last command
+// of the same family stopped, so their output depends on the previous command as well as on engine state.
+enum class DisplayFamily : std::uint8_t {
+  kNone,
+  kMemory,
+  kDisassembly,
+};
+
+struct CommandClassification {
+  std::string_view name;
+  CommandCachePolicy policy;
+  DisplayFamily display = DisplayFamily::kNone;
+};
+
+// Matched case-insensitively against the first token of each command. Anything not listed may change state
+// the engine generation does not cover (.effmach, .scope, dx ...SwitchTo()), so it is treated as mutating.
+constexpr std::array kCommandClassifications = {
+    CommandClassification{"lm", CommandCachePolicy::kCacheable},
+    CommandClassification{"lmv", CommandCachePolicy::kCacheable},
+    CommandClassification{"k", CommandCachePolicy::kCacheable},
+    CommandClassification{"kb", CommandCachePolicy::kCacheable},
+    CommandClassification{"kn", CommandCachePolicy::kCacheable},
+    CommandClassification{"kp", CommandCachePolicy::kCacheable},
+    CommandClassification{"kv", CommandCachePolicy::kCacheable},
+    CommandClassification{"r", CommandCachePolicy::kCacheable},
+    CommandClassification{"dt", CommandCachePolicy::kCacheable},
+    CommandClassification{"dv", CommandCachePolicy::kCacheable},
+    CommandClassification{"db", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"dw", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"dd", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"dq", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"dp", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"da", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"du", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"dps", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"dqs", CommandCachePolicy::kCacheable, DisplayFamily::kMemory},
+    CommandClassification{"u", CommandCachePolicy::kCacheable, DisplayFamily::kDisassembly},
+    CommandClassification{"ub", CommandCachePolicy::kCacheable, DisplayFamily::kDisassembly},
+    CommandClassification{"uf", CommandCachePolicy::kCacheable},
+    CommandClassification{"x", CommandCachePolicy::kCacheable},
+    CommandClassification{"ln", CommandCachePolicy::kCacheable},
+    CommandClassification{"!peb", CommandCachePolicy::kCacheable},
+    CommandClassification{"!teb", CommandCachePolicy::kCacheable},
+    CommandClassification{"!address", CommandCachePolicy::kCacheable},
+    CommandClassification{"!lmi", CommandCachePolicy::kCacheable},
+    CommandClassification{".lastevent", CommandCachePolicy::kCacheable},
+    CommandClassification{"vertarget", CommandCachePolicy::kCacheable},
+    CommandClassification{".echo", CommandCachePolicy::kCacheable},
+    CommandClassification{"g", CommandCachePolicy::kMutating},
+    CommandClassification{"gh", CommandCachePolicy::kMutating},
+    CommandClassification{"gn", CommandCachePolicy::kMutating},
+    CommandClassification{"gu", CommandCachePolicy::kMutating},
+    CommandClassification{"p", CommandCachePolicy::kMutating},
+    CommandClassification{"pa", CommandCachePolicy::kMutating},
+    CommandClassification{"pc", CommandCachePolicy::kMutating},
+    CommandClassification{"pt", CommandCachePolicy::kMutating},
+    CommandClassification{"t", CommandCachePolicy::kMutating},
+    CommandClassification{"ta", CommandCachePolicy::kMutating},
+    CommandClassification{"tc", CommandCachePolicy::kMutating},
+    CommandClassification{"tt", CommandCachePolicy::kMutating},
+    CommandClassification{"wt", CommandCachePolicy::kMutating},
+    CommandClassification{"!tt", CommandCachePolicy::kMutating},
+    CommandClassification{"e", CommandCachePolicy::kMutating},
+    CommandClassification{"ea", CommandCachePolicy::kMutating},
+    CommandClassification{"eb", CommandCachePolicy::kMutating},
+    CommandClassification{"ed", CommandCachePolicy::kMutating},
+    CommandClassification{"ef", CommandCachePolicy::kMutating},
+    CommandClassification{"ep", CommandCachePolicy::kMutating},
+    CommandClassification{"eq", CommandCachePolicy::kMutating},
+    CommandClassification{"eu", CommandCachePolicy::kMutating},
+    CommandClassification{"ew", CommandCachePolicy::kMutating},
+    CommandClassification{"eza", CommandCachePolicy::kMutating},
+    CommandClassification{"ezu", CommandCachePolicy::kMutating},
+    CommandClassification{"f", CommandCachePolicy::kMutating},
+    CommandClassification{".frame", CommandCachePolicy::kMutating},
+    CommandClassification{".f+", CommandCachePolicy::kMutating},
+    CommandClassification{".f-", CommandCachePolicy::kMutating},
+    CommandClassification{".cxr", CommandCachePolicy::kMutating},
+    CommandClassification{".ecxr", CommandCachePolicy::kMutating},
+    CommandClassification{".thread", CommandCachePolicy::kMutating},
+    CommandClassification{".process", CommandCachePolicy::kMutating},
+    CommandClassification{".reload", CommandCachePolicy::kMutating},
+    CommandClassification{".sympath", CommandCachePolicy::kMutating},
+    CommandClassification{".sympath+", CommandCachePolicy::kMutating},
+    CommandClassification{".restart", CommandCachePolicy::kMutating},
+    CommandClassification{".kill", CommandCachePolicy::kMutating},
+    CommandClassification{".detach", CommandCachePolicy::kMutating},
+    CommandClassification{".attach", CommandCachePolicy::kMutating},
+    CommandClassification{".opendump", CommandCachePolicy::kMutating},
+};
+
+std::string_view TrimLeadingSpace(std::string_view text) {
+  while (!text.empty() && IsSpace(text.front())) {
+    text.remove_prefix(1);
+  }
+  return text;
+}
+
+// Splits a single command into its first token and the rest; null when the name is not in the table.
+const CommandClassification* FindClassification(std::string_view command, std::string_view* out_arguments) {
+  std::size_t name_end = 0;
+  while (name_end < command.size() && !IsSpace(command[name_end])) {
+    ++name_end;
+  }
+  const std::string_view name = command.substr(0, name_end);
+  *out_arguments = command.substr(name_end);
+  for (const CommandClassification& entry : kCommandClassifications) {
+    if (EqualsIgnoreCase(entry.name, name)) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+// True when display arguments give no start address: none at all, only a range ("L20", "L?100"), or
+// leading options, which are not parsed and so are treated the same way.
+bool ContinuesLastDisplay(std::string_view arguments) {
+  arguments = TrimLeadingSpace(arguments);
+  if (arguments.empty() || arguments.front() == '/') {
+    return true;
+  }
+  return (arguments[0] == 'L' || arguments[0] == 'l') && arguments.size() > 1 &&
+         ((arguments[1] >= '0' && arguments[1] <= '9') || arguments[1] == '?');
+}
+
+CommandCachePolicy ClassifySingleCommand(std::string_view command) {
+  command = TrimLeadingSpace(command);
+  if (command.empty()) {
+    return CommandCachePolicy::kUncached;
+  }
+  // Thread (~) and process (|) prefixes switch the current context.
+  if (command.front() == '~' || command.front() == '|') {
+    return CommandCachePolicy::kMutating;
+  }
+
+  std::string_view arguments;
+  const CommandClassification* entry = FindClassification(command, &arguments);
+  if (entry == nullptr) {
+    return CommandCachePolicy::kMutating;
+  }
+  // "r rax=0" writes a register.
+  if (entry->policy == CommandCachePolicy::kCacheable && EqualsIgnoreCase(entry->name, "r") &&
+      arguments.find('=') != std::string_view::npos) {
+    return CommandCachePolicy::kMutating;
+  }
+  if (entry->display != DisplayFamily::kNone && ContinuesLastDisplay(arguments)) {
+    return CommandCachePolicy::kUncached;
+  }
+  return entry->policy;
+}
+
+// Calls visit with each part of a normalized command split on ';' outside quotes, until it returns false.
+template <typename Visitor>
+void ForEachCommandPart(std::string_view normalized_command, Visitor visit) {
+  std::size_t start = 0;
+  bool in_quotes = false;
+  for (std::size_t index = 0; index <= normalized_command.size(); ++index) {
+    if (index < normalized_command.size()) {
+      if (normalized_command[index] == '"') {
+        in_quotes = !in_quotes;
+      }
+      if (in_quotes || normalized_command[index] != ';') {
+        continue;
+      }
+    }
+    if (!visit(normalized_command.substr(start, index - start))) {
+      return;
+    }
+    start = index + 1;
+  }
+}
+
+// Which display families a command starts at an explicit address, and which it continues. Indexed by
+// DisplayFamily - 1.
+struct DisplayEffect {
+  std::array<bool, 2> addressed{};
+  std::array<bool, 2> continued{};
+};
+
+DisplayEffect DescribeDisplays(std::string_view normalized_command) {
+  DisplayEffect effect;
+  ForEachCommandPart(normalized_command, [&effect](std::string_view part) {
+    std::string_view arguments;
+    const CommandClassification* entry = FindClassification(TrimLeadingSpace(part), &arguments);
+    if (entry != nullptr && entry->display != DisplayFamily::kNone) {
+      const std::size_t family = static_cast<std::size_t>(entry->display) - 1;
+      (ContinuesLastDisplay(arguments) ? effect.continued : effect.addressed)[family] = true;
+    }
+    return true;
+  });
+  return effect;
+}
+
+std::uint64_t ElapsedMicros(std::chrono::steady_clock::time_point started_at) {
+  return static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_at).count());
+}
+
+}  // namespace
+
+std::string NormalizeCommand(std::string_view command) {
+  std::string normalized;
+  normalized.reserve(command.size());
+  bool in_quotes = false;
+  bool pending_space = false;
+  for (const char ch : command) {
+    if (!in_quotes && IsSpace(ch)) {
+      pending_space = !normalized.empty();
+      continue;
+    }
+    if (pending_space) {
+      normalized.push_back(' ');
+      pending_space = false;
+    }
+    if (ch == '"') {
+      in_quotes = !in_quotes;
+    }
+    normalized.push_back(ch);
+  }
+  return normalized;
+}
+
+CommandCachePolicy ClassifyCommand(std::string_view normalized_command) {
+  if (normalized_command.empty()) {
+    return CommandCachePolicy::kUncached;
+  }
+
+  bool all_cacheable = true;
+  bool mutating = false;
+  ForEachCommandPart(normalized_command, [&](std::string_view part) {
+    const CommandCachePolicy policy = ClassifySingleCommand(part);
+    mutating = policy == CommandCachePolicy::kMutating;
+    all_cacheable = all_cacheable && policy == CommandCachePolicy::kCacheable;
+    return !mutating;
+  });
+  if (mutating) {
+    return CommandCachePolicy::kMutating;
+  }
+  return all_cacheable ? CommandCachePolicy::kCacheable : CommandCachePolicy::kUncached;
+}
+
+CachingCommandExecutor::CachingCommandExecutor(IWinDbgCommandExecutor* inner, CommandCacheOptions options)
+    : inner_(inner), options_(options) {}
+
+CommandExecutionResult CachingCommandExecutor::Execute(const std::string& command) {
+  return ExecuteWithContext(command, nullptr);
+}
+
+CommandExecutionResult CachingCommandExecutor::ExecuteWithContext(
+    const std::string& command,
+    CommandExecutionContext* context) {
+  if (context != nullptr && context->CancelRequested()) {
+    return MakeCancelledResult();
+  }
+
+  const std::string key = NormalizeCommand(command);
+  const CommandCachePolicy policy = ClassifyCommand(key);
+  if (policy != CommandCachePolicy::kCacheable) {
+    PrepareDisplays(key);
+    CommandExecutionResult result = inner_->ExecuteWithContext(command, context);
+    if (policy == CommandCachePolicy::kMutating) {
+      NoteMutation();
+    }
+    return result;
+  }
+
+  const auto started_at = std::chrono::steady_clock::now();
+  const Generation generation = CurrentGeneration();
+  CommandExecutionResult cached;
+  if (TryGetCached(key, generation, &cached)) {
+    NoteDisplayHit(command, key);
+    cached.duration_us = ElapsedMicros(started_at);
+    if (context != nullptr) {
+      context->AppendOutput(cached.output);
+      ShapeCapturedOutput(*context, &cached);
+    }
+    return cached;
+  }
+
+  PrepareDisplays(key);
+  CommandExecutionResult result = inner_->ExecuteWithContext(command, context);
+  // Filtered output depends on the caller's filter, so only unfiltered outputs are reused.
+  if (context == nullptr || context->Filter() == nullptr) {
+    Store(key, generation, result);
+  }
+  return result;
+}
+
+std::vector<CommandExecutionResult> CachingCommandExecutor::ExecuteBatch(
+    const std::vector<std::string>& commands,
+    bool stop_on_error) {
+  std::vector<CommandExecutionResult> results;
+  results.reserve(commands.size());
+
+  // Misses are forwarded to the inner executor in runs so its batch path is kept. A run is flushed before
+  // any cache lookup and after each mutating command, so hits never skip over a pending state change.
+  std::vector<std::string> pending;
+  std::vector<std::string> pending_keys;
+  std::vector<CommandCachePolicy> pending_policies;
+  const auto flush = [&]() {
+    if (pending.empty()) {
+      return true;
+    }
+    const Generation generation = CurrentGeneration();
+    std::vector<CommandExecutionResult> run = inner_->ExecuteBatch(pending, stop_on_error);
+    bool mutated = false;
+    for (std::size_t index = 0; index < run.size() && index < pending.size(); ++index) {
+      if (pending_policies[index] == CommandCachePolicy::kCacheable && !mutated) {
+        Store(pending_keys[index], generation, run[index]);
+      }
+      mutated = mutated || pending_policies[index] == CommandCachePolicy::kMutating;
+    }
+    if (mutated) {
+      NoteMutation();
+    }
+
+    const bool completed = run.size() >= pending.size() && (!stop_on_error || run.empty() || run.back().success);
+    for (CommandExecutionResult& result : run) {
+      results.push_back(std::move(result));
+    }
+    pending.clear();
+    pending_keys.clear();
+    pending_policies.clear();
+    return completed;
+  };
+
+  for (const std::string& command : commands) {
+    std::string key = NormalizeCommand(command);
+    const CommandCachePolicy policy = ClassifyCommand(key);
+    if (policy == CommandCachePolicy::kCacheable) {
+      if (!flush()) {
+        return results;
+      }
+      const auto started_at = std::chrono::steady_clock::now();
+      CommandExecutionResult cached;
+      if (TryGetCached(key, CurrentGeneration(), &cached)) {
+        NoteDisplayHit(command, key);
+        cached.duration_us = ElapsedMicros(started_at);
+        results.push_back(std::move(cached));
+        continue;
+      }
+    }
+
+    // A display replay has to reach the engine before this command, so the run so far goes first.
+    if (NeedsDisplayReplay(key) && !flush()) {
+      return results;
+    }
+    PrepareDisplays(key);
+    pending.push_back(command);
+    pending_keys.push_back(std::move(key));
+    pending_policies.push_back(policy);
+    if (policy == CommandCachePolicy::kMutating && !flush()) {
+      return results;
+    }
+  }
+  flush();
+  return results;
+}
+
+std::uint64_t CachingCommandExecutor::StateGeneration() {
+  const Generation generation = CurrentGeneration();
+  return generation.engine + generation.local;
+}
+
+bool CachingCommandExecutor::OpenSession(std::string* error_message) {
+  return inner_->OpenSession(error_message);
+}
+
+void CachingCommandExecutor::CloseSession() {
+  inner_->CloseSession();
+}
+
+CommandCacheStats CachingCommandExecutor::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+CachingCommandExecutor::Generation CachingCommandExecutor::CurrentGeneration() {
+  const std::uint64_t engine = inner_->StateGeneration();
+  std::lock_guard<std::mutex> lock(mutex_);
+  return Generation{engine, local_generation_};
+}
+
+bool CachingCommandExecutor::TryGetCached(
+    const std::string& key,
+    Generation generation,
+    CommandExecutionResult* out_result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!(generation == generation_)) {
+    InvalidateLocked();
+    generation_ = generation;
+  }
+
+  const auto it = index_.find(key);
+  if (it == index_.end()) {
+    ++stats_.misses;
+    return false;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  *out_result = it->second->result;
+  ++stats_.hits;
+  stats_.saved_us += it->second->result.duration_us;
+  return true;
+}
+
+void CachingCommandExecutor::Store(
+    const std::string& key,
+    Generation generation,
+    const CommandExecutionResult& result) {
+  // Truncated results depend on the caller's output limits, so only complete outputs are reused.
+  if (!result.success || result.cancelled || result.dropped_output_bytes != 0 ||
+      result.output.size() > options_.max_output_bytes) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!(generation == generation_) || index_.count(key) != 0) {
+    return;
+  }
+
+  entries_.push_front(Entry{key, result});
+  index_.emplace(key, entries_.begin());
+  cached_bytes_ += result.output.size();
+  while (!entries_.empty() && (entries_.size() > options_.max_entries || cached_bytes_ > options_.max_output_bytes)) {
+    cached_bytes_ -= entries_.back().result.output.size();
+    index_.erase(entries_.back().key);
+    entries_.pop_back();
+  }
+}
+
+void CachingCommandExecutor::NoteDisplayHit(const std::string& command, std::string_view key) {
+  const DisplayEffect effect = DescribeDisplays(key);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::size_t family = 0; family < display_replays_.size(); ++family) {
+    if (effect.addressed[family]) {
+      display_replays_[family] = command;
+    }
+  }
+}
+
+bool CachingCommandExecutor::NeedsDisplayReplay(std::string_view key) {
+  const DisplayEffect effect = DescribeDisplays(key);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::size_t family = 0; family < display_replays_.size(); ++family) {
+    if (effect.continued[family] && !display_replays_[family].empty()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void CachingCommandExecutor::PrepareDisplays(std::string_view key) {
+  const DisplayEffect effect = DescribeDisplays(key);
+  std::array<std::string, 2> replays;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (std::size_t family = 0; family < display_replays_.size(); ++family) {
+      if (effect.continued[family]) {
+        replays[family] = std::move(display_replays_[family]);
+      }
+      if (effect.continued[family] || effect.addressed[family]) {
+        display_replays_[family].clear();
+      }
+    }
+  }
+  for (const std::string& replay : replays) {
+    if (!replay.empty()) {
+      (void)inner_->Execute(replay);
+    }
+  }
+}
+
+void CachingCommandExecutor::NoteMutation() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++local_generation_;
+  InvalidateLocked();
+}
+
+void CachingCommandExecutor::InvalidateLocked() {
+  if (!entries_.empty()) {
+    ++stats_.invalidations;
+  }
+  entries_.clear();
+  index_.clear();
+  cached_bytes_ = 0;
+}
+
+}  // namespace dbgx::windbg
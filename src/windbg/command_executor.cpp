@@ -0,0 +1,193 @@
+#include "dbgx/windbg/command_executor.hpp"
+
+#include <condition_variable>
+#include <utility>
+
+namespace dbgx::windbg {
+
+void CommandExecutionContext::RequestCancel() {
+  std::function<void()> handler;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancel_requested_.exchange(true)) {
+      return;
+    }
+    handler = interrupt_handler_;
+  }
+  if (handler) {
+    handler();
+  }
+}
+
+bool CommandExecutionContext::CancelRequested() const {
+  return cancel_requested_.load();
+}
+
+void CommandExecutionContext::RequestTimeout() {
+  // A command already cancelled by its client stays reported as cancelled.
+  if (cancel_requested_.load()) {
+    return;
+  }
+  timed_out_.store(true);
+  RequestCancel();
+}
+
+bool CommandExecutionContext::TimedOut() const {
+  return timed_out_.load();
+}
+
+void CommandExecutionContext::SetInterruptHandler(std::function<void()> handler) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  interrupt_handler_ = std::move(handler);
+}
+
+void CommandExecutionContext::ClearInterruptHandler() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  interrupt_handler_ = nullptr;
+}
+
+void CommandExecutionContext::AppendOutput(std::string_view text) {
+  output_bytes_.fetch_add(text.size(), std::memory_order_relaxed);
+  if (output_observer_) {
+    output_observer_(text);
+  }
+}
+
+std::uint64_t CommandExecutionContext::OutputBytes() const {
+  return output_bytes_.load(std::memory_order_relaxed);
+}
+
+void CommandExecutionContext::SetOutputObserver(std::function<void(std::string_view text)> observer) {
+  output_observer_ = std::move(observer);
+}
+
+const std::function<void(std::string_view text)>& CommandExecutionContext::OutputObserver() const {
+  return output_observer_;
+}
+
+void CommandExecutionContext::SetOutputLimits(OutputLimits limits) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  output_limits_ = limits;
+}
+
+OutputLimits CommandExecutionContext::Limits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return output_limits_;
+}
+
+void CommandExecutionContext::SetLineFilter(std::shared_ptr<const LineFilter> filter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  line_filter_ = std::move(filter);
+}
+
+std::shared_ptr<const LineFilter> CommandExecutionContext::Filter() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return line_filter_;
+}
+
+std::vector<CommandExecutionResult> IWinDbgCommandExecutor::ExecuteBatch(
+    const std::vector<std::string>& commands,
+    bool stop_on_error) {
+  std::vector<CommandExecutionResult> results;
+  results.reserve(commands.size());
+
+  for (const std::string& command : commands) {
+    const auto started_at = std::chrono::steady_clock::now();
+    CommandExecutionResult result = Execute(command);
+    if (result.duration_us == 0) {
+      result.duration_us = static_cast<std::uint64_t>(
+          std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_at)
+              .count());
+    }
+    const bool failed = !result.success;
+    results.push_back(std::move(result));
+    if (failed && stop_on_error) {
+      break;
+    }
+  }
+  return results;
+}
+
+CommandExecutionResult IWinDbgCommandExecutor::ExecuteWithContext(
+    const std::string& command,
+    CommandExecutionContext* context) {
+  if (context != nullptr && context->CancelRequested()) {
+    return MakeCancelledResult();
+  }
+
+  CommandExecutionResult result = Execute(command);
+  if (context != nullptr) {
+    context->AppendOutput(result.output);
+    ShapeCapturedOutput(*context, &result);
+  }
+  return result;
+}
+
+std::uint64_t IWinDbgCommandExecutor::StateGeneration() {
+  return 0;
+}
+
+bool IWinDbgCommandExecutor::OpenSession(std::string* /*error_message*/) {
+  return true;
+}
+
+void IWinDbgCommandExecutor::CloseSession() {}
+
+CommandExecutionResult MakeCancelledResult(std::string partial_output) {
+  CommandExecutionResult result;
+  result.output = std::move(partial_output);
+  result.error_message = "Command cancelled";
+  result.cancelled = true;
+  return result;
+}
+
+bool WaitUntilDeadlineOrCancelled(CommandExecutionContext* context, std::chrono::steady_clock::time_point deadline) {
+  struct Wait {
+    std::mutex mutex;
+    std::condition_variable interrupted;
+    bool cancelled = false;
+  };
+  // Shared with the handler, which a racing RequestCancel may still call after it has been cleared.
+  const auto wait = std::make_shared<Wait>();
+  if (context != nullptr) {
+    context->SetInterruptHandler([wait]() {
+      std::lock_guard<std::mutex> lock(wait->mutex);
+      wait->cancelled = true;
+      wait->interrupted.notify_all();
+    });
+  }
+  {
+    std::unique_lock<std::mutex> lock(wait->mutex);
+    const auto cancelled = [&]() { return wait->cancelled || (context != nullptr && context->CancelRequested()); };
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+      wait->interrupted.wait(lock, cancelled);
+    } else {
+      wait->interrupted.wait_until(lock, deadline, cancelled);
+    }
+  }
+  if (context == nullptr) {
+    return true;
+  }
+  context->ClearInterruptHandler();
+  return !context->CancelRequested();
+}
+
+void ShapeCapturedOutput(const CommandExecutionContext& context, CommandExecutionResult* result) {
+  const std::shared_ptr<const LineFilter> filter = context.Filter();
+  if (filter != nullptr) {
+    std::string filter_error;
+    result->output = FilterLines(result->output, *filter, &filter_error);
+    if (!filter_error.empty() && !result->cancelled) {
+      result->success = false;
+      result->error_message = "Line filter failed: " + filter_error;
+    }
+  }
+  const OutputLimits limits = context.Limits();
+  if (limits.Enabled()) {
+    std::uint64_t dropped_bytes = 0;
+    result->output = LimitOutput(result->output, limits, &dropped_bytes);
+    result->dropped_output_bytes += dropped_bytes;
+  }
+}
+
+}  // namespace dbgx::windbg
@@ -0,0 +1,80 @@
+#include "dbgx/windbg/command_watchdog.hpp"
+
+namespace dbgx::windbg {
+
+CommandWatchdog::CommandWatchdog() : thread_([this]() { Run(); }) {}
+
+CommandWatchdog::~CommandWatchdog() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  thread_.join();
+}
+
+CommandWatchdog::Token CommandWatchdog::Arm(
+    CommandExecutionContext* context,
+    std::chrono::steady_clock::time_point deadline) {
+  bool earliest = false;
+  Token token = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    token = next_token_++;
+    const auto it = armed_.emplace(DeadlineKey{deadline, token}, context).first;
+    deadline_by_token_.emplace(token, deadline);
+    earliest = it == armed_.begin();
+  }
+  // Only a new earliest deadline changes how long the watchdog thread has to sleep.
+  if (earliest) {
+    changed_.notify_all();
+  }
+  return token;
+}
+
+void CommandWatchdog::Disarm(Token token) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const auto it = deadline_by_token_.find(token);
+  if (it == deadline_by_token_.end()) {
+    fired_.wait(lock, [&]() { return firing_ != token; });
+    return;
+  }
+  armed_.erase(DeadlineKey{it->second, token});
+  deadline_by_token_.erase(it);
+}
+
+std::uint64_t CommandWatchdog::ExpiredCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return expired_count_;
+}
+
+void CommandWatchdog::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stopping_) {
+    if (armed_.empty()) {
+      changed_.wait(lock);
+      continue;
+    }
+    const auto first = armed_.begin();
+    // Disarm may erase the node while this waits, so the wait must not hold a reference into it.
+    const std::chrono::steady_clock::time_point deadline = first->first.first;
+    if (std::chrono::steady_clock::now() < deadline) {
+      changed_.wait_until(lock, deadline);
+      continue;
+    }
+
+    CommandExecutionContext* context = first->second;
+    firing_ = first->first.second;
+    deadline_by_token_.erase(firing_);
+    armed_.erase(first);
+    ++expired_count_;
+    // The interrupt handler calls into the engine; never run it under the watchdog lock.
+    lock.unlock();
+    context->RequestTimeout();
+    lock.lock();
+    firing_ = 0;
+    fired_.notify_all();
+  }
+}
+
+}  // namespace dbgx::windbg
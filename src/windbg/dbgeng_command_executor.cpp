@@ -5,12 +5,22 @@
 #include <DbgEng.h>
 #include <wrl/client.h>
 
+#include <chrono>
+#include <cstdint>
 #include <mutex>
+#include <optional>
+#include <utility>
+
+#include "dbgx/windbg/segmented_buffer.hpp"
 
 namespace dbgx::windbg {
 
 namespace {
 
+void InterruptEngine();
+
+// DbgEng calls output callbacks only on the thread that created the client, which is also the thread that
+// runs Execute and takes the output, so the sink needs no lock.
 class OutputCaptureCallbacks final : public IDebugOutputCallbacks {
  public:
   OutputCaptureCallbacks() = default;
@@ -44,21 +54,101 @@ class OutputCaptureCallbacks final : public IDebugOutputCallbacks {
 
   STDMETHOD(Output)(ULONG /*mask*/, PCSTR text) override {
     if (text != nullptr) {
-      std::lock_guard<std::mutex> lock(mutex_);
-      output_ += text;
+      if (line_filter_.has_value()) {
+        line_filter_->Feed(text, &filtered_);
+        Keep(filtered_);
+        filtered_.clear();
+        if (!line_filter_->Error().empty() && !filter_failed_) {
+          // Nothing more would be kept, so stop the command rather than let it run to completion.
+          filter_failed_ = true;
+          InterruptEngine();
+        }
+      } else {
+        Keep(text);
+      }
+      if (context_ != nullptr) {
+        context_->AppendOutput(text);
+      }
     }
     return S_OK;
   }
 
-  std::string TakeOutput() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return output_;
+  void SetContext(CommandExecutionContext* context) {
+    context_ = context;
+    bounded_.reset();
+    line_filter_.reset();
+    filter_ = nullptr;
+    limit_reached_ = false;
+    filter_failed_ = false;
+    if (context_ == nullptr) {
+      return;
+    }
+    if (context_->Limits().Enabled()) {
+      bounded_.emplace(context_->Limits());
+    }
+    filter_ = context_->Filter();
+    if (filter_ != nullptr) {
+      line_filter_.emplace(filter_.get());
+    }
+  }
+
+  // A long-lived client also receives engine output broadcast between commands; drop it before the next one.
+  void DiscardOutput() {
+    output_.Clear();
+  }
+
+  std::string TakeOutput(
+      std::uint64_t* out_dropped_bytes = nullptr,
+      bool* out_limit_reached = nullptr,
+      std::string* out_filter_error = nullptr) {
+    if (line_filter_.has_value()) {
+      line_filter_->Finish(&filtered_);
+      Keep(filtered_);
+      filtered_.clear();
+      if (out_filter_error != nullptr) {
+        *out_filter_error = line_filter_->Error();
+      }
+    }
+    if (out_limit_reached != nullptr) {
+      *out_limit_reached = limit_reached_;
+    }
+    if (bounded_.has_value()) {
+      std::uint64_t dropped_bytes = 0;
+      std::string output = bounded_->Finish(&dropped_bytes);
+      if (out_dropped_bytes != nullptr) {
+        *out_dropped_bytes = dropped_bytes;
+      }
+      return output;
+    }
+    std::string output = output_.ToString();
+    output_.Clear();
+    return output;
   }
 
  private:
   volatile LONG ref_count_ = 1;
-  std::mutex mutex_;
-  std::string output_;
+  // Called for text that survived the line filter.
+  void Keep(std::string_view text) {
+    if (!bounded_.has_value()) {
+      output_.Append(text);
+      return;
+    }
+    if (!bounded_->Append(text) && !limit_reached_) {
+      // The engine stops at its next interrupt check; output until then is still bounded.
+      limit_reached_ = true;
+      InterruptEngine();
+    }
+  }
+
+  // Pooled segments: growth never reallocates or copies what was already captured.
+  SegmentedBuffer output_;
+  std::shared_ptr<const LineFilter> filter_;
+  std::optional<StreamingLineFilter> line_filter_;
+  std::string filtered_;
+  std::optional<BoundedOutputBuffer> bounded_;
+  bool limit_reached_ = false;
+  bool filter_failed_ = false;
+  CommandExecutionContext* context_ = nullptr;
 };
 
 std::string HResultToString(HRESULT hr) {
@@ -86,67 +176,274 @@ std::string HResultToString(HRESULT hr) {
   return message;
 }
 
+// SetInterrupt may be called from any thread, so cancellation uses a client of its own rather than the one
+// that is blocked inside IDebugControl::Execute.
+void InterruptEngine() {
+  Microsoft::WRL::ComPtr<IDebugClient> client;
+  if (FAILED(DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(client.GetAddressOf())))) {
+    return;
+  }
+  Microsoft::WRL::ComPtr<IDebugControl> control;
+  if (FAILED(client.As(&control))) {
+    return;
+  }
+  (void)control->SetInterrupt(DEBUG_INTERRUPT_ACTIVE);
+}
+
+// Owns one DebugCreate client with the capture callbacks installed, so a batch or an open executor session
+// pays for client setup and the callback swap once instead of once per command.
+class CaptureSession {
+ public:
+  CaptureSession() = default;
+  CaptureSession(const CaptureSession&) = delete;
+  CaptureSession& operator=(const CaptureSession&) = delete;
+
+  ~CaptureSession() {
+    if (capture_ != nullptr) {
+      (void)client_->SetOutputCallbacks(previous_callbacks_.Get());
+      capture_->Release();
+    }
+  }
+
+  bool Open(std::string* error_message) {
+    HRESULT hr = DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(client_.GetAddressOf()));
+    if (FAILED(hr)) {
+      *error_message = "DebugCreate failed: " + HResultToString(hr);
+      return false;
+    }
+
+    hr = client_.As(&control_);
+    if (FAILED(hr)) {
+      *error_message = "IDebugControl not available: " + HResultToString(hr);
+      return false;
+    }
+
+    (void)client_->GetOutputCallbacks(&previous_callbacks_);
+
+    auto* capture = new OutputCaptureCallbacks();
+    hr = client_->SetOutputCallbacks(capture);
+    if (FAILED(hr)) {
+      capture->Release();
+      *error_message = "SetOutputCallbacks failed: " + HResultToString(hr);
+      return false;
+    }
+    capture_ = capture;
+    return true;
+  }
+
+  IDebugClient* Client() const {
+    return client_.Get();
+  }
+
+  CommandExecutionResult Run(const std::string& command, CommandExecutionContext* context = nullptr) {
+    const auto started_at = std::chrono::steady_clock::now();
+    capture_->DiscardOutput();
+    if (context != nullptr) {
+      capture_->SetContext(context);
+      context->SetInterruptHandler(&InterruptEngine);
+    }
+    const HRESULT hr = control_->Execute(DEBUG_OUTCTL_THIS_CLIENT, command.c_str(), DEBUG_EXECUTE_DEFAULT);
+    if (context != nullptr) {
+      context->ClearInterruptHandler();
+    }
+
+    CommandExecutionResult result;
+    bool limit_reached = false;
+    std::string filter_error;
+    result.output = capture_->TakeOutput(&result.dropped_output_bytes, &limit_reached, &filter_error);
+    if (context != nullptr) {
+      capture_->SetContext(nullptr);
+    }
+    result.duration_us = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_at).count());
+    if (context != nullptr && context->CancelRequested()) {
+      CommandExecutionResult cancelled = MakeCancelledResult(std::move(result.output));
+      cancelled.duration_us = result.duration_us;
+      return cancelled;
+    }
+    if (!filter_error.empty()) {
+      result.error_message = "Line filter failed: " + filter_error;
+      return result;
+    }
+    // An interrupt raised by the output limit ends the command early but is not a failure.
+    if (FAILED(hr) && !limit_reached) {
+      result.error_message = "IDebugControl::Execute failed: " + HResultToString(hr);
+      return result;
+    }
+    result.success = true;
+    return result;
+  }
+
+ private:
+  Microsoft::WRL::ComPtr<IDebugClient> client_;
+  Microsoft::WRL::ComPtr<IDebugControl> control_;
+  Microsoft::WRL::ComPtr<IDebugOutputCallbacks> previous_callbacks_;
+  OutputCaptureCallbacks* capture_ = nullptr;
+};
+
+// Returns the executor's open session, or opens a temporary one in scratch for this call.
+CaptureSession* SessionForCall(
+    CaptureSession* open_session,
+    std::optional<CaptureSession>* scratch,
+    std::string* error_message) {
+  if (open_session != nullptr) {
+    return open_session;
+  }
+  scratch->emplace();
+  return (*scratch)->Open(error_message) ? &scratch->value() : nullptr;
+}
+
 }  // namespace
 
+struct DbgEngCommandExecutor::Session {
+  CaptureSession capture;
+};
+
+DbgEngCommandExecutor::DbgEngCommandExecutor() = default;
+
+DbgEngCommandExecutor::~DbgEngCommandExecutor() = default;
+
+bool DbgEngCommandExecutor::OpenSession(std::string* error_message) {
+  if (session_ != nullptr) {
+    return true;
+  }
+  auto session = std::make_unique<Session>();
+  if (!session->capture.Open(error_message)) {
+    return false;
+  }
+  session_ = std::move(session);
+  session_thread_ = std::this_thread::get_id();
+  return true;
+}
+
+void DbgEngCommandExecutor::CloseSession() {
+  session_.reset();
+  session_thread_ = std::thread::id();
+}
+
+IDebugClient* DbgEngCommandExecutor::SessionClient() const {
+  const Session* open_session = ActiveSession();
+  return open_session != nullptr ? open_session->capture.Client() : nullptr;
+}
+
+DbgEngCommandExecutor::Session* DbgEngCommandExecutor::ActiveSession() const {
+  return session_ != nullptr && session_thread_ == std::this_thread::get_id() ? session_.get() : nullptr;
+}
+
 CommandExecutionResult DbgEngCommandExecutor::Execute(const std::string& command) {
   if (command.empty()) {
     return {.success = false, .output = "", .error_message = "Command cannot be empty"};
   }
 
-  Microsoft::WRL::ComPtr<IDebugClient> client;
-  HRESULT hr = DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(client.GetAddressOf()));
-  if (FAILED(hr)) {
-    return {
-        .success = false,
-        .output = "",
-        .error_message = "DebugCreate failed: " + HResultToString(hr),
-    };
+  Session* open_session = ActiveSession();
+  std::optional<CaptureSession> scratch;
+  std::string error_message;
+  CaptureSession* session =
+      SessionForCall(open_session != nullptr ? &open_session->capture : nullptr, &scratch, &error_message);
+  if (session == nullptr) {
+    return {.success = false, .output = "", .error_message = error_message};
   }
+  return session->Run(command);
+}
 
-  Microsoft::WRL::ComPtr<IDebugControl> control;
-  hr = client.As(&control);
-  if (FAILED(hr)) {
-    return {
-        .success = false,
-        .output = "",
-        .error_message = "IDebugControl not available: " + HResultToString(hr),
-    };
+CommandExecutionResult DbgEngCommandExecutor::ExecuteWithContext(
+    const std::string& command,
+    CommandExecutionContext* context) {
+  if (command.empty()) {
+    return {.success = false, .output = "", .error_message = "Command cannot be empty"};
+  }
+  if (context != nullptr && context->CancelRequested()) {
+    return MakeCancelledResult();
   }
 
-  Microsoft::WRL::ComPtr<IDebugOutputCallbacks> previous_callbacks;
-  (void)client->GetOutputCallbacks(&previous_callbacks);
-
-  auto* capture = new OutputCaptureCallbacks();
-  hr = client->SetOutputCallbacks(capture);
-  if (FAILED(hr)) {
-    capture->Release();
-    return {
-        .success = false,
-        .output = "",
-        .error_message = "SetOutputCallbacks failed: " + HResultToString(hr),
-    };
+  Session* open_session = ActiveSession();
+  std::optional<CaptureSession> scratch;
+  std::string error_message;
+  CaptureSession* session =
+      SessionForCall(open_session != nullptr ? &open_session->capture : nullptr, &scratch, &error_message);
+  if (session == nullptr) {
+    return {.success = false, .output = "", .error_message = error_message};
   }
+  return session->Run(command, context);
+}
 
-  hr = control->Execute(DEBUG_OUTCTL_THIS_CLIENT, command.c_str(), DEBUG_EXECUTE_DEFAULT);
+std::vector<CommandExecutionResult> DbgEngCommandExecutor::ExecuteBatch(
+    const std::vector<std::string>& commands,
+    bool stop_on_error) {
+  std::vector<CommandExecutionResult> results;
+  results.reserve(commands.size());
 
-  (void)client->SetOutputCallbacks(previous_callbacks.Get());
+  Session* open_session = ActiveSession();
+  std::optional<CaptureSession> scratch;
+  std::string session_error;
+  CaptureSession* session =
+      SessionForCall(open_session != nullptr ? &open_session->capture : nullptr, &scratch, &session_error);
 
-  const std::string output = capture->TakeOutput();
-  capture->Release();
+  for (const std::string& command : commands) {
+    CommandExecutionResult result;
+    if (command.empty()) {
+      result.error_message = "Command cannot be empty";
+    } else if (session == nullptr) {
+      result.error_message = session_error;
+    } else {
+      result = session->Run(command);
+    }
 
-  if (FAILED(hr)) {
-    return {
-        .success = false,
-        .output = output,
-        .error_message = "IDebugControl::Execute failed: " + HResultToString(hr),
-    };
+    const bool failed = !result.success;
+    results.push_back(std::move(result));
+    if (failed && stop_on_error) {
+      break;
+    }
+  }
+  return results;
+}
+
+std::uint64_t DbgEngCommandExecutor::StateGeneration() {
+  EngineStateSnapshot snapshot;
+  Microsoft::WRL::ComPtr<IDebugClient> client;
+  if (const Session* open_session = ActiveSession(); open_session != nullptr) {
+    client = open_session->capture.Client();
+  } else if (FAILED(DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(client.GetAddressOf())))) {
+    client.Reset();
+  }
+  if (client.Get() != nullptr) {
+    Microsoft::WRL::ComPtr<IDebugControl> control;
+    if (SUCCEEDED(client.As(&control))) {
+      ULONG status = 0;
+      (void)control->GetExecutionStatus(&status);
+      snapshot.execution_status = status;
+    }
+    Microsoft::WRL::ComPtr<IDebugSystemObjects> system_objects;
+    if (SUCCEEDED(client.As(&system_objects))) {
+      ULONG process_id = 0;
+      ULONG thread_id = 0;
+      (void)system_objects->GetCurrentProcessId(&process_id);
+      (void)system_objects->GetCurrentThreadId(&thread_id);
+      snapshot.process_id = process_id;
+      snapshot.thread_id = thread_id;
+    }
+    Microsoft::WRL::ComPtr<IDebugRegisters> registers;
+    if (SUCCEEDED(client.As(&registers))) {
+      ULONG64 instruction_offset = 0;
+      (void)registers->GetInstructionOffset(&instruction_offset);
+      snapshot.instruction_offset = instruction_offset;
+    }
+    Microsoft::WRL::ComPtr<IDebugSymbols> symbols;
+    if (SUCCEEDED(client.As(&symbols))) {
+      ULONG loaded = 0;
+      ULONG unloaded = 0;
+      (void)symbols->GetNumberModules(&loaded, &unloaded);
+      snapshot.loaded_modules = loaded;
+      snapshot.unloaded_modules = unloaded;
+    }
   }
 
-  return {
-      .success = true,
-      .output = output,
-      .error_message = "",
-  };
+  std::lock_guard<std::mutex> lock(state_mutex_);
+  if (!(snapshot == last_state_)) {
+    last_state_ = snapshot;
+    ++state_generation_;
+  }
+  return state_generation_;
 }
 
 }  // namespace dbgx::windbg
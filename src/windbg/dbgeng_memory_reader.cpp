@@ -0,0 +1,39 @@
+#include "dbgx/windbg/dbgeng_memory_reader.hpp"
+
+#include "dbgx/windbg/dbgeng_command_executor.hpp"
+
+#include <windows.h>
+
+#include <DbgEng.h>
+#include <wrl/client.h>
+
+namespace dbgx::windbg {
+
+bool DbgEngMemoryReader::ReadVirtual(
+    std::uint64_t address,
+    void* buffer,
+    std::uint32_t size,
+    std::uint32_t* bytes_read) {
+  *bytes_read = 0;
+  Microsoft::WRL::ComPtr<IDebugClient> client;
+  if (engine_ != nullptr) {
+    client = engine_->SessionClient();
+  }
+  if (client.Get() == nullptr &&
+      FAILED(DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(client.GetAddressOf())))) {
+    return false;
+  }
+  Microsoft::WRL::ComPtr<IDebugDataSpaces> data_spaces;
+  if (FAILED(client.As(&data_spaces))) {
+    return false;
+  }
+
+  ULONG read = 0;
+  if (FAILED(data_spaces->ReadVirtual(address, buffer, size, &read))) {
+    return false;
+  }
+  *bytes_read = read;
+  return read != 0;
+}
+
+}  // namespace dbgx::windbg
@@ -0,0 +1,139 @@
+#include "dbgx/windbg/dbgeng_symbol_provider.hpp"
+
+#include "dbgx/windbg/dbgeng_command_executor.hpp"
+
+#include <windows.h>
+
+#include <DbgEng.h>
+#include <wrl/client.h>
+
+#include <vector>
+
+namespace dbgx::windbg {
+
+namespace {
+
+Microsoft::WRL::ComPtr<IDebugSymbols> QuerySymbols(const DbgEngCommandExecutor* engine) {
+  Microsoft::WRL::ComPtr<IDebugClient> client;
+  if (engine != nullptr) {
+    client = engine->SessionClient();
+  }
+  if (client.Get() == nullptr &&
+      FAILED(DebugCreate(__uuidof(IDebugClient), reinterpret_cast<void**>(client.GetAddressOf())))) {
+    return nullptr;
+  }
+  Microsoft::WRL::ComPtr<IDebugSymbols> symbols;
+  if (FAILED(client.As(&symbols))) {
+    return nullptr;
+  }
+  return symbols;
+}
+
+bool GetLoadedModuleParameters(IDebugSymbols* symbols, std::vector<DEBUG_MODULE_PARAMETERS>* out_parameters) {
+  ULONG loaded = 0;
+  ULONG unloaded = 0;
+  if (FAILED(symbols->GetNumberModules(&loaded, &unloaded))) {
+    return false;
+  }
+  out_parameters->assign(loaded, DEBUG_MODULE_PARAMETERS{});
+  return loaded == 0 || SUCCEEDED(symbols->GetModuleParameters(loaded, nullptr, 0, out_parameters->data()));
+}
+
+void HashValue(std::uint64_t value, std::uint64_t* hash) {
+  for (int shift = 0; shift < 64; shift += 8) {
+    *hash ^= (value >> shift) & 0xFF;
+    *hash *= 1099511628211ULL;
+  }
+}
+
+}  // namespace
+
+bool DbgEngSymbolProvider::ListModules(std::vector<ModuleRange>* out_modules, std::string* error_message) {
+  const Microsoft::WRL::ComPtr<IDebugSymbols> symbols = QuerySymbols(engine_);
+  if (symbols.Get() == nullptr) {
+    *error_message = "IDebugSymbols not available";
+    return false;
+  }
+  std::vector<DEBUG_MODULE_PARAMETERS> parameters;
+  if (!GetLoadedModuleParameters(symbols.Get(), &parameters)) {
+    *error_message = "Failed to enumerate loaded modules";
+    return false;
+  }
+
+  out_modules->clear();
+  out_modules->reserve(parameters.size());
+  for (ULONG index = 0; index < parameters.size(); ++index) {
+    ModuleRange module;
+    module.base = parameters[index].Base;
+    module.size = parameters[index].Size;
+    std::vector<char> name(parameters[index].ModuleNameSize + 1, '\0');
+    ULONG name_size = 0;
+    if (SUCCEEDED(symbols->GetModuleNames(
+            index,
+            0,
+            nullptr,
+            0,
+            nullptr,
+            name.data(),
+            static_cast<ULONG>(name.size()),
+            &name_size,
+            nullptr,
+            0,
+            nullptr))) {
+      module.name.assign(name.data());
+    }
+    out_modules->push_back(std::move(module));
+  }
+  return true;
+}
+
+bool DbgEngSymbolProvider::GetNameByOffset(
+    std::uint64_t address,
+    std::string* out_name,
+    std::uint64_t* out_displacement) {
+  const Microsoft::WRL::ComPtr<IDebugSymbols> symbols = QuerySymbols(engine_);
+  if (symbols.Get() == nullptr) {
+    return false;
+  }
+
+  std::vector<char> name(256, '\0');
+  ULONG name_size = 0;
+  ULONG64 displacement = 0;
+  HRESULT hr =
+      symbols->GetNameByOffset(address, name.data(), static_cast<ULONG>(name.size()), &name_size, &displacement);
+  // S_FALSE means the buffer was too small; name_size then holds the required size.
+  if (hr == S_FALSE && name_size > name.size()) {
+    name.assign(name_size, '\0');
+    hr = symbols->GetNameByOffset(address, name.data(), static_cast<ULONG>(name.size()), &name_size, &displacement);
+  }
+  if (FAILED(hr)) {
+    return false;
+  }
+  out_name->assign(name.data());
+  *out_displacement = displacement;
+  return true;
+}
+
+std::uint64_t DbgEngSymbolProvider::SymbolGeneration() {
+  std::uint64_t hash = 14695981039346656037ULL;
+  const Microsoft::WRL::ComPtr<IDebugSymbols> symbols = QuerySymbols(engine_);
+  std::vector<DEBUG_MODULE_PARAMETERS> parameters;
+  if (symbols.Get() != nullptr && GetLoadedModuleParameters(symbols.Get(), &parameters)) {
+    for (const DEBUG_MODULE_PARAMETERS& module : parameters) {
+      HashValue(module.Base, &hash);
+      HashValue(module.Size, &hash);
+      HashValue(module.TimeDateStamp, &hash);
+      HashValue(module.Checksum, &hash);
+      HashValue(module.SymbolType, &hash);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(generation_mutex_);
+  if (hash != last_module_hash_) {
+    last_module_hash_ = hash;
+    ++generation_;
+  }
+  return generation_;
+}
+
+}  // namespace dbgx::windbg
@@ -0,0 +1,245 @@
+#include "dbgx/windbg/line_filter.hpp"
+
+#include <bit>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DBGX_HAS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace dbgx::windbg {
+
+namespace {
+
+// Lines longer than this are processed in pieces rather than buffered without bound.
+constexpr std::size_t kMaxPartialLineBytes = 1024 * 1024;
+
+std::string_view StripLineEnding(std::string_view line) {
+  while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+    line.remove_suffix(1);
+  }
+  return line;
+}
+
+bool ContainsAny(std::string_view line, const std::vector<std::string>& needles) {
+  for (const std::string& needle : needles) {
+    if (FindSubstring(line, needle) != std::string_view::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CompileRegex(const std::string& pattern, std::optional<std::regex>* out_regex, std::string* error_message) {
+  if (pattern.empty()) {
+    return true;
+  }
+  try {
+    out_regex->emplace(pattern, std::regex::ECMAScript | std::regex::optimize);
+  } catch (const std::regex_error& error) {
+    if (error_message != nullptr) {
+      *error_message = "Invalid regex '" + pattern + "': " + error.what();
+    }
+    return false;
+  }
+  return true;
+}
+
+bool SearchRegex(std::string_view line, const std::regex& regex, std::string* error_message) {
+  line = line.substr(0, LineFilter::kMaxRegexLineBytes);
+  try {
+    return std::regex_search(line.begin(), line.end(), regex);
+  } catch (const std::regex_error& error) {
+    // MSVC reports runaway backtracking as error_complexity or error_stack.
+    if (error_message != nullptr) {
+      *error_message = std::string("Regex match failed: ") + error.what();
+    }
+    return false;
+  }
+}
+
+}  // namespace
+
+bool LineFilterOptions::Enabled() const {
+  return !include.empty() || !exclude.empty() || !include_regex.empty() || !exclude_regex.empty();
+}
+
+std::size_t FindSubstring(std::string_view haystack, std::string_view needle) {
+  const std::size_t needle_size = needle.size();
+  if (needle_size == 0) {
+    return 0;
+  }
+  if (needle_size > haystack.size()) {
+    return std::string_view::npos;
+  }
+  if (needle_size == 1) {
+    const void* hit = std::memchr(haystack.data(), needle[0], haystack.size());
+    return hit == nullptr ? std::string_view::npos
+                          : static_cast<std::size_t>(static_cast<const char*>(hit) - haystack.data());
+  }
+
+  std::size_t pos = 0;
+#if defined(DBGX_HAS_SSE2)
+  // Compare the needle's first and last bytes against 16 candidate positions at once and verify only
+  // positions where both agree.
+  const __m128i first = _mm_set1_epi8(needle.front());
+  const __m128i last = _mm_set1_epi8(needle.back());
+  for (; pos + needle_size - 1 + 16 <= haystack.size(); pos += 16) {
+    const __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack.data() + pos));
+    const __m128i block_last =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack.data() + pos + needle_size - 1));
+    auto mask = static_cast<unsigned>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+    while (mask != 0) {
+      const auto bit = static_cast<std::size_t>(std::countr_zero(mask));
+      if (std::memcmp(haystack.data() + pos + bit + 1, needle.data() + 1, needle_size - 2) == 0) {
+        return pos + bit;
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  const std::size_t found = haystack.substr(pos).find(needle);
+  return found == std::string_view::npos ? std::string_view::npos : pos + found;
+}
+
+bool LineFilter::Compile(LineFilterOptions options, LineFilter* out_filter, std::string* error_message) {
+  LineFilter filter;
+  if (!CompileRegex(options.include_regex, &filter.include_regex_, error_message) ||
+      !CompileRegex(options.exclude_regex, &filter.exclude_regex_, error_message)) {
+    return false;
+  }
+  filter.options_ = std::move(options);
+  *out_filter = std::move(filter);
+  return true;
+}
+
+bool LineFilter::Matches(std::string_view line, std::string* error_message) const {
+  line = StripLineEnding(line);
+  const bool has_include = !options_.include.empty() || include_regex_.has_value();
+  if (has_include && !ContainsAny(line, options_.include) &&
+      !(include_regex_.has_value() && SearchRegex(line, *include_regex_, error_message))) {
+    return false;
+  }
+  if (ContainsAny(line, options_.exclude)) {
+    return false;
+  }
+  std::string exclude_error;
+  const bool excluded = exclude_regex_.has_value() && SearchRegex(line, *exclude_regex_, &exclude_error);
+  if (!exclude_error.empty()) {
+    if (error_message != nullptr) {
+      *error_message = std::move(exclude_error);
+    }
+    return false;
+  }
+  return !excluded;
+}
+
+std::size_t LineFilter::ContextLines() const {
+  return options_.context_lines;
+}
+
+StreamingLineFilter::StreamingLineFilter(const LineFilter* filter) : filter_(filter) {}
+
+void StreamingLineFilter::Feed(std::string_view chunk, std::string* out) {
+  while (!chunk.empty()) {
+    const std::size_t newline = chunk.find('\n');
+    if (newline == std::string_view::npos) {
+      partial_.append(chunk);
+      if (partial_.size() >= kMaxPartialLineBytes) {
+        ProcessLine(partial_, out);
+        partial_.clear();
+      }
+      return;
+    }
+
+    const std::string_view line = chunk.substr(0, newline + 1);
+    chunk.remove_prefix(newline + 1);
+    if (partial_.empty()) {
+      ProcessLine(line, out);
+    } else {
+      partial_.append(line);
+      ProcessLine(partial_, out);
+      partial_.clear();
+    }
+  }
+}
+
+void StreamingLineFilter::Finish(std::string* out) {
+  if (!partial_.empty()) {
+    ProcessLine(partial_, out);
+    partial_.clear();
+  }
+}
+
+std::uint64_t StreamingLineFilter::MatchedLines() const {
+  return matched_lines_;
+}
+
+const std::string& StreamingLineFilter::Error() const {
+  return error_;
+}
+
+void StreamingLineFilter::ProcessLine(std::string_view line, std::string* out) {
+  if (!error_.empty()) {
+    return;
+  }
+  ++line_number_;
+  const std::size_t context_lines = filter_->ContextLines();
+  const bool matches = filter_->Matches(line, &error_);
+  if (!error_.empty()) {
+    return;
+  }
+  if (matches) {
+    ++matched_lines_;
+    const std::uint64_t first_line = line_number_ - before_.size();
+    if (emitted_any_ && first_line > last_emitted_line_ + 1 && context_lines != 0) {
+      out->append("--\n");
+    }
+    for (const std::string& context_line : before_) {
+      EmitLine(context_line, out);
+    }
+    before_.clear();
+    EmitLine(line, out);
+    last_emitted_line_ = line_number_;
+    emitted_any_ = true;
+    after_remaining_ = context_lines;
+    return;
+  }
+
+  if (after_remaining_ != 0) {
+    --after_remaining_;
+    EmitLine(line, out);
+    last_emitted_line_ = line_number_;
+    return;
+  }
+  if (context_lines != 0) {
+    before_.emplace_back(line);
+    if (before_.size() > context_lines) {
+      before_.pop_front();
+    }
+  }
+}
+
+void StreamingLineFilter::EmitLine(std::string_view line, std::string* out) {
+  out->append(line);
+  if (line.empty() || line.back() != '\n') {
+    out->push_back('\n');
+  }
+}
+
+std::string FilterLines(std::string_view output, const LineFilter& filter, std::string* error_message) {
+  StreamingLineFilter stream(&filter);
+  std::string filtered;
+  stream.Feed(output, &filtered);
+  stream.Finish(&filtered);
+  if (error_message != nullptr) {
+    *error_message = stream.Error();
+  }
+  return filtered;
+}
+
+}  // namespace dbgx::windbg
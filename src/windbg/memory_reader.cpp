@@ -0,0 +1,99 @@
+#include "dbgx/windbg/memory_reader.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace dbgx::windbg {
+
+namespace {
+
+void AddHole(std::uint64_t address, std::uint64_t size, std::vector<MemoryHole>* holes) {
+  if (size == 0) {
+    return;
+  }
+  if (!holes->empty() && holes->back().address + holes->back().size == address) {
+    holes->back().size += size;
+    return;
+  }
+  holes->push_back(MemoryHole{address, size});
+}
+
+// Bytes from address up to the next multiple of granularity (a power of two), capped at remaining.
+std::uint32_t BytesToBoundary(std::uint64_t address, std::uint32_t granularity, std::uint64_t remaining) {
+  const std::uint64_t to_boundary = granularity - (address & (granularity - 1));
+  return static_cast<std::uint32_t>(std::min(to_boundary, remaining));
+}
+
+bool IsPowerOfTwo(std::uint32_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+}  // namespace
+
+bool ReadMemoryRange(
+    IWinDbgMemoryReader* reader,
+    std::uint64_t address,
+    std::size_t size,
+    MemoryRangeRead* out_read,
+    std::string* error_message,
+    const CommandExecutionContext* context,
+    MemoryRangeOptions options) {
+  if (reader == nullptr) {
+    *error_message = "Memory reads are unavailable";
+    return false;
+  }
+  if (!IsPowerOfTwo(options.chunk_bytes) || !IsPowerOfTwo(options.page_bytes) ||
+      options.page_bytes > options.chunk_bytes) {
+    *error_message = "Invalid memory read chunking";
+    return false;
+  }
+  if (size != 0 && address > std::numeric_limits<std::uint64_t>::max() - (size - 1)) {
+    *error_message = "Address range wraps past the end of the address space";
+    return false;
+  }
+
+  *out_read = MemoryRangeRead{};
+  out_read->bytes.assign(size, '\0');
+  std::uint64_t offset = 0;
+  while (offset < size) {
+    if (context != nullptr && context->CancelRequested()) {
+      out_read->cancelled = true;
+      AddHole(address + offset, size - offset, &out_read->holes);
+      return true;
+    }
+
+    const std::uint64_t chunk_address = address + offset;
+    const std::uint32_t chunk_size = BytesToBoundary(chunk_address, options.chunk_bytes, size - offset);
+    char* chunk_buffer = out_read->bytes.data() + offset;
+    std::uint32_t chunk_read = 0;
+    if (!reader->ReadVirtual(chunk_address, chunk_buffer, chunk_size, &chunk_read)) {
+      chunk_read = 0;
+    }
+    chunk_read = std::min(chunk_read, chunk_size);
+    out_read->bytes_read += chunk_read;
+
+    // Retry the unread tail page by page so readable pages after a hole are still returned.
+    std::uint32_t chunk_offset = chunk_read;
+    while (chunk_offset < chunk_size) {
+      const std::uint64_t page_address = chunk_address + chunk_offset;
+      const std::uint32_t page_size = BytesToBoundary(page_address, options.page_bytes, chunk_size - chunk_offset);
+      std::uint32_t page_read = 0;
+      if (chunk_offset == chunk_read ||
+          !reader->ReadVirtual(page_address, chunk_buffer + chunk_offset, page_size, &page_read)) {
+        // The first unread page is the one the chunk read stopped in; it is known to be unreadable.
+        page_read = 0;
+      }
+      page_read = std::min(page_read, page_size);
+      out_read->bytes_read += page_read;
+      if (page_read < page_size) {
+        std::fill(chunk_buffer + chunk_offset + page_read, chunk_buffer + chunk_offset + page_size, '\0');
+        AddHole(page_address + page_read, page_size - page_read, &out_read->holes);
+      }
+      chunk_offset += page_size;
+    }
+    offset += chunk_size;
+  }
+  return true;
+}
+
+}  // namespace dbgx::windbg
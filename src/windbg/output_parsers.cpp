@@ -0,0 +1,498 @@
+#include "dbgx/windbg/output_parsers.hpp"
+
+#include "dbgx/windbg/ascii.hpp"
+
+namespace dbgx::windbg {
+
+namespace {
+
+struct OutputParserEntry {
+  std::string_view name;
+  OutputFormat format;
+  unsigned unit_size;
+  // Letters that may follow the name in the same token ("kn", "lmv"); matched case-sensitively.
+  std::string_view option_letters;
+};
+
+// Matched case-insensitively against the first token of the command.
+constexpr std::array kOutputParsers = {
+    OutputParserEntry{"db", OutputFormat::kMemory, 1, ""},
+    OutputParserEntry{"dw", OutputFormat::kMemory, 2, ""},
+    OutputParserEntry{"dd", OutputFormat::kMemory, 4, ""},
+    OutputParserEntry{"dq", OutputFormat::kMemory, 8, ""},
+    OutputParserEntry{"dp", OutputFormat::kMemory, 0, ""},
+    OutputParserEntry{"lm", OutputFormat::kModules, 0, "vlkeoft"},
+    OutputParserEntry{"k", OutputFormat::kStack, 0, "bvpPnfL"},
+    OutputParserEntry{"r", OutputFormat::kRegisters, 0, ""},
+};
+
+constexpr std::string_view kUnloadedModulesHeader = "Unloaded modules:";
+
+bool StartsWithIgnoreCase(std::string_view text, std::string_view prefix) {
+  if (text.size() < prefix.size()) {
+    return false;
+  }
+  for (std::size_t index = 0; index < prefix.size(); ++index) {
+    if (ToLowerAscii(text[index]) != ToLowerAscii(prefix[index])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string_view TrimSpaces(std::string_view text) {
+  while (!text.empty() && IsSpace(text.front())) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && IsSpace(text.back())) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+std::string_view NextToken(std::string_view* rest) {
+  std::size_t start = 0;
+  while (start < rest->size() && IsSpace((*rest)[start])) {
+    ++start;
+  }
+  std::size_t end = start;
+  while (end < rest->size() && !IsSpace((*rest)[end])) {
+    ++end;
+  }
+  const std::string_view token = rest->substr(start, end - start);
+  rest->remove_prefix(end);
+  return token;
+}
+
+std::string_view PeekToken(std::string_view rest) {
+  return NextToken(&rest);
+}
+
+int HexDigitValue(char ch) {
+  if (ch >= '0' && ch <= '9') {
+    return ch - '0';
+  }
+  if (ch >= 'a' && ch <= 'f') {
+    return ch - 'a' + 10;
+  }
+  if (ch >= 'A' && ch <= 'F') {
+    return ch - 'A' + 10;
+  }
+  return -1;
+}
+
+// Parses WinDbg hex such as "7ffa1c2d" or "00007ffa`1c2d3e4e" (one backtick separator allowed).
+bool ParseHex(std::string_view token, std::uint64_t* out_value, std::size_t* out_digits = nullptr) {
+  std::uint64_t value = 0;
+  std::size_t digits = 0;
+  bool seen_backtick = false;
+  for (const char ch : token) {
+    if (ch == '`' && digits != 0 && !seen_backtick) {
+      seen_backtick = true;
+      continue;
+    }
+    const int digit = HexDigitValue(ch);
+    if (digit < 0 || digits == 16) {
+      return false;
+    }
+    value = (value << 4) | static_cast<std::uint64_t>(digit);
+    ++digits;
+  }
+  if (digits == 0 || token.back() == '`') {
+    return false;
+  }
+  *out_value = value;
+  if (out_digits != nullptr) {
+    *out_digits = digits;
+  }
+  return true;
+}
+
+// Addresses are printed as 8 hex digits (32-bit) or 16 digits, usually split by a backtick.
+bool ParseAddress(std::string_view token, std::uint64_t* out_value, std::size_t* out_digits = nullptr) {
+  std::size_t digits = 0;
+  if (!ParseHex(token, out_value, &digits) || (digits != 8 && digits != 16)) {
+    return false;
+  }
+  if (out_digits != nullptr) {
+    *out_digits = digits;
+  }
+  return true;
+}
+
+bool IsMaskToken(std::string_view token, char mask) {
+  bool any = false;
+  for (const char ch : token) {
+    if (ch == mask) {
+      any = true;
+    } else if (ch != '`') {
+      return false;
+    }
+  }
+  return any;
+}
+
+bool IsFrameNumber(std::string_view token, std::uint32_t* out_number) {
+  if (token.empty() || token.size() > 4) {
+    return false;
+  }
+  std::uint64_t value = 0;
+  if (!ParseHex(token, &value)) {
+    return false;
+  }
+  *out_number = static_cast<std::uint32_t>(value);
+  return true;
+}
+
+class ParseState {
+ public:
+  ParseState(ParsedOutput* parsed, std::size_t max_entries) : parsed_(parsed), max_entries_(max_entries) {}
+
+  ParsedOutput* parsed() const {
+    return parsed_;
+  }
+
+  // Returns false once max_entries is reached.
+  bool Reserve(std::size_t current_entries) {
+    if (max_entries_ != 0 && current_entries >= max_entries_) {
+      parsed_->truncated = true;
+      return false;
+    }
+    return true;
+  }
+
+  bool unloaded_modules = false;
+
+ private:
+  ParsedOutput* parsed_;
+  std::size_t max_entries_;
+};
+
+bool ParseMemoryLine(std::string_view line, unsigned unit_size, ParseState* state) {
+  std::string_view rest = line;
+  std::uint64_t address = 0;
+  std::size_t address_digits = 0;
+  if (!ParseAddress(NextToken(&rest), &address, &address_digits)) {
+    return false;
+  }
+  if (unit_size == 0) {
+    unit_size = address_digits == 16 ? 8 : 4;
+  }
+
+  MemoryDump& dump = state->parsed()->memory;
+  if (dump.unit_size == 0) {
+    dump.unit_size = unit_size;
+  }
+  MemoryRow row;
+  row.address = address;
+  row.first_value = dump.values.size();
+
+  // db separates the eighth and ninth byte with '-' and ends the row with an ASCII column after two spaces.
+  const bool byte_dump = unit_size == 1;
+  const std::size_t value_digits = static_cast<std::size_t>(unit_size) * 2;
+  std::size_t pos = 0;
+  while (true) {
+    std::size_t spaces = 0;
+    while (pos + spaces < rest.size() && IsSpace(rest[pos + spaces])) {
+      ++spaces;
+    }
+    if (pos + spaces >= rest.size() || (byte_dump && spaces >= 2 && (row.value_count != 0 || row.unreadable))) {
+      break;
+    }
+    pos += spaces;
+    std::size_t end = pos;
+    while (end < rest.size() && !IsSpace(rest[end]) && !(byte_dump && rest[end] == '-')) {
+      ++end;
+    }
+    const std::string_view token = rest.substr(pos, end - pos);
+    pos = end;
+    if (byte_dump && pos < rest.size() && rest[pos] == '-') {
+      ++pos;
+    }
+
+    if (IsMaskToken(token, '?')) {
+      row.unreadable = true;
+      continue;
+    }
+    std::uint64_t value = 0;
+    std::size_t digits = 0;
+    if (!ParseHex(token, &value, &digits) || digits != value_digits) {
+      break;
+    }
+    dump.values.push_back(value);
+    ++row.value_count;
+  }
+
+  if (row.value_count == 0 && !row.unreadable) {
+    dump.values.resize(row.first_value);
+    return false;
+  }
+  dump.rows.push_back(row);
+  return true;
+}
+
+bool ParseModuleLine(std::string_view line, ParseState* state) {
+  if (TrimSpaces(line) == kUnloadedModulesHeader) {
+    state->unloaded_modules = true;
+    return true;
+  }
+
+  std::string_view rest = line;
+  ModuleEntry entry;
+  if (!ParseAddress(NextToken(&rest), &entry.start) || !ParseAddress(NextToken(&rest), &entry.end)) {
+    return false;
+  }
+  entry.name = NextToken(&rest);
+  if (entry.name.empty()) {
+    return false;
+  }
+  rest = TrimSpaces(rest);
+  if (!rest.empty() && rest.front() == '(') {
+    const std::size_t close = rest.find(')');
+    if (close != std::string_view::npos) {
+      entry.symbol_status = rest.substr(1, close - 1);
+      entry.image_path = TrimSpaces(rest.substr(close + 1));
+    }
+  }
+  entry.unloaded = state->unloaded_modules;
+  state->parsed()->modules.push_back(entry);
+  return true;
+}
+
+void SplitCallSite(StackFrame* frame) {
+  std::string_view call_site = frame->call_site;
+  if (!call_site.empty() && call_site.back() == ']') {
+    const std::size_t open = call_site.rfind(" [");
+    if (open != std::string_view::npos) {
+      frame->source = call_site.substr(open + 2, call_site.size() - open - 3);
+      call_site = TrimSpaces(call_site.substr(0, open));
+      frame->call_site = call_site;
+    }
+  }
+
+  const std::size_t bang = call_site.find('!');
+  std::string_view symbol = bang == std::string_view::npos ? call_site : call_site.substr(bang + 1);
+  const std::size_t plus = symbol.rfind("+0x");
+  if (plus != std::string_view::npos) {
+    std::size_t digits_end = plus + 3;
+    while (digits_end < symbol.size() && HexDigitValue(symbol[digits_end]) >= 0) {
+      ++digits_end;
+    }
+    std::uint64_t offset = 0;
+    if (ParseHex(symbol.substr(plus + 3, digits_end - plus - 3), &offset)) {
+      frame->has_offset = true;
+      frame->offset = offset;
+      symbol = symbol.substr(0, plus);
+    }
+  }
+  if (bang != std::string_view::npos) {
+    frame->module = call_site.substr(0, bang);
+    frame->function = symbol;
+  } else if (frame->has_offset) {
+    // "ntdll+0x1234": module-relative address without symbols.
+    frame->module = symbol;
+  }
+}
+
+bool ParseStackLine(std::string_view line, ParseState* state) {
+  std::string_view rest = line;
+  StackFrame frame;
+  std::uint32_t number = 0;
+  if (IsFrameNumber(PeekToken(rest), &number)) {
+    NextToken(&rest);
+    frame.has_number = true;
+    frame.number = number;
+  }
+
+  if (PeekToken(rest) == "(Inline") {
+    NextToken(&rest);
+    if (NextToken(&rest) != "Function)") {
+      return false;
+    }
+    frame.is_inline = true;
+    if (IsMaskToken(PeekToken(rest), '-')) {
+      NextToken(&rest);
+    }
+  } else if (!ParseAddress(NextToken(&rest), &frame.child_sp) ||
+             !ParseAddress(NextToken(&rest), &frame.return_address)) {
+    return false;
+  }
+
+  // kb/kv: "Child-SP RetAddr : Args to Child : Call Site".
+  if (PeekToken(rest) == ":") {
+    NextToken(&rest);
+    while (true) {
+      const std::string_view token = NextToken(&rest);
+      if (token.empty()) {
+        return false;
+      }
+      if (token == ":") {
+        break;
+      }
+      std::uint64_t value = 0;
+      if (frame.arg_count < frame.args.size() && ParseHex(token, &value)) {
+        frame.args[frame.arg_count++] = value;
+      }
+    }
+  }
+
+  frame.call_site = TrimSpaces(rest);
+  if (frame.call_site.empty()) {
+    return false;
+  }
+  SplitCallSite(&frame);
+  state->parsed()->frames.push_back(frame);
+  return true;
+}
+
+bool IsRegisterName(std::string_view name) {
+  if (name.empty() || name.size() > 16) {
+    return false;
+  }
+  for (const char ch : name) {
+    const bool alnum = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9');
+    if (!alnum) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ParseRegisterLine(std::string_view line, ParseState* state) {
+  std::string_view rest = line;
+  bool any = false;
+  while (true) {
+    const std::string_view token = NextToken(&rest);
+    if (token.empty()) {
+      break;
+    }
+    const std::size_t equals = token.find('=');
+    if (equals == std::string_view::npos) {
+      continue;
+    }
+    RegisterValue reg;
+    reg.name = token.substr(0, equals);
+    if (!IsRegisterName(reg.name) || !ParseHex(token.substr(equals + 1), &reg.value)) {
+      continue;
+    }
+    if (!state->Reserve(state->parsed()->registers.size())) {
+      return true;
+    }
+    state->parsed()->registers.push_back(reg);
+    any = true;
+  }
+  return any;
+}
+
+std::size_t EntryCount(const ParsedOutput& parsed) {
+  switch (parsed.format) {
+    case OutputFormat::kMemory:
+      return parsed.memory.rows.size();
+    case OutputFormat::kModules:
+      return parsed.modules.size();
+    case OutputFormat::kStack:
+      return parsed.frames.size();
+    case OutputFormat::kRegisters:
+    case OutputFormat::kNone:
+      break;
+  }
+  return 0;
+}
+
+}  // namespace
+
+std::string_view OutputFormatName(OutputFormat format) {
+  switch (format) {
+    case OutputFormat::kMemory:
+      return "memory";
+    case OutputFormat::kModules:
+      return "modules";
+    case OutputFormat::kStack:
+      return "stack";
+    case OutputFormat::kRegisters:
+      return "registers";
+    case OutputFormat::kNone:
+      break;
+  }
+  return "none";
+}
+
+OutputParserSelection SelectOutputParser(std::string_view command) {
+  std::string_view rest = command;
+  const std::string_view name = NextToken(&rest);
+  for (const OutputParserEntry& entry : kOutputParsers) {
+    if (!StartsWithIgnoreCase(name, entry.name)) {
+      continue;
+    }
+    const std::string_view options = name.substr(entry.name.size());
+    if (options.find_first_not_of(entry.option_letters) != std::string_view::npos) {
+      continue;
+    }
+    return OutputParserSelection{entry.format, entry.unit_size};
+  }
+  return {};
+}
+
+bool ParseOutput(
+    OutputParserSelection selection,
+    std::string_view output,
+    ParsedOutput* parsed,
+    std::size_t max_entries) {
+  *parsed = ParsedOutput{};
+  if (selection.format == OutputFormat::kNone) {
+    return false;
+  }
+  parsed->format = selection.format;
+
+  ParseState state(parsed, max_entries);
+  std::size_t line_start = 0;
+  while (line_start < output.size()) {
+    std::size_t line_end = output.find('\n', line_start);
+    if (line_end == std::string_view::npos) {
+      line_end = output.size();
+    }
+    const std::string_view line = output.substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+    if (TrimSpaces(line).empty()) {
+      continue;
+    }
+    if (selection.format != OutputFormat::kRegisters && !state.Reserve(EntryCount(*parsed))) {
+      break;
+    }
+
+    bool recognized = false;
+    switch (selection.format) {
+      case OutputFormat::kMemory:
+        recognized = ParseMemoryLine(line, selection.unit_size, &state);
+        break;
+      case OutputFormat::kModules:
+        recognized = ParseModuleLine(line, &state);
+        break;
+      case OutputFormat::kStack:
+        recognized = ParseStackLine(line, &state);
+        break;
+      case OutputFormat::kRegisters:
+        recognized = ParseRegisterLine(line, &state);
+        break;
+      case OutputFormat::kNone:
+        break;
+    }
+    if (!recognized) {
+      ++parsed->skipped_lines;
+    }
+    if (parsed->truncated) {
+      break;
+    }
+  }
+  return true;
+}
+
+bool ParseCommandOutput(
+    std::string_view command,
+    std::string_view output,
+    ParsedOutput* parsed,
+    std::size_t max_entries) {
+  return ParseOutput(SelectOutputParser(command), output, parsed, max_entries);
+}
+
+}  // namespace dbgx::windbg
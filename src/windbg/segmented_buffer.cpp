@@ -0,0 +1,120 @@
+#include "dbgx/windbg/segmented_buffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace dbgx::windbg {
+
+SegmentPool::SegmentPool(std::size_t segment_bytes, std::size_t max_free_segments)
+    : segment_bytes_(std::max<std::size_t>(segment_bytes, 1)), max_free_segments_(max_free_segments) {}
+
+SegmentPool& SegmentPool::Shared() {
+  static SegmentPool pool;
+  return pool;
+}
+
+std::unique_ptr<char[]> SegmentPool::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+      std::unique_ptr<char[]> segment = std::move(free_.back());
+      free_.pop_back();
+      return segment;
+    }
+  }
+  return std::make_unique_for_overwrite<char[]>(segment_bytes_);
+}
+
+void SegmentPool::Release(std::unique_ptr<char[]> segment) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (segment != nullptr && free_.size() < max_free_segments_) {
+    free_.push_back(std::move(segment));
+  }
+}
+
+std::size_t SegmentPool::SegmentBytes() const {
+  return segment_bytes_;
+}
+
+std::size_t SegmentPool::FreeCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return free_.size();
+}
+
+SegmentedBuffer::SegmentedBuffer(SegmentPool* pool) : pool_(pool) {}
+
+SegmentedBuffer::~SegmentedBuffer() {
+  Clear();
+}
+
+SegmentedBuffer::SegmentedBuffer(SegmentedBuffer&& other) noexcept
+    : pool_(other.pool_), segments_(std::move(other.segments_)), size_(std::exchange(other.size_, 0)) {
+  other.segments_.clear();
+}
+
+SegmentedBuffer& SegmentedBuffer::operator=(SegmentedBuffer&& other) noexcept {
+  if (this != &other) {
+    Clear();
+    pool_ = other.pool_;
+    segments_ = std::move(other.segments_);
+    size_ = std::exchange(other.size_, 0);
+    other.segments_.clear();
+  }
+  return *this;
+}
+
+void SegmentedBuffer::Append(std::string_view text) {
+  const std::size_t segment_bytes = pool_->SegmentBytes();
+  while (!text.empty()) {
+    if (segments_.empty() || segments_.back().size == segment_bytes) {
+      segments_.push_back(Segment{pool_->Acquire(), 0});
+    }
+    Segment& segment = segments_.back();
+    const std::size_t count = std::min(text.size(), segment_bytes - segment.size);
+    std::memcpy(segment.data.get() + segment.size, text.data(), count);
+    segment.size += count;
+    size_ += count;
+    text.remove_prefix(count);
+  }
+}
+
+std::size_t SegmentedBuffer::Size() const {
+  return size_;
+}
+
+bool SegmentedBuffer::Empty() const {
+  return size_ == 0;
+}
+
+std::vector<std::string_view> SegmentedBuffer::Segments() const {
+  std::vector<std::string_view> views;
+  views.reserve(segments_.size());
+  for (const Segment& segment : segments_) {
+    views.emplace_back(segment.data.get(), segment.size);
+  }
+  return views;
+}
+
+void SegmentedBuffer::AppendTo(std::string* out) const {
+  out->reserve(out->size() + size_);
+  for (const Segment& segment : segments_) {
+    out->append(segment.data.get(), segment.size);
+  }
+}
+
+std::string SegmentedBuffer::ToString() const {
+  std::string text;
+  AppendTo(&text);
+  return text;
+}
+
+void SegmentedBuffer::Clear() {
+  for (Segment& segment : segments_) {
+    pool_->Release(std::move(segment.data));
+  }
+  segments_.clear();
+  size_ = 0;
+}
+
+}  // namespace dbgx::windbg
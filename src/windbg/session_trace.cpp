@@ -0,0 +1,386 @@
+#include "dbgx/windbg/session_trace.hpp"
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace dbgx::windbg {
+
+namespace {
+
+constexpr std::string_view kTraceMagic("DBGXTRC1", 8);
+constexpr std::size_t kRecordHeaderBytes = 1 + 4 + 4 + 8 + 8;
+constexpr std::uint8_t kFlagSuccess = 1;
+constexpr std::uint8_t kFlagCancelled = 2;
+constexpr std::uint8_t kFlagTimedOut = 4;
+
+void PutLittleEndian(std::uint64_t value, std::size_t bytes, char* out) {
+  for (std::size_t index = 0; index < bytes; ++index) {
+    out[index] = static_cast<char>((value >> (8 * index)) & 0xFF);
+  }
+}
+
+std::uint64_t GetLittleEndian(const char* in, std::size_t bytes) {
+  std::uint64_t value = 0;
+  for (std::size_t index = 0; index < bytes; ++index) {
+    value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[index])) << (8 * index);
+  }
+  return value;
+}
+
+std::string LastErrorText(std::string_view action, const std::string& path) {
+#ifdef _WIN32
+  return std::string(action) + " '" + path + "' failed (error " + std::to_string(GetLastError()) + ")";
+#else
+  return std::string(action) + " '" + path + "' failed (" + std::strerror(errno) + ")";
+#endif
+}
+
+}  // namespace
+
+SessionTraceWriter::~SessionTraceWriter() {
+  Close();
+}
+
+bool SessionTraceWriter::Open(const std::string& path, std::string* error_message) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_.close();
+  record_count_ = 0;
+  file_.open(path, std::ios::binary | std::ios::trunc);
+  if (!file_.is_open()) {
+    *error_message = "Cannot create trace file '" + path + "'";
+    return false;
+  }
+  if (!file_.write(kTraceMagic.data(), static_cast<std::streamsize>(kTraceMagic.size())).flush()) {
+    file_.close();
+    *error_message = "Cannot write trace file '" + path + "'";
+    return false;
+  }
+  return true;
+}
+
+bool SessionTraceWriter::Append(std::string_view command, const CommandExecutionResult& result) {
+  std::array<char, kRecordHeaderBytes> header{};
+  const std::uint8_t flags = (result.success ? kFlagSuccess : 0) | (result.cancelled ? kFlagCancelled : 0) |
+                             (result.timed_out ? kFlagTimedOut : 0);
+  header[0] = static_cast<char>(flags);
+  PutLittleEndian(command.size(), 4, header.data() + 1);
+  PutLittleEndian(result.error_message.size(), 4, header.data() + 5);
+  PutLittleEndian(result.output.size(), 8, header.data() + 9);
+  PutLittleEndian(result.duration_us, 8, header.data() + 17);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!file_.is_open()) {
+    return false;
+  }
+  // Flushing per record keeps the file readable up to the last finished command.
+  file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+  file_.write(command.data(), static_cast<std::streamsize>(command.size()));
+  file_.write(result.error_message.data(), static_cast<std::streamsize>(result.error_message.size()));
+  file_.write(result.output.data(), static_cast<std::streamsize>(result.output.size()));
+  const bool written = static_cast<bool>(file_.flush());
+  if (written) {
+    ++record_count_;
+  }
+  return written;
+}
+
+void SessionTraceWriter::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_.close();
+}
+
+std::uint64_t SessionTraceWriter::RecordCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return record_count_;
+}
+
+RecordingCommandExecutor::RecordingCommandExecutor(IWinDbgCommandExecutor* inner, SessionTraceWriter* writer)
+    : inner_(inner), writer_(writer) {}
+
+CommandExecutionResult RecordingCommandExecutor::Execute(const std::string& command) {
+  CommandExecutionResult result = inner_->Execute(command);
+  writer_->Append(command, result);
+  return result;
+}
+
+std::vector<CommandExecutionResult> RecordingCommandExecutor::ExecuteBatch(
+    const std::vector<std::string>& commands,
+    bool stop_on_error) {
+  std::vector<CommandExecutionResult> results = inner_->ExecuteBatch(commands, stop_on_error);
+  for (std::size_t index = 0; index < results.size() && index < commands.size(); ++index) {
+    writer_->Append(commands[index], results[index]);
+  }
+  return results;
+}
+
+CommandExecutionResult RecordingCommandExecutor::ExecuteWithContext(
+    const std::string& command,
+    CommandExecutionContext* context) {
+  if (context == nullptr) {
+    CommandExecutionResult result = inner_->ExecuteWithContext(command, nullptr);
+    writer_->Append(command, result);
+    return result;
+  }
+
+  // The result is already filtered and limited for this request, so the trace keeps the raw capture the
+  // context saw instead; replay shapes it once, the way the live executor did.
+  std::string raw_output;
+  std::function<void(std::string_view text)> observer = context->OutputObserver();
+  context->SetOutputObserver([&raw_output, &observer](std::string_view text) {
+    raw_output.append(text);
+    if (observer) {
+      observer(text);
+    }
+  });
+  CommandExecutionResult result = inner_->ExecuteWithContext(command, context);
+  context->SetOutputObserver(std::move(observer));
+
+  result.output.swap(raw_output);
+  writer_->Append(command, result);
+  result.output.swap(raw_output);
+  return result;
+}
+
+std::uint64_t RecordingCommandExecutor::StateGeneration() {
+  return inner_->StateGeneration();
+}
+
+bool RecordingCommandExecutor::OpenSession(std::string* error_message) {
+  return inner_->OpenSession(error_message);
+}
+
+void RecordingCommandExecutor::CloseSession() {
+  inner_->CloseSession();
+}
+
+#ifdef _WIN32
+struct SessionTrace::Mapping {
+  HANDLE file = INVALID_HANDLE_VALUE;
+  HANDLE file_mapping = nullptr;
+  const char* data = nullptr;
+  std::size_t size = 0;
+
+  ~Mapping() {
+    if (data != nullptr) {
+      UnmapViewOfFile(data);
+    }
+    if (file_mapping != nullptr) {
+      CloseHandle(file_mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+      CloseHandle(file);
+    }
+  }
+
+  bool Open(const std::string& path, std::string* error_message) {
+    // The recorder may still be appending, so writers are not locked out.
+    file = CreateFileA(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      *error_message = LastErrorText("Opening trace", path);
+      return false;
+    }
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size)) {
+      *error_message = LastErrorText("Sizing trace", path);
+      return false;
+    }
+    if (static_cast<std::uint64_t>(file_size.QuadPart) < kTraceMagic.size()) {
+      *error_message = "Trace '" + path + "' is too short";
+      return false;
+    }
+    file_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (file_mapping == nullptr) {
+      *error_message = LastErrorText("Mapping trace", path);
+      return false;
+    }
+    data = static_cast<const char*>(MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+      *error_message = LastErrorText("Mapping trace", path);
+      return false;
+    }
+    size = static_cast<std::size_t>(file_size.QuadPart);
+    return true;
+  }
+};
+#else
+struct SessionTrace::Mapping {
+  int file = -1;
+  const char* data = nullptr;
+  std::size_t size = 0;
+
+  ~Mapping() {
+    if (data != nullptr) {
+      munmap(const_cast<char*>(data), size);
+    }
+    if (file != -1) {
+      close(file);
+    }
+  }
+
+  bool Open(const std::string& path, std::string* error_message) {
+    file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file == -1) {
+      *error_message = LastErrorText("Opening trace", path);
+      return false;
+    }
+    struct stat file_status {};
+    if (fstat(file, &file_status) != 0) {
+      *error_message = LastErrorText("Sizing trace", path);
+      return false;
+    }
+    if (static_cast<std::uint64_t>(file_status.st_size) < kTraceMagic.size()) {
+      *error_message = "Trace '" + path + "' is too short";
+      return false;
+    }
+    const std::size_t file_size = static_cast<std::size_t>(file_status.st_size);
+    void* view = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+      *error_message = LastErrorText("Mapping trace", path);
+      return false;
+    }
+    data = static_cast<const char*>(view);
+    size = file_size;
+    return true;
+  }
+};
+#endif
+
+SessionTrace::SessionTrace() = default;
+SessionTrace::~SessionTrace() = default;
+SessionTrace::SessionTrace(SessionTrace&& other) noexcept = default;
+SessionTrace& SessionTrace::operator=(SessionTrace&& other) noexcept = default;
+
+bool SessionTrace::Load(const std::string& path, SessionTrace* out_trace, std::string* error_message) {
+  auto mapping = std::make_unique<Mapping>();
+  if (!mapping->Open(path, error_message)) {
+    return false;
+  }
+
+  const std::string_view bytes(mapping->data, mapping->size);
+  if (bytes.substr(0, kTraceMagic.size()) != kTraceMagic) {
+    *error_message = "'" + path + "' is not a session trace";
+    return false;
+  }
+
+  std::vector<TraceRecord> records;
+  std::size_t offset = kTraceMagic.size();
+  while (bytes.size() - offset >= kRecordHeaderBytes) {
+    const char* header = bytes.data() + offset;
+    const std::uint8_t flags = static_cast<std::uint8_t>(header[0]);
+    const std::uint64_t command_bytes = GetLittleEndian(header + 1, 4);
+    const std::uint64_t error_bytes = GetLittleEndian(header + 5, 4);
+    const std::uint64_t output_bytes = GetLittleEndian(header + 9, 8);
+    const std::size_t remaining = bytes.size() - offset - kRecordHeaderBytes;
+    if ((flags & ~(kFlagSuccess | kFlagCancelled | kFlagTimedOut)) != 0) {
+      *error_message = "Trace '" + path + "' has a malformed record at offset " + std::to_string(offset);
+      return false;
+    }
+    if (output_bytes > remaining || command_bytes + error_bytes > remaining - output_bytes) {
+      break;
+    }
+
+    TraceRecord record;
+    std::size_t field = offset + kRecordHeaderBytes;
+    record.command = bytes.substr(field, command_bytes);
+    field += command_bytes;
+    record.error_message = bytes.substr(field, error_bytes);
+    field += error_bytes;
+    record.output = bytes.substr(field, output_bytes);
+    record.duration_us = GetLittleEndian(header + 17, 8);
+    record.success = (flags & kFlagSuccess) != 0;
+    record.cancelled = (flags & kFlagCancelled) != 0;
+    record.timed_out = (flags & kFlagTimedOut) != 0;
+    records.push_back(record);
+    offset = field + output_bytes;
+  }
+
+  out_trace->mapping_ = std::move(mapping);
+  out_trace->records_ = std::move(records);
+  return true;
+}
+
+const std::vector<TraceRecord>& SessionTrace::Records() const {
+  return records_;
+}
+
+ReplayExecutor::ReplayExecutor(const SessionTrace* trace, ReplayOptions options) : options_(options) {
+  for (const TraceRecord& record : trace->Records()) {
+    by_command_[record.command].push_back(&record);
+  }
+}
+
+CommandExecutionResult ReplayExecutor::Execute(const std::string& command) {
+  return ExecuteWithContext(command, nullptr);
+}
+
+CommandExecutionResult ReplayExecutor::ExecuteWithContext(
+    const std::string& command,
+    CommandExecutionContext* context) {
+  if (context != nullptr && context->CancelRequested()) {
+    return MakeCancelledResult();
+  }
+
+  const TraceRecord* record = Next(command);
+  if (record == nullptr) {
+    return {.success = false, .output = "", .error_message = "Command not in trace: " + command};
+  }
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(record->duration_us);
+  if (options_.original_timing && !WaitUntilDeadlineOrCancelled(context, deadline)) {
+    return MakeCancelledResult();
+  }
+
+  CommandExecutionResult result;
+  result.success = record->success;
+  result.output.assign(record->output);
+  result.error_message.assign(record->error_message);
+  result.duration_us = record->duration_us;
+  result.cancelled = record->cancelled;
+  result.timed_out = record->timed_out;
+  if (context != nullptr) {
+    context->AppendOutput(record->output);
+    ShapeCapturedOutput(*context, &result);
+  }
+  return result;
+}
+
+std::uint64_t ReplayExecutor::ReplayedCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return replayed_count_;
+}
+
+const TraceRecord* ReplayExecutor::Next(std::string_view command) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto it = by_command_.find(command);
+  if (it == by_command_.end()) {
+    return nullptr;
+  }
+  std::size_t& cursor = cursors_[it->first];
+  const TraceRecord* record = it->second[cursor];
+  cursor = (cursor + 1) % it->second.size();
+  ++replayed_count_;
+  return record;
+}
+
+}  // namespace dbgx::windbg
@@ -0,0 +1,176 @@
+#include "dbgx/windbg/simulated_executor.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace dbgx::windbg {
+
+namespace {
+
+// Output is reported to the context in this many pieces spread over the command's latency.
+constexpr std::size_t kOutputPieces = 8;
+constexpr std::size_t kBytesPerLine = 16;
+
+std::chrono::microseconds DrawLatency(const LatencyModel& model, std::mt19937_64* random) {
+  const double median = static_cast<double>(model.median.count());
+  double drawn = median;
+  switch (model.distribution) {
+    case LatencyDistribution::kFixed:
+      break;
+    case LatencyDistribution::kUniform: {
+      const double spread = static_cast<double>(model.spread.count());
+      drawn = std::uniform_real_distribution<double>(std::max(0.0, median - spread), median + spread)(*random);
+      break;
+    }
+    case LatencyDistribution::kExponential:
+      drawn = median > 0 ? std::exponential_distribution<double>(1.0 / median)(*random) : 0.0;
+      break;
+    case LatencyDistribution::kLogNormal:
+      drawn = median > 0 ? std::lognormal_distribution<double>(std::log(median), model.sigma)(*random) : 0.0;
+      break;
+  }
+  const double bounded = std::clamp(drawn, 0.0, static_cast<double>(model.max.count()));
+  return std::chrono::microseconds(static_cast<std::int64_t>(bounded));
+}
+
+void AppendHexByte(unsigned char value, std::string* out) {
+  static constexpr char kDigits[] = "0123456789abcdef";
+  out->push_back(kDigits[value >> 4]);
+  out->push_back(kDigits[value & 0xF]);
+}
+
+}  // namespace
+
+std::string GenerateSimulatedOutput(std::size_t size, double entropy, std::uint64_t seed) {
+  std::mt19937_64 random(seed);
+  const auto threshold = static_cast<std::uint64_t>(std::clamp(entropy, 0.0, 1.0) * 4294967296.0);
+  std::string output;
+  output.reserve(size + 96);
+  std::array<unsigned char, kBytesPerLine> bytes{};
+  for (std::uint64_t address = 0x0000000000100000; output.size() < size; address += kBytesPerLine) {
+    for (unsigned char& byte : bytes) {
+      const std::uint64_t draw = random();
+      byte = (draw & 0xFFFFFFFF) < threshold ? static_cast<unsigned char>(draw >> 56) : 0;
+    }
+    // Same layout as db: address, sixteen bytes with a dash in the middle, then the ASCII column.
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      AppendHexByte(static_cast<unsigned char>(address >> shift), &output);
+      if (shift == 32) {
+        output.push_back('`');
+      }
+    }
+    output.push_back(' ');
+    for (std::size_t index = 0; index < bytes.size(); ++index) {
+      output.push_back(index == 8 ? '-' : ' ');
+      AppendHexByte(bytes[index], &output);
+    }
+    output += "  ";
+    for (const unsigned char byte : bytes) {
+      output.push_back(byte >= 0x20 && byte < 0x7F ? static_cast<char>(byte) : '.');
+    }
+    output.push_back('\n');
+  }
+  output.resize(size);
+  return output;
+}
+
+SimulatedCommandExecutor::SimulatedCommandExecutor(SimulationOptions options)
+    : options_(std::move(options)), random_(options_.seed) {}
+
+CommandExecutionResult SimulatedCommandExecutor::Execute(const std::string& command) {
+  return ExecuteWithContext(command, nullptr);
+}
+
+CommandExecutionResult SimulatedCommandExecutor::ExecuteWithContext(
+    const std::string& command,
+    CommandExecutionContext* context) {
+  if (context != nullptr && context->CancelRequested()) {
+    return MakeCancelledResult();
+  }
+
+  const auto started_at = std::chrono::steady_clock::now();
+  const Draw draw = DrawFor(command);
+  const std::string output =
+      draw.fail ? std::string() : GenerateSimulatedOutput(draw.output_bytes, draw.output_entropy, draw.output_seed);
+
+  CommandExecutionResult result;
+  std::size_t reported = 0;
+  bool cancelled = false;
+  for (std::size_t piece = 1; piece <= kOutputPieces; ++piece) {
+    if (draw.block) {
+      // Reports its first piece and then hangs, like a runaway search.
+      cancelled = piece > 1 && !WaitUntilDeadlineOrCancelled(context, std::chrono::steady_clock::time_point::max());
+    } else {
+      const auto deadline =
+          started_at + draw.latency * static_cast<std::int64_t>(piece) / static_cast<std::int64_t>(kOutputPieces);
+      cancelled = deadline <= std::chrono::steady_clock::now() ? context != nullptr && context->CancelRequested()
+                                                               : !WaitUntilDeadlineOrCancelled(context, deadline);
+    }
+    if (cancelled) {
+      break;
+    }
+    const std::size_t end = output.size() * piece / kOutputPieces;
+    if (context != nullptr && end > reported) {
+      context->AppendOutput(std::string_view(output).substr(reported, end - reported));
+    }
+    reported = end;
+  }
+
+  if (cancelled) {
+    result = MakeCancelledResult(output.substr(0, reported));
+  } else if (draw.fail) {
+    result.error_message = draw.failure_message;
+  } else {
+    result.success = true;
+    result.output = output;
+  }
+  result.duration_us = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started_at).count());
+  if (context != nullptr) {
+    ShapeCapturedOutput(*context, &result);
+  }
+  Count(result);
+  return result;
+}
+
+SimulationStats SimulatedCommandExecutor::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+const SimulationProfile& SimulatedCommandExecutor::ProfileFor(std::string_view command) const {
+  for (const SimulationRule& rule : options_.rules) {
+    if (command.starts_with(rule.command_prefix)) {
+      return rule.profile;
+    }
+  }
+  return options_.defaults;
+}
+
+SimulatedCommandExecutor::Draw SimulatedCommandExecutor::DrawFor(std::string_view command) {
+  const SimulationProfile& profile = ProfileFor(command);
+  Draw draw;
+  draw.output_entropy = profile.output_entropy;
+  draw.block = profile.block_until_cancelled;
+  draw.failure_message = profile.failure_message;
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  draw.latency = DrawLatency(profile.latency, &random_);
+  const std::size_t max_output_bytes = std::max(profile.min_output_bytes, profile.max_output_bytes);
+  draw.output_bytes = std::uniform_int_distribution<std::size_t>(profile.min_output_bytes, max_output_bytes)(random_);
+  draw.fail = std::bernoulli_distribution(std::clamp(profile.failure_rate, 0.0, 1.0))(random_);
+  draw.output_seed = random_();
+  return draw;
+}
+
+void SimulatedCommandExecutor::Count(const CommandExecutionResult& result) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++stats_.executed;
+  stats_.failed += !result.success && !result.cancelled ? 1 : 0;
+  stats_.cancelled += result.cancelled ? 1 : 0;
+  stats_.output_bytes += result.output.size();
+}
+
+}  // namespace dbgx::windbg
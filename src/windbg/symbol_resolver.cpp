@@ -0,0 +1,162 @@
+#include "dbgx/windbg/symbol_resolver.hpp"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+#include "dbgx/windbg/ascii.hpp"
+
+namespace dbgx::windbg {
+
+namespace {
+
+// Matched case-insensitively against the first token of each ';'-separated command.
+constexpr std::array<std::string_view, 6> kSymbolCommands = {
+    ".reload",
+    ".sympath",
+    ".sympath+",
+    ".symfix",
+    ".symfix+",
+    "ld",
+};
+
+bool PartInvalidatesSymbols(std::string_view part) {
+  while (!part.empty() && IsSpace(part.front())) {
+    part.remove_prefix(1);
+  }
+  std::size_t name_end = 0;
+  while (name_end < part.size() && !IsSpace(part[name_end])) {
+    ++name_end;
+  }
+  const std::string_view name = part.substr(0, name_end);
+  return std::any_of(kSymbolCommands.begin(), kSymbolCommands.end(), [name](std::string_view symbol_command) {
+    return EqualsIgnoreCase(name, symbol_command);
+  });
+}
+
+}  // namespace
+
+bool InvalidatesSymbols(std::string_view command) {
+  std::size_t start = 0;
+  while (start <= command.size()) {
+    std::size_t end = command.find(';', start);
+    if (end == std::string_view::npos) {
+      end = command.size();
+    }
+    if (PartInvalidatesSymbols(command.substr(start, end - start))) {
+      return true;
+    }
+    start = end + 1;
+  }
+  return false;
+}
+
+SymbolResolver::SymbolResolver(SymbolResolverOptions options) : options_(options) {}
+
+bool SymbolResolver::Resolve(
+    IWinDbgSymbolProvider* provider,
+    const std::vector<std::uint64_t>& addresses,
+    std::vector<ResolvedAddress>* out_results,
+    std::string* error_message) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!RefreshLocked(provider, error_message)) {
+    return false;
+  }
+
+  out_results->clear();
+  out_results->reserve(addresses.size());
+  for (const std::uint64_t address : addresses) {
+    ResolvedAddress result;
+    result.address = address;
+    const ModuleRange* module = FindModuleLocked(address);
+    if (module != nullptr) {
+      result.module = module->name;
+      result.module_offset = address - module->base;
+      LookupSymbolLocked(provider, &result);
+    }
+    out_results->push_back(std::move(result));
+  }
+  return true;
+}
+
+void SymbolResolver::Invalidate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  valid_ = false;
+}
+
+SymbolResolverStats SymbolResolver::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool SymbolResolver::RefreshLocked(IWinDbgSymbolProvider* provider, std::string* error_message) {
+  const std::uint64_t generation = provider->SymbolGeneration();
+  if (valid_ && generation == generation_) {
+    return true;
+  }
+
+  std::vector<ModuleRange> modules;
+  if (!provider->ListModules(&modules, error_message)) {
+    valid_ = false;
+    return false;
+  }
+  std::sort(modules.begin(), modules.end(), [](const ModuleRange& left, const ModuleRange& right) {
+    return left.base < right.base;
+  });
+  modules.erase(
+      std::remove_if(modules.begin(), modules.end(), [](const ModuleRange& module) { return module.size == 0; }),
+      modules.end());
+
+  modules_ = std::move(modules);
+  symbols_.clear();
+  symbol_index_.clear();
+  generation_ = generation;
+  valid_ = true;
+  ++stats_.index_rebuilds;
+  return true;
+}
+
+const ModuleRange* SymbolResolver::FindModuleLocked(std::uint64_t address) const {
+  auto it = std::upper_bound(
+      modules_.begin(), modules_.end(), address, [](std::uint64_t value, const ModuleRange& module) {
+        return value < module.base;
+      });
+  if (it == modules_.begin()) {
+    return nullptr;
+  }
+  --it;
+  return address - it->base < it->size ? &*it : nullptr;
+}
+
+void SymbolResolver::LookupSymbolLocked(IWinDbgSymbolProvider* provider, ResolvedAddress* result) {
+  const auto cached = symbol_index_.find(result->address);
+  if (cached != symbol_index_.end()) {
+    symbols_.splice(symbols_.begin(), symbols_, cached->second);
+    result->symbol = cached->second->symbol;
+    result->displacement = cached->second->displacement;
+    ++stats_.hits;
+    return;
+  }
+
+  ++stats_.misses;
+  CachedSymbol entry;
+  entry.address = result->address;
+  if (!provider->GetNameByOffset(result->address, &entry.symbol, &entry.displacement)) {
+    entry.symbol.clear();
+    entry.displacement = 0;
+  }
+  result->symbol = entry.symbol;
+  result->displacement = entry.displacement;
+
+  if (options_.max_cached_symbols == 0) {
+    return;
+  }
+  symbols_.push_front(std::move(entry));
+  symbol_index_.emplace(result->address, symbols_.begin());
+  while (symbols_.size() > options_.max_cached_symbols) {
+    symbol_index_.erase(symbols_.back().address);
+    symbols_.pop_back();
+  }
+}
+
+}  // namespace dbgx::windbg
@@ -1,11 +1,49 @@
+#include "dbgx/mcp/async_log.hpp"
+#include "dbgx/mcp/command_jobs.hpp"
+#include "dbgx/mcp/engine_queue.hpp"
+#include "dbgx/mcp/flight_recorder.hpp"
 #include "dbgx/mcp/json_rpc.hpp"
+#include "dbgx/mcp/metrics.hpp"
+#include "dbgx/mcp/output_store.hpp"
 #include "dbgx/mcp/io_echo.hpp"
 #include "dbgx/mcp/http_server.hpp"
-
+#include "dbgx/mcp/perfect_hash.hpp"
+#include "dbgx/mcp/span_tracer.hpp"
+#include "dbgx/mcp/structured_output.hpp"
+#include "dbgx/mcp/tools.hpp"
+#include "dbgx/windbg/caching_command_executor.hpp"
+#include "dbgx/windbg/command_watchdog.hpp"
+#include "dbgx/windbg/memory_reader.hpp"
+#include "dbgx/windbg/output_parsers.hpp"
+#include "dbgx/windbg/segmented_buffer.hpp"
+#include "dbgx/windbg/session_trace.hpp"
+#include "dbgx/windbg/simulated_executor.hpp"
+#include "dbgx/windbg/symbol_resolver.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
 namespace {
 
 class FakeExecutor final : public dbgx::windbg::IWinDbgCommandExecutor {
@@ -13,7 +51,9 @@ class FakeExecutor final : public dbgx::windbg::IWinDbgCommandExecutor {
   dbgx::windbg::CommandExecutionResult Execute(const std::string& command) override {
     ++call_count;
     last_command = command;
-    if (should_fail) {
+    commands.push_back(command);
+    execute_thread = std::this_thread::get_id();
+    if (should_fail || (!fail_on_command.empty() && command == fail_on_command)) {
       return {
           .success = false,
           .output = "",
@@ -24,14 +64,152 @@ class FakeExecutor final : public dbgx::windbg::IWinDbgCommandExecutor {
         .success = true,
         .output = output,
         .error_message = "",
+        .duration_us = duration_us,
     };
   }
 
+  std::uint64_t StateGeneration() override {
+    return generation;
+  }
+
+  bool OpenSession(std::string* /*error_message*/) override {
+    ++session_opens;
+    session_thread = std::this_thread::get_id();
+    return true;
+  }
+
+  void CloseSession() override {
+    ++session_closes;
+    close_thread = std::this_thread::get_id();
+  }
+
   bool should_fail = false;
   std::string failure_message = "failed";
+  std::string fail_on_command;
   std::string output = "ok";
   std::string last_command;
+  std::vector<std::string> commands;
   int call_count = 0;
+  std::uint64_t duration_us = 0;
+  std::uint64_t generation = 0;
+  int session_opens = 0;
+  int session_closes = 0;
+  std::thread::id session_thread;
+  std::thread::id execute_thread;
+  std::thread::id close_thread;
+};
+
+// Emits some output, then blocks until the router cancels it through the execution context.
+class CancellableFakeExecutor final : public dbgx::windbg::IWinDbgCommandExecutor {
+ public:
+  dbgx::windbg::CommandExecutionResult Execute(const std::string& command) override {
+    return ExecuteWithContext(command, nullptr);
+  }
+
+  dbgx::windbg::CommandExecutionResult ExecuteWithContext(
+      const std::string& /*command*/,
+      dbgx::windbg::CommandExecutionContext* context) override {
+    if (context == nullptr) {
+      return {.success = true, .output = "done", .error_message = ""};
+    }
+
+    context->SetInterruptHandler([this]() {
+      std::lock_guard<std::mutex> lock(mutex);
+      interrupted = true;
+      changed.notify_all();
+    });
+    context->AppendOutput("partial");
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      started = true;
+      changed.notify_all();
+      changed.wait_for(lock, std::chrono::seconds(5), [this]() { return interrupted; });
+    }
+    context->ClearInterruptHandler();
+
+    if (context->CancelRequested()) {
+      return dbgx::windbg::MakeCancelledResult("partial");
+    }
+    return {.success = true, .output = "done", .error_message = ""};
+  }
+
+  bool WaitUntilStarted() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, std::chrono::seconds(5), [this]() { return started; });
+  }
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool started = false;
+  bool interrupted = false;
+};
+
+// In-memory target: mapped regions hold byte patterns, everything else is unreadable.
+class FakeMemoryReader final : public dbgx::windbg::IWinDbgMemoryReader {
+ public:
+  void Map(std::uint64_t address, std::string bytes) {
+    regions[address] = std::move(bytes);
+  }
+
+  bool ReadVirtual(std::uint64_t address, void* buffer, std::uint32_t size, std::uint32_t* bytes_read) override {
+    ++read_calls;
+    largest_read = std::max(largest_read, size);
+    *bytes_read = 0;
+    auto* out = static_cast<char*>(buffer);
+    while (*bytes_read < size) {
+      const std::uint64_t current = address + *bytes_read;
+      auto it = regions.upper_bound(current);
+      if (it == regions.begin()) {
+        break;
+      }
+      --it;
+      const std::uint64_t region_end = it->first + it->second.size();
+      if (current >= region_end) {
+        break;
+      }
+      const std::uint32_t count =
+          static_cast<std::uint32_t>(std::min<std::uint64_t>(region_end - current, size - *bytes_read));
+      std::memcpy(out + *bytes_read, it->second.data() + (current - it->first), count);
+      *bytes_read += count;
+    }
+    return *bytes_read != 0;
+  }
+
+  std::map<std::uint64_t, std::string> regions;
+  int read_calls = 0;
+  std::uint32_t largest_read = 0;
+};
+
+// Fixed module list and symbol table; generation is bumped by tests to simulate module loads.
+class FakeSymbolProvider final : public dbgx::windbg::IWinDbgSymbolProvider {
+ public:
+  bool ListModules(std::vector<dbgx::windbg::ModuleRange>* out_modules, std::string* /*error_message*/) override {
+    ++list_calls;
+    *out_modules = modules;
+    return true;
+  }
+
+  bool GetNameByOffset(std::uint64_t address, std::string* out_name, std::uint64_t* out_displacement) override {
+    ++name_calls;
+    auto it = symbols.upper_bound(address);
+    if (it == symbols.begin()) {
+      return false;
+    }
+    --it;
+    *out_name = it->second;
+    *out_displacement = address - it->first;
+    return true;
+  }
+
+  std::uint64_t SymbolGeneration() override {
+    return generation;
+  }
+
+  std::vector<dbgx::windbg::ModuleRange> modules;
+  std::map<std::uint64_t, std::string> symbols;
+  std::uint64_t generation = 0;
+  int list_calls = 0;
+  int name_calls = 0;
 };
 
 bool Contains(const std::string& text, const std::string& expected_substring) {
@@ -164,6 +342,127 @@ void TestHttpServerNonRetryableBindFailureStopsImmediately(int* failures) {
   Expect(Contains(error_message, "Bind failed on port"), "failure should identify bind error context", failures);
 }
 
+std::string SendHttpRequest(std::uint16_t port, const std::string& request) {
+  SOCKET client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (client == INVALID_SOCKET) {
+    return {};
+  }
+
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+  if (connect(client, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    closesocket(client);
+    return {};
+  }
+
+  send(client, request.data(), static_cast<int>(request.size()), 0);
+
+  std::string response;
+  char buffer[1024];
+  int received = 0;
+  while ((received = recv(client, buffer, static_cast<int>(sizeof(buffer)), 0)) > 0) {
+    response.append(buffer, static_cast<std::size_t>(received));
+  }
+  closesocket(client);
+  return response;
+}
+
+std::string SendHttpPost(std::uint16_t port, const std::string& body) {
+  return SendHttpRequest(
+      port,
+      "POST /mcp HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/json\r\nContent-Length: " +
+          std::to_string(body.size()) + "\r\n\r\n" + body);
+}
+
+void TestHttpServerServesConnectionsConcurrently(int* failures) {
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool fast_served = false;
+
+  dbgx::mcp::HttpServer server;
+  std::string error_message;
+  const bool started = server.Start(
+      "127.0.0.1",
+      0,
+      [&](const dbgx::mcp::HttpRequest& request) {
+        dbgx::mcp::HttpResponse response;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (request.body == "slow") {
+          const bool released = changed.wait_for(lock, std::chrono::seconds(5), [&]() { return fast_served; });
+          response.body = released ? "slow-released" : "slow-timed-out";
+        } else {
+          fast_served = true;
+          changed.notify_all();
+          response.body = "fast";
+        }
+        return response;
+      },
+      &error_message);
+  Expect(started, "server should start for concurrency test", failures);
+  if (!started) {
+    return;
+  }
+
+  std::string slow_response;
+  std::thread slow_client([&]() { slow_response = SendHttpPost(server.BoundPort(), "slow"); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  const std::string fast_response = SendHttpPost(server.BoundPort(), "fast");
+  slow_client.join();
+  server.Stop();
+
+  Expect(Contains(fast_response, "\r\n\r\nfast"), "second connection should be served while the first blocks", failures);
+  Expect(Contains(slow_response, "slow-released"), "blocked connection should finish after the second one", failures);
+}
+
+void TestHttpServerSendsLargeAndChunkedBodiesIntact(int* failures) {
+  std::string large_body(3 * 1024 * 1024 + 17, '\0');
+  for (std::size_t index = 0; index < large_body.size(); ++index) {
+    large_body[index] = static_cast<char>('a' + index % 26);
+  }
+
+  dbgx::mcp::HttpServer server;
+  std::string error_message;
+  const bool started = server.Start(
+      "127.0.0.1",
+      0,
+      [&](const dbgx::mcp::HttpRequest& request) {
+        dbgx::mcp::HttpResponse response;
+        if (request.body == "large") {
+          response.body = large_body;
+        } else {
+          response.body_stream = [](const dbgx::mcp::HttpBodyWriter& write_chunk) {
+            write_chunk("hello");
+            write_chunk("");
+            write_chunk(std::string(300, 'x'));
+          };
+        }
+        return response;
+      },
+      &error_message);
+  Expect(started, "server should start for scatter send test", failures);
+  if (!started) {
+    return;
+  }
+
+  const std::string large_response = SendHttpPost(server.BoundPort(), "large");
+  const std::string chunked_response = SendHttpPost(server.BoundPort(), "chunked");
+  server.Stop();
+
+  const std::size_t body_start = large_response.find("\r\n\r\n");
+  Expect(
+      Contains(large_response, "Content-Length: " + std::to_string(large_body.size()) + "\r\n") &&
+          body_start != std::string::npos && large_response.compare(body_start + 4, std::string::npos, large_body) == 0,
+      "head and body sent as separate pieces should arrive as one intact response",
+      failures);
+  Expect(
+      Contains(chunked_response, "Transfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n12c\r\n" + std::string(300, 'x') +
+                                     "\r\n0\r\n\r\n"),
+      "chunk framing should be sent around each chunk and empty chunks skipped",
+      failures);
+}
+
 void TestInitialize(int* failures) {
   FakeExecutor executor;
   dbgx::mcp::JsonRpcRouter router(&executor);
@@ -215,180 +514,2064 @@ void TestToolsCallSuccess(int* failures) {
   Expect(Contains(result.body, "eax=0x42"), "tools/call should return executor output", failures);
 }
 
-void TestToolsCallMissingCommand(int* failures) {
+void TestEvalBatchRunsCommandsInOrder(int* failures) {
   FakeExecutor executor;
+  executor.fail_on_command = "bad";
   dbgx::mcp::JsonRpcRouter router(&executor);
 
   const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
-      R"({"jsonrpc":"2.0","id":3,"method":"tools/call","params":{"name":"windbg.eval","arguments":{}}})");
+      R"({"jsonrpc":"2.0","id":12,"method":"tools/call","params":{"name":"windbg.eval_batch",)"
+      R"("arguments":{"commands":["dq rsp","bad","ln rip"]}}})");
 
-  Expect(result.status_code == 200, "missing command should still return JSON-RPC response", failures);
-  Expect(Contains(result.body, "\"code\":-32602"), "missing command should return invalid params", failures);
-  Expect(executor.call_count == 0, "missing command must not execute command", failures);
+  Expect(result.status_code == 200, "eval_batch should return HTTP 200", failures);
+  Expect(
+      executor.commands == std::vector<std::string>({"dq rsp", "bad", "ln rip"}),
+      "eval_batch should execute every command in order",
+      failures);
+  Expect(
+      Contains(result.body, R"("content":[{"type":"text","text":"ok"},{"type":"text","text":"failed"},)"),
+      "eval_batch should return one content item per command",
+      failures);
+  Expect(
+      Contains(result.body, R"({"command":"bad","success":false,"durationUs":)"),
+      "eval_batch should report per-command success flags and timings",
+      failures);
+  Expect(Contains(result.body, R"("skipped":0)"), "eval_batch without stop_on_error should skip nothing", failures);
+  Expect(Contains(result.body, R"("isError":true)"), "eval_batch with a failed command should be an error", failures);
 }
 
-void TestUnknownMethod(int* failures) {
+void TestEvalBatchStopOnError(int* failures) {
   FakeExecutor executor;
+  executor.fail_on_command = "bad";
   dbgx::mcp::JsonRpcRouter router(&executor);
 
-  const dbgx::mcp::JsonRpcHttpResult result =
-      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":4,"method":"unknown/method","params":{}})");
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":13,"method":"tools/call","params":{"name":"windbg.eval_batch",)"
+      R"("arguments":{"commands":["k","bad","r","lm"],"stop_on_error":true}}})");
 
-  Expect(result.status_code == 200, "unknown method should return HTTP 200 with JSON-RPC error", failures);
-  Expect(Contains(result.body, "\"code\":-32601"), "unknown method should return method not found", failures);
+  Expect(executor.call_count == 2, "stop_on_error should stop after the failing command", failures);
+  Expect(Contains(result.body, R"("skipped":2)"), "stop_on_error should report skipped commands", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult empty = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":14,"method":"tools/call","params":{"name":"windbg.eval_batch",)"
+      R"("arguments":{"commands":[]}}})");
+  Expect(Contains(empty.body, "\"code\":-32602"), "empty command list should return invalid params", failures);
+  Expect(executor.call_count == 2, "empty command list must not execute commands", failures);
 }
 
-void TestInitializedNotification(int* failures) {
-  FakeExecutor executor;
-  dbgx::mcp::JsonRpcRouter router(&executor);
+void TestEvalBatchAppliesOutputLimits(int* failures) {
+  // Records the limits each command was started with.
+  class LimitsRecordingExecutor final : public dbgx::windbg::IWinDbgCommandExecutor {
+   public:
+    dbgx::windbg::CommandExecutionResult Execute(const std::string& command) override {
+      return ExecuteWithContext(command, nullptr);
+    }
 
-  const dbgx::mcp::JsonRpcHttpResult result =
-      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","method":"notifications/initialized","params":{}})");
+    dbgx::windbg::CommandExecutionResult ExecuteWithContext(
+        const std::string& /*command*/,
+        dbgx::windbg::CommandExecutionContext* context) override {
+      limits.push_back(context != nullptr ? context->Limits() : dbgx::windbg::OutputLimits{});
+      return {.success = true, .output = "ok", .error_message = ""};
+    }
 
-  Expect(result.status_code == 202, "initialized notification should return HTTP 202", failures);
-  Expect(!result.has_body, "initialized notification should return empty body", failures);
-  Expect(result.body.empty(), "initialized notification payload should be empty", failures);
-}
+    std::vector<dbgx::windbg::OutputLimits> limits;
+  };
 
-void TestParseError(int* failures) {
-  FakeExecutor executor;
+  LimitsRecordingExecutor executor;
   dbgx::mcp::JsonRpcRouter router(&executor);
-
-  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost("this-is-not-json");
-
-  Expect(result.status_code == 400, "invalid JSON should return HTTP 400", failures);
-  Expect(Contains(result.body, "\"code\":-32700"), "invalid JSON should return parse error", failures);
+  router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":15,"method":"tools/call","params":{"name":"windbg.eval_batch",)"
+      R"("arguments":{"commands":["k","lm"]}}})");
+
+  Expect(executor.limits.size() == 2, "eval_batch should run each command with a context", failures);
+  for (const dbgx::windbg::OutputLimits& limits : executor.limits) {
+    Expect(
+        limits.max_output_bytes != 0 && limits.interrupt_after_bytes != 0,
+        "eval_batch commands should be bounded like eval",
+        failures);
+  }
 }
 
-void TestIoEchoRequestSummaryMasksSensitiveHeader(int* failures) {
-  dbgx::mcp::HttpRequest request;
-  request.method = "POST";
-  request.path = "/mcp";
-  request.headers.insert_or_assign("authorization", "Bearer super-secret-token");
-  request.body =
-      R"({"jsonrpc":"2.0","id":99,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"r eax"}}})";
+void TestCommandCacheClassification(int* failures) {
+  using dbgx::windbg::ClassifyCommand;
+  using dbgx::windbg::CommandCachePolicy;
+  using dbgx::windbg::NormalizeCommand;
 
-  const std::string summary = dbgx::mcp::BuildRequestIoSummary(request);
+  Expect(NormalizeCommand("  lm   m\tnt  ") == "lm m nt", "normalization should collapse whitespace", failures);
+  Expect(
+      NormalizeCommand(R"(s -a 0 L10  "a  b")") == R"(s -a 0 L10 "a  b")",
+      "normalization should keep quoted whitespace",
+      failures);
 
-  Expect(Contains(summary, "method=POST"), "request summary should include HTTP method", failures);
-  Expect(Contains(summary, "path=/mcp"), "request summary should include request path", failures);
-  Expect(Contains(summary, "rpc_method=tools/call"), "request summary should include JSON-RPC method", failures);
-  Expect(Contains(summary, "rpc_id=99"), "request summary should include JSON-RPC id", failures);
-  Expect(Contains(summary, "authorization=<masked>"), "request summary should mask authorization header", failures);
-  Expect(!Contains(summary, "super-secret-token"), "request summary must not expose authorization token", failures);
+  Expect(ClassifyCommand("lm") == CommandCachePolicy::kCacheable, "lm should be cacheable", failures);
+  Expect(ClassifyCommand("dt nt!_EPROCESS") == CommandCachePolicy::kCacheable, "dt should be cacheable", failures);
+  Expect(ClassifyCommand("!PEB") == CommandCachePolicy::kCacheable, "names should match case-insensitively", failures);
+  Expect(ClassifyCommand("r") == CommandCachePolicy::kCacheable, "r should be cacheable", failures);
+  Expect(ClassifyCommand("r rax=1") == CommandCachePolicy::kMutating, "register writes should mutate", failures);
+  Expect(ClassifyCommand("g") == CommandCachePolicy::kMutating, "g should mutate", failures);
+  Expect(ClassifyCommand("!tt 0") == CommandCachePolicy::kMutating, "!tt should mutate", failures);
+  Expect(ClassifyCommand(".frame 2") == CommandCachePolicy::kMutating, ".frame should mutate", failures);
+  Expect(ClassifyCommand("eb rsp 90") == CommandCachePolicy::kMutating, "memory edits should mutate", failures);
+  Expect(ClassifyCommand("~1s") == CommandCachePolicy::kMutating, "thread switches should mutate", failures);
+  Expect(ClassifyCommand("!analyze -v") == CommandCachePolicy::kMutating, "unknown commands should mutate", failures);
+  Expect(ClassifyCommand("lm; k") == CommandCachePolicy::kCacheable, "all-cacheable chains should be cacheable", failures);
+  Expect(ClassifyCommand("lm; p") == CommandCachePolicy::kMutating, "chains with a step should mutate", failures);
+  Expect(
+      ClassifyCommand(R"(.echo "a; g")") == CommandCachePolicy::kCacheable,
+      "separators inside quotes should be ignored",
+      failures);
+  Expect(ClassifyCommand("u rip") == CommandCachePolicy::kCacheable, "addressed u should be cacheable", failures);
+  Expect(ClassifyCommand("u") == CommandCachePolicy::kUncached, "bare u continues and should not be cached", failures);
+  Expect(ClassifyCommand("dq L4") == CommandCachePolicy::kUncached, "range-only displays should not be cached", failures);
+  Expect(ClassifyCommand("lm; db") == CommandCachePolicy::kUncached, "chained bare displays should not be cached", failures);
 }
 
-void TestIoEchoSummaryTruncatesLongPayload(int* failures) {
-  const std::string long_text(512, 'x');
+void TestCachingExecutorServesHitsUntilStateChanges(int* failures) {
+  FakeExecutor executor;
+  executor.duration_us = 250;
+  dbgx::windbg::CachingCommandExecutor cache(&executor);
+
+  cache.Execute("lm");
+  const dbgx::windbg::CommandExecutionResult hit = cache.Execute("  lm ");
+  Expect(executor.call_count == 1, "repeated cacheable command should be served from the cache", failures);
+  Expect(hit.success && hit.output == "ok", "cache hit should return the original output", failures);
+
+  cache.Execute("!analyze -v");
+  cache.Execute("!analyze -v");
+  Expect(executor.call_count == 3, "unknown commands should always execute", failures);
+
+  cache.Execute("g");
+  cache.Execute("lm");
+  Expect(executor.call_count == 5, "mutating command should invalidate cached results", failures);
+
+  executor.generation = 7;
+  cache.Execute("lm");
+  Expect(executor.call_count == 6, "engine state generation change should invalidate cached results", failures);
+
+  executor.fail_on_command = "k";
+  cache.Execute("k");
+  cache.Execute("k");
+  Expect(executor.call_count == 8, "failed results should not be cached", failures);
+
+  const dbgx::windbg::CommandCacheStats stats = cache.Stats();
+  Expect(stats.hits == 1, "cache should count hits", failures);
+  Expect(stats.misses == 5, "cache should count misses", failures);
+  Expect(stats.saved_us == 250, "cache should report saved engine time", failures);
+  Expect(stats.invalidations == 2, "cache should count invalidations", failures);
+}
 
-  dbgx::mcp::HttpResponse response;
-  response.status_code = 200;
-  response.body =
-      "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":{\"content\":[{\"type\":\"text\",\"text\":\"" + long_text +
-      "\"}]}}";
+void TestCachingExecutorInvalidatesOnUnknownCommands(int* failures) {
+  FakeExecutor executor;
+  dbgx::windbg::CachingCommandExecutor cache(&executor);
 
-  const std::string summary = dbgx::mcp::BuildResponseIoSummary(response);
-  Expect(Contains(summary, "...(truncated)"), "long response summary should be truncated", failures);
+  (void)cache.Execute("k");
+  (void)cache.Execute(".effmach x86");
+  (void)cache.Execute("k");
+  Expect(
+      executor.commands == std::vector<std::string>({"k", ".effmach x86", "k"}),
+      "a command not known to be read-only should invalidate cached results",
+      failures);
+
+  (void)cache.Execute("dx @$curthread.Stack.Frames[1].SwitchTo()");
+  (void)cache.Execute("k");
+  Expect(executor.call_count == 5, "dx with side effects should invalidate cached results", failures);
 }
 
-void TestIoEchoRequestSummaryIncludesTraceContext(int* failures) {
-  dbgx::mcp::HttpRequest request;
-  request.method = "POST";
-  request.path = "/mcp";
-  request.body =
-      R"({"jsonrpc":"2.0","id":7,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"g"}}})";
+void TestCachingExecutorRepeatsDisplayContinuations(int* failures) {
+  FakeExecutor executor;
+  dbgx::windbg::CachingCommandExecutor cache(&executor);
 
-  dbgx::mcp::IoTraceContext trace_context;
-  trace_context.trace_id = "rpc:7";
-  trace_context.stage = "tool_execute_start";
-  trace_context.rpc_method = "tools/call";
-  trace_context.rpc_id = "7";
-  trace_context.tool_name = "windbg.eval";
-  trace_context.duration_ms = 12;
+  (void)cache.Execute("u");
+  (void)cache.Execute("u");
+  Expect(executor.call_count == 2, "repeated u should run each time", failures);
 
-  const std::string summary = dbgx::mcp::BuildRequestIoSummary(request, trace_context);
-  Expect(Contains(summary, "trace_id=rpc:7"), "request summary should include trace id", failures);
-  Expect(Contains(summary, "stage=tool_execute_start"), "request summary should include stage", failures);
-  Expect(Contains(summary, "duration_ms=12"), "request summary should include duration", failures);
-  Expect(Contains(summary, "tool=windbg.eval"), "request summary should include tool name", failures);
+  (void)cache.Execute("u rip");
+  (void)cache.Execute("u rip");
+  (void)cache.Execute("db rsp");
+  (void)cache.Execute("u");
+  const std::vector<std::string> expected_commands = {"u", "u", "u rip", "db rsp", "u rip", "u"};
+  Expect(
+      executor.commands == expected_commands,
+      "a cached display should run again before the command that continues it",
+      failures);
+
+  (void)cache.Execute("db rsp");
+  (void)cache.ExecuteBatch({"lm", "db"}, false);
+  const std::vector<std::string> batch_commands = {"lm", "db rsp", "db"};
+  Expect(
+      std::vector<std::string>(executor.commands.end() - 3, executor.commands.end()) == batch_commands,
+      "batches should replay a cached display before continuing it",
+      failures);
 }
 
-void TestIoEchoParseRequestMetaMissingId(int* failures) {
-  dbgx::mcp::HttpRequest request;
-  request.method = "POST";
-  request.path = "/mcp";
-  request.body =
-      R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"g"}}})";
+void TestCachingExecutorBatchKeepsMutationOrder(int* failures) {
+  FakeExecutor executor;
+  dbgx::windbg::CachingCommandExecutor cache(&executor);
 
-  const dbgx::mcp::RequestIoMeta meta = dbgx::mcp::ParseRequestIoMeta(request);
-  Expect(meta.parseable, "request meta should parse valid JSON", failures);
-  Expect(meta.has_rpc_method && meta.rpc_method == "tools/call", "request meta should include tools/call method", failures);
-  Expect(!meta.has_rpc_id, "request meta should detect missing id", failures);
-  Expect(meta.has_tool_name && meta.tool_name == "windbg.eval", "request meta should include tool name", failures);
+  const std::vector<dbgx::windbg::CommandExecutionResult> results =
+      cache.ExecuteBatch({"lm", "k", "lm", "g", "lm"}, false);
+  Expect(results.size() == 5, "cached batch should return one result per command", failures);
+  const std::vector<std::string> expected_commands = {"lm", "k", "g", "lm"};
+  Expect(executor.commands == expected_commands, "batch should only skip hits not separated by a mutation", failures);
 }
 
-void TestIoEchoLocalTraceIdConsistencyAcrossStages(int* failures) {
-  dbgx::mcp::HttpRequest request;
-  request.method = "POST";
-  request.path = "/mcp";
-  request.body =
-      R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"g"}}})";
+// Keeps lines with "alpha" and at most 24 bytes of them.
+void ApplyTraceTestShaping(dbgx::windbg::CommandExecutionContext* context) {
+  dbgx::windbg::LineFilterOptions filter_options;
+  filter_options.include = {"alpha"};
+  auto filter = std::make_shared<dbgx::windbg::LineFilter>();
+  std::string filter_error;
+  dbgx::windbg::LineFilter::Compile(std::move(filter_options), filter.get(), &filter_error);
+  context->SetLineFilter(std::move(filter));
+  dbgx::windbg::OutputLimits limits;
+  limits.max_output_bytes = 16;
+  context->SetOutputLimits(limits);
+}
 
-  dbgx::mcp::IoTraceContext request_context;
-  request_context.trace_id = "local-42";
-  request_context.stage = "request_received";
-  request_context.rpc_method = "tools/call";
-  request_context.tool_name = "windbg.eval";
-  request_context.duration_ms = 0;
+void TestSessionTraceRecordsAndReplaysCommands(int* failures) {
+  const std::string path = (std::filesystem::temp_directory_path() / "dbgx_session_trace_test.bin").string();
+  std::string shaped_live_output;
+  FakeExecutor inner;
+  inner.duration_us = 1500;
+  {
+    dbgx::windbg::SessionTraceWriter writer;
+    std::string open_error;
+    Expect(writer.Open(path, &open_error), "trace writer should open: " + open_error, failures);
+    dbgx::windbg::RecordingCommandExecutor recorder(&inner, &writer);
+    inner.output = "rax=1";
+    recorder.Execute("r rax");
+    inner.output = "rax=2";
+    dbgx::windbg::CommandExecutionContext context;
+    recorder.ExecuteWithContext("r rax", &context);
+    inner.output = "start end module";
+    inner.fail_on_command = "bad";
+    recorder.ExecuteBatch({"lm", "bad"}, false);
+    Expect(writer.RecordCount() == 4, "recorder should write one record per executed command", failures);
+
+    // Shaped output goes to the caller; the trace keeps the raw capture for replay to shape.
+    inner.output = "alpha 1\nbeta 2\nalpha 3\nalpha 4\n";
+    dbgx::windbg::CommandExecutionContext shaped;
+    ApplyTraceTestShaping(&shaped);
+    std::string observed;
+    shaped.SetOutputObserver([&observed](std::string_view text) { observed.append(text); });
+    const dbgx::windbg::CommandExecutionResult live = recorder.ExecuteWithContext("!alpha", &shaped);
+    Expect(live.output == "alpha 1\nalpha 3\n... [8 bytes omitted] ...\n", "live output should be shaped", failures);
+    Expect(observed == inner.output, "recording should still feed the caller's observer", failures);
+    shaped_live_output = live.output;
+  }
+  {
+    // A record cut off mid-write must not hide the ones before it.
+    std::ofstream append(path, std::ios::binary | std::ios::app);
+    append.write("\x01\x05\x00", 3);
+  }
 
-  const std::string request_summary = dbgx::mcp::BuildRequestIoSummary(request, request_context);
-  Expect(Contains(request_summary, "trace_id=local-42"), "request summary should include local trace id", failures);
+  dbgx::windbg::SessionTrace trace;
+  std::string load_error;
+  Expect(dbgx::windbg::SessionTrace::Load(path, &trace, &load_error), "trace should load: " + load_error, failures);
+  Expect(trace.Records().size() == 5, "truncated tail record should be ignored", failures);
+  if (trace.Records().size() == 5) {
+    const dbgx::windbg::TraceRecord& failed = trace.Records()[3];
+    Expect(failed.command == "bad" && !failed.success && failed.error_message == "failed",
+           "failed command should be recorded with its error", failures);
+    Expect(trace.Records()[0].duration_us == 1500, "record should keep the command duration", failures);
+    Expect(
+        trace.Records()[4].output == "alpha 1\nbeta 2\nalpha 3\nalpha 4\n",
+        "record should keep the raw capture",
+        failures);
+  }
 
-  dbgx::mcp::HttpResponse response;
-  response.status_code = 200;
-  response.body =
-      R"({"jsonrpc":"2.0","result":{"content":[{"type":"text","text":"ok"}],"isError":false}})";
+  dbgx::windbg::ReplayExecutor replay(&trace);
+  Expect(replay.Execute("r rax").output == "rax=1", "replay should serve the first recording first", failures);
+  Expect(replay.Execute("r rax").output == "rax=2", "replay should serve recordings in order", failures);
+  Expect(replay.Execute("r rax").output == "rax=1", "replay should start over once recordings run out", failures);
+  Expect(!replay.Execute("bad").success, "replay should keep recorded failures", failures);
+  const dbgx::windbg::CommandExecutionResult unknown = replay.Execute("!analyze -v");
+  Expect(!unknown.success && Contains(unknown.error_message, "not in trace"), "unrecorded command should fail",
+         failures);
+  Expect(replay.ReplayedCount() == 4, "replay should count served commands", failures);
+  dbgx::windbg::CommandExecutionContext replay_shaped;
+  ApplyTraceTestShaping(&replay_shaped);
+  Expect(
+      replay.ExecuteWithContext("!alpha", &replay_shaped).output == shaped_live_output,
+      "replay should shape the raw capture once, as the live command was",
+      failures);
 
-  dbgx::mcp::IoTraceContext response_context = request_context;
-  response_context.stage = "response_sent";
-  response_context.duration_ms = 25;
+  dbgx::mcp::JsonRpcRouter router(&replay);
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":1,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"lm"}}})");
+  Expect(Contains(result.body, "\"text\":\"start end module\""), "router should serve replayed output", failures);
+
+  dbgx::windbg::ReplayOptions timed;
+  timed.original_timing = true;
+  dbgx::windbg::ReplayExecutor timed_replay(&trace, timed);
+  const auto started_at = std::chrono::steady_clock::now();
+  timed_replay.Execute("lm");
+  Expect(std::chrono::steady_clock::now() - started_at >= std::chrono::microseconds(1500),
+         "original timing should hold the command for its recorded duration", failures);
+  dbgx::windbg::CommandExecutionContext cancelled;
+  cancelled.RequestCancel();
+  Expect(timed_replay.ExecuteWithContext("lm", &cancelled).cancelled, "cancelled replay should report it", failures);
+
+  trace = dbgx::windbg::SessionTrace();
+  std::filesystem::remove(path);
+}
 
-  const std::string response_summary = dbgx::mcp::BuildResponseIoSummary(response, response_context);
-  Expect(Contains(response_summary, "trace_id=local-42"), "response summary should include same local trace id", failures);
-  Expect(Contains(response_summary, "stage=response_sent"), "response summary should include response stage", failures);
+void TestSimulatedExecutorDrawsReproducibleLoad(int* failures) {
+  const std::string zeros = dbgx::windbg::GenerateSimulatedOutput(1000, 0.0, 7);
+  Expect(zeros.size() == 1000, "simulated output should have the requested size", failures);
+  Expect(Contains(zeros, "00000000`00100000  00 00 00 00 00 00 00 00-00 00"), "zero entropy should dump zeros",
+         failures);
+  Expect(dbgx::windbg::GenerateSimulatedOutput(1000, 1.0, 7) == dbgx::windbg::GenerateSimulatedOutput(1000, 1.0, 7),
+         "simulated output should depend only on its seed", failures);
+  Expect(dbgx::windbg::GenerateSimulatedOutput(1000, 1.0, 7) != zeros, "full entropy should randomize bytes",
+         failures);
+
+  dbgx::windbg::SimulationOptions options;
+  options.defaults.latency.distribution = dbgx::windbg::LatencyDistribution::kUniform;
+  options.defaults.latency.median = std::chrono::microseconds(3000);
+  options.defaults.latency.spread = std::chrono::microseconds(1000);
+  options.defaults.min_output_bytes = 100;
+  options.defaults.max_output_bytes = 5000;
+  dbgx::windbg::SimulationProfile failing;
+  failing.failure_rate = 1.0;
+  options.rules.push_back({"!fail", failing});
+  dbgx::windbg::SimulatedCommandExecutor first(options);
+  dbgx::windbg::SimulatedCommandExecutor second(options);
+  bool same = true;
+  bool sized = true;
+  bool timed = true;
+  for (int index = 0; index < 4; ++index) {
+    const dbgx::windbg::CommandExecutionResult a = first.Execute("dq @rsp");
+    const dbgx::windbg::CommandExecutionResult b = second.Execute("dq @rsp");
+    same = same && a.success && a.output == b.output;
+    sized = sized && a.output.size() >= 100 && a.output.size() <= 5000;
+    timed = timed && a.duration_us >= 2000;
+  }
+  Expect(same, "executors with the same seed should produce the same outputs", failures);
+  Expect(sized, "output sizes should stay within the profile bounds", failures);
+  Expect(timed, "latency should be at least the uniform lower bound", failures);
+  const dbgx::windbg::CommandExecutionResult failed = first.Execute("!fail now");
+  Expect(!failed.success && failed.error_message == "Simulated command failure", "matching rule should fail",
+         failures);
+
+  dbgx::windbg::SimulationOptions blocking_options;
+  blocking_options.defaults.min_output_bytes = 800;
+  blocking_options.defaults.max_output_bytes = 800;
+  blocking_options.defaults.block_until_cancelled = true;
+  dbgx::windbg::SimulatedCommandExecutor blocking(blocking_options);
+  dbgx::mcp::EngineDispatchQueue engine;
+  dbgx::windbg::CommandExecutionContext context;
+  dbgx::windbg::CommandExecutionResult cancelled;
+  // The engine thread runs the command while this thread polls it, and cancels it 20 ms after its first output.
+  std::chrono::steady_clock::time_point first_output_at;
+  bool still_running = false;
+  engine.Run(
+      [&]() { cancelled = blocking.ExecuteWithContext("s -a 0 L?1 x", &context); },
+      std::chrono::milliseconds(1),
+      [&]() {
+        const auto now = std::chrono::steady_clock::now();
+        if (context.OutputBytes() == 0) {
+          return;
+        }
+        if (first_output_at == std::chrono::steady_clock::time_point()) {
+          first_output_at = now;
+        } else if (now - first_output_at >= std::chrono::milliseconds(20)) {
+          still_running = true;
+          context.RequestCancel();
+        }
+      });
+  Expect(still_running, "blocking command should not finish on its own", failures);
+  Expect(cancelled.cancelled && cancelled.output.size() == 100, "cancelled command should keep its first piece",
+         failures);
+
+  const dbgx::windbg::SimulationStats stats = first.Stats();
+  Expect(stats.executed == 5 && stats.failed == 1, "stats should count executed and failed commands", failures);
+  Expect(blocking.Stats().cancelled == 1, "stats should count cancelled commands", failures);
 }
 
-void TestIoEchoResponseSummaryCoversSuccessAndError(int* failures) {
-  dbgx::mcp::HttpResponse success_response;
-  success_response.status_code = 200;
-  success_response.body =
-      "{\"jsonrpc\":\"2.0\",\"id\":10,\"result\":{\"content\":[{\"type\":\"text\",\"text\":\"ok\"}]}}";
+void TestOutputStorePagesByLineAndByteOffset(int* failures) {
+  dbgx::mcp::OutputStoreOptions options;
+  options.max_entries = 2;
+  options.max_total_bytes = 1024;
+  dbgx::mcp::OutputStore store(options);
 
-  const std::string success_summary = dbgx::mcp::BuildResponseIoSummary(success_response);
-  Expect(Contains(success_summary, "rpc_outcome=success"), "success response should be marked as success", failures);
+  std::string text;
+  for (int line = 0; line < 10; ++line) {
+    text += "line" + std::to_string(line) + "\n";
+  }
+  dbgx::mcp::StoredOutputInfo info;
+  Expect(store.Put("windbg.eval", text, &info), "output store should accept output", failures);
+  Expect(info.uri == "dbgx://output/1", "stored output should get a dbgx://output URI", failures);
+  Expect(info.total_lines == 10 && info.total_bytes == text.size(), "stored output should be indexed", failures);
+
+  dbgx::mcp::OutputPage page;
+  store.ReadLines(info.uri, 3, 2, &page);
+  Expect(page.text == "line3\nline4\n", "line page should start at the requested line", failures);
+  Expect(page.next_line == 5 && page.next_offset == 30, "line page should report where the next page starts", failures);
+
+  store.ReadBytes(info.uri, 6, 5, &page);
+  Expect(page.text == "line1" && page.first_line == 1, "byte page should map its offset to a line", failures);
+
+  store.ReadLines(info.uri, 9, 100, &page);
+  Expect(page.text == "line9\n" && page.next_line == 10, "last page should stop at the end of the output", failures);
+
+  dbgx::mcp::StoredOutputInfo second;
+  dbgx::mcp::StoredOutputInfo third;
+  store.Put("windbg.eval", "b", &second);
+  store.Put("windbg.eval", "c", &third);
+  Expect(!store.ReadLines(info.uri, 0, 1, &page), "oldest output should be evicted past max_entries", failures);
+  Expect(store.List().size() == 2, "output store should list retained outputs", failures);
+  Expect(
+      !store.Put("windbg.eval", std::string(2048, 'x'), &info),
+      "output larger than the store should be rejected",
+      failures);
+}
 
-  dbgx::mcp::HttpResponse error_response;
-  error_response.status_code = 200;
-  error_response.body =
-      "{\"jsonrpc\":\"2.0\",\"id\":10,\"error\":{\"code\":-32600,\"message\":\"Invalid Request\"}}";
+void TestOutputStoreBytePagesKeepUtf8Whole(int* failures) {
+  dbgx::mcp::OutputStore store;
+  dbgx::mcp::StoredOutputInfo info;
+  // "a", a three-byte euro sign, then "b".
+  Expect(store.Put("windbg.eval", "a\xE2\x82\xAC" "b", &info), "output store should accept output", failures);
 
-  const std::string error_summary = dbgx::mcp::BuildResponseIoSummary(error_response);
-  Expect(Contains(error_summary, "rpc_outcome=error"), "error response should be marked as error", failures);
-  Expect(Contains(error_summary, "-32600"), "error response summary should include JSON-RPC error code", failures);
+  dbgx::mcp::OutputPage page;
+  store.ReadBytes(info.uri, 0, 2, &page);
+  Expect(page.text == "a" && page.next_offset == 1, "a page should end before a split character", failures);
+  store.ReadBytes(info.uri, 2, 4, &page);
+  Expect(
+      page.offset == 1 && page.text == "\xE2\x82\xAC" "b" && page.next_offset == 5,
+      "a page should start at the character its offset falls inside",
+      failures);
+  store.ReadBytes(info.uri, 1, 1, &page);
+  Expect(
+      page.text == "\xE2\x82\xAC" && page.next_offset == 4,
+      "a page smaller than one character should still return that character",
+      failures);
 }
 
-void TestIoEchoResponseSummaryTreatsToolIsErrorAsError(int* failures) {
-  dbgx::mcp::HttpResponse response;
-  response.status_code = 200;
-  response.body =
-      R"({"jsonrpc":"2.0","id":5,"result":{"content":[{"type":"text","text":"failed"}],"isError":true}})";
+void TestLargeEvalOutputReturnsExcerptAndResourceLink(int* failures) {
+  FakeExecutor executor;
+  for (int line = 0; line < 20000; ++line) {
+    executor.output += "row " + std::to_string(line) + "\n";
+  }
+  dbgx::mcp::JsonRpcRouter router(&executor);
 
-  const std::string summary = dbgx::mcp::BuildResponseIoSummary(response);
-  Expect(Contains(summary, "rpc_outcome=error"), "result.isError=true should be treated as error outcome", failures);
+  const dbgx::mcp::JsonRpcHttpResult call = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":60,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"!heap -a"}}})");
+  Expect(call.body.size() < 16 * 1024, "large output should not be embedded in the response", failures);
+  Expect(Contains(call.body, "output truncated"), "large output should be marked as truncated", failures);
+  Expect(Contains(call.body, "\"type\":\"resource_link\""), "large output should carry a resource link", failures);
+  Expect(Contains(call.body, "\"outputUri\":\"dbgx://output/1\""), "large output should report its URI", failures);
+  Expect(Contains(call.body, "row 0\\n"), "large output should include the head excerpt", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult read = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":61,"method":"resources/read","params":{"uri":"dbgx://output/1?line=19998&lines=5"}})");
+  Expect(Contains(read.body, "\"text\":\"row 19998\\nrow 19999\\n\""), "resources/read should page by line", failures);
+  Expect(Contains(read.body, "\"nextLine\":20000"), "resources/read should report the next line", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult list = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":62,"method":"resources/list"})");
+  Expect(Contains(list.body, "\"uri\":\"dbgx://output/1\""), "resources/list should include stored outputs", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult missing = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":63,"method":"resources/read","params":{"uri":"dbgx://output/99"}})");
+  Expect(Contains(missing.body, "\"code\":-32002"), "unknown resource should be reported", failures);
 }
 
-void TestIoEchoBlockingLocatabilityStageOrder(int* failures) {
-  dbgx::mcp::IoTraceContext execute_start_context;
+void TestBoundedOutputBufferKeepsHeadAndTail(int* failures) {
+  dbgx::windbg::OutputLimits limits;
+  limits.max_output_bytes = 1024;
+  limits.head_lines = 2;
+  limits.tail_lines = 2;
+  dbgx::windbg::BoundedOutputBuffer buffer(limits);
+
+  std::string full_output;
+  for (int line = 0; line < 100; ++line) {
+    const std::string text = "l" + std::to_string(line) + "\n";
+    full_output += text;
+    buffer.Append(text.substr(0, 1));
+    buffer.Append(text.substr(1));
+  }
+  std::uint64_t dropped = 0;
+  const std::string output = buffer.Finish(&dropped);
+  const std::uint64_t expected_dropped = full_output.size() - std::string("l0\nl1\nl98\nl99\n").size();
+  Expect(dropped == expected_dropped, "bounded buffer should count dropped bytes", failures);
+  Expect(
+      output == "l0\nl1\n... [" + std::to_string(expected_dropped) + " bytes omitted] ...\nl98\nl99\n",
+      "bounded buffer should keep head and tail lines around an omission marker",
+      failures);
+
+  dbgx::windbg::OutputLimits tail_limits;
+  tail_limits.max_output_bytes = 16;
+  tail_limits.tail_lines = 1000;
+  dbgx::windbg::BoundedOutputBuffer tail_buffer(tail_limits);
+  for (int chunk = 0; chunk < 1000; ++chunk) {
+    tail_buffer.Append(std::string(1000, static_cast<char>('a' + chunk % 26)));
+  }
+  tail_buffer.Append("0123456789\n");
+  const std::string tail_output = tail_buffer.Finish(&dropped);
+  Expect(dropped == 1000000 + 11 - 16, "tail-only buffer should keep only its byte budget", failures);
+  Expect(
+      tail_output.size() >= 16 && tail_output.substr(tail_output.size() - 16) == "lllll0123456789\n",
+      "tail ring buffer should keep the newest bytes in order",
+      failures);
+
+  dbgx::windbg::OutputLimits head_limits;
+  head_limits.head_lines = 1;
+  dbgx::windbg::BoundedOutputBuffer head_buffer(head_limits);
+  Expect(head_buffer.Append("first"), "head buffer should accept output until its limit", failures);
+  Expect(!head_buffer.Append("\nsecond\n"), "head-only buffer should ask for an interrupt once full", failures);
+
+  dbgx::windbg::OutputLimits cap_limits;
+  cap_limits.tail_lines = 1;
+  cap_limits.max_output_bytes = 8;
+  cap_limits.interrupt_after_bytes = 32;
+  dbgx::windbg::BoundedOutputBuffer cap_buffer(cap_limits);
+  Expect(cap_buffer.Append(std::string(32, 'x')), "tail buffer should run until the hard cap", failures);
+  Expect(!cap_buffer.Append("x"), "tail buffer should ask for an interrupt past the hard cap", failures);
+
+  // A head spanning several pooled segments comes back whole, with the marker on a line of its own.
+  dbgx::windbg::SegmentPool pool(4096, 4);
+  dbgx::windbg::OutputLimits large_limits;
+  large_limits.max_output_bytes = 10000;
+  dbgx::windbg::BoundedOutputBuffer large_buffer(large_limits, &pool);
+  std::string large_output;
+  for (int chunk = 0; chunk < 30; ++chunk) {
+    large_output += std::string(999, static_cast<char>('a' + chunk % 26)) + "|";
+  }
+  Expect(!large_buffer.Append(large_output), "head-only buffer should ask for an interrupt past its budget", failures);
+  Expect(
+      large_buffer.Finish(&dropped) == large_output.substr(0, 10000) + "\n... [20000 bytes omitted] ...\n",
+      "segmented head should keep its bytes in order",
+      failures);
+  Expect(pool.FreeCount() == 3, "finishing should return the head segments to the pool", failures);
+}
+
+void TestEvalOutputLimitsTrimHeadAndTail(int* failures) {
+  FakeExecutor executor;
+  executor.output.clear();
+  for (int line = 0; line < 100; ++line) {
+    executor.output += "frame " + std::to_string(line) + "\n";
+  }
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":70,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"k 100","head_lines":2,"tail_lines":1}}})");
+  Expect(
+      Contains(result.body, "\"text\":\"frame 0\\nframe 1\\n... ["),
+      "head_lines should keep the first lines",
+      failures);
+  Expect(Contains(result.body, "bytes omitted] ...\\nframe 99\\n\""), "tail_lines should keep the last lines", failures);
+  Expect(Contains(result.body, "\"droppedBytes\":"), "limited output should report dropped bytes", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult bytes_result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":71,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"k 100","max_output_bytes":8}}})");
+  Expect(Contains(bytes_result.body, "\"text\":\"frame 0\\n... ["), "max_output_bytes should cap output", failures);
+}
+
+void TestSegmentedBufferRecyclesPooledSegments(int* failures) {
+  dbgx::windbg::SegmentPool pool(16, 2);
+  std::string expected;
+  {
+    dbgx::windbg::SegmentedBuffer buffer(&pool);
+    for (const std::string_view piece : {"0:000> k\n", "", "Child-SP          RetAddr\n", "ntdll!NtWait"}) {
+      buffer.Append(piece);
+      expected += piece;
+    }
+    const std::vector<std::string_view> segments = buffer.Segments();
+    std::string joined;
+    for (const std::string_view segment : segments) {
+      joined += segment;
+    }
+    Expect(buffer.Size() == expected.size(), "segmented buffer should count appended bytes", failures);
+    Expect(segments.size() == 3 && segments.front().size() == 16, "appends should fill fixed-size segments", failures);
+    Expect(joined == expected && buffer.ToString() == expected, "segments should hold the bytes in order", failures);
+
+    dbgx::windbg::SegmentedBuffer moved = std::move(buffer);
+    Expect(buffer.Empty() && moved.Size() == expected.size(), "moving should hand over segments", failures);
+    Expect(pool.FreeCount() == 0, "moving should not return segments to the pool", failures);
+  }
+  Expect(pool.FreeCount() == 2, "released segments should be kept up to the pool limit", failures);
+
+  dbgx::windbg::SegmentedBuffer reused(&pool);
+  reused.Append(std::string(20, 'r'));
+  Expect(pool.FreeCount() == 0, "new segments should come from the free list first", failures);
+  reused.Clear();
+  Expect(reused.Empty() && pool.FreeCount() == 2, "Clear should return segments to the pool", failures);
+}
+
+void TestFindSubstringMatchesStdFind(int* failures) {
+  std::uint32_t seed = 12345;
+  const auto next = [&seed]() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 16;
+  };
+
+  int mismatches = 0;
+  for (int iteration = 0; iteration < 2000; ++iteration) {
+    std::string haystack(next() % 80, 'a');
+    for (char& ch : haystack) {
+      ch = static_cast<char>('a' + next() % 3);
+    }
+    std::string needle(1 + next() % 5, 'a');
+    for (char& ch : needle) {
+      ch = static_cast<char>('a' + next() % 3);
+    }
+    if (dbgx::windbg::FindSubstring(haystack, needle) != std::string_view(haystack).find(needle)) {
+      ++mismatches;
+    }
+  }
+  Expect(mismatches == 0, "FindSubstring should agree with std::string_view::find", failures);
+  Expect(
+      dbgx::windbg::FindSubstring(std::string(100, 'x') + "ntdll!Rtl", "ntdll!") == 100,
+      "FindSubstring should find needles past the vectorized blocks",
+      failures);
+}
+
+void TestStreamingLineFilterKeepsMatchesWithContext(int* failures) {
+  dbgx::windbg::LineFilterOptions options;
+  options.include = {"hit"};
+  options.exclude = {"skip"};
+  options.context_lines = 1;
+  dbgx::windbg::LineFilter filter;
+  std::string error_message;
+  Expect(dbgx::windbg::LineFilter::Compile(options, &filter, &error_message), "filter should compile", failures);
+
+  const std::string text = "l0\nl1\nhit2\nl3\nl4\nl5\nl6\nhit7\nl8\nhit skip9\nl10";
+  dbgx::windbg::StreamingLineFilter stream(&filter);
+  std::string filtered;
+  for (std::size_t pos = 0; pos < text.size(); pos += 3) {
+    stream.Feed(std::string_view(text).substr(pos, 3), &filtered);
+  }
+  stream.Finish(&filtered);
+  Expect(
+      filtered == "l1\nhit2\nl3\n--\nl6\nhit7\nl8\n",
+      "streaming filter should keep matches with context across chunk boundaries",
+      failures);
+  Expect(stream.MatchedLines() == 2, "streaming filter should count matching lines", failures);
+
+  dbgx::windbg::LineFilterOptions regex_options;
+  regex_options.include_regex = R"(^\s*[0-9a-f]{2} )";
+  regex_options.exclude_regex = "kernel32";
+  dbgx::windbg::LineFilter regex_filter;
+  dbgx::windbg::LineFilter::Compile(regex_options, &regex_filter, &error_message);
+  Expect(
+      dbgx::windbg::FilterLines(" 00 ntdll!a\r\n 01 kernel32!b\n#02 x\n 03 user32!c\n", regex_filter) ==
+          " 00 ntdll!a\r\n 03 user32!c\n",
+      "regex filter should include and exclude lines",
+      failures);
+
+  dbgx::windbg::LineFilterOptions bad_options;
+  bad_options.include_regex = "([";
+  Expect(
+      !dbgx::windbg::LineFilter::Compile(bad_options, &regex_filter, &error_message),
+      "invalid regex should be rejected",
+      failures);
+}
+
+void TestLineFilterBoundsRegexOnLongLines(int* failures) {
+  dbgx::windbg::LineFilterOptions options;
+  options.include_regex = "a.*b";
+  dbgx::windbg::LineFilter filter;
+  std::string error_message;
+  Expect(dbgx::windbg::LineFilter::Compile(options, &filter, &error_message), "filter should compile", failures);
+
+  // Unbounded, std::regex would recurse once per byte of this line and overflow the stack.
+  const std::string long_line(4 * 1024 * 1024, 'a');
+  std::string filter_error;
+  const std::string filtered =
+      dbgx::windbg::FilterLines("ab\n" + long_line + "b\nac\n", filter, &filter_error);
+  Expect(filter_error.empty(), "a long line should not fail the filter", failures);
+  Expect(filtered == "ab\n", "regex should only see the head of a long line", failures);
+
+  const std::string head_match =
+      "ab" + std::string(dbgx::windbg::LineFilter::kMaxRegexLineBytes, 'c') + "\n";
+  Expect(
+      dbgx::windbg::FilterLines(head_match, filter) == head_match,
+      "long lines should be kept whole when their head matches",
+      failures);
+}
+
+void TestEvalLineFilterArguments(int* failures) {
+  FakeExecutor executor;
+  executor.output = "00 ntdll!NtWaitForSingleObject\n01 KERNELBASE!WaitForSingleObjectEx\n02 ntdll!RtlUserThreadStart\n";
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":80,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"~*k","include":["ntdll!"],"exclude":["Rtl"]}}})");
+  Expect(
+      Contains(result.body, "\"text\":\"00 ntdll!NtWaitForSingleObject\\n\""),
+      "windbg.eval should return only filtered lines",
+      failures);
+
+  const dbgx::mcp::JsonRpcHttpResult bad_regex = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":81,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"~*k","include_regex":"(["}}})");
+  Expect(Contains(bad_regex.body, "\"code\":-32602"), "invalid filter regex should be invalid params", failures);
+}
+
+void TestOutputParsersParseCommonFormats(int* failures) {
+  using dbgx::windbg::OutputFormat;
+  dbgx::windbg::ParsedOutput parsed;
+
+  Expect(dbgx::windbg::SelectOutputParser("kvn 20").format == OutputFormat::kStack, "kvn should select stack", failures);
+  Expect(dbgx::windbg::SelectOutputParser("lmv m ntdll").format == OutputFormat::kModules, "lmv should select modules", failures);
+  Expect(dbgx::windbg::SelectOutputParser("dps rsp").format == OutputFormat::kNone, "dps has no parser", failures);
+  Expect(dbgx::windbg::SelectOutputParser("DQ rsp").unit_size == 8, "dq should parse 8-byte units", failures);
+
+  const std::string bytes =
+      "00007ff6`4a1b0000  4d 5a 90 00 03 00 00 00-04 00 00 00 ff ff 00 00  MZ..............\n"
+      "00007ff6`4a1b0010  b8 00 00                                         ...\n"
+      "00007ff6`4a1b0020  ?? ?? ?? ?? ?? ?? ?? ?\?-?? ?? ?? ?? ?? ?? ?? ??  ????????????????\n";
+  Expect(dbgx::windbg::ParseCommandOutput("db 00007ff6`4a1b0000", bytes, &parsed), "db should parse", failures);
+  Expect(parsed.memory.rows.size() == 3 && parsed.memory.unit_size == 1, "db should yield three byte rows", failures);
+  Expect(
+      parsed.memory.rows.size() == 3 && parsed.memory.rows[0].value_count == 16 &&
+          parsed.memory.values[1] == 0x5a && parsed.memory.values[15] == 0x00 &&
+          parsed.memory.rows[1].value_count == 3 && parsed.memory.rows[2].unreadable,
+      "db rows should stop before the ASCII column and mark unreadable bytes",
+      failures);
+
+  const std::string pointers = "0000004f`6b8ff5c8  00007ffa`1c2d3e4e 00000000`000002a4\n0:004> \n";
+  Expect(dbgx::windbg::ParseCommandOutput("dp rsp", pointers, &parsed), "dp should parse", failures);
+  Expect(
+      parsed.memory.unit_size == 8 && parsed.memory.rows.size() == 1 &&
+          parsed.memory.rows[0].address == 0x4f6b8ff5c8ULL && parsed.memory.values[0] == 0x7ffa1c2d3e4eULL &&
+          parsed.skipped_lines == 1,
+      "dp should infer 8-byte pointers from the address width",
+      failures);
+
+  const std::string modules =
+      "start             end                 module name\n"
+      "00007ffa`1e5a0000 00007ffa`1e7b4000   ntdll      (pdb symbols)          c:\\symbols\\ntdll.pdb\n"
+      "00007ffa`1a8c0000 00007ffa`1a8e7000   bcrypt     (deferred)             \n"
+      "\n"
+      "Unloaded modules:\n"
+      "00007ffa`0f120000 00007ffa`0f13b000   ScriptEngine.dll\n";
+  Expect(dbgx::windbg::ParseCommandOutput("lm", modules, &parsed), "lm should parse", failures);
+  Expect(
+      parsed.modules.size() == 3 && parsed.modules[0].name == "ntdll" &&
+          parsed.modules[0].start == 0x7ffa1e5a0000ULL && parsed.modules[0].symbol_status == "pdb symbols" &&
+          parsed.modules[0].image_path == "c:\\symbols\\ntdll.pdb" && parsed.modules[1].image_path.empty() &&
+          !parsed.modules[1].unloaded && parsed.modules[2].unloaded && parsed.skipped_lines == 1,
+      "lm should parse module ranges, symbol status and unloaded modules",
+      failures);
+
+  const std::string stack =
+      " # Child-SP          RetAddr               Call Site\n"
+      "00 0000004f`6b8ff5c8 00007ffa`1c2d3e4e     ntdll!NtWaitForSingleObject+0x14\n"
+      "01 (Inline Function) --------`--------     sample!Worker::WaitIdle+0x9 [d:\\src\\worker.cpp @ 198]\n"
+      "02 0000004f`6b8ff670 00007ff6`4a1b1f02 : 00000000`000002a4 00000000`00000000 : sample+0x1f02\n";
+  Expect(dbgx::windbg::ParseCommandOutput("kbn", stack, &parsed), "kbn should parse", failures);
+  Expect(parsed.frames.size() == 3, "stack should yield three frames", failures);
+  if (parsed.frames.size() == 3) {
+    Expect(
+        parsed.frames[0].number == 0 && parsed.frames[0].child_sp == 0x4f6b8ff5c8ULL &&
+            parsed.frames[0].module == "ntdll" && parsed.frames[0].function == "NtWaitForSingleObject" &&
+            parsed.frames[0].offset == 0x14,
+        "stack frame should split module, function and offset",
+        failures);
+    Expect(
+        parsed.frames[1].is_inline && parsed.frames[1].function == "Worker::WaitIdle" &&
+            parsed.frames[1].source == "d:\\src\\worker.cpp @ 198",
+        "inline frame should keep its function and source",
+        failures);
+    Expect(
+        parsed.frames[2].arg_count == 2 && parsed.frames[2].args[0] == 0x2a4 && parsed.frames[2].module == "sample" &&
+            parsed.frames[2].function.empty() && parsed.frames[2].offset == 0x1f02,
+        "kb frame should parse arguments and module-relative call sites",
+        failures);
+  }
+
+  const std::string registers =
+      "rax=0000000000000000 rbx=0000004f6b8ff660\n"
+      " r8=0000000000000001\n"
+      "iopl=0         nv up ei pl zr na po nc\n"
+      "ntdll!NtWaitForSingleObject+0x14:\n"
+      "00007ffa`1e60d0c4 c3              ret\n";
+  Expect(dbgx::windbg::ParseCommandOutput("r", registers, &parsed), "r should parse", failures);
+  Expect(
+      parsed.registers.size() == 4 && parsed.registers[1].name == "rbx" &&
+          parsed.registers[1].value == 0x4f6b8ff660ULL && parsed.registers[2].name == "r8" && parsed.skipped_lines == 2,
+      "r should parse name=value pairs",
+      failures);
+
+  std::string json;
+  dbgx::mcp::AppendParsedOutputJson(parsed, &json);
+  Expect(
+      Contains(json, "\"format\":\"registers\",\"registers\":{\"rax\":\"0x0\",\"rbx\":\"0x4f6b8ff660\""),
+      "parsed registers should serialize as hex strings",
+      failures);
+
+  Expect(
+      dbgx::windbg::ParseCommandOutput("dq rsp", pointers + pointers + pointers, &parsed, 2) && parsed.truncated &&
+          parsed.memory.rows.size() == 2,
+      "parsing should stop at max_entries",
+      failures);
+}
+
+void TestOutputParsersSurviveFuzzedInput(int* failures) {
+  const std::array<std::string_view, 6> commands = {"db", "dd", "dp", "lm", "kvn", "r"};
+  const std::string seed_text =
+      "00007ff6`4a1b0000  4d 5a 90 00 03 00 00 00-04 00 00 00 ff ff 00 00  MZ..............\n"
+      "0000004f`6b8ff5c8  00007ffa`1c2d3e4e 00000000`000002a4\n"
+      "00007ffa`1e5a0000 00007ffa`1e7b4000   ntdll      (pdb symbols)          c:\\symbols\\ntdll.pdb\n"
+      "01 (Inline Function) --------`--------     sample!Worker::WaitIdle+0x9 [d:\\src\\worker.cpp @ 198]\n"
+      "02 0000004f`6b8ff670 00007ff6`4a1b1f02 : 00000000`000002a4 00000000`00000000 : sample+0x1f02\n"
+      "rax=0000000000000000 rbx=0000004f6b8ff660\n";
+  constexpr std::string_view kAlphabet = "0123456789abcdef`?-:()[]!+x= \n\t\"\\";
+
+  std::uint32_t seed = 4242;
+  const auto next = [&seed]() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 16;
+  };
+
+  int violations = 0;
+  for (int iteration = 0; iteration < 3000; ++iteration) {
+    std::string text = seed_text;
+    const std::uint32_t mutations = 1 + next() % 8;
+    for (std::uint32_t mutation = 0; mutation < mutations && !text.empty(); ++mutation) {
+      const std::size_t pos = next() % text.size();
+      switch (next() % 3) {
+        case 0:
+          text[pos] = kAlphabet[next() % kAlphabet.size()];
+          break;
+        case 1:
+          text.insert(pos, 1, kAlphabet[next() % kAlphabet.size()]);
+          break;
+        default:
+          text.erase(pos, 1 + next() % 16);
+          break;
+      }
+    }
+    if (next() % 4 == 0) {
+      text.resize(next() % (text.size() + 1));
+    }
+
+    dbgx::windbg::ParsedOutput parsed;
+    const std::string_view command = commands[iteration % commands.size()];
+    dbgx::windbg::ParseCommandOutput(command, text, &parsed, 1 + next() % 8);
+
+    const auto in_text = [&text](std::string_view view) {
+      return view.empty() || (view.data() >= text.data() && view.data() + view.size() <= text.data() + text.size());
+    };
+    for (const dbgx::windbg::MemoryRow& row : parsed.memory.rows) {
+      violations += row.first_value + row.value_count > parsed.memory.values.size() ? 1 : 0;
+    }
+    for (const dbgx::windbg::ModuleEntry& module : parsed.modules) {
+      violations += in_text(module.name) && in_text(module.symbol_status) && in_text(module.image_path) ? 0 : 1;
+    }
+    for (const dbgx::windbg::StackFrame& frame : parsed.frames) {
+      violations += in_text(frame.call_site) && in_text(frame.module) && in_text(frame.function) &&
+                            in_text(frame.source) && frame.arg_count <= frame.args.size()
+                        ? 0
+                        : 1;
+    }
+
+    std::string json;
+    dbgx::mcp::AppendParsedOutputJson(parsed, &json);
+    dbgx::json::FieldMap fields;
+    std::string error_message;
+    violations += dbgx::json::ParseObjectFields(json, &fields, &error_message) ? 0 : 1;
+  }
+  Expect(violations == 0, "parsers should keep views in bounds and emit valid JSON for mutated output", failures);
+}
+
+void TestEvalStructuredOutput(int* failures) {
+  FakeExecutor executor;
+  executor.output =
+      " # Child-SP          RetAddr               Call Site\n"
+      "00 0000004f`6b8ff5c8 00007ffa`1c2d3e4e     ntdll!NtWaitForSingleObject+0x14\n";
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":90,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"kn","structured":true}}})");
+  Expect(
+      Contains(
+          result.body,
+          "\"structuredContent\":{\"parsed\":{\"format\":\"stack\",\"frames\":[{\"frame\":0,"
+          "\"childSp\":\"0x4f6b8ff5c8\",\"returnAddress\":\"0x7ffa1c2d3e4e\","
+          "\"callSite\":\"ntdll!NtWaitForSingleObject+0x14\",\"module\":\"ntdll\","
+          "\"function\":\"NtWaitForSingleObject\",\"offset\":\"0x14\"}],\"skippedLines\":1}}"),
+      "structured eval should report parsed frames",
+      failures);
+  Expect(Contains(result.body, "\"text\":\" # Child-SP"), "structured eval should keep the text output", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult unsupported = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":91,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"!analyze -v","structured":true}}})");
+  Expect(
+      Contains(unsupported.body, "\"structuredContent\":{\"parsed\":null}"),
+      "structured eval should report null for commands without a parser",
+      failures);
+}
+
+void TestAppendBase64(int* failures) {
+  const std::array<std::pair<std::string_view, std::string_view>, 6> vectors = {{
+      {"", ""},
+      {"f", "Zg=="},
+      {"fo", "Zm8="},
+      {"foo", "Zm9v"},
+      {"foobar", "Zm9vYmFy"},
+      {std::string_view("MZ\x90\0\xff", 5), "TVqQAP8="},
+  }};
+  for (const auto& [bytes, expected] : vectors) {
+    std::string encoded = "prefix:";
+    dbgx::json::AppendBase64(bytes, &encoded);
+    Expect(encoded == "prefix:" + std::string(expected), "base64 should match RFC 4648 vectors", failures);
+  }
+}
+
+void TestUtf8PrefixLength(int* failures) {
+  using dbgx::json::Utf8PrefixLength;
+  Expect(Utf8PrefixLength("abc", 8) == 3, "short text should be kept whole", failures);
+  Expect(Utf8PrefixLength("abcdef", 4) == 4, "ASCII should be cut at the budget", failures);
+  Expect(Utf8PrefixLength("a\xc3\xa9z", 2) == 1, "a two-byte sequence should not be split", failures);
+  Expect(Utf8PrefixLength("\xe4\xb8\xad\xe6\x96\x87", 5) == 3, "a three-byte sequence should not be split", failures);
+  Expect(Utf8PrefixLength("\xc3\xa9\xc3\xa9", 2) == 2, "a cut on a boundary should not back off", failures);
+  Expect(Utf8PrefixLength("\x80\x80\x80\x80\x80\x80", 5) == 2, "invalid input should back off at most 3 bytes", failures);
+  Expect(
+      dbgx::json::Utf8PageLength("\xe4\xb8\xad\xe6\x96\x87", 2) == 3,
+      "a page too small for one character should take that character",
+      failures);
+  Expect(dbgx::json::Utf8PageLength("a\xc3\xa9", 2) == 1, "a page should otherwise back off like a prefix", failures);
+
+  FakeExecutor executor;
+  executor.output = "a";
+  for (int index = 0; index < 40000; ++index) {
+    executor.output += "\xc3\xa9";
+  }
+  dbgx::mcp::JsonRpcRouter router(&executor);
+  const dbgx::mcp::JsonRpcHttpResult call = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":64,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"du rsp"}}})");
+  Expect(Contains(call.body, "output truncated"), "long single-line output should be excerpted", failures);
+  Expect(Contains(call.body, "showing 8191 of 80001 bytes"), "excerpts should end on a code point", failures);
+}
+
+void TestReadMemoryRangeReportsHoles(int* failures) {
+  FakeMemoryReader reader;
+  std::string first(0x3000, '\0');
+  for (std::size_t index = 0; index < first.size(); ++index) {
+    first[index] = static_cast<char>(index & 0xFF);
+  }
+  reader.Map(0x10000, first);
+  reader.Map(0x14000, std::string(0x1e000, 'B'));
+
+  dbgx::windbg::MemoryRangeRead read;
+  std::string error_message;
+  const bool ok = dbgx::windbg::ReadMemoryRange(&reader, 0x11800, 0x20000, &read, &error_message);
+  Expect(ok, "range read should succeed despite holes", failures);
+  Expect(read.bytes.size() == 0x20000, "range read should return the requested size", failures);
+  Expect(
+      read.holes.size() == 1 && read.holes[0].address == 0x13000 && read.holes[0].size == 0x1000,
+      "unreadable page should be reported as one hole",
+      failures);
+  Expect(read.bytes_read == 0x20000 - 0x1000, "bytes_read should exclude the hole", failures);
+  Expect(
+      read.bytes[0] == static_cast<char>(0x00) && read.bytes[0x100] == static_cast<char>(0x00) &&
+          read.bytes[0x101] == static_cast<char>(0x01) && read.bytes[0x1800] == '\0' && read.bytes[0x2800] == 'B',
+      "range read should copy mapped bytes and zero-fill holes",
+      failures);
+  Expect(reader.largest_read <= 64 * 1024, "range read should be chunked", failures);
+
+  Expect(
+      !dbgx::windbg::ReadMemoryRange(&reader, 0xFFFFFFFFFFFFF000ULL, 0x2000, &read, &error_message),
+      "range read should reject ranges that wrap",
+      failures);
+
+  dbgx::windbg::CommandExecutionContext cancelled;
+  cancelled.RequestCancel();
+  dbgx::windbg::ReadMemoryRange(&reader, 0x10000, 0x1000, &read, &error_message, &cancelled);
+  Expect(read.cancelled && read.bytes_read == 0, "cancelled range read should stop before reading", failures);
+}
+
+void TestReadMemoryTool(int* failures) {
+  FakeExecutor executor;
+  FakeMemoryReader reader;
+  reader.Map(0x7ff64a1b0000ULL, std::string("MZ\x90\0\x03\0\0\0", 8));
+  dbgx::mcp::JsonRpcRouter router(&executor, &reader);
+
+  const dbgx::mcp::JsonRpcHttpResult blob = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":100,"method":"tools/call","params":{"name":"windbg.read_memory",)"
+      R"("arguments":{"address":"00007ff6`4a1b0000","size":3}}})");
+  Expect(
+      Contains(
+          blob.body,
+          "{\"type\":\"resource\",\"resource\":{\"uri\":\"dbgx://memory/0x7ff64a1b0000?size=3\","
+          "\"mimeType\":\"application/octet-stream\",\"blob\":\"TVqQ\"}}"),
+      "read_memory should return an embedded blob resource",
+      failures);
+  Expect(
+      Contains(blob.body, "\"structuredContent\":{\"address\":\"0x7ff64a1b0000\",\"size\":3,\"bytesRead\":3,\"holes\":[]}"),
+      "read_memory should report the read range",
+      failures);
+  Expect(executor.call_count == 0, "read_memory should not execute debugger commands", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult text = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":101,"method":"tools/call","params":{"name":"windbg.read_memory",)"
+      R"("arguments":{"address":"0x7ff64a1afffe","size":4,"encoding":"base64"}}})");
+  Expect(Contains(text.body, "{\"type\":\"text\",\"text\":\"AABNWg==\"}"), "base64 encoding should return text", failures);
+  Expect(
+      Contains(text.body, "\"bytesRead\":2,\"holes\":[{\"address\":\"0x7ff64a1afffe\",\"size\":2}]"),
+      "read_memory should report leading holes",
+      failures);
+
+  const dbgx::mcp::JsonRpcHttpResult unreadable = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":102,"method":"tools/call","params":{"name":"windbg.read_memory",)"
+      R"("arguments":{"address":"0x1000","size":16}}})");
+  Expect(Contains(unreadable.body, "\"isError\":true"), "fully unreadable range should be a tool error", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult bad_address = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":103,"method":"tools/call","params":{"name":"windbg.read_memory",)"
+      R"("arguments":{"address":"rsp","size":16}}})");
+  Expect(Contains(bad_address.body, "\"code\":-32602"), "non-hex address should be invalid params", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult too_large = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":104,"method":"tools/call","params":{"name":"windbg.read_memory",)"
+      R"("arguments":{"address":"0x1000","size":16777217}}})");
+  Expect(Contains(too_large.body, "\"code\":-32602"), "oversized read should be invalid params", failures);
+
+  dbgx::mcp::JsonRpcRouter no_reader(&executor);
+  const dbgx::mcp::JsonRpcHttpResult unavailable = no_reader.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":105,"method":"tools/call","params":{"name":"windbg.read_memory",)"
+      R"("arguments":{"address":"0x1000","size":16}}})");
+  Expect(Contains(unavailable.body, "Memory reads are unavailable"), "missing reader should be reported", failures);
+}
+
+FakeSymbolProvider MakeSymbolProvider() {
+  FakeSymbolProvider provider;
+  provider.modules = {
+      {0x7ffa1e5a0000ULL, 0x214000, "ntdll"},
+      {0x7ffa1c2d0000ULL, 0x2d2000, "KERNELBASE"},
+  };
+  provider.symbols = {
+      {0x7ffa1c2d3dc0ULL, "KERNELBASE!WaitForSingleObjectEx"},
+      {0x7ffa1e60d0b0ULL, "ntdll!NtWaitForSingleObject"},
+  };
+  return provider;
+}
+
+void TestSymbolResolverUsesIndexAndLru(int* failures) {
+  FakeSymbolProvider provider = MakeSymbolProvider();
+  dbgx::windbg::SymbolResolver resolver(dbgx::windbg::SymbolResolverOptions{.max_cached_symbols = 2});
+  std::vector<dbgx::windbg::ResolvedAddress> results;
+  std::string error_message;
+
+  const std::vector<std::uint64_t> addresses = {0x7ffa1e60d0c4ULL, 0x7ffa1c2d3e4eULL, 0x1000, 0x7ffa1e7b4000ULL};
+  Expect(resolver.Resolve(&provider, addresses, &results, &error_message), "resolve should succeed", failures);
+  Expect(results.size() == 4, "resolve should return one entry per address", failures);
+  if (results.size() == 4) {
+    Expect(
+        results[0].module == "ntdll" && results[0].module_offset == 0x6d0c4 &&
+            results[0].symbol == "ntdll!NtWaitForSingleObject" && results[0].displacement == 0x14,
+        "address should resolve to module offset and symbol",
+        failures);
+    Expect(results[1].module == "KERNELBASE" && results[1].displacement == 0x8e, "second module should resolve", failures);
+    Expect(results[2].module.empty() && results[2].symbol.empty(), "unmapped address should stay unresolved", failures);
+    Expect(results[3].module.empty(), "module end should be exclusive", failures);
+  }
+  Expect(provider.name_calls == 2, "symbol lookups should be made only for addresses inside modules", failures);
+
+  resolver.Resolve(&provider, {0x7ffa1e60d0c4ULL, 0x7ffa1c2d3e4eULL}, &results, &error_message);
+  Expect(provider.name_calls == 2 && resolver.Stats().hits == 2, "repeated addresses should hit the LRU", failures);
+  Expect(provider.list_calls == 1, "module index should be reused while the generation is unchanged", failures);
+
+  resolver.Resolve(&provider, {0x7ffa1e5a1000ULL}, &results, &error_message);
+  resolver.Resolve(&provider, {0x7ffa1c2d3e4eULL}, &results, &error_message);
+  Expect(provider.name_calls == 3, "most recently used entries should survive eviction", failures);
+  resolver.Resolve(&provider, {0x7ffa1e60d0c4ULL}, &results, &error_message);
+  Expect(provider.name_calls == 4, "least recently used entry should be evicted", failures);
+
+  provider.generation = 1;
+  provider.modules.push_back({0x7ff64a1b0000ULL, 0x42000, "sample"});
+  resolver.Resolve(&provider, {0x7ff64a1b2c17ULL, 0x7ffa1e60d0c4ULL}, &results, &error_message);
+  Expect(
+      provider.list_calls == 2 && results[0].module == "sample" && provider.name_calls == 6,
+      "generation change should rebuild the index and drop cached symbols",
+      failures);
+
+  resolver.Invalidate();
+  resolver.Resolve(&provider, {0x7ffa1e60d0c4ULL}, &results, &error_message);
+  Expect(provider.list_calls == 3 && resolver.Stats().index_rebuilds == 3, "Invalidate should force a rebuild", failures);
+
+  Expect(dbgx::windbg::InvalidatesSymbols(".reload /f ntdll.dll"), ".reload should invalidate symbols", failures);
+  Expect(dbgx::windbg::InvalidatesSymbols("lm; .SYMFIX"), "joined .symfix should invalidate symbols", failures);
+  Expect(!dbgx::windbg::InvalidatesSymbols("lm m ntdll"), "lm should not invalidate symbols", failures);
+}
+
+void TestResolveAddressesTool(int* failures) {
+  FakeExecutor executor;
+  FakeSymbolProvider provider = MakeSymbolProvider();
+  dbgx::mcp::JsonRpcRouter router(&executor, nullptr, &provider);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":110,"method":"tools/call","params":{"name":"windbg.resolve_addresses",)"
+      R"("arguments":{"addresses":["00007ffa`1e60d0c4","0x1000"]}}})");
+  Expect(
+      Contains(
+          result.body,
+          "\"structuredContent\":{\"results\":[{\"address\":\"0x7ffa1e60d0c4\",\"module\":\"ntdll\","
+          "\"moduleOffset\":\"0x6d0c4\",\"symbol\":\"ntdll!NtWaitForSingleObject\",\"displacement\":\"0x14\"},"
+          "{\"address\":\"0x1000\"}]}"),
+      "resolve_addresses should return compact entries",
+      failures);
+  Expect(
+      Contains(result.body, "\"text\":\"0x7ffa1e60d0c4 ntdll!NtWaitForSingleObject+0x14\\n0x1000\\n\""),
+      "resolve_addresses should return one text line per address",
+      failures);
+  Expect(executor.call_count == 0, "resolve_addresses should not execute debugger commands", failures);
+
+  router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":111,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":".reload"}}})");
+  router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":112,"method":"tools/call","params":{"name":"windbg.resolve_addresses",)"
+      R"("arguments":{"addresses":["0x7ffa1e60d0c4"]}}})");
+  Expect(provider.list_calls == 2, ".reload through windbg.eval should invalidate the module index", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult bad_address = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":113,"method":"tools/call","params":{"name":"windbg.resolve_addresses",)"
+      R"("arguments":{"addresses":["0x1000","ntdll!Foo"]}}})");
+  Expect(
+      Contains(bad_address.body, "\"code\":-32602") && Contains(bad_address.body, "addresses[1]"),
+      "non-hex address should be invalid params naming its index",
+      failures);
+}
+
+void TestToolsListSchemaGeneratedFromDescriptor(int* failures) {
+  static_assert(
+      dbgx::mcp::BuiltinToolCatalog::ToolsListJson().find("\"required\":[\"command\"]") != std::string_view::npos,
+      "tools/list schema must be generated at compile time");
+
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+  const dbgx::mcp::JsonRpcHttpResult result =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":8,"method":"tools/list","params":{}})");
+
+  Expect(
+      Contains(result.body, std::string(dbgx::mcp::BuiltinToolCatalog::ToolsListJson())),
+      "tools/list should return the descriptor-generated catalog",
+      failures);
+  Expect(Contains(result.body, "\"minLength\":1"), "command schema should declare the non-empty constraint", failures);
+  Expect(Contains(result.body, "\"additionalProperties\":false"), "tool schema should forbid extra properties", failures);
+}
+
+void TestDecodeToolArgumentsSinglePass(int* failures) {
+  dbgx::mcp::EvalToolArguments arguments;
+  std::string error_message;
+
+  const bool decoded = dbgx::mcp::DecodeToolArguments(
+      dbgx::mcp::kEvalTool, R"({"extra":{"nested":[1,2]},"command":"dt nt!_PEB"})", &arguments, &error_message);
+  Expect(decoded, "eval arguments should decode from a single object pass", failures);
+  Expect(arguments.command == "dt nt!_PEB", "decoded command should match the argument text", failures);
+
+  dbgx::mcp::EvalToolArguments wrong_type;
+  Expect(
+      !dbgx::mcp::DecodeToolArguments(dbgx::mcp::kEvalTool, R"({"command":42})", &wrong_type, &error_message),
+      "non-string command should be rejected",
+      failures);
+  Expect(
+      Contains(error_message, "command must be a non-empty string"),
+      "type errors should be described from the field descriptor",
+      failures);
+}
+
+void TestToolsCallRejectsNonStringCommand(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":9,"method":"tools/call","params":{"arguments":{"command":["r"]},"name":"windbg.eval"}})");
+
+  Expect(Contains(result.body, "\"code\":-32602"), "non-string command should return invalid params", failures);
+  Expect(executor.call_count == 0, "non-string command must not execute command", failures);
+}
+
+void TestPerfectHashTableLookup(int* failures) {
+  constexpr dbgx::mcp::PerfectHashTable<5> table(std::array<std::string_view, 5>{
+      "initialize", "notifications/initialized", "initialized", "tools/list", "tools/call"});
+  static_assert(table.Find("tools/call") == 4, "perfect hash lookup must resolve at compile time");
+
+  Expect(table.Find("initialize") == 0, "perfect hash should resolve initialize", failures);
+  Expect(table.Find("tools/list") == 3, "perfect hash should resolve tools/list", failures);
+  Expect(table.Find("tools/lis") == table.kNotFound, "perfect hash should reject near-miss names", failures);
+  Expect(table.Find("") == table.kNotFound, "perfect hash should reject empty names", failures);
+}
+
+void TestCachedCatalogResponsesSpliceRequestId(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult numeric_id =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":7,"method":"tools/list"})");
+  const dbgx::mcp::JsonRpcHttpResult string_id =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":"req-7","method":"tools/list"})");
+
+  const std::string numeric_prefix = "{\"jsonrpc\":\"2.0\",\"id\":7,\"result\":";
+  const std::string string_prefix = "{\"jsonrpc\":\"2.0\",\"id\":\"req-7\",\"result\":";
+  Expect(numeric_id.body.rfind(numeric_prefix, 0) == 0, "cached tools/list should splice numeric id", failures);
+  Expect(string_id.body.rfind(string_prefix, 0) == 0, "cached tools/list should splice string id", failures);
+  Expect(
+      numeric_id.body.substr(numeric_prefix.size()) == string_id.body.substr(string_prefix.size()),
+      "cached tools/list result should be identical across ids",
+      failures);
+
+  dbgx::json::FieldMap fields;
+  std::string parse_error;
+  Expect(
+      dbgx::json::ParseObjectFields(string_id.body, &fields, &parse_error),
+      "cached tools/list response should be valid JSON",
+      failures);
+
+  const dbgx::mcp::JsonRpcHttpResult initialize =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":null,"method":"initialize"})");
+  Expect(
+      initialize.body.rfind("{\"jsonrpc\":\"2.0\",\"id\":null,\"result\":{\"protocolVersion\"", 0) == 0,
+      "cached initialize should splice null id",
+      failures);
+}
+
+void TestToolsCallMissingCommand(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":3,"method":"tools/call","params":{"name":"windbg.eval","arguments":{}}})");
+
+  Expect(result.status_code == 200, "missing command should still return JSON-RPC response", failures);
+  Expect(Contains(result.body, "\"code\":-32602"), "missing command should return invalid params", failures);
+  Expect(executor.call_count == 0, "missing command must not execute command", failures);
+}
+
+void TestUnknownMethod(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":4,"method":"unknown/method","params":{}})");
+
+  Expect(result.status_code == 200, "unknown method should return HTTP 200 with JSON-RPC error", failures);
+  Expect(Contains(result.body, "\"code\":-32601"), "unknown method should return method not found", failures);
+}
+
+void TestInitializedNotification(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","method":"notifications/initialized","params":{}})");
+
+  Expect(result.status_code == 202, "initialized notification should return HTTP 202", failures);
+  Expect(!result.has_body, "initialized notification should return empty body", failures);
+  Expect(result.body.empty(), "initialized notification payload should be empty", failures);
+}
+
+void TestParseError(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost("this-is-not-json");
+
+  Expect(result.status_code == 400, "invalid JSON should return HTTP 400", failures);
+  Expect(Contains(result.body, "\"code\":-32700"), "invalid JSON should return parse error", failures);
+}
+
+void TestCancelledNotificationInterruptsToolsCall(int* failures) {
+  CancellableFakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  dbgx::mcp::JsonRpcHttpResult call_result;
+  std::thread call_thread([&]() {
+    call_result = router.HandleJsonRpcPost(
+        R"({"jsonrpc":"2.0","id":41,"method":"tools/call","params":{"name":"windbg.eval",)"
+        R"("arguments":{"command":"s -a 0 L?80000000 \"x\""}}})");
+  });
+
+  Expect(executor.WaitUntilStarted(), "cancellable command should start", failures);
+  const dbgx::mcp::JsonRpcHttpResult cancel_result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","method":"notifications/cancelled","params":{"requestId":41,"reason":"user"}})");
+  call_thread.join();
+
+  Expect(cancel_result.status_code == 202, "cancelled notification should return HTTP 202", failures);
+  Expect(executor.interrupted, "cancelled notification should interrupt the running command", failures);
+  Expect(Contains(call_result.body, "Command cancelled"), "cancelled tools/call should report cancellation", failures);
+  Expect(Contains(call_result.body, "partial"), "cancelled tools/call should keep partial output", failures);
+  Expect(Contains(call_result.body, "\"isError\":true"), "cancelled tools/call should be an error", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult unknown_cancel = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","method":"notifications/cancelled","params":{"requestId":"missing"}})");
+  Expect(unknown_cancel.status_code == 202, "cancelling an unknown request should be ignored", failures);
+}
+
+void TestRouterShutdownCancelsRunningWork(int* failures) {
+  CancellableFakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+  dbgx::mcp::HttpServer server;
+  std::string error_message;
+  const bool started = server.Start(
+      "127.0.0.1",
+      0,
+      [&router](const dbgx::mcp::HttpRequest& request) {
+        dbgx::mcp::HttpResponse response;
+        response.body = router.HandleJsonRpcPost(request.body).body;
+        return response;
+      },
+      &error_message);
+  Expect(started, "server should start for shutdown test", failures);
+  if (!started) {
+    return;
+  }
+
+  // The job holds the engine thread, so the eval waits in the engine queue behind it.
+  const dbgx::mcp::JsonRpcHttpResult job = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":45,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"!analyze -v","async":true}}})");
+  Expect(executor.WaitUntilStarted(), "blocking job should start", failures);
+  std::string queued_response;
+  std::thread client([&]() {
+    queued_response = SendHttpPost(
+        server.BoundPort(),
+        R"({"jsonrpc":"2.0","id":46,"method":"tools/call","params":{"name":"windbg.eval",)"
+        R"("arguments":{"command":"!heap -s"}}})");
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  const auto stop_started = std::chrono::steady_clock::now();
+  router.Shutdown();
+  server.Stop();
+  client.join();
+  const auto stop_duration = std::chrono::steady_clock::now() - stop_started;
+
+  Expect(Contains(job.body, "\"jobId\":\"job-1\""), "job should have started before shutdown", failures);
+  Expect(stop_duration < std::chrono::seconds(2), "shutdown should not wait for the blocking command", failures);
+  Expect(executor.interrupted, "shutdown should interrupt the running job", failures);
+  Expect(Contains(queued_response, "Command cancelled"), "shutdown should cancel queued commands", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult late_call = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":47,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"k"}}})");
+  Expect(Contains(late_call.body, "Command cancelled"), "commands after shutdown should be cancelled", failures);
+  const dbgx::mcp::JsonRpcHttpResult late_job = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":48,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"k","async":true}}})");
+  Expect(Contains(late_job.body, "Server is shutting down"), "jobs after shutdown should be refused", failures);
+}
+
+void TestEvalBatchCanBeCancelledAndTimedOut(int* failures) {
+  CancellableFakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  dbgx::mcp::JsonRpcHttpResult call_result;
+  std::thread call_thread([&]() {
+    call_result = router.HandleJsonRpcPost(
+        R"({"jsonrpc":"2.0","id":49,"method":"tools/call","params":{"name":"windbg.eval_batch",)"
+        R"("arguments":{"commands":["!analyze -v","k"]}}})");
+  });
+  Expect(executor.WaitUntilStarted(), "first batch command should start", failures);
+  router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","method":"notifications/cancelled","params":{"requestId":49,"reason":"user"}})");
+  call_thread.join();
+
+  Expect(executor.interrupted, "cancelling a batch should interrupt its running command", failures);
+  Expect(Contains(call_result.body, "Command cancelled"), "cancelled batch command should report cancellation", failures);
+  Expect(Contains(call_result.body, R"("skipped":1)"), "commands after a cancel should not run", failures);
+
+  CancellableFakeExecutor timed_executor;
+  dbgx::mcp::JsonRpcRouterOptions options;
+  options.default_command_timeout = std::chrono::milliseconds(50);
+  dbgx::mcp::JsonRpcRouter timed_router(&timed_executor, nullptr, nullptr, options);
+  const dbgx::mcp::JsonRpcHttpResult timed_result = timed_router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":50,"method":"tools/call","params":{"name":"windbg.eval_batch",)"
+      R"("arguments":{"commands":["!analyze -v"]}}})");
+  Expect(timed_executor.interrupted, "default timeout should interrupt a batch command", failures);
+  Expect(Contains(timed_result.body, "Command timed out after 50 ms"), "batch timeout should be reported", failures);
+  Expect(timed_router.Stats().timed_out_commands == 1, "batch timeout should be counted", failures);
+}
+
+void TestCommandWatchdogTimesOutExpiredContexts(int* failures) {
+  dbgx::windbg::CommandWatchdog watchdog;
+  dbgx::windbg::CommandExecutionContext expiring;
+  dbgx::windbg::CommandExecutionContext disarmed;
+  dbgx::windbg::CommandExecutionContext cancelled;
+  const auto now = std::chrono::steady_clock::now();
+  const dbgx::windbg::CommandWatchdog::Token expiring_token =
+      watchdog.Arm(&expiring, now + std::chrono::milliseconds(20));
+  watchdog.Disarm(watchdog.Arm(&disarmed, now + std::chrono::milliseconds(10)));
+  cancelled.RequestCancel();
+  const dbgx::windbg::CommandWatchdog::Token cancelled_token = watchdog.Arm(&cancelled, now);
+
+  const auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (watchdog.ExpiredCount() < 2 && std::chrono::steady_clock::now() < give_up) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  watchdog.Disarm(expiring_token);
+  watchdog.Disarm(cancelled_token);
+
+  Expect(watchdog.ExpiredCount() == 2, "watchdog should expire only the armed deadlines", failures);
+  Expect(expiring.TimedOut() && expiring.CancelRequested(), "expired context should be timed out", failures);
+  Expect(!disarmed.TimedOut() && !disarmed.CancelRequested(), "disarmed context should be left alone", failures);
+  Expect(!cancelled.TimedOut(), "a context cancelled first should not be reported as timed out", failures);
+}
+
+void TestCommandWatchdogDisarmsBeforeDeadline(int* failures) {
+  dbgx::windbg::CommandWatchdog watchdog;
+  dbgx::windbg::CommandExecutionContext context;
+  const dbgx::windbg::CommandWatchdog::Token token =
+      watchdog.Arm(&context, std::chrono::steady_clock::now() + std::chrono::milliseconds(100));
+  // The watchdog is now sleeping until the deadline of the entry this removes.
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  watchdog.Disarm(token);
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+
+  Expect(watchdog.ExpiredCount() == 0, "a disarmed deadline should never fire", failures);
+  Expect(!context.TimedOut() && !context.CancelRequested(), "a disarmed context should be left alone", failures);
+}
+
+void TestEvalTimeoutInterruptsCommand(int* failures) {
+  CancellableFakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":43,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"!analyze -v","timeout_ms":50}}})");
+
+  Expect(executor.interrupted, "timeout should interrupt the running command", failures);
+  Expect(Contains(result.body, "Command timed out after 50 ms"), "timeout should be reported", failures);
+  Expect(Contains(result.body, "partial output:\\npartial"), "timeout should keep partial output", failures);
+  Expect(Contains(result.body, "\"timedOut\":true"), "timeout should be flagged in structuredContent", failures);
+  Expect(Contains(result.body, "\"isError\":true"), "timed out command should be an error", failures);
+  Expect(router.Stats().timed_out_commands == 1, "timeout should be counted", failures);
+
+  CancellableFakeExecutor default_executor;
+  dbgx::mcp::JsonRpcRouterOptions options;
+  options.default_command_timeout = std::chrono::milliseconds(50);
+  dbgx::mcp::JsonRpcRouter default_router(&default_executor, nullptr, nullptr, options);
+  const dbgx::mcp::JsonRpcHttpResult default_result = default_router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":44,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"!analyze -v"}}})");
+  Expect(default_executor.interrupted, "server default timeout should interrupt the command", failures);
+  Expect(Contains(default_result.body, "Command timed out after 50 ms"), "default timeout should be reported",
+         failures);
+  Expect(default_router.Stats().timed_out_commands == 1, "default timeout should be counted", failures);
+}
+
+void TestEngineDispatchQueueRunsTasksInOrderOnOneThread(int* failures) {
+  constexpr int kProducers = 8;
+  constexpr int kTasksPerProducer = 200;
+  dbgx::mcp::EngineDispatchQueue queue;
+
+  std::vector<std::pair<int, int>> ran;
+  std::vector<std::thread::id> engine_threads;
+  int active = 0;
+  bool overlapped = false;
+  std::vector<std::thread> producers;
+  for (int producer = 0; producer < kProducers; ++producer) {
+    producers.emplace_back([&, producer]() {
+      for (int sequence = 0; sequence < kTasksPerProducer; ++sequence) {
+        queue.Run([&, producer, sequence]() {
+          overlapped = overlapped || ++active != 1;
+          ran.emplace_back(producer, sequence);
+          engine_threads.push_back(std::this_thread::get_id());
+          --active;
+        });
+      }
+    });
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+
+  Expect(ran.size() == kProducers * kTasksPerProducer, "every submitted task should run", failures);
+  Expect(!overlapped, "engine tasks should never run concurrently", failures);
+  Expect(
+      std::all_of(
+          engine_threads.begin(),
+          engine_threads.end(),
+          [&](std::thread::id id) { return id == engine_threads.front() && id != std::this_thread::get_id(); }),
+      "engine tasks should all run on the dedicated engine thread",
+      failures);
+  std::vector<int> next_sequence(kProducers, 0);
+  bool in_order = true;
+  for (const auto& [producer, sequence] : ran) {
+    in_order = in_order && sequence == next_sequence[producer]++;
+  }
+  Expect(in_order, "tasks from one producer should run in submission order", failures);
+
+  bool nested_ran = false;
+  queue.Run([&]() { queue.Run([&]() { nested_ran = queue.OnEngineThread(); }); });
+  Expect(nested_ran, "Run from the engine thread should run inline", failures);
+
+  bool rethrown = false;
+  try {
+    queue.Run([]() { throw std::runtime_error("engine failure"); });
+  } catch (const std::runtime_error&) {
+    rethrown = true;
+  }
+  Expect(rethrown, "exceptions thrown by a task should reach the submitter", failures);
+}
+
+void TestRouterKeepsExecutorSessionOnEngineThread(int* failures) {
+  FakeExecutor executor;
+  dbgx::windbg::CachingCommandExecutor command_cache(&executor);
+  {
+    dbgx::mcp::JsonRpcRouter router(&command_cache);
+    Expect(executor.session_opens == 1, "router should open the executor session once", failures);
+    router.HandleJsonRpcPost(
+        R"({"jsonrpc":"2.0","id":47,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"r"}}})");
+    router.HandleJsonRpcPost(
+        R"({"jsonrpc":"2.0","id":48,"method":"tools/call","params":{"name":"windbg.eval_batch",)"
+        R"("arguments":{"commands":["lm","k"]}}})");
+    Expect(executor.call_count == 3, "commands should run through the caching executor", failures);
+    Expect(
+        executor.session_opens == 1 && executor.session_closes == 0,
+        "commands should reuse the open session",
+        failures);
+    Expect(
+        executor.session_thread != std::this_thread::get_id() && executor.execute_thread == executor.session_thread,
+        "session should be opened on the engine thread that runs commands",
+        failures);
+  }
+  Expect(
+      executor.session_closes == 1 && executor.close_thread == executor.session_thread,
+      "router should close the session on the engine thread",
+      failures);
+}
+
+void TestRouterSerializesConcurrentSimulatedLoad(int* failures) {
+  constexpr int kClients = 6;
+  constexpr int kCommandsPerClient = 4;
+  dbgx::windbg::SimulationOptions options;
+  options.defaults.latency.median = std::chrono::microseconds(2000);
+  options.defaults.min_output_bytes = 256;
+  options.defaults.max_output_bytes = 96 * 1024;
+  dbgx::windbg::SimulatedCommandExecutor executor(options);
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  std::atomic<int> succeeded{0};
+  std::vector<std::thread> clients;
+  const auto started = std::chrono::steady_clock::now();
+  for (int client = 0; client < kClients; ++client) {
+    clients.emplace_back([&, client]() {
+      for (int index = 0; index < kCommandsPerClient; ++index) {
+        const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+            R"({"jsonrpc":"2.0","id":)" + std::to_string(client * 100 + index) +
+            R"(,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"db @rsp"}}})");
+        if (Contains(result.body, "\"isError\":false")) {
+          ++succeeded;
+        }
+      }
+    });
+  }
+  auto slowest_list = std::chrono::steady_clock::duration::zero();
+  for (int index = 0; index < 10; ++index) {
+    const auto list_started = std::chrono::steady_clock::now();
+    router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":1,"method":"tools/list"})");
+    slowest_list = std::max(slowest_list, std::chrono::steady_clock::now() - list_started);
+  }
+  for (std::thread& client : clients) {
+    client.join();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - started;
+
+  Expect(succeeded.load() == kClients * kCommandsPerClient, "every queued command should succeed", failures);
+  Expect(executor.Stats().executed == kClients * kCommandsPerClient, "every command should reach the engine",
+         failures);
+  Expect(elapsed >= std::chrono::milliseconds(2) * kClients * kCommandsPerClient,
+         "commands should run one at a time on the engine", failures);
+  Expect(slowest_list < std::chrono::milliseconds(250), "tools/list should not queue behind the load", failures);
+}
+
+void TestMetadataNotBlockedByRunningCommand(int* failures) {
+  CancellableFakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  // The fake command holds the engine for up to 5 seconds unless it is cancelled.
+  dbgx::mcp::JsonRpcHttpResult running_result;
+  std::thread running_thread([&]() {
+    running_result = router.HandleJsonRpcPost(
+        R"({"jsonrpc":"2.0","id":43,"method":"tools/call","params":{"name":"windbg.eval",)"
+        R"("arguments":{"command":"!analyze -v"}}})");
+  });
+  Expect(executor.WaitUntilStarted(), "slow command should start", failures);
+  dbgx::mcp::JsonRpcHttpResult queued_result;
+  std::thread queued_thread([&]() {
+    queued_result = router.HandleJsonRpcPost(
+        R"({"jsonrpc":"2.0","id":44,"method":"tools/call","params":{"name":"windbg.eval",)"
+        R"("arguments":{"command":"lm"}}})");
+  });
+
+  auto slowest = std::chrono::steady_clock::duration::zero();
+  bool answered = true;
+  for (int index = 0; index < 20; ++index) {
+    const auto started = std::chrono::steady_clock::now();
+    const dbgx::mcp::JsonRpcHttpResult list_result =
+        router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":45,"method":"tools/list"})");
+    const dbgx::mcp::JsonRpcHttpResult initialize_result = router.HandleJsonRpcPost(
+        R"({"jsonrpc":"2.0","id":46,"method":"initialize","params":{"protocolVersion":"2025-11-25"}})");
+    slowest = std::max(slowest, std::chrono::steady_clock::now() - started);
+    answered = answered && Contains(list_result.body, "\"tools\":[") && Contains(initialize_result.body, "serverInfo");
+  }
+  Expect(answered, "metadata requests should be answered while a command runs", failures);
+  Expect(
+      slowest < std::chrono::milliseconds(250),
+      "tools/list latency should not depend on the command holding the engine",
+      failures);
+
+  router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","method":"notifications/cancelled","params":{"requestId":43}})");
+  running_thread.join();
+  queued_thread.join();
+  Expect(Contains(running_result.body, "Command cancelled"), "slow command should end cancelled", failures);
+  Expect(Contains(queued_result.body, "done"), "queued command should run once the engine is free", failures);
+}
+
+void TestToolsCallWithProgressTokenStreamsProgress(int* failures) {
+  CancellableFakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":42,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"!for_each_module"},"_meta":{"progressToken":"p-42"}}})");
+  Expect(result.content_type == "text/event-stream", "progress tools/call should answer with SSE", failures);
+  Expect(static_cast<bool>(result.body_stream), "progress tools/call should stream its response", failures);
+  if (!result.body_stream) {
+    return;
+  }
+
+  std::mutex events_mutex;
+  std::condition_variable events_changed;
+  std::vector<std::string> events;
+  std::thread stream_thread([&]() {
+    result.body_stream([&](std::string_view chunk) {
+      std::lock_guard<std::mutex> lock(events_mutex);
+      events.emplace_back(chunk);
+      events_changed.notify_all();
+      return true;
+    });
+  });
+
+  bool saw_progress = false;
+  {
+    std::unique_lock<std::mutex> lock(events_mutex);
+    saw_progress = events_changed.wait_for(lock, std::chrono::seconds(5), [&]() { return !events.empty(); });
+  }
+  router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","method":"notifications/cancelled","params":{"requestId":42}})");
+  stream_thread.join();
+
+  Expect(saw_progress, "progress notification should arrive while the command runs", failures);
+  Expect(events.size() >= 2, "SSE stream should end with the tools/call response", failures);
+  if (events.size() >= 2) {
+    Expect(
+        Contains(events.front(), R"("method":"notifications/progress","params":{"progressToken":"p-42","progress":7)"),
+        "progress notification should report captured output bytes",
+        failures);
+    Expect(events.front().rfind("event: message\ndata: ", 0) == 0, "progress should be an SSE message event", failures);
+    Expect(Contains(events.back(), R"("id":42,"result")"), "last SSE event should be the tools/call response", failures);
+  }
+}
+
+bool WaitForJobState(
+    dbgx::mcp::CommandJobTable* jobs,
+    const std::string& job_id,
+    dbgx::mcp::CommandJobState expected_state) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  dbgx::mcp::CommandJobStatus status;
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (jobs->GetStatus(job_id, &status) && status.state == expected_state) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+void TestAsyncEvalJobReportsStatusAndIncrementalOutput(int* failures) {
+  CancellableFakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult start = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":50,"method":"tools/call","params":{"name":"windbg.eval",)"
+      R"("arguments":{"command":"!analyze -v","async":true}}})");
+  Expect(Contains(start.body, "\"jobId\":\"job-1\""), "async eval should return a job id", failures);
+  Expect(Contains(start.body, "\"state\":\"running\""), "async eval should report a running job", failures);
+  Expect(executor.WaitUntilStarted(), "async job should start the command", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult status = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":51,"method":"tools/call","params":{"name":"windbg.job_status",)"
+      R"("arguments":{"job_id":"job-1"}}})");
+  Expect(Contains(status.body, "\"state\":\"running\""), "job status should report running", failures);
+  Expect(Contains(status.body, "\"outputBytes\":7"), "job status should report captured bytes", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult first_read = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":52,"method":"tools/call","params":{"name":"windbg.job_output",)"
+      R"("arguments":{"job_id":"job-1","offset":0}}})");
+  Expect(Contains(first_read.body, "\"text\":\"partial\""), "job output should return captured text", failures);
+  Expect(Contains(first_read.body, "\"nextOffset\":7"), "job output should report the next offset", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult second_read = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":53,"method":"tools/call","params":{"name":"windbg.job_output",)"
+      R"("arguments":{"job_id":"job-1","offset":7}}})");
+  Expect(Contains(second_read.body, "\"text\":\"\""), "reading from nextOffset should return only new output", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult cancel = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":54,"method":"tools/call","params":{"name":"windbg.job_cancel",)"
+      R"("arguments":{"job_id":"job-1"}}})");
+  Expect(Contains(cancel.body, "\"isError\":false"), "job cancel should be accepted", failures);
+
+  bool saw_cancelled = false;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (!saw_cancelled && std::chrono::steady_clock::now() < deadline) {
+    const dbgx::mcp::JsonRpcHttpResult final_status = router.HandleJsonRpcPost(
+        R"({"jsonrpc":"2.0","id":55,"method":"tools/call","params":{"name":"windbg.job_status",)"
+        R"("arguments":{"job_id":"job-1"}}})");
+    saw_cancelled = Contains(final_status.body, "\"state\":\"cancelled\"");
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  Expect(saw_cancelled, "cancelled job should end in the cancelled state", failures);
+  Expect(executor.interrupted, "job cancel should interrupt the running command", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult unknown = router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":56,"method":"tools/call","params":{"name":"windbg.job_status",)"
+      R"("arguments":{"job_id":"job-99"}}})");
+  Expect(Contains(unknown.body, "\"code\":-32602"), "unknown job id should be invalid params", failures);
+}
+
+void TestCommandJobTableBoundsJobsAndOutput(int* failures) {
+  dbgx::mcp::CommandJobTableOptions options;
+  options.max_jobs = 1;
+  options.output_window_bytes = 4;
+  options.finished_job_ttl = std::chrono::hours(1);
+  dbgx::mcp::CommandJobTable jobs(options);
+
+  std::string first_job;
+  std::string error_message;
+  jobs.Start(
+      "db rsp",
+      [](dbgx::windbg::CommandExecutionContext* context) {
+        context->AppendOutput("abcdefgh");
+        return dbgx::windbg::CommandExecutionResult{.success = true, .output = "abcdefgh", .error_message = ""};
+      },
+      &first_job,
+      &error_message);
+  Expect(WaitForJobState(&jobs, first_job, dbgx::mcp::CommandJobState::kSucceeded), "job should finish", failures);
+
+  dbgx::mcp::CommandJobOutputSlice slice;
+  jobs.ReadOutput(first_job, 0, 1024, &slice);
+  Expect(slice.offset == 4 && slice.text == "efgh", "job output should keep only the newest window", failures);
+  Expect(slice.total_bytes == 8, "job output should count dropped bytes", failures);
+
+  std::string second_job;
+  const bool second_started = jobs.Start(
+      "!heap -s",
+      [](dbgx::windbg::CommandExecutionContext* context) {
+        while (!context->CancelRequested()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return dbgx::windbg::MakeCancelledResult();
+      },
+      &second_job,
+      &error_message);
+  dbgx::mcp::CommandJobStatus status;
+  Expect(second_started, "a full table should evict its oldest finished job", failures);
+  Expect(!jobs.GetStatus(first_job, &status), "evicted job should no longer be found", failures);
+
+  std::string third_job;
+  const bool third_started = jobs.Start(
+      "k",
+      [](dbgx::windbg::CommandExecutionContext* /*context*/) { return dbgx::windbg::CommandExecutionResult{}; },
+      &third_job,
+      &error_message);
+  Expect(!third_started, "a table full of running jobs should reject new jobs", failures);
+  Expect(Contains(error_message, "Too many running jobs"), "rejected job should explain the limit", failures);
+
+  jobs.Cancel(second_job);
+  Expect(
+      WaitForJobState(&jobs, second_job, dbgx::mcp::CommandJobState::kCancelled),
+      "cancelled job should end in the cancelled state",
+      failures);
+}
+
+void TestCommandJobOutputSlicesKeepUtf8Whole(int* failures) {
+  dbgx::mcp::CommandJobTableOptions options;
+  options.output_window_bytes = 8;
+  dbgx::mcp::CommandJobTable jobs(options);
+
+  // "ab", then two three-byte euro signs.
+  const std::string euro = "\xE2\x82\xAC";
+  std::string job_id;
+  std::string error_message;
+  jobs.Start(
+      "du rsp",
+      [&euro](dbgx::windbg::CommandExecutionContext* context) {
+        context->AppendOutput("ab" + euro + euro);
+        return dbgx::windbg::CommandExecutionResult{.success = true, .output = "", .error_message = ""};
+      },
+      &job_id,
+      &error_message);
+  Expect(WaitForJobState(&jobs, job_id, dbgx::mcp::CommandJobState::kSucceeded), "job should finish", failures);
+
+  dbgx::mcp::CommandJobOutputSlice slice;
+  jobs.ReadOutput(job_id, 3, 4, &slice);
+  Expect(
+      slice.offset == 2 && slice.text == euro && slice.next_offset == 5,
+      "job output slices should start and end on character boundaries",
+      failures);
+  jobs.ReadOutput(job_id, 5, 1, &slice);
+  Expect(slice.text == euro && slice.next_offset == 8, "a one-byte slice should return a whole character", failures);
+
+  std::string trimmed_job;
+  options.output_window_bytes = 4;
+  dbgx::mcp::CommandJobTable trimmed_jobs(options);
+  trimmed_jobs.Start(
+      "du rsp",
+      [&euro](dbgx::windbg::CommandExecutionContext* context) {
+        context->AppendOutput("a" + euro + euro);
+        return dbgx::windbg::CommandExecutionResult{.success = true, .output = "", .error_message = ""};
+      },
+      &trimmed_job,
+      &error_message);
+  Expect(
+      WaitForJobState(&trimmed_jobs, trimmed_job, dbgx::mcp::CommandJobState::kSucceeded),
+      "trimmed job should finish",
+      failures);
+  trimmed_jobs.ReadOutput(trimmed_job, 0, 1024, &slice);
+  Expect(
+      slice.offset == 4 && slice.text == euro,
+      "a window trimmed inside a character should skip its leftover bytes",
+      failures);
+}
+
+void TestCommandJobTableEvictsExpiredJobs(int* failures) {
+  dbgx::mcp::CommandJobTableOptions options;
+  options.finished_job_ttl = std::chrono::milliseconds(0);
+  dbgx::mcp::CommandJobTable jobs(options);
+
+  std::string job_id;
+  std::string error_message;
+  std::atomic<bool> finished{false};
+  jobs.Start(
+      "lm",
+      [&finished](dbgx::windbg::CommandExecutionContext* /*context*/) {
+        finished = true;
+        return dbgx::windbg::CommandExecutionResult{.success = true, .output = "", .error_message = ""};
+      },
+      &job_id,
+      &error_message);
+
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (jobs.JobCount() != 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  Expect(finished.load(), "job runner should have executed", failures);
+  Expect(jobs.JobCount() == 0, "finished jobs past their TTL should be evicted", failures);
+}
+
+std::string CollectStreamedBody(const dbgx::mcp::JsonRpcHttpResult& result) {
+  std::string body;
+  if (result.body_stream) {
+    result.body_stream([&body](std::string_view chunk) {
+      body.append(chunk);
+      return true;
+    });
+  }
+  return body;
+}
+
+void TestBatchAnswersMetadataFirstAndRunsToolsInOrder(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"([{"jsonrpc":"2.0","id":1,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"k"}}},)"
+      R"({"jsonrpc":"2.0","method":"notifications/initialized"},)"
+      R"({"jsonrpc":"2.0","id":2,"method":"tools/list"},)"
+      R"({"jsonrpc":"2.0","id":3,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"r"}}},)"
+      R"(7])");
+
+  Expect(result.status_code == 200, "batch should return HTTP 200", failures);
+  Expect(static_cast<bool>(result.body_stream), "batch response should be streamed", failures);
+  Expect(executor.call_count == 0, "batch tools must not run before the response is streamed", failures);
+
+  const std::string body = CollectStreamedBody(result);
+  Expect(body.front() == '[' && body.back() == ']', "batch response should be a JSON array", failures);
+  const std::size_t list_pos = body.find("\"id\":2");
+  const std::size_t first_call_pos = body.find("\"id\":1");
+  const std::size_t second_call_pos = body.find("\"id\":3");
+  Expect(list_pos != std::string::npos && list_pos < first_call_pos, "tools/list should be answered first", failures);
+  Expect(first_call_pos < second_call_pos, "tools/call responses should keep request order", failures);
+  Expect(
+      Contains(body, R"({"jsonrpc":"2.0","id":null,"error":{"code":-32600)"),
+      "non-object batch item should return invalid request",
+      failures);
+  Expect(
+      executor.commands == std::vector<std::string>({"k", "r"}),
+      "batch tools/call items should execute in order",
+      failures);
+}
+
+void TestBatchOfNotificationsReturnsAccepted(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(
+      R"([{"jsonrpc":"2.0","method":"notifications/initialized"},{"jsonrpc":"2.0","method":"initialized"}])");
+
+  Expect(result.status_code == 202, "notification-only batch should return HTTP 202", failures);
+  Expect(!result.has_body, "notification-only batch should return empty body", failures);
+  Expect(!result.body_stream, "notification-only batch should not stream", failures);
+}
+
+void TestEmptyBatchIsInvalidRequest(int* failures) {
+  FakeExecutor executor;
+  dbgx::mcp::JsonRpcRouter router(&executor);
+
+  const dbgx::mcp::JsonRpcHttpResult empty = router.HandleJsonRpcPost("[ ]");
+  Expect(Contains(empty.body, "\"code\":-32600"), "empty batch should return invalid request", failures);
+
+  const dbgx::mcp::JsonRpcHttpResult broken = router.HandleJsonRpcPost("[{\"jsonrpc\":\"2.0\"");
+  Expect(broken.status_code == 400, "truncated batch should return HTTP 400", failures);
+  Expect(Contains(broken.body, "\"code\":-32700"), "truncated batch should return parse error", failures);
+}
+
+void TestIoEchoRequestSummaryMasksSensitiveHeader(int* failures) {
+  dbgx::mcp::HttpRequest request;
+  request.method = "POST";
+  request.path = "/mcp";
+  request.headers.insert_or_assign("authorization", "Bearer super-secret-token");
+  request.body =
+      R"({"jsonrpc":"2.0","id":99,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"r eax"}}})";
+
+  const std::string summary = dbgx::mcp::BuildRequestIoSummary(request);
+
+  Expect(Contains(summary, "method=POST"), "request summary should include HTTP method", failures);
+  Expect(Contains(summary, "path=/mcp"), "request summary should include request path", failures);
+  Expect(Contains(summary, "rpc_method=tools/call"), "request summary should include JSON-RPC method", failures);
+  Expect(Contains(summary, "rpc_id=99"), "request summary should include JSON-RPC id", failures);
+  Expect(Contains(summary, "authorization=<masked>"), "request summary should mask authorization header", failures);
+  Expect(!Contains(summary, "super-secret-token"), "request summary must not expose authorization token", failures);
+}
+
+void TestIoEchoSummaryTruncatesLongPayload(int* failures) {
+  const std::string long_text(512, 'x');
+
+  dbgx::mcp::HttpResponse response;
+  response.status_code = 200;
+  response.body =
+      "{\"jsonrpc\":\"2.0\",\"id\":1,\"result\":{\"content\":[{\"type\":\"text\",\"text\":\"" + long_text +
+      "\"}]}}";
+
+  const std::string summary = dbgx::mcp::BuildResponseIoSummary(response);
+  Expect(Contains(summary, "...(truncated)"), "long response summary should be truncated", failures);
+}
+
+void TestIoEchoRequestSummaryIncludesTraceContext(int* failures) {
+  dbgx::mcp::HttpRequest request;
+  request.method = "POST";
+  request.path = "/mcp";
+  request.body =
+      R"({"jsonrpc":"2.0","id":7,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"g"}}})";
+
+  dbgx::mcp::IoTraceContext trace_context;
+  trace_context.trace_id = "rpc:7";
+  trace_context.stage = "tool_execute_start";
+  trace_context.rpc_method = "tools/call";
+  trace_context.rpc_id = "7";
+  trace_context.tool_name = "windbg.eval";
+  trace_context.duration_ms = 12;
+
+  const std::string summary = dbgx::mcp::BuildRequestIoSummary(request, trace_context);
+  Expect(Contains(summary, "trace_id=rpc:7"), "request summary should include trace id", failures);
+  Expect(Contains(summary, "stage=tool_execute_start"), "request summary should include stage", failures);
+  Expect(Contains(summary, "duration_ms=12"), "request summary should include duration", failures);
+  Expect(Contains(summary, "tool=windbg.eval"), "request summary should include tool name", failures);
+}
+
+void TestIoEchoParseRequestMetaMissingId(int* failures) {
+  dbgx::mcp::HttpRequest request;
+  request.method = "POST";
+  request.path = "/mcp";
+  request.body =
+      R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"g"}}})";
+
+  const dbgx::mcp::RequestIoMeta meta = dbgx::mcp::ParseRequestIoMeta(request);
+  Expect(meta.parseable, "request meta should parse valid JSON", failures);
+  Expect(meta.has_rpc_method && meta.rpc_method == "tools/call", "request meta should include tools/call method", failures);
+  Expect(!meta.has_rpc_id, "request meta should detect missing id", failures);
+  Expect(meta.has_tool_name && meta.tool_name == "windbg.eval", "request meta should include tool name", failures);
+}
+
+void TestIoEchoLocalTraceIdConsistencyAcrossStages(int* failures) {
+  dbgx::mcp::HttpRequest request;
+  request.method = "POST";
+  request.path = "/mcp";
+  request.body =
+      R"({"jsonrpc":"2.0","method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"g"}}})";
+
+  dbgx::mcp::IoTraceContext request_context;
+  request_context.trace_id = "local-42";
+  request_context.stage = "request_received";
+  request_context.rpc_method = "tools/call";
+  request_context.tool_name = "windbg.eval";
+  request_context.duration_ms = 0;
+
+  const std::string request_summary = dbgx::mcp::BuildRequestIoSummary(request, request_context);
+  Expect(Contains(request_summary, "trace_id=local-42"), "request summary should include local trace id", failures);
+
+  dbgx::mcp::HttpResponse response;
+  response.status_code = 200;
+  response.body =
+      R"({"jsonrpc":"2.0","result":{"content":[{"type":"text","text":"ok"}],"isError":false}})";
+
+  dbgx::mcp::IoTraceContext response_context = request_context;
+  response_context.stage = "response_sent";
+  response_context.duration_ms = 25;
+
+  const std::string response_summary = dbgx::mcp::BuildResponseIoSummary(response, response_context);
+  Expect(Contains(response_summary, "trace_id=local-42"), "response summary should include same local trace id", failures);
+  Expect(Contains(response_summary, "stage=response_sent"), "response summary should include response stage", failures);
+}
+
+void TestIoEchoResponseSummaryCoversSuccessAndError(int* failures) {
+  dbgx::mcp::HttpResponse success_response;
+  success_response.status_code = 200;
+  success_response.body =
+      "{\"jsonrpc\":\"2.0\",\"id\":10,\"result\":{\"content\":[{\"type\":\"text\",\"text\":\"ok\"}]}}";
+
+  const std::string success_summary = dbgx::mcp::BuildResponseIoSummary(success_response);
+  Expect(Contains(success_summary, "rpc_outcome=success"), "success response should be marked as success", failures);
+
+  dbgx::mcp::HttpResponse error_response;
+  error_response.status_code = 200;
+  error_response.body =
+      "{\"jsonrpc\":\"2.0\",\"id\":10,\"error\":{\"code\":-32600,\"message\":\"Invalid Request\"}}";
+
+  const std::string error_summary = dbgx::mcp::BuildResponseIoSummary(error_response);
+  Expect(Contains(error_summary, "rpc_outcome=error"), "error response should be marked as error", failures);
+  Expect(Contains(error_summary, "-32600"), "error response summary should include JSON-RPC error code", failures);
+}
+
+void TestIoEchoResponseSummaryTreatsToolIsErrorAsError(int* failures) {
+  dbgx::mcp::HttpResponse response;
+  response.status_code = 200;
+  response.body =
+      R"({"jsonrpc":"2.0","id":5,"result":{"content":[{"type":"text","text":"failed"}],"isError":true}})";
+
+  dbgx::mcp::IoTraceContext trace_context;
+  trace_context.is_error = true;
+
+  const std::string summary = dbgx::mcp::BuildResponseIoSummary(response, trace_context);
+  Expect(Contains(summary, "rpc_outcome=error"), "result.isError=true should be treated as error outcome", failures);
+  Expect(Contains(dbgx::mcp::BuildResponseIoSummary(response), "rpc_outcome=success"),
+         "the summary should not rescan the result body for isError",
+         failures);
+}
+
+void TestIoEchoBlockingLocatabilityStageOrder(int* failures) {
+  dbgx::mcp::IoTraceContext execute_start_context;
   execute_start_context.trace_id = "rpc:5";
   execute_start_context.stage = "tool_execute_start";
   execute_start_context.rpc_method = "tools/call";
@@ -417,8 +2600,488 @@ void TestIoEchoBlockingLocatabilityStageOrder(int* failures) {
   Expect(Contains(logs[1], "trace_id=rpc:5"), "second log should include same request trace id", failures);
 }
 
+void TestIoEchoFormatsLargeBodiesIntoFixedBuffer(int* failures) {
+  dbgx::mcp::HttpResponse response;
+  response.status_code = 200;
+  response.body = R"({"jsonrpc":"2.0","id":9,"result":{"content":[{"type":"text","text":")" +
+                  std::string(10 * 1024 * 1024, 'a') + R"("}],"isError":true}})";
+  dbgx::mcp::IoTraceContext trace_context;
+  trace_context.trace_id = "rpc:9";
+  trace_context.stage = "response_sent";
+  trace_context.tool_name = std::string(4096, 't');
+  trace_context.is_error = true;
+
+  dbgx::mcp::IoSummaryBuffer buffer;
+  const std::string_view summary = dbgx::mcp::FormatResponseIoSummary(response, trace_context, &buffer);
+  Expect(summary.data() == buffer.data() && summary.size() < buffer.size(),
+         "summary should be formatted into the caller's buffer",
+         failures);
+  Expect(Contains(std::string(summary), "rpc_outcome=error"), "the router's tool error should set the outcome", failures);
+  Expect(Contains(std::string(summary), "tool=" + std::string(dbgx::mcp::kSummaryValueLimit, 't') + "...(truncated)"),
+         "long context values should be cut to the value limit",
+         failures);
+  Expect(summary == dbgx::mcp::BuildResponseIoSummary(response, trace_context),
+         "Build and Format should produce the same summary",
+         failures);
+
+  dbgx::mcp::HttpRequest request;
+  request.method = "POST";
+  request.path = "/mcp";
+  request.body = R"({"jsonrpc":"2.0","id":"a\nb","method":"tools\/call","params":{"name":"windbg.eval"}})";
+  request.headers["Authorization"] = "Bearer secret";
+  const std::string request_summary(dbgx::mcp::FormatRequestIoSummary(request, {}, &buffer));
+  Expect(Contains(request_summary, "rpc_method=tools/call") && Contains(request_summary, "tool=windbg.eval") &&
+             Contains(request_summary, "sensitive_headers=authorization=<masked>") &&
+             !Contains(request_summary, "secret"),
+         "escaped request fields should be decoded and headers masked",
+         failures);
+
+  Expect(dbgx::mcp::IsLogLevelCompiled(dbgx::mcp::LogLevel::kError), "error records should always be compiled in", failures);
+}
+
+void TestAsyncLogDropsWhenFullAndKeepsOrder(int* failures) {
+  {
+    // The sink blocks until released, so the ring fills and further records are dropped without waiting.
+    std::mutex mutex;
+    std::condition_variable released_cv;
+    bool released = false;
+    std::vector<std::string> written;
+    dbgx::mcp::AsyncLogOptions options;
+    options.capacity = 8;
+    options.max_record_bytes = 8;
+    {
+      dbgx::mcp::AsyncLog log(options, [&](std::span<const dbgx::mcp::LogRecord> records) {
+        std::unique_lock<std::mutex> lock(mutex);
+        released_cv.wait(lock, [&released]() { return released; });
+        for (const dbgx::mcp::LogRecord& record : records) {
+          written.emplace_back(record.text);
+        }
+      });
+      // Slots are handed back only after the sink returns, so exactly the ring's capacity is accepted.
+      int accepted = log.Enqueue(dbgx::mcp::LogLevel::kInfo, "much longer than eight bytes") ? 1 : 0;
+      for (int index = 1; index < 32; ++index) {
+        accepted += log.Enqueue(dbgx::mcp::LogLevel::kInfo, "r" + std::to_string(index)) ? 1 : 0;
+      }
+      Expect(accepted == 8, "a blocked sink should leave room for exactly the ring capacity", failures);
+      Expect(log.Stats().dropped == 24, "records beyond the ring capacity should be dropped", failures);
+      Expect(log.Stats().truncated == 1, "the long record should be counted as truncated", failures);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+      }
+      released_cv.notify_all();
+      log.Flush();
+      Expect(log.Enqueue(dbgx::mcp::LogLevel::kInfo, "after"), "a drained ring should accept records again", failures);
+    }
+    Expect(written.size() == 9 && written.front() == "much lon" && written[1] == "r1" && written.back() == "after",
+           "accepted records should be written in order, cut to max_record_bytes",
+           failures);
+  }
+
+  {
+    std::mutex mutex;
+    std::vector<std::string> written;
+    dbgx::mcp::AsyncLogOptions options;
+    options.min_level = dbgx::mcp::LogLevel::kInfo;
+    std::string error_message;
+    Expect(dbgx::mcp::ParseStageSampling(" route_dispatch=3 ", &options.sampling, &error_message),
+           "stage sampling should parse",
+           failures);
+    Expect(!dbgx::mcp::ParseStageSampling("route_dispatch=0", &options.sampling, &error_message) &&
+               Contains(error_message, "route_dispatch=0"),
+           "zero sampling should be rejected",
+           failures);
+    dbgx::mcp::LogLevel level = dbgx::mcp::LogLevel::kDebug;
+    Expect(dbgx::mcp::ParseLogLevel("warning", &level) && level == dbgx::mcp::LogLevel::kWarning,
+           "log level should parse",
+           failures);
+    Expect(!dbgx::mcp::ParseLogLevel("verbose", &level), "unknown log level should be rejected", failures);
+
+    dbgx::mcp::AsyncLog log(options, [&](std::span<const dbgx::mcp::LogRecord> records) {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (const dbgx::mcp::LogRecord& record : records) {
+        written.emplace_back(record.text);
+      }
+    });
+    Expect(!log.Log(dbgx::mcp::LogLevel::kDebug, "request_received", "debug"), "debug should be filtered", failures);
+    for (int index = 0; index < 6; ++index) {
+      log.Log(dbgx::mcp::LogLevel::kInfo, "route_dispatch", "dispatch" + std::to_string(index));
+    }
+
+    constexpr int kProducers = 4;
+    constexpr int kRecordsPerProducer = 100;
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kProducers; ++producer) {
+      producers.emplace_back([&log, producer]() {
+        for (int index = 0; index < kRecordsPerProducer; ++index) {
+          log.Log(dbgx::mcp::LogLevel::kInfo,
+                  "request_received",
+                  "p" + std::to_string(producer) + ":" + std::to_string(index));
+        }
+      });
+    }
+    for (std::thread& producer : producers) {
+      producer.join();
+    }
+    log.Flush();
+
+    const dbgx::mcp::AsyncLogStats stats = log.Stats();
+    Expect(stats.sampled_out == 4, "1-in-3 sampling should be counted", failures);
+    std::lock_guard<std::mutex> lock(mutex);
+    Expect(written.size() == 2 + kProducers * kRecordsPerProducer, "nothing should be dropped below capacity", failures);
+    Expect(written.size() >= 2 && written[0] == "dispatch0" && written[1] == "dispatch3",
+           "sampling should keep the first of every three records",
+           failures);
+    std::array<int, kProducers> next{};
+    bool ordered = true;
+    for (std::size_t index = 2; index < written.size(); ++index) {
+      const std::string& text = written[index];
+      const int producer = text[1] - '0';
+      ordered = ordered && text == "p" + std::to_string(producer) + ":" + std::to_string(next[producer]++);
+    }
+    Expect(ordered, "each producer's records should be written in order", failures);
+  }
+}
+
 }  // namespace
 
+void TestLatencyHistogramBucketsAreLogLinear(int* failures) {
+  bool bounds_hold = true;
+  for (std::uint64_t value : {0ull, 7ull, 8ull, 9ull, 1000ull, 123456789ull, (1ull << 39) + 12345, 1ull << 41}) {
+    const std::size_t index = dbgx::mcp::LatencyBucketIndex(value);
+    const std::uint64_t upper = dbgx::mcp::LatencyBucketUpperBound(index);
+    const std::uint64_t lower = index == 0 ? 0 : dbgx::mcp::LatencyBucketUpperBound(index - 1) + 1;
+    if (index == dbgx::mcp::kLatencyBucketCount - 1) {
+      bounds_hold = bounds_hold && value >= lower;
+      continue;
+    }
+    bounds_hold = bounds_hold && lower <= value && value <= upper && (upper - lower) * 8 <= lower;
+  }
+  Expect(bounds_hold, "every value should land in a bucket no wider than an eighth of its lower bound", failures);
+  Expect(dbgx::mcp::LatencyBucketIndex(1ull << 62) == dbgx::mcp::kLatencyBucketCount - 1,
+         "huge values should share the last bucket",
+         failures);
+
+  dbgx::mcp::LatencyHistogram histogram;
+  dbgx::mcp::ShardedCounter counter;
+  std::vector<std::thread> threads;
+  for (int thread = 0; thread < 8; ++thread) {
+    threads.emplace_back([&histogram, &counter, thread]() {
+      for (int index = 0; index < 1000; ++index) {
+        histogram.Record(static_cast<std::uint64_t>(thread) * 1000000);
+        counter.Add(2);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const dbgx::mcp::HistogramSnapshot snapshot = histogram.Snapshot();
+  Expect(snapshot.count == 8000 && counter.Value() == 16000, "sharded recording should lose no updates", failures);
+  Expect(snapshot.sum_nanoseconds == 28000000000ull, "histogram sum should add every recorded value", failures);
+  Expect(snapshot.counts[0] == 1000 && snapshot.counts[dbgx::mcp::LatencyBucketIndex(7000000)] == 1000,
+         "each thread's values should share one bucket",
+         failures);
+
+  dbgx::mcp::PrometheusWriter writer;
+  const dbgx::mcp::MetricLabel labels[] = {{"method", "a\"b"}};
+  writer.BeginFamily("test_seconds", "histogram", "Test.");
+  writer.WriteHistogram("test_seconds", labels, snapshot);
+  const std::string& text = writer.Text();
+  Expect(Contains(text, "# TYPE test_seconds histogram\n") &&
+             Contains(text, "test_seconds_bucket{method=\"a\\\"b\",le=\"0\"} 1000\n") &&
+             Contains(text, "test_seconds_bucket{method=\"a\\\"b\",le=\"+Inf\"} 8000\n") &&
+             Contains(text, "test_seconds_sum{method=\"a\\\"b\"} 28\n") &&
+             Contains(text, "test_seconds_count{method=\"a\\\"b\"} 8000\n"),
+         "histogram should render cumulative buckets, sum and count with escaped labels",
+         failures);
+}
+
+void TestMetricsEndpointExportsPerMethodSeries(int* failures) {
+  FakeExecutor executor;
+  executor.output = "eax=0x42";
+  dbgx::mcp::JsonRpcRouter router(&executor);
+  router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":1,"method":"initialize","params":{}})");
+  router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":2,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"r"}}})");
+  CollectStreamedBody(router.HandleJsonRpcPost(
+      R"([{"jsonrpc":"2.0","id":3,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"r"}}},)"
+      R"({"jsonrpc":"2.0","id":4,"method":"no/such"},7])"));
+  router.HandleJsonRpcPost("{not json");
+
+  dbgx::mcp::HttpServer server;
+  dbgx::mcp::HttpServerStartOptions start_options;
+  start_options.metrics_exporter = [&router](dbgx::mcp::PrometheusWriter* writer) { router.ExportMetrics(writer); };
+  std::string error_message;
+  const bool started =
+      server.Start("127.0.0.1", 0, MakeNoopHttpResponse, &error_message, nullptr, &start_options);
+  Expect(started, "server should start with a metrics exporter", failures);
+  if (!started) {
+    return;
+  }
+  const std::string metrics =
+      SendHttpRequest(server.BoundPort(), "GET /metrics HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+  const std::string other = SendHttpPost(server.BoundPort(), "{}");
+  const std::string posted = SendHttpRequest(
+      server.BoundPort(), "POST /metrics HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 0\r\n\r\n");
+  server.Stop();
+
+  Expect(Contains(metrics, "HTTP/1.1 200") && Contains(metrics, "text/plain; version=0.0.4"),
+         "GET /metrics should answer in the Prometheus text format",
+         failures);
+  Expect(Contains(metrics, "dbgx_mcp_active_connections 1\n"), "the scrape should count its own connection", failures);
+  Expect(Contains(metrics, "dbgx_mcp_requests_total{method=\"initialize\"} 1\n") &&
+             Contains(metrics, "dbgx_mcp_requests_total{method=\"tools/call\",tool=\"windbg.eval\"} 2\n") &&
+             Contains(metrics, "dbgx_mcp_requests_total{method=\"(unknown)\"} 1\n") &&
+             Contains(metrics, "dbgx_mcp_requests_total{method=\"(invalid)\"} 2\n"),
+         "requests should be counted by method and tool, batch items one by one",
+         failures);
+  Expect(Contains(metrics, "dbgx_mcp_executor_seconds_count{method=\"tools/call\",tool=\"windbg.eval\"} 2\n") &&
+             Contains(metrics, "dbgx_mcp_queue_wait_seconds_count{method=\"tools/call\",tool=\"windbg.eval\"} 2\n") &&
+             !Contains(metrics, "dbgx_mcp_executor_seconds_count{method=\"initialize\"}") &&
+             Contains(metrics, "dbgx_mcp_serialization_seconds_count{method=\"initialize\"} 1\n") &&
+             Contains(metrics, "dbgx_mcp_parse_seconds_bucket{method=\"initialize\",le=\"+Inf\"} 1\n"),
+         "engine histograms should cover only methods that reach the engine",
+         failures);
+  Expect(Contains(metrics, "dbgx_mcp_request_bytes_total{method=\"initialize\"} 58\n") &&
+             Contains(metrics, "dbgx_mcp_engine_queue_depth 0\n"),
+         "request bytes and queue depth should be exported",
+         failures);
+  Expect(Contains(other, "\r\n\r\n{}"), "other paths should still reach the request handler", failures);
+  Expect(Contains(posted, "HTTP/1.1 405"), "only GET should be served on /metrics", failures);
+}
+
+std::size_t CountOccurrences(const std::string& text, const std::string& needle) {
+  std::size_t count = 0;
+  for (std::size_t position = text.find(needle); position != std::string::npos;
+       position = text.find(needle, position + needle.size())) {
+    ++count;
+  }
+  return count;
+}
+
+void TestSpanTracerKeepsRecentSpansPerThread(int* failures) {
+  dbgx::mcp::SpanTracerOptions options;
+  options.spans_per_thread = 8;
+  dbgx::mcp::SpanTracer tracer(options);
+  tracer.Record(dbgx::mcp::TraceStage::kParse, 1, 2);
+  Expect(tracer.ChromeTraceJson() == R"({"displayTimeUnit":"ns","traceEvents":[]})",
+         "a stopped tracer should record nothing",
+         failures);
+
+  tracer.Start();
+  const std::uint64_t begin = dbgx::mcp::MonotonicNanoseconds();
+  tracer.Record(dbgx::mcp::TraceStage::kQueueWait, begin, begin + 1500);
+  { const dbgx::mcp::TraceScope scope(&tracer, dbgx::mcp::TraceStage::kExecute); }
+  std::thread worker([&tracer]() {
+    for (int index = 0; index < 20; ++index) {
+      const dbgx::mcp::TraceScope scope(&tracer, dbgx::mcp::TraceStage::kSend);
+    }
+  });
+  worker.join();
+  const std::string json = tracer.ChromeTraceJson();
+  Expect(Contains(json, R"({"name":"queue_wait","cat":"dbgx","ph":"X","pid":1,"tid":1,"ts":)") &&
+             Contains(json, R"(,"dur":1.500})") && Contains(json, R"("name":"execute")"),
+         "spans should be complete events in microseconds on the recording thread's track",
+         failures);
+  Expect(CountOccurrences(json, R"("name":"send","cat":"dbgx","ph":"X","pid":1,"tid":2,)") == 8,
+         "a thread's ring should keep only its most recent spans",
+         failures);
+  Expect(json.find("queue_wait") < json.find("execute") && json.find("execute") < json.find("send"),
+         "events should be ordered by begin time",
+         failures);
+
+  // Rings of exited threads are reused, and dumps run safely next to recording threads.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> writers;
+  for (int thread = 0; thread < 4; ++thread) {
+    writers.emplace_back([&tracer, &stop]() {
+      while (!stop.load()) {
+        const dbgx::mcp::TraceScope scope(&tracer, dbgx::mcp::TraceStage::kParse);
+      }
+    });
+  }
+  bool dumps_well_formed = true;
+  for (int dump = 0; dump < 20; ++dump) {
+    const std::string concurrent = tracer.ChromeTraceJson();
+    dumps_well_formed = dumps_well_formed && concurrent.ends_with("]}") &&
+                        CountOccurrences(concurrent, R"("ph":"X")") <= 8 * 6;
+  }
+  stop.store(true);
+  for (std::thread& writer : writers) {
+    writer.join();
+  }
+  Expect(dumps_well_formed, "dumps during recording should stay bounded and well formed", failures);
+
+  tracer.Stop();
+  tracer.Start();
+  Expect(tracer.ChromeTraceJson() == R"({"displayTimeUnit":"ns","traceEvents":[]})",
+         "a restart should leave earlier spans out",
+         failures);
+}
+
+void TestTraceEndpointCoversRequestStages(int* failures) {
+  FakeExecutor executor;
+  executor.output = "eax=0x42";
+  dbgx::mcp::SpanTracer tracer;
+  dbgx::mcp::JsonRpcRouterOptions router_options;
+  router_options.tracer = &tracer;
+  dbgx::mcp::JsonRpcRouter router(&executor, nullptr, nullptr, router_options);
+
+  dbgx::mcp::HttpServer server;
+  dbgx::mcp::HttpServerStartOptions start_options;
+  start_options.tracer = &tracer;
+  std::string error_message;
+  const bool started = server.Start(
+      "127.0.0.1",
+      0,
+      [&router](const dbgx::mcp::HttpRequest& request) {
+        const dbgx::mcp::JsonRpcHttpResult result = router.HandleJsonRpcPost(request.body);
+        dbgx::mcp::HttpResponse response;
+        response.status_code = result.status_code;
+        response.body = result.body;
+        return response;
+      },
+      &error_message,
+      nullptr,
+      &start_options);
+  Expect(started, "server should start with a tracer", failures);
+  if (!started) {
+    return;
+  }
+  const std::string trace_start = SendHttpRequest(
+      server.BoundPort(), "POST /trace/start HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Length: 0\r\n\r\n");
+  const std::string eval = SendHttpPost(
+      server.BoundPort(),
+      R"({"jsonrpc":"2.0","id":1,"method":"tools/call","params":{"name":"windbg.eval","arguments":{"command":"r"}}})");
+  const std::string trace = SendHttpRequest(server.BoundPort(), "GET /trace HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+  const std::string wrong_method =
+      SendHttpRequest(server.BoundPort(), "GET /trace/stop HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+  server.Stop();
+
+  Expect(Contains(trace_start, R"({"tracing":true})") && Contains(eval, "eax=0x42"),
+         "tracing should start over HTTP without disturbing requests",
+         failures);
+  bool all_stages = true;
+  for (const char* stage : {"accept", "recv", "parse", "queue_wait", "execute", "escape", "serialize", "send"}) {
+    all_stages = all_stages && Contains(trace, std::string("\"name\":\"") + stage + "\"");
+  }
+  Expect(all_stages, "GET /trace should cover every stage of the traced request", failures);
+  Expect(Contains(trace, R"({"displayTimeUnit":"ns","traceEvents":[)"), "the trace should be Chrome JSON", failures);
+  Expect(Contains(wrong_method, "HTTP/1.1 405"), "trace control should require POST", failures);
+}
+
+void TestFlightRecorderKeepsRecentRecordsConsistent(int* failures) {
+  dbgx::mcp::FlightRecorder recorder(dbgx::mcp::FlightRecorderOptions{6});
+  Expect(recorder.Capacity() == 8 && recorder.Snapshot().empty(),
+         "capacity should round up to a power of two",
+         failures);
+
+  dbgx::mcp::FlightRecord record;
+  record.command.Assign(std::string(100, 'k'));
+  for (std::uint64_t index = 1; index <= 20; ++index) {
+    record.total_ns = index * 10;
+    recorder.Record(record);
+  }
+  const std::vector<dbgx::mcp::FlightRecord> recent = recorder.Snapshot();
+  Expect(recent.size() == 8 && recent.front().sequence == 13 && recent.back().sequence == 20 &&
+             recent.back().total_ns == 200,
+         "the ring should keep the most recent records, oldest first",
+         failures);
+  Expect(recent.back().command.View() == std::string(dbgx::mcp::FlightText::kCapacity, 'k'),
+         "long text should be cut to the inline capacity",
+         failures);
+  dbgx::mcp::FlightText text;
+  text.Assign(std::string(30, 'k') + "\xc3\xa9");
+  Expect(text.View() == std::string(30, 'k'), "long text should not be cut inside a UTF-8 sequence", failures);
+
+  std::vector<std::uint64_t> values = {50, 10, 40, 20, 30, 100, 90, 80, 70, 60};
+  const dbgx::mcp::LatencyPercentiles percentiles = dbgx::mcp::ComputeLatencyPercentiles(values);
+  Expect(percentiles.count == 10 && percentiles.p50 == 50 && percentiles.p90 == 90 && percentiles.p99 == 100 &&
+             percentiles.max == 100,
+         "percentiles should use the nearest rank",
+         failures);
+
+  // Writers never wait; snapshots taken meanwhile only hold records that were complete when copied.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> writers;
+  for (int thread = 0; thread < 4; ++thread) {
+    writers.emplace_back([&recorder, &stop]() {
+      dbgx::mcp::FlightRecord concurrent;
+      for (std::uint64_t index = 1; !stop.load(); ++index) {
+        concurrent.parse_ns = index;
+        concurrent.executor_ns = index * 3;
+        concurrent.total_ns = index * 7;
+        recorder.Record(concurrent);
+      }
+    });
+  }
+  bool snapshots_consistent = true;
+  for (int snapshot = 0; snapshot < 200; ++snapshot) {
+    const std::vector<dbgx::mcp::FlightRecord> records = recorder.Snapshot();
+    snapshots_consistent = snapshots_consistent && records.size() <= recorder.Capacity();
+    for (std::size_t index = 0; index < records.size(); ++index) {
+      const dbgx::mcp::FlightRecord& entry = records[index];
+      snapshots_consistent = snapshots_consistent && (index == 0 || entry.sequence > records[index - 1].sequence) &&
+                             (entry.sequence <= 20 || (entry.executor_ns == entry.parse_ns * 3 &&
+                                                       entry.total_ns == entry.parse_ns * 7));
+    }
+  }
+  stop.store(true);
+  for (std::thread& writer : writers) {
+    writer.join();
+  }
+  Expect(snapshots_consistent, "snapshots during recording should never hold torn records", failures);
+  Expect(recorder.Snapshot().size() <= recorder.Capacity() && recorder.DroppedCount() < recorder.RecordedCount(),
+         "dropped records should be counted, not waited for",
+         failures);
+}
+
+void TestStatsMethodReportsRecentRequests(int* failures) {
+  FakeExecutor executor;
+  executor.output = "eax=0x42";
+  dbgx::mcp::JsonRpcRouterOptions options;
+  options.flight_records = 4;
+  dbgx::mcp::JsonRpcRouter router(&executor, nullptr, nullptr, options);
+  router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":1,"method":"initialize","params":{}})");
+  router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":"a","method":"tools/call",)"
+      R"("params":{"name":"windbg.eval","arguments":{"command":"k 20"}}})");
+  executor.should_fail = true;
+  router.HandleJsonRpcPost(
+      R"({"jsonrpc":"2.0","id":3,"method":"tools/call",)"
+      R"("params":{"name":"windbg.eval_batch","arguments":{"commands":["r","lm"]}}})");
+  router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":4,"method":"no/such"})");
+  router.HandleJsonRpcPost("{not json");
+
+  const dbgx::mcp::JsonRpcHttpResult stats =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":6,"method":"dbgx/stats","params":{}})");
+  Expect(stats.status_code == 200 && Contains(stats.body, R"("capacity":4,"recorded":5,"dropped":0,)") &&
+             Contains(stats.body, R"("summary":{"requests":4,"errors":3,"totalNs":{"count":4,)") &&
+             Contains(stats.body, R"("queueWaitNs":{"count":2,)"),
+         "dbgx/stats should summarize the records still in the ring",
+         failures);
+  Expect(!Contains(stats.body, R"("method":"initialize")") &&
+             Contains(stats.body, R"("tool":"windbg.eval","id":"\"a\"","command":"k 20","outcome":"ok",)") &&
+             Contains(stats.body, R"("tool":"windbg.eval_batch","id":"3","command":"r; lm","outcome":"tool_error",)") &&
+             Contains(stats.body, "(unknown)\",\"id\":\"4\",\"outcome\":\"error\",\"errorCode\":-32601,") &&
+             Contains(stats.body, "\"method\":\"(invalid)\",\"outcome\":\"error\",\"errorCode\":-32700,"),
+         "each record should carry its method, tool, id, command prefix and outcome",
+         failures);
+  Expect(Contains(stats.body, R"("executorNs":)") && Contains(stats.body, R"("serializationNs":)"),
+         "records should carry stage timings",
+         failures);
+
+  const dbgx::mcp::JsonRpcHttpResult limited =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":7,"method":"dbgx/stats","params":{"limit":1}})");
+  Expect(CountOccurrences(limited.body, R"("sequence":)") == 1 && Contains(limited.body, R"("method":"dbgx/stats")"),
+         "limit should keep only the most recent records",
+         failures);
+  const dbgx::mcp::JsonRpcHttpResult invalid =
+      router.HandleJsonRpcPost(R"({"jsonrpc":"2.0","id":8,"method":"dbgx/stats","params":{"limit":-1}})");
+  Expect(Contains(invalid.body, R"("code":-32602)"), "a negative limit should be rejected", failures);
+}
+
 int main() {
   int failures = 0;
 
@@ -426,13 +3089,67 @@ int main() {
   TestToolsList(&failures);
   TestToolsCallSuccess(&failures);
   TestToolsCallMissingCommand(&failures);
+  TestEvalBatchRunsCommandsInOrder(&failures);
+  TestEvalBatchStopOnError(&failures);
+  TestEvalBatchAppliesOutputLimits(&failures);
+  TestCommandCacheClassification(&failures);
+  TestCachingExecutorServesHitsUntilStateChanges(&failures);
+  TestCachingExecutorInvalidatesOnUnknownCommands(&failures);
+  TestCachingExecutorRepeatsDisplayContinuations(&failures);
+  TestCachingExecutorBatchKeepsMutationOrder(&failures);
+  TestSessionTraceRecordsAndReplaysCommands(&failures);
+  TestSimulatedExecutorDrawsReproducibleLoad(&failures);
+  TestOutputStorePagesByLineAndByteOffset(&failures);
+  TestOutputStoreBytePagesKeepUtf8Whole(&failures);
+  TestLargeEvalOutputReturnsExcerptAndResourceLink(&failures);
+  TestBoundedOutputBufferKeepsHeadAndTail(&failures);
+  TestEvalOutputLimitsTrimHeadAndTail(&failures);
+  TestSegmentedBufferRecyclesPooledSegments(&failures);
+  TestFindSubstringMatchesStdFind(&failures);
+  TestStreamingLineFilterKeepsMatchesWithContext(&failures);
+  TestLineFilterBoundsRegexOnLongLines(&failures);
+  TestEvalLineFilterArguments(&failures);
+  TestOutputParsersParseCommonFormats(&failures);
+  TestOutputParsersSurviveFuzzedInput(&failures);
+  TestEvalStructuredOutput(&failures);
+  TestAppendBase64(&failures);
+  TestUtf8PrefixLength(&failures);
+  TestReadMemoryRangeReportsHoles(&failures);
+  TestReadMemoryTool(&failures);
+  TestSymbolResolverUsesIndexAndLru(&failures);
+  TestResolveAddressesTool(&failures);
+  TestToolsListSchemaGeneratedFromDescriptor(&failures);
+  TestDecodeToolArgumentsSinglePass(&failures);
+  TestToolsCallRejectsNonStringCommand(&failures);
+  TestPerfectHashTableLookup(&failures);
+  TestCachedCatalogResponsesSpliceRequestId(&failures);
   TestUnknownMethod(&failures);
   TestInitializedNotification(&failures);
   TestParseError(&failures);
+  TestBatchAnswersMetadataFirstAndRunsToolsInOrder(&failures);
+  TestBatchOfNotificationsReturnsAccepted(&failures);
+  TestEmptyBatchIsInvalidRequest(&failures);
+  TestCancelledNotificationInterruptsToolsCall(&failures);
+  TestRouterShutdownCancelsRunningWork(&failures);
+  TestEvalBatchCanBeCancelledAndTimedOut(&failures);
+  TestCommandWatchdogTimesOutExpiredContexts(&failures);
+  TestCommandWatchdogDisarmsBeforeDeadline(&failures);
+  TestEvalTimeoutInterruptsCommand(&failures);
+  TestEngineDispatchQueueRunsTasksInOrderOnOneThread(&failures);
+  TestRouterSerializesConcurrentSimulatedLoad(&failures);
+  TestMetadataNotBlockedByRunningCommand(&failures);
+  TestRouterKeepsExecutorSessionOnEngineThread(&failures);
+  TestToolsCallWithProgressTokenStreamsProgress(&failures);
+  TestAsyncEvalJobReportsStatusAndIncrementalOutput(&failures);
+  TestCommandJobTableBoundsJobsAndOutput(&failures);
+  TestCommandJobOutputSlicesKeepUtf8Whole(&failures);
+  TestCommandJobTableEvictsExpiredJobs(&failures);
   TestHttpServerStartBindsWithoutConflict(&failures);
   TestHttpServerFallbackAfterPortConflict(&failures);
   TestHttpServerFailsAfterMaxConflictAttempts(&failures);
   TestHttpServerNonRetryableBindFailureStopsImmediately(&failures);
+  TestHttpServerServesConnectionsConcurrently(&failures);
+  TestHttpServerSendsLargeAndChunkedBodiesIntact(&failures);
   TestIoEchoRequestSummaryMasksSensitiveHeader(&failures);
   TestIoEchoSummaryTruncatesLongPayload(&failures);
   TestIoEchoRequestSummaryIncludesTraceContext(&failures);
@@ -441,6 +3158,14 @@ int main() {
   TestIoEchoResponseSummaryCoversSuccessAndError(&failures);
   TestIoEchoResponseSummaryTreatsToolIsErrorAsError(&failures);
   TestIoEchoBlockingLocatabilityStageOrder(&failures);
+  TestIoEchoFormatsLargeBodiesIntoFixedBuffer(&failures);
+  TestAsyncLogDropsWhenFullAndKeepsOrder(&failures);
+  TestLatencyHistogramBucketsAreLogLinear(&failures);
+  TestMetricsEndpointExportsPerMethodSeries(&failures);
+  TestSpanTracerKeepsRecentSpansPerThread(&failures);
+  TestTraceEndpointCoversRequestStages(&failures);
+  TestFlightRecorderKeepsRecentRecordsConsistent(&failures);
+  TestStatsMethodReportsRecentRequests(&failures);
 
   if (failures == 0) {
     std::cout << "All unit tests passed.\n";